@@ -0,0 +1,426 @@
+/* Generated by script/gen_ksyms.sh - do not edit */
+#include "kernel/ksyms.h"
+
+const ksym_t ksym_table[] = {
+    { 0xc0100000, "multiboot_header" },
+    { 0xc010000c, "_start" },
+    { 0xc010000c, "_text_start" },
+    { 0xc01000fd, "_start_higher" },
+    { 0xc0100140, "kernel_main" },
+    { 0xc01002e0, "gdt_init" },
+    { 0xc0100380, "idt_set_gate" },
+    { 0xc01003c0, "idt_init" },
+    { 0xc0100450, "isr_init" },
+    { 0xc0100820, "cpu_detect_features" },
+    { 0xc0100860, "mmio_map" },
+    { 0xc0100960, "panic" },
+    { 0xc0100990, "panic_isr" },
+    { 0xc0100b20, "sched_init" },
+    { 0xc0100b80, "rcu_process_callbacks" },
+    { 0xc0100c60, "rcu_quiescent_state" },
+    { 0xc0100c90, "synchronize_rcu" },
+    { 0xc0100d50, "call_rcu" },
+    { 0xc0100de0, "rcu_barrier" },
+    { 0xc0100df0, "irqsoff_stop" },
+    { 0xc0100e40, "irqsoff_record" },
+    { 0xc0100e80, "irqsoff_reset" },
+    { 0xc0100ec0, "trace_events_show" },
+    { 0xc0100f40, "trace_show" },
+    { 0xc0101110, "trace_emit" },
+    { 0xc0101170, "trace_set_event" },
+    { 0xc0101220, "trace_events_store" },
+    { 0xc01012f0, "trace_init" },
+    { 0xc0101350, "ksym_index" },
+    { 0xc01013b0, "ksym_lookup" },
+    { 0xc01013f0, "top_insert" },
+    { 0xc01014a0, "profile_show" },
+    { 0xc0101840, "profile_tick" },
+    { 0xc0101920, "profile_start" },
+    { 0xc0101940, "profile_stop" },
+    { 0xc0101950, "profile_reset" },
+    { 0xc01019b0, "profile_store" },
+    { 0xc0101af0, "profile_dump" },
+    { 0xc0101b30, "profile_init" },
+    { 0xc0101c20, "tsc_init" },
+    { 0xc0101d90, "tsc_to_us" },
+    { 0xc0101df0, "boottime_show.part.0" },
+    { 0xc01020f0, "boottime_show" },
+    { 0xc0102130, "boot_stage" },
+    { 0xc0102170, "boottime_report" },
+    { 0xc01021e0, "schedule_work" },
+    { 0xc0102290, "schedule_delayed_work" },
+    { 0xc0102360, "workqueue_tick" },
+    { 0xc0102430, "work_pending" },
+    { 0xc0102440, "run_work" },
+    { 0xc0102510, "initcall_run" },
+    { 0xc01025b0, "initcall_scan" },
+    { 0xc01026c0, "initcall_work" },
+    { 0xc01026f0, "do_initcalls" },
+    { 0xc01027b0, "initcall_flush" },
+    { 0xc0102800, "fpu_nm_trap" },
+    { 0xc01028e0, "fpu_switch_to" },
+    { 0xc0102900, "kernel_fpu_usable" },
+    { 0xc0102920, "kernel_fpu_begin" },
+    { 0xc0102970, "kernel_fpu_end" },
+    { 0xc0102990, "fpu_init" },
+    { 0xc0102a90, "text_poke" },
+    { 0xc0102ad0, "apply_alternatives" },
+    { 0xc0102bf0, "static_key_enable" },
+    { 0xc0102ca0, "static_key_disable" },
+    { 0xc0102d30, "log_init" },
+    { 0xc0102d50, "log_read_one" },
+    { 0xc0102f30, "log_read_all.part.0" },
+    { 0xc0103070, "dmesg_show" },
+    { 0xc0103090, "dmesg_store" },
+    { 0xc0103170, "console_flush" },
+    { 0xc0103400, "console_work_fn" },
+    { 0xc0103410, "register_console" },
+    { 0xc01034c0, "console_selected" },
+    { 0xc01035d0, "log_set_sync" },
+    { 0xc01035f0, "log_panic" },
+    { 0xc0103610, "log_store" },
+    { 0xc0103860, "log_read_all" },
+    { 0xc0103880, "cmdline_devfs_init" },
+    { 0xc01038a0, "cmdline_show" },
+    { 0xc01038c0, "cmdline_init" },
+    { 0xc0103910, "cmdline_get" },
+    { 0xc0103920, "cmdline_param" },
+    { 0xc0103a20, "bench_main" },
+    { 0xc0103e90, "bench_kalloc_64" },
+    { 0xc0103ed0, "bench_kalloc_1024" },
+    { 0xc0103f10, "bench_kalloc_batch" },
+    { 0xc0103f80, "bench_page_alloc_1" },
+    { 0xc0103fe0, "bench_page_alloc_16" },
+    { 0xc0104040, "bench_blk_read_hot" },
+    { 0xc01040a0, "bench_blk_read_seq" },
+    { 0xc0104110, "bench_blk_read_seq8" },
+    { 0xc0104190, "bench_blk_ref_hot" },
+    { 0xc01041f0, "bench_blk_write_seq" },
+    { 0xc0104280, "bench_wb_teardown" },
+    { 0xc0104290, "bench_vfs_teardown" },
+    { 0xc01042c0, "bench_vfs_open" },
+    { 0xc0104320, "bench_vfs_read" },
+    { 0xc01043c0, "bench_printk" },
+    { 0xc0104400, "bench_vga_write" },
+    { 0xc0104440, "bench_uart_write" },
+    { 0xc0104490, "bench_disk.part.0" },
+    { 0xc0104500, "bench_disk_setup" },
+    { 0xc0104530, "bench_wb_setup" },
+    { 0xc0104560, "bench_vfs_setup" },
+    { 0xc01045c0, "bench_disk" },
+    { 0xc01045d1, "isr0" },
+    { 0xc01045da, "isr1" },
+    { 0xc01045e3, "isr2" },
+    { 0xc01045ec, "isr3" },
+    { 0xc01045f5, "isr4" },
+    { 0xc01045fe, "isr5" },
+    { 0xc0104607, "isr6" },
+    { 0xc0104610, "isr8" },
+    { 0xc0104617, "isr9" },
+    { 0xc0104620, "isr10" },
+    { 0xc0104627, "isr11" },
+    { 0xc010462e, "isr12" },
+    { 0xc0104635, "isr13" },
+    { 0xc010463c, "isr14" },
+    { 0xc0104643, "isr15" },
+    { 0xc010464c, "isr16" },
+    { 0xc0104655, "isr17" },
+    { 0xc010465c, "isr18" },
+    { 0xc0104665, "isr19" },
+    { 0xc010466e, "isr20" },
+    { 0xc0104677, "isr21" },
+    { 0xc010467e, "isr22" },
+    { 0xc0104687, "isr23" },
+    { 0xc0104690, "isr24" },
+    { 0xc0104699, "isr25" },
+    { 0xc01046a2, "isr26" },
+    { 0xc01046ab, "isr27" },
+    { 0xc01046b4, "isr28" },
+    { 0xc01046bd, "isr29" },
+    { 0xc01046c4, "isr30" },
+    { 0xc01046cb, "isr31" },
+    { 0xc01046d4, "irq0" },
+    { 0xc01046dd, "irq1" },
+    { 0xc01046e6, "irq2" },
+    { 0xc01046ec, "irq3" },
+    { 0xc01046f2, "irq4" },
+    { 0xc01046f8, "irq5" },
+    { 0xc01046fe, "irq6" },
+    { 0xc0104704, "irq7" },
+    { 0xc010470a, "irq8" },
+    { 0xc0104710, "irq9" },
+    { 0xc0104716, "irq10" },
+    { 0xc010471c, "irq11" },
+    { 0xc0104722, "irq12" },
+    { 0xc0104728, "irq13" },
+    { 0xc010472e, "irq14" },
+    { 0xc0104734, "irq15" },
+    { 0xc010473a, "irq16" },
+    { 0xc0104740, "irq17" },
+    { 0xc0104746, "irq18" },
+    { 0xc010474c, "irq19" },
+    { 0xc0104752, "irq20" },
+    { 0xc0104758, "irq21" },
+    { 0xc010475e, "irq22" },
+    { 0xc0104764, "irq23" },
+    { 0xc010476a, "irq_common" },
+    { 0xc0104770, "irq_stamped" },
+    { 0xc01047b8, "irq_stamp_entry" },
+    { 0xc01047c7, "isr7" },
+    { 0xc01047d4, "spurious_irq" },
+    { 0xc01047d5, "isr_common" },
+    { 0xc0104810, "mm_init" },
+    { 0xc0104970, "buddy_init" },
+    { 0xc0104a10, "page_alloc" },
+    { 0xc0104b80, "page_free" },
+    { 0xc0104cd0, "buddy_total_pages" },
+    { 0xc0104ce0, "buddy_free_pages" },
+    { 0xc0104cf0, "buddy_used_pages" },
+    { 0xc0104d00, "get_cache" },
+    { 0xc0104d80, "slab_init" },
+    { 0xc0104df0, "kalloc" },
+    { 0xc0105000, "kfree" },
+    { 0xc0105100, "add_slab" },
+    { 0xc0105150, "slab_stats" },
+    { 0xc0105230, "register_shrinker" },
+    { 0xc0105260, "unregister_shrinker" },
+    { 0xc0105290, "shrink_memory" },
+    { 0xc0105310, "out_char" },
+    { 0xc01053c0, "print_int" },
+    { 0xc0105910, "vprintk_internal" },
+    { 0xc0105ee0, "vprintk_early" },
+    { 0xc0105f20, "printk_early" },
+    { 0xc0105f60, "vprintk" },
+    { 0xc0106000, "printk" },
+    { 0xc0106020, "vsnprintk" },
+    { 0xc0106080, "snprintk" },
+    { 0xc01060e0, "scnprintk" },
+    { 0xc0106150, "strlen" },
+    { 0xc01061c0, "strcmp" },
+    { 0xc0106260, "strncmp" },
+    { 0xc0106310, "strcpy" },
+    { 0xc0106390, "strncpy" },
+    { 0xc01063d0, "strcat" },
+    { 0xc01063f0, "strchr" },
+    { 0xc01064b0, "strrchr" },
+    { 0xc0106500, "memcmp" },
+    { 0xc0106550, "memcpy_word" },
+    { 0xc01065e0, "memset_word" },
+    { 0xc0106670, "memcpy_rep" },
+    { 0xc01066b0, "memset_rep" },
+    { 0xc01066f0, "memcpy_erms" },
+    { 0xc0106710, "memset_erms" },
+    { 0xc0106730, "have_always" },
+    { 0xc0106740, "have_erms" },
+    { 0xc0106750, "have_sse2" },
+    { 0xc0106780, "membench_init" },
+    { 0xc01067a0, "membench_show" },
+    { 0xc0106ae0, "memcpy_sse2" },
+    { 0xc0106bb0, "memset_sse2" },
+    { 0xc0106c80, "mem_set_impl" },
+    { 0xc0106cf0, "membench_store" },
+    { 0xc0106d50, "mem_select_impl" },
+    { 0xc0106da0, "memcpy" },
+    { 0xc0106db0, "memset" },
+    { 0xc0106dc0, "memmove" },
+    { 0xc0106e70, "merge" },
+    { 0xc0106ee0, "list_sort" },
+    { 0xc0106ff0, "htable_init" },
+    { 0xc0107060, "htable_destroy" },
+    { 0xc0107090, "htable_resize" },
+    { 0xc0107170, "rb_insert_color" },
+    { 0xc0107310, "rb_erase" },
+    { 0xc0107770, "rb_replace_node" },
+    { 0xc01077d0, "rb_first" },
+    { 0xc01077f0, "rb_last" },
+    { 0xc0107810, "rb_next" },
+    { 0xc0107840, "rb_prev" },
+    { 0xc0107870, "pic_init" },
+    { 0xc01078f0, "pic_send_eoi" },
+    { 0xc0107910, "pic_enable_irq" },
+    { 0xc0107940, "pic_disable_irq" },
+    { 0xc0107980, "pic_disable_all" },
+    { 0xc0107990, "ioapic_program" },
+    { 0xc0107a50, "apic_eoi" },
+    { 0xc0107a60, "apic_set_affinity" },
+    { 0xc0107aa0, "mp_scan" },
+    { 0xc0107b10, "apic_enable" },
+    { 0xc0107b40, "apic_disable" },
+    { 0xc0107b70, "lapic_eoi" },
+    { 0xc0107b80, "lapic_id" },
+    { 0xc0107b90, "apic_init" },
+    { 0xc0108150, "irq_account_timing" },
+    { 0xc01082e0, "irq_latency_show" },
+    { 0xc0108490, "pic_disable" },
+    { 0xc01084b0, "pic_enable" },
+    { 0xc01084d0, "pic_eoi" },
+    { 0xc01084f0, "irq_show" },
+    { 0xc01086b0, "irq_latency_store" },
+    { 0xc0108800, "irq_dispatch" },
+    { 0xc01089b0, "irq_latency_dump" },
+    { 0xc01089f0, "irq_init" },
+    { 0xc0108a90, "request_irq" },
+    { 0xc0108c20, "free_irq" },
+    { 0xc0108d30, "irq_enable" },
+    { 0xc0108d50, "irq_disable" },
+    { 0xc0108d70, "irq_eoi" },
+    { 0xc0108d90, "irq_set_affinity" },
+    { 0xc0108db0, "irq_chip_name" },
+    { 0xc0108dc0, "register_char_device" },
+    { 0xc0108e90, "unregister_char_device" },
+    { 0xc0108f20, "cread" },
+    { 0xc0108fa0, "cwrite" },
+    { 0xc0109020, "char_ioctl" },
+    { 0xc01090a0, "vga_emit" },
+    { 0xc0109200, "vga_write_buf" },
+    { 0xc0109260, "vga_read" },
+    { 0xc0109270, "vga_write" },
+    { 0xc01092c0, "vga_set_cursor" },
+    { 0xc0109320, "vga_get_cursor" },
+    { 0xc0109370, "vga_set_color" },
+    { 0xc0109380, "vga_clear" },
+    { 0xc01093e0, "vga_putchar" },
+    { 0xc0109430, "vga_init" },
+    { 0xc0109500, "tty_newline" },
+    { 0xc01095c0, "tty_init" },
+    { 0xc0109650, "tty_read" },
+    { 0xc0109660, "tty_clear" },
+    { 0xc01096d0, "tty_ioctl" },
+    { 0xc0109700, "tty_set_color" },
+    { 0xc0109720, "tty_get_cursor" },
+    { 0xc0109750, "tty_set_cursor" },
+    { 0xc0109790, "tty_putchar" },
+    { 0xc0109e70, "tty_write_cb" },
+    { 0xc0109e90, "tty_puts" },
+    { 0xc0109ec0, "kbd_write" },
+    { 0xc0109ed0, "kbd_ioctl" },
+    { 0xc0109ee0, "kbd_init" },
+    { 0xc0109f40, "kbd_irq" },
+    { 0xc010a080, "kbd_read" },
+    { 0xc010a0c0, "kbd_register_hotkey" },
+    { 0xc010a120, "pit_read" },
+    { 0xc010a130, "pit_write" },
+    { 0xc010a140, "pit_irq" },
+    { 0xc010a170, "pit_initcall" },
+    { 0xc010a1e0, "pit_get_ticks" },
+    { 0xc010a1f0, "pit_init" },
+    { 0xc010a290, "uart_ioctl" },
+    { 0xc010a2a0, "uart_read" },
+    { 0xc010a310, "uart_init" },
+    { 0xc010a5e0, "uart_tx_fill" },
+    { 0xc010a6e0, "uart_irq" },
+    { 0xc010a7d0, "uart_write_buf" },
+    { 0xc010ab80, "uart_write" },
+    { 0xc010abb0, "uart_console_write" },
+    { 0xc010ac30, "uart_console_write1" },
+    { 0xc010ac50, "uart_console_write0" },
+    { 0xc010ac70, "dev_write" },
+    { 0xc010ad10, "bread_fill" },
+    { 0xc010ade0, "register_block_device" },
+    { 0xc010aeb0, "unregister_block_device" },
+    { 0xc010af40, "bread" },
+    { 0xc010b140, "bwrite" },
+    { 0xc010b370, "bsync" },
+    { 0xc010b380, "bwrite_direct" },
+    { 0xc010b410, "block_max_blocks" },
+    { 0xc010b470, "block_ioctl" },
+    { 0xc010b4f0, "bget" },
+    { 0xc010b580, "bread_ref" },
+    { 0xc010b690, "bmark_dirty" },
+    { 0xc010b6a0, "brelse" },
+    { 0xc010b6c0, "ide_probe_finish" },
+    { 0xc010b760, "ide_probe_drive" },
+    { 0xc010b8b0, "ide_read_sectors" },
+    { 0xc010ba20, "ide_block_read" },
+    { 0xc010ba70, "ide_write_sectors" },
+    { 0xc010bbe0, "ide_block_write" },
+    { 0xc010bc30, "ide_print_disks" },
+    { 0xc010bc80, "ide_init" },
+    { 0xc010bd60, "find_entry" },
+    { 0xc010bde0, "put_slot" },
+    { 0xc010bf10, "writeback_entry" },
+    { 0xc010bfa0, "dirty_cmp" },
+    { 0xc010bfe0, "set_dirty.part.0" },
+    { 0xc010c070, "forget_ghost" },
+    { 0xc010c110, "unhash_entry" },
+    { 0xc010c200, "shrink_list" },
+    { 0xc010c3b0, "new_entry" },
+    { 0xc010ca00, "cache_shrink_scan" },
+    { 0xc010ca40, "write_dirty" },
+    { 0xc010ce60, "flush_work_fn" },
+    { 0xc010cee0, "balance_dirty" },
+    { 0xc010cf50, "invalidate_list" },
+    { 0xc010cff0, "cache_set_limits" },
+    { 0xc010d090, "cache_init" },
+    { 0xc010d350, "cache_lookup" },
+    { 0xc010d450, "cache_insert" },
+    { 0xc010d510, "cache_get" },
+    { 0xc010d640, "cache_put" },
+    { 0xc010d690, "cache_dirty" },
+    { 0xc010d700, "cache_mark_dirty" },
+    { 0xc010d7b0, "cache_write" },
+    { 0xc010d890, "cache_sync" },
+    { 0xc010d8c0, "cache_flush" },
+    { 0xc010d8f0, "cache_set_writeback" },
+    { 0xc010d930, "cache_writeback" },
+    { 0xc010d940, "cache_set_policy" },
+    { 0xc010daa0, "cache_policy" },
+    { 0xc010dab0, "cache_invalidate" },
+    { 0xc010db30, "cache_invalidate_device" },
+    { 0xc010db90, "cache_stats" },
+    { 0xc010dbd0, "cache_ghost_hits" },
+    { 0xc010dbe0, "cache_usage" },
+    { 0xc010dc20, "cache_dirty_count" },
+    { 0xc010dc30, "cache_wb_stats" },
+    { 0xc010dc70, "part_block_write" },
+    { 0xc010dcf0, "part_block_read" },
+    { 0xc010dd70, "mbr_parse_disk" },
+    { 0xc010de70, "mbr_init" },
+    { 0xc010dfc0, "mbr_print_partitions" },
+    { 0xc010e140, "mbr_initcall" },
+    { 0xc010e150, "mbr_get_partition_info" },
+    { 0xc010e190, "mbr_read_partition" },
+    { 0xc010e250, "mbr_write_partition" },
+    { 0xc010e310, "vfs_init" },
+    { 0xc010e370, "resolve_mount" },
+    { 0xc010e470, "register_filesystem" },
+    { 0xc010e560, "fs_mount" },
+    { 0xc010e6c0, "fs_unmount" },
+    { 0xc010e790, "fs_open" },
+    { 0xc010e960, "fs_close" },
+    { 0xc010ea10, "fs_read" },
+    { 0xc010eac0, "fs_write" },
+    { 0xc010eb70, "fs_seek" },
+    { 0xc010ec20, "fs_truncate" },
+    { 0xc010ec80, "fs_readdir" },
+    { 0xc010ece0, "fs_mkdir" },
+    { 0xc010ed90, "fs_rmdir" },
+    { 0xc010ee30, "fs_unlink" },
+    { 0xc010eed0, "fs_rename" },
+    { 0xc010eff0, "fs_stat" },
+    { 0xc010f0b0, "fs_chdir" },
+    { 0xc010f1f0, "fs_getcwd" },
+    { 0xc010f250, "resolve_path" },
+    { 0xc010f530, "devfs_unmount" },
+    { 0xc010f540, "devfs_seek" },
+    { 0xc010f5c0, "devfs_truncate" },
+    { 0xc010f5d0, "devfs_mkdir" },
+    { 0xc010f5e0, "devfs_rmdir" },
+    { 0xc010f5f0, "devfs_rename" },
+    { 0xc010f600, "devfs_mount" },
+    { 0xc010f630, "devfs_write" },
+    { 0xc010f740, "devfs_read" },
+    { 0xc010f850, "devfs_close" },
+    { 0xc010f890, "devfs_open" },
+    { 0xc010fa30, "devfs_readdir" },
+    { 0xc010fae0, "devfs_init" },
+    { 0xc010fb50, "devfs_unlink" },
+    { 0xc010fb60, "devfs_add_node" },
+    { 0xc010fca0, "devfs_stat" },
+    { 0xc010fde0, "devfs_register_device" },
+    { 0xc010fe30, "devfs_register_file" },
+    { 0xc010fe60, "devfs_unregister_device" },
+    { 0xc010fef3, "_text_end" },
+};
+
+const uint32_t ksym_count = 419;
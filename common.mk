@@ -8,6 +8,11 @@ CC      = gcc
 CFLAGS  = -c -ffreestanding -nostdlib -fno-builtin -fno-stack-protector \
           -fno-pie -mno-red-zone -O2 -Wall -Wextra -fno-pic -m32
 
+# make FRAME_POINTER=1 keeps EBP chains so the profiler can record callchains
+ifeq ($(FRAME_POINTER),1)
+CFLAGS += -fno-omit-frame-pointer
+endif
+
 LDFLAGS = -T linker.ld -ffreestanding -nostdlib -fno-builtin -fno-stack-protector \
           -fno-pie -mno-red-zone -O2 -Wall -Wextra -fno-pic -m32
 
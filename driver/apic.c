@@ -0,0 +1,462 @@
+#include "driver/apic.h"
+#include "kernel/cpu.h"
+#include "kernel/asm.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * MP specification structures
+ * ========================================================================= */
+
+/* MP floating pointer structure (16 bytes, 16-byte aligned) */
+typedef struct {
+    char     signature[4];      /* "_MP_"                               */
+    uint32_t config_table;      /* physical address of the config table */
+    uint8_t  length;            /* in 16-byte units (1)                 */
+    uint8_t  spec_rev;
+    uint8_t  checksum;
+    uint8_t  features[5];       /* features[1] bit 7: IMCR present      */
+} __attribute__((packed)) mp_fps_t;
+
+/* MP configuration table header */
+typedef struct {
+    char     signature[4];      /* "PCMP" */
+    uint16_t base_length;
+    uint8_t  spec_rev;
+    uint8_t  checksum;
+    char     oem_id[8];
+    char     product_id[12];
+    uint32_t oem_table;
+    uint16_t oem_table_size;
+    uint16_t entry_count;
+    uint32_t lapic_addr;
+    uint16_t ext_length;
+    uint8_t  ext_checksum;
+    uint8_t  reserved;
+} __attribute__((packed)) mp_config_t;
+
+#define MP_ENTRY_PROCESSOR  0     /* 20 bytes */
+#define MP_ENTRY_BUS        1     /*  8 bytes */
+#define MP_ENTRY_IOAPIC     2     /*  8 bytes */
+#define MP_ENTRY_IOINT      3     /*  8 bytes */
+#define MP_ENTRY_LINT       4     /*  8 bytes */
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  apic_id;
+    uint8_t  apic_version;
+    uint8_t  cpu_flags;         /* bit 0: enabled, bit 1: BSP */
+    uint32_t signature;
+    uint32_t feature_flags;
+    uint32_t reserved[2];
+} __attribute__((packed)) mp_processor_t;
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  bus_id;
+    char     bus_type[6];       /* "ISA   ", "PCI   ", ... */
+} __attribute__((packed)) mp_bus_t;
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  id;
+    uint8_t  version;
+    uint8_t  flags;             /* bit 0: enabled */
+    uint32_t addr;
+} __attribute__((packed)) mp_ioapic_t;
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  int_type;          /* 0 = vectored INT */
+    uint16_t flags;             /* bits 0-1 polarity, bits 2-3 trigger */
+    uint8_t  src_bus;
+    uint8_t  src_irq;
+    uint8_t  dst_ioapic;
+    uint8_t  dst_pin;
+} __attribute__((packed)) mp_ioint_t;
+
+#define MP_POLARITY_MASK   0x03
+#define MP_POLARITY_LOW    0x03
+#define MP_TRIGGER_MASK    0x0C
+#define MP_TRIGGER_LEVEL   0x0C
+
+/* =========================================================================
+ * Driver state
+ * ========================================================================= */
+
+#define APIC_MAX_CPUS     16
+#define MAX_IOAPICS       4
+#define MAX_MP_BUSES      32
+
+typedef struct {
+    uint8_t           id;
+    volatile uint32_t *base;    /* mapped register window   */
+    uint32_t          gsi_base; /* first GSI handled        */
+    uint32_t          pins;     /* redirection entries      */
+} ioapic_t;
+
+/* Where an IRQ is wired and how it must be programmed */
+typedef struct {
+    uint32_t gsi;
+    uint32_t rte_flags;         /* IOAPIC_RTE_ACTIVE_LOW | IOAPIC_RTE_LEVEL */
+    uint8_t  dest;              /* destination APIC ID */
+    uint8_t  enabled;
+} irq_route_t;
+
+static volatile uint32_t *lapic_base = NULL;
+
+static ioapic_t ioapics[MAX_IOAPICS];
+static int      nr_ioapics = 0;
+
+static uint8_t  cpu_apic_ids[APIC_MAX_CPUS];
+static int      nr_apic_cpus = 0;
+
+static uint8_t  isa_bus[MAX_MP_BUSES];   /* 1 if MP bus id is ISA/EISA */
+
+static irq_route_t irq_routes[NR_IRQS];
+
+#define IRQ_NO_GSI  0xFFFFFFFFU   /* line not wired to any IOAPIC pin */
+
+extern void spurious_irq(void);   /* defined in kernel/isr.s */
+
+/* =========================================================================
+ * Register access
+ * ========================================================================= */
+
+static inline uint32_t lapic_read(uint32_t reg)
+{
+    return lapic_base[reg / 4];
+}
+
+static inline void lapic_write(uint32_t reg, uint32_t val)
+{
+    lapic_base[reg / 4] = val;
+    (void)lapic_base[LAPIC_ID / 4];   /* wait for the write to post */
+}
+
+static uint32_t ioapic_read(ioapic_t *io, uint8_t reg)
+{
+    io->base[IOAPIC_REGSEL / 4] = reg;
+    return io->base[IOAPIC_WIN / 4];
+}
+
+static void ioapic_write(ioapic_t *io, uint8_t reg, uint32_t val)
+{
+    io->base[IOAPIC_REGSEL / 4] = reg;
+    io->base[IOAPIC_WIN / 4]    = val;
+}
+
+/* Find the I/O APIC serving a GSI; *pin receives the pin on that chip */
+static ioapic_t *ioapic_for_gsi(uint32_t gsi, uint32_t *pin)
+{
+    for (int i = 0; i < nr_ioapics; i++) {
+        ioapic_t *io = &ioapics[i];
+        if (gsi >= io->gsi_base && gsi < io->gsi_base + io->pins) {
+            *pin = gsi - io->gsi_base;
+            return io;
+        }
+    }
+    return NULL;
+}
+
+/* Write the redirection entry for irq from its routing state */
+static void ioapic_program(uint8_t irq)
+{
+    irq_route_t *rt = &irq_routes[irq];
+    uint32_t pin;
+    ioapic_t *io = ioapic_for_gsi(rt->gsi, &pin);
+    if (!io)
+        return;
+
+    uint32_t lo = (IRQ_VECTOR_BASE + irq) | rt->rte_flags;
+    if (!rt->enabled)
+        lo |= IOAPIC_RTE_MASKED;
+
+    /* Mask first so the entry never fires half-written */
+    ioapic_write(io, IOAPIC_REG_REDTBL + 2 * pin, IOAPIC_RTE_MASKED);
+    ioapic_write(io, IOAPIC_REG_REDTBL + 2 * pin + 1, (uint32_t)rt->dest << 24);
+    ioapic_write(io, IOAPIC_REG_REDTBL + 2 * pin, lo);
+}
+
+/* =========================================================================
+ * MP table discovery
+ * ========================================================================= */
+
+static uint8_t mp_checksum(const void *p, uint32_t len)
+{
+    const uint8_t *b = p;
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < len; i++)
+        sum += b[i];
+    return sum;
+}
+
+/* Search [phys, phys + len) for a valid floating pointer structure */
+static mp_fps_t *mp_scan(uint32_t phys, uint32_t len)
+{
+    for (uint32_t p = phys; p + sizeof(mp_fps_t) <= phys + len; p += 16) {
+        mp_fps_t *fps = (mp_fps_t *)(p + KERNEL_VMA);
+        if (memcmp(fps->signature, "_MP_", 4) == 0 &&
+            fps->length == 1 &&
+            mp_checksum(fps, sizeof(mp_fps_t)) == 0)
+            return fps;
+    }
+    return NULL;
+}
+
+static mp_fps_t *mp_find(void)
+{
+    mp_fps_t *fps;
+
+    /* 1. First KB of the Extended BIOS Data Area */
+    uint32_t ebda = (uint32_t)*(volatile uint16_t *)(0x40E + KERNEL_VMA) << 4;
+    if (ebda && (fps = mp_scan(ebda, 1024)) != NULL)
+        return fps;
+
+    /* 2. Last KB of base memory */
+    uint32_t base_kb = *(volatile uint16_t *)(0x413 + KERNEL_VMA);
+    if (base_kb && (fps = mp_scan(base_kb * 1024 - 1024, 1024)) != NULL)
+        return fps;
+
+    /* 3. BIOS ROM */
+    return mp_scan(0xF0000, 0x10000);
+}
+
+static void mp_parse_routes(mp_config_t *cfg)
+{
+    uint8_t *entry = (uint8_t *)(cfg + 1);
+    uint8_t *end   = (uint8_t *)cfg + cfg->base_length;
+
+    while (entry < end) {
+        switch (*entry) {
+        case MP_ENTRY_PROCESSOR: {
+            mp_processor_t *cpu = (mp_processor_t *)entry;
+            if ((cpu->cpu_flags & 1) && nr_apic_cpus < APIC_MAX_CPUS)
+                cpu_apic_ids[nr_apic_cpus++] = cpu->apic_id;
+            entry += sizeof(mp_processor_t);
+            break;
+        }
+        case MP_ENTRY_BUS: {
+            mp_bus_t *bus = (mp_bus_t *)entry;
+            if (bus->bus_id < MAX_MP_BUSES)
+                isa_bus[bus->bus_id] = memcmp(bus->bus_type, "ISA", 3) == 0 ||
+                                       memcmp(bus->bus_type, "EISA", 4) == 0;
+            entry += sizeof(mp_bus_t);
+            break;
+        }
+        case MP_ENTRY_IOAPIC: {
+            mp_ioapic_t *ent = (mp_ioapic_t *)entry;
+            if ((ent->flags & 1) && nr_ioapics < MAX_IOAPICS) {
+                ioapic_t *io = &ioapics[nr_ioapics];
+                io->id   = ent->id;
+                io->base = mmio_map(ent->addr, 0x20);
+                if (io->base) {
+                    io->pins     = ((ioapic_read(io, IOAPIC_REG_VER) >> 16) & 0xFF) + 1;
+                    io->gsi_base = nr_ioapics ? ioapics[nr_ioapics - 1].gsi_base +
+                                                ioapics[nr_ioapics - 1].pins : 0;
+                    nr_ioapics++;
+                }
+            }
+            entry += sizeof(mp_ioapic_t);
+            break;
+        }
+        case MP_ENTRY_IOINT:
+        case MP_ENTRY_LINT:
+            entry += 8;
+            break;
+        default:
+            /* Unknown entry type: its length is unknown, stop here */
+            return;
+        }
+    }
+}
+
+/*
+ * Apply ISA interrupt source overrides (e.g. IRQ0 wired to pin 2).
+ * Runs as a second pass because bus and IOAPIC entries may follow the
+ * interrupt entries that reference them.  PCI interrupt entries are
+ * skipped: without a PCI driver nothing asks for those lines.
+ */
+static void mp_parse_overrides(mp_config_t *cfg)
+{
+    uint8_t *entry = (uint8_t *)(cfg + 1);
+    uint8_t *end   = (uint8_t *)cfg + cfg->base_length;
+
+    while (entry < end) {
+        if (*entry == MP_ENTRY_PROCESSOR) {
+            entry += sizeof(mp_processor_t);
+            continue;
+        }
+        if (*entry > MP_ENTRY_LINT)
+            return;
+
+        if (*entry == MP_ENTRY_IOINT) {
+            mp_ioint_t *ent = (mp_ioint_t *)entry;
+            if (ent->int_type == 0 && ent->src_bus < MAX_MP_BUSES &&
+                isa_bus[ent->src_bus] && ent->src_irq < 16) {
+                for (int i = 0; i < nr_ioapics; i++) {
+                    if (ioapics[i].id != ent->dst_ioapic)
+                        continue;
+
+                    irq_route_t *rt = &irq_routes[ent->src_irq];
+                    rt->gsi       = ioapics[i].gsi_base + ent->dst_pin;
+                    rt->rte_flags = 0;
+                    if ((ent->flags & MP_POLARITY_MASK) == MP_POLARITY_LOW)
+                        rt->rte_flags |= IOAPIC_RTE_ACTIVE_LOW;
+                    if ((ent->flags & MP_TRIGGER_MASK) == MP_TRIGGER_LEVEL)
+                        rt->rte_flags |= IOAPIC_RTE_LEVEL;
+                    break;
+                }
+            }
+        }
+        entry += 8;
+    }
+}
+
+/* =========================================================================
+ * irq_chip callbacks
+ * ========================================================================= */
+
+static void apic_eoi(uint8_t irq)
+{
+    (void)irq;
+    lapic_eoi();
+}
+
+static void apic_enable(uint8_t irq)
+{
+    if (irq >= NR_IRQS)
+        return;
+    irq_routes[irq].enabled = 1;
+    ioapic_program(irq);
+}
+
+static void apic_disable(uint8_t irq)
+{
+    if (irq >= NR_IRQS)
+        return;
+    irq_routes[irq].enabled = 0;
+    ioapic_program(irq);
+}
+
+static int apic_set_affinity(uint8_t irq, int cpu)
+{
+    if (irq >= NR_IRQS || cpu < 0 || cpu >= nr_apic_cpus)
+        return -1;
+    irq_routes[irq].dest = cpu_apic_ids[cpu];
+    ioapic_program(irq);
+    return 0;
+}
+
+const irq_chip_t apic_irq_chip = {
+    .name         = "IOAPIC",
+    .eoi          = apic_eoi,
+    .enable       = apic_enable,
+    .disable      = apic_disable,
+    .set_affinity = apic_set_affinity,
+};
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void lapic_eoi(void)
+{
+    lapic_base[LAPIC_EOI / 4] = 0;
+}
+
+uint8_t lapic_id(void)
+{
+    return (uint8_t)(lapic_read(LAPIC_ID) >> 24);
+}
+
+int apic_init(void)
+{
+    if (!cpu_has(X86_FEATURE_APIC)) {
+        printk("[APIC] No local APIC, using 8259A\n");
+        return -1;
+    }
+
+    mp_fps_t *fps = mp_find();
+    if (!fps || fps->config_table == 0 || fps->config_table >= 0x40000000) {
+        /* Default configurations (no table) are not supported */
+        printk("[APIC] No MP configuration table, using 8259A\n");
+        return -1;
+    }
+
+    mp_config_t *cfg = (mp_config_t *)(fps->config_table + KERNEL_VMA);
+    if (memcmp(cfg->signature, "PCMP", 4) != 0 ||
+        mp_checksum(cfg, cfg->base_length) != 0) {
+        printk("[APIC] Bad MP configuration table, using 8259A\n");
+        return -1;
+    }
+
+    /* Local APIC: prefer the MSR, which reflects any relocation */
+    uint32_t lapic_phys = cfg->lapic_addr;
+    if (cpu_has(X86_FEATURE_MSR)) {
+        uint64_t msr = rdmsr(MSR_APIC_BASE);
+        lapic_phys = (uint32_t)msr & 0xFFFFF000;
+        wrmsr(MSR_APIC_BASE, msr | MSR_APIC_BASE_ENABLE);
+    }
+
+    mp_parse_routes(cfg);
+    if (nr_ioapics == 0) {
+        printk("[APIC] No I/O APIC, using 8259A\n");
+        return -1;
+    }
+
+    lapic_base = mmio_map(lapic_phys, 0x400);
+    if (!lapic_base) {
+        printk("[APIC] Cannot map local APIC, using 8259A\n");
+        return -1;
+    }
+    if (nr_apic_cpus == 0)
+        cpu_apic_ids[nr_apic_cpus++] = lapic_id();
+
+    /* ISA IRQs are identity mapped, active high, edge triggered... */
+    uint8_t boot_id = lapic_id();
+    for (int irq = 0; irq < NR_IRQS; irq++) {
+        irq_routes[irq].gsi       = irq;
+        irq_routes[irq].rte_flags = irq < 16 ? 0 : IOAPIC_RTE_ACTIVE_LOW | IOAPIC_RTE_LEVEL;
+        irq_routes[irq].dest      = boot_id;
+        irq_routes[irq].enabled   = 0;
+    }
+    /* ...unless the firmware says otherwise */
+    mp_parse_overrides(cfg);
+
+    /* An override can take over another IRQ's pin (IRQ0 -> pin 2 evicts IRQ2) */
+    for (int irq = 0; irq < 16; irq++) {
+        for (int other = 0; other < 16; other++) {
+            if (other != irq && irq_routes[other].gsi == (uint32_t)irq &&
+                irq_routes[irq].gsi == (uint32_t)irq) {
+                irq_routes[irq].gsi = IRQ_NO_GSI;
+                break;
+            }
+        }
+    }
+
+    /* Leave PIC mode through the IMCR if the board has one */
+    if (fps->features[1] & 0x80) {
+        outb(0x22, 0x70);
+        outb(0x23, 0x01);
+    }
+
+    /* Local APIC: accept everything, mask LVTs we don't use */
+    idt_set_gate(SPURIOUS_VECTOR, (uint32_t)spurious_irq, GDT_KERNEL_CODE, IDT_GATE_INT32);
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_NMI);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VECTOR);
+
+    /* Every line starts masked and aimed at the boot CPU */
+    for (int irq = 0; irq < NR_IRQS; irq++)
+        ioapic_program(irq);
+
+    printk("[APIC] LAPIC id %d at 0x%08x, %d I/O APIC%s, %d CPU%s\n",
+           boot_id, lapic_phys, nr_ioapics, nr_ioapics > 1 ? "s" : "",
+           nr_apic_cpus, nr_apic_cpus > 1 ? "s" : "");
+    return 0;
+}
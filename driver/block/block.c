@@ -1,7 +1,7 @@
 #include "driver/block/block.h"
 #include "driver/block/cache.h"
-#include "driver/block/ide.h"
-#include "driver/block/part_mbr.h"
+#include "kernel/rcu.h"
+#include "kernel/trace.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -9,6 +9,9 @@
  * Block device registry
  *
  * Uses a static fixed-size array so registration is allocation-free.
+ * Lookups run on every bread/bwrite and are lock-free under RCU: a slot is
+ * published only after its ops are written, and a retired slot is reused
+ * only after a grace period.
  * ========================================================================= */
 
 #define MAX_BLOCK_DEVICES 16
@@ -21,14 +24,18 @@ typedef struct {
 
 static block_device_t block_devices[MAX_BLOCK_DEVICES];
 
+DEFINE_TRACE_EVENT(bread,  "dev=%d minor=%d blk=%u count=%u");
+DEFINE_TRACE_EVENT(bwrite, "dev=%d minor=%d blk=%u count=%u");
+
 /* -------------------------------------------------------------------------
- * Internal lookup
+ * Internal lookup – caller must hold rcu_read_lock()
  * ------------------------------------------------------------------------- */
 
 static block_device_t *find_block_device(int prim_id)
 {
     for (int i = 0; i < MAX_BLOCK_DEVICES; i++) {
-        if (block_devices[i].in_use && block_devices[i].prim_id == prim_id)
+        if (rcu_slot_live(&block_devices[i].in_use) &&
+            block_devices[i].prim_id == prim_id)
             return &block_devices[i];
     }
     return NULL;
@@ -43,79 +50,287 @@ int register_block_device(int prim_id, block_ops_t *ops)
     if (!ops || prim_id < 0 || prim_id > 255)
         return -1;
 
-    if (find_block_device(prim_id))
+    rcu_read_lock();
+    block_device_t *dup = find_block_device(prim_id);
+    rcu_read_unlock();
+    if (dup)
         return -1;   /* already registered */
 
     for (int i = 0; i < MAX_BLOCK_DEVICES; i++) {
         if (!block_devices[i].in_use) {
             block_devices[i].prim_id = prim_id;
             block_devices[i].ops    = *ops;
-            block_devices[i].in_use = 1;
+            rcu_publish_slot(&block_devices[i].in_use);
             return 0;
         }
     }
     return -1;   /* table full */
 }
 
+int unregister_block_device(int prim_id)
+{
+    rcu_read_lock();
+    block_device_t *dev = find_block_device(prim_id);
+    rcu_read_unlock();
+    if (!dev)
+        return -1;
+
+    /* Write back and drop cached blocks while the driver is still live */
+    cache_invalidate_device(prim_id);
+
+    rcu_retire_slot(&dev->in_use);
+    synchronize_rcu();   /* no bread/bwrite can still be using dev->ops */
+    return 0;
+}
+
 /* =========================================================================
- * Public API – I/O (with LRU cache)
+ * Public API – I/O (through the block cache)
+ *
+ * Block numbers are in CACHE_BLOCK_SIZE units.  The read-side RCU section
+ * spans the driver calls, so unregister_block_device() waits for them.
  * ========================================================================= */
 
+/* Largest request for the driver at a time, out of count blocks */
+static uint32_t dev_chunk(const block_device_t *dev, uint32_t count)
+{
+    uint32_t max = dev->ops.max_blocks;
+    return max && count > max ? max : count;
+}
+
+/* Write [offset, offset + count) through the driver in chunks it takes */
+static int dev_write(block_device_t *dev, int scnd_id, const uint8_t *src,
+                     uint32_t offset, uint32_t count)
+{
+    while (count) {
+        uint32_t n = dev_chunk(dev, count);
+        if (dev->ops.write(dev->prim_id, scnd_id, src, offset, n) != (int)(n * CACHE_BLOCK_SIZE))
+            return -1;
+        src    += n * CACHE_BLOCK_SIZE;
+        offset += n;
+        count  -= n;
+    }
+    return 0;
+}
+
+/* Read [offset, offset + count) from the driver, in chunks of at most
+ * max_blocks, and cache what arrived */
+static int bread_fill(block_device_t *dev, int scnd_id, uint8_t *buf,
+                      uint32_t offset, uint32_t count)
+{
+    while (count) {
+        uint32_t n   = dev_chunk(dev, count);
+        int      ret = dev->ops.read(dev->prim_id, scnd_id, buf, offset, n);
+        if (ret != (int)(n * CACHE_BLOCK_SIZE))
+            return -1;
+
+        for (uint32_t i = 0; i < n; i++)
+            cache_insert(dev->prim_id, scnd_id, offset + i, buf + i * CACHE_BLOCK_SIZE);
+        buf    += n * CACHE_BLOCK_SIZE;
+        offset += n;
+        count  -= n;
+    }
+    return 0;
+}
+
 int bread(int prim_id, int scnd_id, void *buf, uint32_t offset, size_t count)
 {
+    TRACE(bread, prim_id, scnd_id, offset, count);
+
+    rcu_read_lock();
     block_device_t *dev = find_block_device(prim_id);
-    if (!dev || !dev->ops.read)
+    if (!dev || !dev->ops.read) {
+        rcu_read_unlock();
         return -1;
+    }
 
-    /* Try cache first for single-block reads at offset 0 */
-    if (count == 1 && offset == 0) {
-        if (cache_lookup(prim_id, scnd_id, 0, buf))
-            return CACHE_BLOCK_SIZE;
+    if (dev->ops.flags & BLOCK_NOCACHE) {
+        int ret = dev->ops.read(prim_id, scnd_id, buf, offset, count);
+        rcu_read_unlock();
+        return ret;
     }
 
-    int ret = dev->ops.read(prim_id, scnd_id, buf, offset, count);
+    /*
+     * Walk the request: hits are copied out by cache_lookup() as we go,
+     * and each run of misses is fetched with one driver call when the
+     * next hit (or the end) is reached.
+     */
+    uint8_t *dst  = (uint8_t *)buf;
+    uint32_t run  = 0;             /* misses pending before block i */
+    int      ret  = (int)(count * CACHE_BLOCK_SIZE);
 
-    if (ret > 0 && count == 1 && offset == 0)
-        cache_insert(prim_id, scnd_id, 0, buf);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!cache_lookup(prim_id, scnd_id, offset + i, dst + i * CACHE_BLOCK_SIZE)) {
+            run++;
+            continue;
+        }
+        if (run && bread_fill(dev, scnd_id, dst + (i - run) * CACHE_BLOCK_SIZE,
+                              offset + i - run, run) < 0) {
+            ret = -1;
+            break;
+        }
+        run = 0;
+    }
+    if (ret > 0 && run &&
+        bread_fill(dev, scnd_id, dst + (count - run) * CACHE_BLOCK_SIZE,
+                   offset + (uint32_t)count - run, run) < 0)
+        ret = -1;
 
+    rcu_read_unlock();
+    return ret;
+}
+
+/*
+ * Write-back: the blocks go into the cache dirty.  Any that find no
+ * slot are written now, one driver call per run of them.
+ */
+static int bwrite_back(block_device_t *dev, int scnd_id, const uint8_t *src,
+                       uint32_t offset, size_t count)
+{
+    uint32_t run = 0;              /* uncached blocks pending before i */
+    int      ret = (int)(count * CACHE_BLOCK_SIZE);
+
+    for (uint32_t i = 0; i <= count; i++) {
+        if (i < count &&
+            cache_write(dev->prim_id, scnd_id, offset + i, src + i * CACHE_BLOCK_SIZE) < 0) {
+            run++;
+            continue;
+        }
+        if (run && dev_write(dev, scnd_id, src + (i - run) * CACHE_BLOCK_SIZE,
+                             offset + i - run, run) < 0)
+            ret = -1;
+        run = 0;
+    }
     return ret;
 }
 
 int bwrite(int prim_id, int scnd_id, const void *buf,
            uint32_t offset, size_t count)
 {
+    TRACE(bwrite, prim_id, scnd_id, offset, count);
+
+    rcu_read_lock();
     block_device_t *dev = find_block_device(prim_id);
-    if (!dev || !dev->ops.write)
+    if (!dev || !dev->ops.write) {
+        rcu_read_unlock();
         return -1;
+    }
+
+    if (!(dev->ops.flags & BLOCK_NOCACHE) && cache_writeback()) {
+        int ret = bwrite_back(dev, scnd_id, (const uint8_t *)buf, offset, count);
+        rcu_read_unlock();
+        return ret;
+    }
+
+    int ret = dev_write(dev, scnd_id, (const uint8_t *)buf, offset, (uint32_t)count) < 0 ?
+              -1 : (int)(count * CACHE_BLOCK_SIZE);
 
-    int ret = dev->ops.write(prim_id, scnd_id, buf, offset, count);
+    if (!(dev->ops.flags & BLOCK_NOCACHE)) {
+        const uint8_t *src = (const uint8_t *)buf;
 
-    /* Write-through: update cache on single-block writes at offset 0 */
-    if (ret > 0 && count == 1 && offset == 0)
-        cache_insert(prim_id, scnd_id, 0, buf);
+        for (uint32_t i = 0; i < count; i++) {
+            if (ret == (int)(count * CACHE_BLOCK_SIZE))
+                cache_insert(prim_id, scnd_id, offset + i, src + i * CACHE_BLOCK_SIZE);
+            else
+                cache_invalidate(prim_id, scnd_id, offset + i);  /* unknown state */
+        }
+    }
+
+    rcu_read_unlock();
+    return ret;
+}
 
+int bsync(int prim_id)
+{
+    return cache_sync(prim_id);
+}
+
+int bwrite_direct(int prim_id, int scnd_id, const void *buf,
+                  uint32_t offset, size_t count)
+{
+    rcu_read_lock();
+    block_device_t *dev = find_block_device(prim_id);
+    int ret = -1;
+    if (dev && dev->ops.write)
+        ret = dev->ops.write(prim_id, scnd_id, buf, offset, count);
+    rcu_read_unlock();
     return ret;
 }
 
+uint32_t block_max_blocks(int prim_id)
+{
+    rcu_read_lock();
+    block_device_t *dev = find_block_device(prim_id);
+    uint32_t max = dev ? dev->ops.max_blocks : 0;
+    rcu_read_unlock();
+    return max;
+}
+
 int block_ioctl(int prim_id, int scnd_id, unsigned int command)
 {
+    rcu_read_lock();
     block_device_t *dev = find_block_device(prim_id);
-    if (!dev || !dev->ops.ioctl)
-        return -1;
-    return dev->ops.ioctl(prim_id, scnd_id, command);
+    int ret = -1;
+    if (dev && dev->ops.ioctl)
+        ret = dev->ops.ioctl(prim_id, scnd_id, command);
+    rcu_read_unlock();
+    return ret;
 }
 
 /* =========================================================================
- * Aggregator – initialise all block devices
- *
- * ide_init() self-registers IDE disks as block devices and populates
- * devfs nodes.  mbr_init() parses MBR partition tables and registers
- * partition block devices; mbr_print_partitions() reports the result.
+ * Public API – buffer references
  * ========================================================================= */
 
-void block_init(void)
+/* Cached device the buffer calls may use; caller holds rcu_read_lock() */
+static block_device_t *find_cached_device(int prim_id)
+{
+    block_device_t *dev = find_block_device(prim_id);
+    if (!dev || (dev->ops.flags & BLOCK_NOCACHE))
+        return NULL;
+    return dev;
+}
+
+cache_buf_t *bget(int prim_id, int scnd_id, uint32_t block)
+{
+    rcu_read_lock();
+    block_device_t *dev = find_cached_device(prim_id);
+    rcu_read_unlock();
+
+    return dev ? cache_get(prim_id, scnd_id, block, 1) : NULL;
+}
+
+cache_buf_t *bread_ref(int prim_id, int scnd_id, uint32_t block)
 {
-    ide_init();             /* detect, register, devfs: hda-hdd */
-    mbr_init();             /* parse MBR, register partition devs */
-    mbr_print_partitions(); /* print partition table summary      */
-}
\ No newline at end of file
+    TRACE(bread, prim_id, scnd_id, block, 1);
+
+    rcu_read_lock();
+    block_device_t *dev = find_cached_device(prim_id);
+    if (!dev || !dev->ops.read) {
+        rcu_read_unlock();
+        return NULL;
+    }
+
+    /* A miss is read straight into the buffer's cache slot */
+    cache_buf_t *b = cache_get(prim_id, scnd_id, block, 1);
+    if (b && !b->uptodate) {
+        if (dev->ops.read(prim_id, scnd_id, b->data, block, 1) == CACHE_BLOCK_SIZE) {
+            b->uptodate = 1;
+        } else {
+            cache_put(b);
+            b = NULL;
+        }
+    }
+
+    rcu_read_unlock();
+    return b;
+}
+
+void bmark_dirty(cache_buf_t *b)
+{
+    cache_dirty(b);
+}
+
+void brelse(cache_buf_t *b)
+{
+    if (b)
+        cache_put(b);
+}
@@ -1,94 +1,826 @@
 #include "driver/block/cache.h"
 #include "driver/driver.h"
 #include "mm/slab.h"
+#include "mm/buddy.h"
+#include "mm/shrinker.h"
 #include "lib/list.h"
+#include "lib/hash.h"
+#include "lib/string.h"
 #include "lib/printk.h"
+#include "kernel/initcall.h"
+#include "kernel/cmdline.h"
+#include "kernel/workqueue.h"
+#include "driver/char/pit.h"
+#include "kernel/asm.h"
+#include "kernel/trace.h"
 #include <stdint.h>
 #include <stddef.h>
 
 /* =========================================================================
  * LRU Cache Entry Structure
+ *
+ * Block data lives in whole pages, CACHE_BLOCKS_PER_PAGE blocks each.
+ * A cache_page_t (one kalloc) describes a data page and embeds the
+ * entries for its slots, so a cached block costs no allocation of its
+ * own and memory goes back to the page allocator a page at a time.
+ *
+ * A slot is taken while it holds a block or is referenced.  Dropping a
+ * referenced block (invalidation) only unhashes it; its slot is given
+ * back by the last cache_put().  Referenced blocks are never evicted.
+ *
+ * The page also carries the ghost entries of the 2Q policy (below): half
+ * as many as blocks, so the ghost list scales with the cache as well.
  * ========================================================================= */
 
+#define CACHE_BLOCKS_PER_PAGE  (PAGE_SIZE / CACHE_BLOCK_SIZE)
+#define CACHE_GHOSTS_PER_PAGE  (CACHE_BLOCKS_PER_PAGE / 2)
+
+struct cache_page;
+
 typedef struct cache_entry {
-    int      prim_id;           /* device primary ID   */
-    int      scnd_id;           /* device secondary ID */
-    uint32_t offset;            /* block number        */
-    uint8_t *data;              /* block data          */
+    cache_buf_t buf;            /* what bget() hands out; data is a slot
+                                 * of page->data */
+    uint32_t refcnt;            /* bget() references; pinned while > 0 */
     int      dirty;             /* 1 = needs write-back */
-    list_head_t node;           /* embedded in lru sentinel list */
+    uint32_t dirtied;           /* pit tick it became dirty */
+    uint32_t wb_errors;         /* failed write-backs since then */
+    list_head_t dirty_node;     /* in dirty_list while dirty */
+    int      valid;             /* in the index and lru_list/a1in_list */
+    int      a1in;              /* on a1in_list rather than lru_list */
+    list_head_t node;           /* in lru_list or a1in_list, or free_slots
+                                 * when the slot is not taken */
+    htable_node_t hnode;        /* in cache_index, keyed by cache_key() */
+    struct cache_page *page;    /* page this slot belongs to */
 } cache_entry_t;
 
+/* A block recently evicted from a1in_list: its key, no data */
+typedef struct cache_ghost {
+    int      prim_id;
+    int      scnd_id;
+    uint32_t block;
+    int      used;              /* in ghost_index and ghost_list */
+    list_head_t node;           /* in ghost_list, or free_ghosts */
+    htable_node_t hnode;        /* in ghost_index, keyed by cache_key() */
+} cache_ghost_t;
+
+typedef struct cache_page {
+    uint8_t      *data;         /* one page from page_alloc() */
+    uint32_t      used;         /* slots holding a block, or taken */
+    cache_entry_t slots[CACHE_BLOCKS_PER_PAGE];
+    cache_ghost_t ghosts[CACHE_GHOSTS_PER_PAGE];
+} cache_page_t;
+
 /* =========================================================================
  * Global Cache State
  *
  * lru_list is a sentinel; entries are ordered most→least recently used
  * (head->next is the MRU entry, head->prev is the LRU entry).
+ *
+ * cache_index holds the same entries hashed by (prim_id, scnd_id, block),
+ * so finding a block costs the same with 64 entries or 64K; it grows and
+ * shrinks with the entry count.
+ *
+ * The cache holds between min_pages and max_pages data pages.  Below
+ * min_pages it always grows; above, only while the page allocator has
+ * more than 1/CACHE_GROW_DIV of memory free, otherwise it recycles its
+ * LRU block.  When free memory drops under 1/CACHE_SHRINK_DIV, inserts
+ * hand pages back until the grow watermark is reached again, and the
+ * "blkcache" shrinker lets page_alloc() take clean pages when it runs
+ * out.  Neither goes below min_pages.
+ *
+ * dirty_list holds the dirty entries oldest first.  In write-back mode
+ * bwrite() only dirties cached blocks; flush_work writes them from the
+ * idle loop once they are CACHE_DIRTY_EXPIRE ticks old, or sooner while
+ * more than CACHE_DIRTY_BG_PCT of the cache is dirty.  Past
+ * CACHE_DIRTY_MAX_PCT the writer itself writes the oldest back before
+ * returning, so dirty data stays bounded when the disk cannot keep up.
+ * A block whose write-back fails stays dirty for the next pass, which
+ * goes on with the others; after CACHE_WB_RETRIES failures it is dropped
+ * with an error, so one bad block cannot hold up the rest for good.
+ *
+ * Each write-back pass picks its blocks by age, then sorts them by
+ * device and block number and writes runs of consecutive blocks with
+ * one request each, through wb_buf.  stat_wb_* count what that saves.
+ * A run that fails is written again block by block, and only the blocks
+ * that still fail go back to dirty_list, in age order.
  * ========================================================================= */
 
+/* =========================================================================
+ * Replacement Policy
+ *
+ * CACHE_POLICY_LRU keeps every block on lru_list and evicts its tail.
+ * One pass over a large device then pushes out everything else.
+ *
+ * CACHE_POLICY_2Q ("blkcache=MIN,MAX,2q", cache_set_policy()) is the full
+ * 2Q of Johnson and Shasha.  A block read in for the first time goes on
+ * a1in_list, a FIFO that hits do not reorder.  Only a block asked for
+ * again after it left a1in_list counts as hot and goes on lru_list (Am),
+ * the LRU part.  The ghost list (A1out, newest first) remembers the keys
+ * of blocks evicted from a1in_list, up to half as many as the cache
+ * holds; a miss that finds its key there goes straight to lru_list.
+ * Eviction takes the oldest a1in_list block while that list has more
+ * than CACHE_2Q_IN_PCT of the cache, otherwise the LRU block.  A
+ * sequential scan thus only ever cycles through a1in_list and the ghost
+ * list, and the hot blocks on lru_list stay.
+ * ========================================================================= */
+
+#define CACHE_INDEX_BITS  6     /* initial buckets: 64 */
+
+#define CACHE_MIN_KB      32    /* default floor: the old fixed 64 blocks */
+#define CACHE_MAX_DIV     4     /* default ceiling: 1/4 of memory         */
+#define CACHE_GROW_DIV    8     /* grow while free > total / 8            */
+#define CACHE_SHRINK_DIV  16    /* shrink when free < total / 16          */
+
+#define CACHE_FLUSH_INTERVAL  PIT_DEFAULT_HZ          /* flusher: every 1 s */
+#define CACHE_DIRTY_EXPIRE    (3 * PIT_DEFAULT_HZ)    /* write back at 3 s  */
+#define CACHE_DIRTY_BG_PCT    10    /* flush early above this much dirty  */
+#define CACHE_DIRTY_MAX_PCT   40    /* writers wait for the disk above    */
+#define CACHE_WB_MAX_BLOCKS   16    /* longest merged write (wb_buf)      */
+#define CACHE_WB_RETRIES      3     /* failed write-backs, then dropped   */
+
+#define CACHE_2Q_IN_PCT       25    /* a1in_list share of the cache (Kin) */
+
 static LIST_HEAD(lru_list);
+static LIST_HEAD(a1in_list);
+static LIST_HEAD(free_slots);
+static LIST_HEAD(dirty_list);
+static LIST_HEAD(ghost_list);
+static LIST_HEAD(free_ghosts);
+static htable_t cache_index;
+static htable_t ghost_index;
+static int      policy      = CACHE_POLICY_LRU;
 static uint32_t num_entries = 0;
+static uint32_t num_a1in    = 0;
+static uint32_t num_dirty   = 0;
+static int      writeback   = 0;    /* bwrite() leaves blocks dirty */
+static uint32_t num_pages   = 0;
+static uint32_t min_pages   = 0;
+static uint32_t max_pages   = 0;
 static uint32_t stat_hits   = 0;
 static uint32_t stat_misses = 0;
+static uint32_t stat_ghost_hits  = 0;   /* misses found on ghost_list */
+static uint32_t stat_wb_blocks   = 0;   /* blocks written back        */
+static uint32_t stat_wb_requests = 0;   /* driver writes they took    */
+
+static uint8_t wb_buf[CACHE_WB_MAX_BLOCKS * CACHE_BLOCK_SIZE];
+
+/* Non-zero while a public function is changing the lists; the shrinker
+ * can be called from page_alloc() in the middle of one (our own
+ * add_page(), or an interrupt handler) and must then leave us alone */
+static int cache_busy = 0;
+
+#define cache_enter()  do { cache_busy++; barrier(); } while (0)
+#define cache_leave()  do { barrier(); cache_busy--; } while (0)
+
+static void flush_work_fn(work_t *work);
+
+static work_t flush_work = {
+    .node    = LIST_HEAD_INIT(flush_work.node),
+    .fn      = flush_work_fn,
+};
+
+DEFINE_TRACE_EVENT(cache_lookup, "dev=%d minor=%d blk=%u hit=%u");
 
 /* =========================================================================
  * Internal Helper Functions
  * ========================================================================= */
 
-static void cache_memcpy(void *dest, const void *src, size_t n)
+static inline uint32_t cache_key(int prim_id, int scnd_id, uint32_t offset)
 {
-    uint8_t       *d = (uint8_t *)dest;
-    const uint8_t *s = (const uint8_t *)src;
-    for (size_t i = 0; i < n; i++)
-        d[i] = s[i];
+    uint64_t dev = ((uint32_t)prim_id << 16) | ((uint32_t)scnd_id & 0xFFFF);
+    return hash_64((dev << 32) | offset, 32);
 }
 
 static cache_entry_t *find_entry(int prim_id, int scnd_id, uint32_t offset)
 {
+    uint32_t       h = cache_key(prim_id, scnd_id, offset);
     cache_entry_t *e;
-    list_for_each_entry(e, &lru_list, node) {
-        if (e->prim_id == prim_id &&
-            e->scnd_id == scnd_id &&
-            e->offset  == offset)
+
+    if (!cache_index.buckets)
+        return NULL;
+
+    htable_for_each_possible(&cache_index, e, hnode, h) {
+        if (e->buf.prim_id == prim_id &&
+            e->buf.scnd_id == scnd_id &&
+            e->buf.block   == offset)
             return e;
     }
     return NULL;
 }
 
+/* =========================================================================
+ * Page and Slot Management
+ * ========================================================================= */
+
+static int add_page(void)
+{
+    cache_page_t *pg = (cache_page_t *)kalloc(sizeof(cache_page_t));
+    if (!pg)
+        return -1;
+
+    pg->data = (uint8_t *)page_alloc(PAGE_SIZE);
+    if (!pg->data) {
+        kfree(pg);
+        return -1;
+    }
+
+    pg->used = 0;
+    for (int i = 0; i < CACHE_BLOCKS_PER_PAGE; i++) {
+        cache_entry_t *e = &pg->slots[i];
+        e->page  = pg;
+        e->buf.data = pg->data + i * CACHE_BLOCK_SIZE;
+        e->refcnt   = 0;
+        e->valid    = 0;
+        e->a1in     = 0;
+        list_add_tail(&e->node, &free_slots);
+    }
+    for (int i = 0; i < CACHE_GHOSTS_PER_PAGE; i++) {
+        pg->ghosts[i].used = 0;
+        list_add_tail(&pg->ghosts[i].node, &free_ghosts);
+    }
+    num_pages++;
+    return 0;
+}
+
+/* All slots are free: take them off free_slots, forget the page's
+ * ghosts and release it */
+static void free_page(cache_page_t *pg)
+{
+    for (int i = 0; i < CACHE_BLOCKS_PER_PAGE; i++)
+        list_del(&pg->slots[i].node);
+    for (int i = 0; i < CACHE_GHOSTS_PER_PAGE; i++) {
+        cache_ghost_t *g = &pg->ghosts[i];
+        if (g->used)
+            htable_del(&ghost_index, &g->hnode);
+        list_del(&g->node);
+    }
+
+    page_free(pg->data);
+    kfree(pg);
+    num_pages--;
+}
+
+static int can_grow(void)
+{
+    if (num_pages >= max_pages)
+        return 0;
+    if (num_pages < min_pages)
+        return 1;
+    return buddy_free_pages() > buddy_total_pages() / CACHE_GROW_DIV;
+}
+
+/* =========================================================================
+ * Replacement
+ * ========================================================================= */
+
+static cache_ghost_t *find_ghost(int prim_id, int scnd_id, uint32_t offset)
+{
+    uint32_t       h = cache_key(prim_id, scnd_id, offset);
+    cache_ghost_t *g;
+
+    htable_for_each_possible(&ghost_index, g, hnode, h) {
+        if (g->prim_id == prim_id && g->scnd_id == scnd_id && g->block == offset)
+            return g;
+    }
+    return NULL;
+}
+
+static void forget_ghost(cache_ghost_t *g)
+{
+    htable_del(&ghost_index, &g->hnode);
+    g->used = 0;
+    list_move(&g->node, &free_ghosts);
+}
+
+/* Remember an evicted a1in_list block, recycling the oldest ghost */
+static void add_ghost(const cache_entry_t *entry)
+{
+    cache_ghost_t *g;
+
+    if (list_empty(&free_ghosts)) {
+        if (list_empty(&ghost_list))
+            return;
+        forget_ghost(list_last_entry(&ghost_list, cache_ghost_t, node));
+    }
+
+    g = list_first_entry(&free_ghosts, cache_ghost_t, node);
+    g->prim_id = entry->buf.prim_id;
+    g->scnd_id = entry->buf.scnd_id;
+    g->block   = entry->buf.block;
+    g->used    = 1;
+    list_move(&g->node, &ghost_list);
+    htable_add(&ghost_index, &g->hnode, cache_key(g->prim_id, g->scnd_id, g->block));
+}
+
+/* Put a new block on its list: lru_list, or under 2Q a1in_list unless
+ * hot says it was seen on the ghost list */
+static void queue_entry(cache_entry_t *entry, int hot)
+{
+    if (policy == CACHE_POLICY_2Q && !hot) {
+        entry->a1in = 1;
+        num_a1in++;
+        list_add(&entry->node, &a1in_list);
+    } else {
+        entry->a1in = 0;
+        list_add(&entry->node, &lru_list);
+    }
+}
+
+/* A hit: move to the MRU end, except on the a1in_list FIFO */
+static void touch_entry(cache_entry_t *entry)
+{
+    if (!entry->a1in)
+        list_move(&entry->node, &lru_list);
+}
+
+static void dequeue_entry(cache_entry_t *entry)
+{
+    list_del(&entry->node);
+    if (entry->a1in) {
+        entry->a1in = 0;
+        num_a1in--;
+    }
+}
+
+/* The two lists in the order the policy gives blocks up */
+static void victim_lists(list_head_t *order[2])
+{
+    uint32_t kin = num_pages * CACHE_BLOCKS_PER_PAGE * CACHE_2Q_IN_PCT / 100;
+
+    order[0] = num_a1in > kin ? &a1in_list : &lru_list;
+    order[1] = num_a1in > kin ? &lru_list : &a1in_list;
+}
+
+/* The oldest unreferenced clean block of a list, or NULL */
+static cache_entry_t *oldest_clean(list_head_t *list)
+{
+    cache_entry_t *entry;
+
+    list_for_each_entry_reverse(entry, list, node) {
+        if (!entry->refcnt && !entry->dirty)
+            return entry;
+    }
+    return NULL;
+}
+
+/* The clean block to make room with, or NULL if all are referenced or
+ * dirty (alloc_slot() then writes one back) */
+static cache_entry_t *pick_victim(void)
+{
+    list_head_t   *order[2];
+    cache_entry_t *entry;
+
+    victim_lists(order);
+    entry = oldest_clean(order[0]);
+    return entry ? entry : oldest_clean(order[1]);
+}
+
+/* =========================================================================
+ * Dirty Tracking
+ * ========================================================================= */
+
+/* Blocks the cache holds (or may hold at its floor) */
+static uint32_t dirty_capacity(void)
+{
+    uint32_t pages = num_pages > min_pages ? num_pages : min_pages;
+    return pages * CACHE_BLOCKS_PER_PAGE;
+}
+
+static int over_dirty(uint32_t pct)
+{
+    return num_dirty * 100 > dirty_capacity() * pct;
+}
+
+static void set_dirty(cache_entry_t *entry)
+{
+    if (entry->dirty)
+        return;
+
+    entry->dirty   = 1;
+    entry->dirtied = pit_get_ticks();
+    list_add_tail(&entry->dirty_node, &dirty_list);
+    num_dirty++;
+
+    if (over_dirty(CACHE_DIRTY_BG_PCT))
+        schedule_work(&flush_work);
+    else
+        schedule_delayed_work(&flush_work, CACHE_FLUSH_INTERVAL);
+}
+
+static void clear_dirty(cache_entry_t *entry)
+{
+    if (!entry->dirty)
+        return;
+
+    entry->dirty     = 0;
+    entry->wb_errors = 0;
+    list_del(&entry->dirty_node);
+    num_dirty--;
+}
+
+/* Unlink from its list and the index; the slot stays taken.  A dirty
+ * block that could not be written back is lost here. */
+static void unhash_entry(cache_entry_t *entry)
+{
+    clear_dirty(entry);
+    dequeue_entry(entry);
+    htable_del(&cache_index, &entry->hnode);
+    entry->valid = 0;
+    num_entries--;
+}
+
+/* Give a taken slot back; the page goes with its last block */
+static void put_slot(cache_entry_t *entry)
+{
+    cache_page_t *pg = entry->page;
+
+    list_add(&entry->node, &free_slots);
+    if (--pg->used == 0)
+        free_page(pg);
+}
+
+static void drop_entry(cache_entry_t *entry)
+{
+    unhash_entry(entry);
+    if (!entry->refcnt)
+        put_slot(entry);
+}
+
 static int writeback_entry(cache_entry_t *entry)
 {
     if (!entry->dirty)
         return 0;
 
-    int ret = bwrite(entry->prim_id, entry->scnd_id,
-                     entry->data, entry->offset, 1);
+    int ret = bwrite_direct(entry->buf.prim_id, entry->buf.scnd_id,
+                            entry->buf.data, entry->buf.block, 1);
     if (ret > 0) {
-        entry->dirty = 0;
+        stat_wb_blocks++;
+        stat_wb_requests++;
+        clear_dirty(entry);
         return 0;
     }
     return -1;
 }
 
-/* Evict the LRU (tail) entry */
-static int evict_lru(void)
+/* Back onto dirty_list at its place by age, which write_dirty() relies
+ * on; being among the oldest, it does not go far from the head */
+static void requeue_dirty(cache_entry_t *entry)
 {
-    if (list_empty(&lru_list))
-        return -1;
+    cache_entry_t *e;
+
+    list_for_each_entry(e, &dirty_list, dirty_node) {
+        if ((int32_t)(e->dirtied - entry->dirtied) > 0)
+            break;
+    }
+    list_move_tail(&entry->dirty_node, &e->dirty_node);
+}
+
+/* A write-back of the entry failed: keep it dirty for another try, up to
+ * CACHE_WB_RETRIES, then give the data up */
+static void writeback_failed(cache_entry_t *entry)
+{
+    if (++entry->wb_errors < CACHE_WB_RETRIES) {
+        requeue_dirty(entry);
+        return;
+    }
+
+    printk(KERN_ERR "[CACHE] Dropping block %u of device %d.%d: write-back failed %u times\n",
+           entry->buf.block, entry->buf.prim_id, entry->buf.scnd_id, entry->wb_errors);
+    drop_entry(entry);
+}
+
+/* Order dirty entries by device, minor, then block */
+static int dirty_cmp(const list_head_t *a, const list_head_t *b)
+{
+    const cache_buf_t *x = &list_entry(a, cache_entry_t, dirty_node)->buf;
+    const cache_buf_t *y = &list_entry(b, cache_entry_t, dirty_node)->buf;
+
+    if (x->prim_id != y->prim_id)
+        return x->prim_id < y->prim_id ? -1 : 1;
+    if (x->scnd_id != y->scnd_id)
+        return x->scnd_id < y->scnd_id ? -1 : 1;
+    return x->block < y->block ? -1 : x->block > y->block;
+}
+
+/*
+ * Write back a batch of dirty entries (linked by dirty_node): sorted,
+ * each run of consecutive blocks copied into wb_buf and written with one
+ * request, up to the device's max_blocks.  A run that fails is tried
+ * again block by block, so only the blocks that really fail go back to
+ * dirty_list (writeback_failed()); the other runs are still written.
+ * Returns the number written, or -1 if any failed.
+ */
+static int write_batch(list_head_t *batch)
+{
+    int written = 0;
+    int failed  = 0;
+
+    list_sort(batch, dirty_cmp);
+
+    while (!list_empty(batch)) {
+        cache_entry_t *first = list_first_entry(batch, cache_entry_t, dirty_node);
+        cache_entry_t *last  = first;
+        uint32_t       max   = block_max_blocks(first->buf.prim_id);
+        uint32_t       n     = 1;
 
-    cache_entry_t *victim = list_last_entry(&lru_list, cache_entry_t, node);
+        if (max == 0 || max > CACHE_WB_MAX_BLOCKS)
+            max = CACHE_WB_MAX_BLOCKS;
 
-    if (victim->dirty) {
-        if (writeback_entry(victim) < 0)
-            printk("[CACHE] Warning: Failed to write back dirty block\n");
+        memcpy(wb_buf, first->buf.data, CACHE_BLOCK_SIZE);
+        while (n < max && last->dirty_node.next != batch) {
+            cache_entry_t *next = list_entry(last->dirty_node.next, cache_entry_t, dirty_node);
+            if (next->buf.prim_id != first->buf.prim_id ||
+                next->buf.scnd_id != first->buf.scnd_id ||
+                next->buf.block   != first->buf.block + n)
+                break;
+            memcpy(wb_buf + n * CACHE_BLOCK_SIZE, next->buf.data, CACHE_BLOCK_SIZE);
+            last = next;
+            n++;
+        }
+
+        if (bwrite_direct(first->buf.prim_id, first->buf.scnd_id, wb_buf,
+                          first->buf.block, n) != (int)(n * CACHE_BLOCK_SIZE)) {
+            int single = n == 1;
+
+            while (n--) {
+                cache_entry_t *e = list_first_entry(batch, cache_entry_t, dirty_node);
+                if (!single && writeback_entry(e) == 0) {
+                    written++;
+                    continue;
+                }
+                failed = 1;
+                writeback_failed(e);
+            }
+            continue;
+        }
+
+        stat_wb_blocks += n;
+        stat_wb_requests++;
+        written += (int)n;
+        while (n--)
+            clear_dirty(list_first_entry(batch, cache_entry_t, dirty_node));
     }
+    return failed ? -1 : written;
+}
 
-    list_del(&victim->node);
-    kfree(victim->data);
-    kfree(victim);
-    num_entries--;
+/*
+ * Write back dirty blocks of a device (prim_id < 0: all): those at least
+ * min_age ticks old, plus the oldest others until no more than pct of
+ * the cache stays dirty.  Returns the number written, or -1 if any
+ * failed; the others are written all the same.
+ */
+static int write_dirty(int prim_id, uint32_t min_age, uint32_t pct)
+{
+    LIST_HEAD(batch);
+    uint32_t       now    = pit_get_ticks();
+    uint32_t       limit  = dirty_capacity() * pct / 100;
+    uint32_t       excess = num_dirty > limit ? num_dirty - limit : 0;
+    cache_entry_t *e, *tmp;
+
+    list_for_each_entry_safe(e, tmp, &dirty_list, dirty_node) {
+        if (now - e->dirtied < min_age && !excess)
+            break;
+        if (prim_id >= 0 && e->buf.prim_id != prim_id)
+            continue;
+        list_move_tail(&e->dirty_node, &batch);
+        if (excess)
+            excess--;
+    }
+    return write_batch(&batch);
+}
+
+/* The writer waits for the disk while too much is dirty */
+static void balance_dirty(void)
+{
+    if (over_dirty(CACHE_DIRTY_MAX_PCT) &&
+        write_dirty(-1, UINT32_MAX, CACHE_DIRTY_MAX_PCT) < 0)
+        printk(KERN_ERR "[CACHE] Failed to write back dirty block\n");
+}
+
+/* Idle loop: write back what has aged, then come back while any is left */
+static void flush_work_fn(work_t *work)
+{
+    (void)work;
+
+    cache_enter();
+    if (write_dirty(-1, CACHE_DIRTY_EXPIRE, CACHE_DIRTY_BG_PCT) < 0)
+        printk(KERN_ERR "[CACHE] Failed to write back dirty block\n");
+    if (num_dirty)
+        schedule_delayed_work(&flush_work, CACHE_FLUSH_INTERVAL);
+    cache_leave();
+}
+
+/*
+ * No clean block to give up: write back the oldest dirty ones in policy
+ * order until one succeeds.  Blocks that fail stay dirty and cached, for
+ * the flusher to retry; after CACHE_WB_RETRIES failures here this gives
+ * up and the new block goes uncached.
+ */
+static cache_entry_t *clean_victim(void)
+{
+    list_head_t   *order[2];
+    cache_entry_t *entry;
+    int            failures = 0;
+
+    victim_lists(order);
+    for (int i = 0; i < 2; i++) {
+        list_for_each_entry_reverse(entry, order[i], node) {
+            if (entry->refcnt || !entry->dirty)
+                continue;
+            if (writeback_entry(entry) == 0)
+                return entry;
+            if (++failures == CACHE_WB_RETRIES)
+                return NULL;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * A slot for a new block: a free one, else a new page if the cache may
+ * grow, else the slot of the unreferenced block the policy gives up.
+ * Only clean blocks are given up; NULL if none is, or can be made, clean.
+ */
+static cache_entry_t *alloc_slot(void)
+{
+    cache_entry_t *entry;
+
+    if (list_empty(&free_slots) && (!can_grow() || add_page() < 0)) {
+        entry = pick_victim();
+        if (!entry)
+            entry = clean_victim();
+        if (!entry)
+            return NULL;
+        if (entry->a1in)
+            add_ghost(entry);
+        unhash_entry(entry);
+        return entry;
+    }
+
+    entry = list_first_entry(&free_slots, cache_entry_t, node);
+    list_del(&entry->node);
+    entry->page->used++;
+    return entry;
+}
+
+/* Referenced, or (without allow_io) holding dirty blocks */
+static int page_busy(const cache_page_t *pg, int allow_io)
+{
+    for (int i = 0; i < CACHE_BLOCKS_PER_PAGE; i++) {
+        const cache_entry_t *e = &pg->slots[i];
+        if (e->refcnt || (!allow_io && e->valid && e->dirty))
+            return 1;
+    }
     return 0;
 }
 
+/* Write back the dirty blocks of a page; -1 if any stays dirty */
+static int clean_page(cache_page_t *pg)
+{
+    int ret = 0;
+
+    for (int i = 0; i < CACHE_BLOCKS_PER_PAGE; i++) {
+        cache_entry_t *e = &pg->slots[i];
+        if (e->valid && e->dirty && writeback_entry(e) < 0)
+            ret = -1;
+    }
+    return ret;
+}
+
+/* Drop every block of a clean page, which frees it */
+static void evict_page(cache_page_t *pg)
+{
+    uint32_t left = pg->used;
+
+    for (int i = 0; left && i < CACHE_BLOCKS_PER_PAGE; i++) {
+        cache_entry_t *e = &pg->slots[i];
+        if (!e->valid)
+            continue;
+        left--;
+        drop_entry(e);
+    }
+}
+
+/* shrink_pages() over one list, from its oldest block */
+static uint32_t shrink_list(list_head_t *list, uint32_t nr, int allow_io)
+{
+    uint32_t     released = 0;
+    list_head_t *pos      = list->prev;
+
+    while (released < nr && num_pages > min_pages && pos != list) {
+        cache_page_t *pg = list_entry(pos, cache_entry_t, node)->page;
+
+        /* Step past the victim's blocks before they are dropped */
+        while (pos != list && list_entry(pos, cache_entry_t, node)->page == pg)
+            pos = pos->prev;
+
+        /* A page whose dirty blocks cannot be written stays */
+        if (page_busy(pg, allow_io) || (allow_io && clean_page(pg) < 0))
+            continue;
+
+        evict_page(pg);
+        released++;
+    }
+    return released;
+}
+
+/*
+ * Release up to nr pages, starting from the page of the oldest a1in_list
+ * block, then of the LRU block, but keep min_pages.  Other blocks in a
+ * victim page go with it even if they are recent; that is the price of
+ * returning whole pages.  Pages with referenced blocks are skipped, and
+ * so are pages holding dirty blocks, unless allow_io lets them be
+ * written back first and that succeeds.
+ *
+ * Pages with free slots are only released by the loops once their
+ * blocks are gone, so the free list never keeps a page alive by itself.
+ */
+static uint32_t shrink_pages(uint32_t nr, int allow_io)
+{
+    uint32_t released = shrink_list(&a1in_list, nr, allow_io);
+
+    return released + shrink_list(&lru_list, nr - released, allow_io);
+}
+
+/* Memory is getting short: shrink back to the grow watermark */
+static void shrink_low_memory(void)
+{
+    uint32_t total = buddy_total_pages();
+    uint32_t avail = buddy_free_pages();
+
+    if (num_pages <= min_pages || avail >= total / CACHE_SHRINK_DIV)
+        return;
+
+    shrink_pages(total / CACHE_GROW_DIV - avail, 1);
+}
+
+/* A slot for the block, hashed in and queued; contents not set */
+static cache_entry_t *new_entry(int prim_id, int scnd_id, uint32_t offset)
+{
+    if (!cache_index.buckets)
+        return NULL;
+
+    shrink_low_memory();
+
+    /* Before alloc_slot(), which may recycle this very ghost */
+    cache_ghost_t *ghost = policy == CACHE_POLICY_2Q ?
+                           find_ghost(prim_id, scnd_id, offset) : NULL;
+    if (ghost) {
+        stat_ghost_hits++;
+        forget_ghost(ghost);
+    }
+
+    cache_entry_t *entry = alloc_slot();
+    if (!entry)
+        return NULL;
+
+    entry->buf.prim_id  = prim_id;
+    entry->buf.scnd_id  = scnd_id;
+    entry->buf.block    = offset;
+    entry->buf.uptodate = 0;
+    entry->dirty        = 0;
+    entry->wb_errors    = 0;
+    entry->valid        = 1;
+
+    queue_entry(entry, ghost != NULL);
+    htable_add(&cache_index, &entry->hnode, cache_key(prim_id, scnd_id, offset));
+    num_entries++;
+    return entry;
+}
+
+/* page_alloc() ran out: hand back clean pages, never doing I/O here */
+static uint32_t cache_shrink_scan(uint32_t nr_pages)
+{
+    if (cache_busy)
+        return 0;
+    return shrink_pages(nr_pages, 0);
+}
+
+static shrinker_t cache_shrinker = {
+    .name = "blkcache",
+    .scan = cache_shrink_scan,
+};
+
+/* Drop all ghosts; their slots stay with the pages */
+static void clear_ghosts(void)
+{
+    while (!list_empty(&ghost_list))
+        forget_ghost(list_first_entry(&ghost_list, cache_ghost_t, node));
+}
+
+/* Decimal KB value; leaves *kb alone if there are no digits */
+static const char *parse_kb(const char *s, uint32_t *kb)
+{
+    if (*s < '0' || *s > '9')
+        return s;
+
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9')
+        v = v * 10 + (uint32_t)(*s++ - '0');
+    *kb = v;
+    return s;
+}
+
 /* =========================================================================
  * Public API
  * ========================================================================= */
@@ -96,102 +828,320 @@ static int evict_lru(void)
 void cache_init(void)
 {
     INIT_LIST_HEAD(&lru_list);
+    INIT_LIST_HEAD(&a1in_list);
+    INIT_LIST_HEAD(&free_slots);
+    INIT_LIST_HEAD(&dirty_list);
+    INIT_LIST_HEAD(&ghost_list);
+    INIT_LIST_HEAD(&free_ghosts);
     num_entries = 0;
+    num_a1in    = 0;
+    num_dirty   = 0;
+    num_pages   = 0;
     stat_hits   = 0;
     stat_misses = 0;
+    stat_ghost_hits = 0;
+
+    if (htable_init(&ghost_index, CACHE_INDEX_BITS) < 0 ||
+        htable_init(&cache_index, CACHE_INDEX_BITS) < 0) {
+        htable_destroy(&ghost_index);
+        printk(KERN_ERR "[CACHE] Cannot allocate the block index, cache disabled\n");
+        return;
+    }
+
+    /* blkcache=MIN,MAX[,wb][,2q] in KB; either size may be left out
+     * ("blkcache=,8192"), ",wb" selects write-back and ",2q" the 2Q
+     * replacement policy */
+    uint32_t min_kb = CACHE_MIN_KB;
+    uint32_t max_kb = buddy_total_pages() / CACHE_MAX_DIV * (PAGE_SIZE / 1024);
+    char     opt[24];
+
+    if (cmdline_param("blkcache", 0, opt, sizeof(opt)) >= 0) {
+        const char *p = parse_kb(opt, &min_kb);
+        if (*p == ',')
+            p = parse_kb(p + 1, &max_kb);
+        while (*p == ',') {
+            if (strncmp(p, ",wb", 3) == 0)
+                writeback = 1;
+            else if (strncmp(p, ",2q", 3) == 0)
+                policy = CACHE_POLICY_2Q;
+            else
+                break;
+            p += 3;
+        }
+        if (*p)
+            printk(KERN_WARNING "[CACHE] Ignoring blkcache option \"%s\"\n", p);
+    }
+    cache_set_limits(min_kb, max_kb);
+
+    register_shrinker(&cache_shrinker);
+
+    printk("[CACHE] Initialized %s cache: %u-%u KB in %d-byte blocks, %s\n",
+           policy == CACHE_POLICY_2Q ? "2Q" : "LRU",
+           min_pages * (PAGE_SIZE / 1024), max_pages * (PAGE_SIZE / 1024),
+           CACHE_BLOCK_SIZE, writeback ? "write-back" : "write-through");
+}
 
-    printk("[CACHE] Initialized LRU cache: %d entries x %d bytes = %d KB\n",
-           CACHE_MAX_ENTRIES, CACHE_BLOCK_SIZE,
-           (CACHE_MAX_ENTRIES * CACHE_BLOCK_SIZE) / 1024);
+void cache_set_limits(uint32_t min_kb, uint32_t max_kb)
+{
+    uint32_t kb_per_page = PAGE_SIZE / 1024;
+
+    cache_enter();
+
+    min_pages = (min_kb + kb_per_page - 1) / kb_per_page;
+    max_pages = (max_kb + kb_per_page - 1) / kb_per_page;
+    if (max_pages < min_pages)
+        max_pages = min_pages;
+    if (max_pages == 0)
+        max_pages = 1;
+
+    /* Lowering the ceiling takes effect now; shrink_pages() keeps the
+     * floor, which is at most the ceiling */
+    if (num_pages > max_pages)
+        shrink_pages(num_pages - max_pages, 1);
+
+    cache_leave();
 }
 
 int cache_lookup(int prim_id, int scnd_id, uint32_t offset, void *buf)
 {
+    cache_enter();
+
     cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
 
+    if (entry && !entry->buf.uptodate)
+        entry = NULL;               /* bget() slot not filled in yet */
+
+    TRACE(cache_lookup, prim_id, scnd_id, offset, entry != NULL);
+
     if (entry) {
         stat_hits++;
-        cache_memcpy(buf, entry->data, CACHE_BLOCK_SIZE);
-        /* Promote to MRU position */
-        list_move(&entry->node, &lru_list);
-        return 1;
+        memcpy(buf, entry->buf.data, CACHE_BLOCK_SIZE);
+        touch_entry(entry);
+    } else {
+        stat_misses++;
     }
 
-    stat_misses++;
-    return 0;
+    cache_leave();
+    return entry != NULL;
 }
 
 int cache_insert(int prim_id, int scnd_id, uint32_t offset, const void *data)
 {
-    cache_entry_t *existing = find_entry(prim_id, scnd_id, offset);
-    if (existing) {
-        cache_memcpy(existing->data, data, CACHE_BLOCK_SIZE);
-        list_move(&existing->node, &lru_list);
-        return 0;
+    int ret = 0;
+
+    cache_enter();
+
+    cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
+    if (entry) {
+        memcpy(entry->buf.data, data, CACHE_BLOCK_SIZE);
+        entry->buf.uptodate = 1;
+        touch_entry(entry);
+        goto out;
     }
 
-    if (num_entries >= CACHE_MAX_ENTRIES) {
-        if (evict_lru() < 0)
-            return -1;
+    entry = new_entry(prim_id, scnd_id, offset);
+    if (!entry) {
+        ret = -1;
+        goto out;
     }
 
-    cache_entry_t *entry = (cache_entry_t *)kalloc(sizeof(cache_entry_t));
-    if (!entry)
-        return -1;
+    memcpy(entry->buf.data, data, CACHE_BLOCK_SIZE);
+    entry->buf.uptodate = 1;
 
-    entry->data = (uint8_t *)kalloc(CACHE_BLOCK_SIZE);
-    if (!entry->data) {
-        kfree(entry);
-        return -1;
-    }
+out:
+    cache_leave();
+    return ret;
+}
+
+cache_buf_t *cache_get(int prim_id, int scnd_id, uint32_t offset, int create)
+{
+    cache_enter();
 
-    entry->prim_id = prim_id;
-    entry->scnd_id = scnd_id;
-    entry->offset  = offset;
-    entry->dirty   = 0;
-    cache_memcpy(entry->data, data, CACHE_BLOCK_SIZE);
+    cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
+    int            hit   = entry && entry->buf.uptodate;
 
-    /* Insert at MRU position (head) */
-    list_add(&entry->node, &lru_list);
-    num_entries++;
-    return 0;
+    TRACE(cache_lookup, prim_id, scnd_id, offset, hit);
+
+    if (hit)
+        stat_hits++;
+    else
+        stat_misses++;
+
+    if (entry)
+        touch_entry(entry);
+    else if (create)
+        entry = new_entry(prim_id, scnd_id, offset);
+
+    if (entry)
+        entry->refcnt++;
+
+    cache_leave();
+    return entry ? &entry->buf : NULL;
+}
+
+void cache_put(cache_buf_t *buf)
+{
+    cache_entry_t *entry = container_of(buf, cache_entry_t, buf);
+
+    cache_enter();
+    if (--entry->refcnt == 0 && !entry->valid)
+        put_slot(entry);            /* invalidated while referenced */
+    cache_leave();
+}
+
+void cache_dirty(cache_buf_t *buf)
+{
+    cache_entry_t *entry = container_of(buf, cache_entry_t, buf);
+
+    cache_enter();
+    entry->buf.uptodate = 1;
+
+    if (entry->valid) {
+        set_dirty(entry);
+        balance_dirty();
+    } else if (bwrite_direct(buf->prim_id, buf->scnd_id, buf->data, buf->block, 1) < 0) {
+        /* Out of the cache already: nothing would ever write it back */
+        printk(KERN_ERR "[CACHE] Failed to write back dirty block\n");
+    }
+    cache_leave();
 }
 
 int cache_mark_dirty(int prim_id, int scnd_id, uint32_t offset)
 {
+    cache_enter();
+
     cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
-    if (!entry)
-        return -1;
+    if (entry) {
+        set_dirty(entry);
+        touch_entry(entry);
+        balance_dirty();
+    }
 
-    entry->dirty = 1;
-    list_move(&entry->node, &lru_list);
-    return 0;
+    cache_leave();
+    return entry ? 0 : -1;
+}
+
+int cache_write(int prim_id, int scnd_id, uint32_t offset, const void *data)
+{
+    cache_enter();
+
+    cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
+    if (entry)
+        touch_entry(entry);
+    else
+        entry = new_entry(prim_id, scnd_id, offset);
+
+    if (entry) {
+        memcpy(entry->buf.data, data, CACHE_BLOCK_SIZE);
+        entry->buf.uptodate = 1;
+        set_dirty(entry);
+        balance_dirty();
+    }
+
+    cache_leave();
+    return entry ? 0 : -1;
+}
+
+int cache_sync(int prim_id)
+{
+    cache_enter();
+    int written = write_dirty(prim_id, 0, 0);
+    cache_leave();
+    return written;
 }
 
 int cache_flush(void)
 {
-    int written = 0;
+    return cache_sync(-1);
+}
+
+void cache_set_writeback(int on)
+{
+    writeback = on;
+    if (!on)
+        cache_sync(-1);
+}
+
+int cache_writeback(void)
+{
+    return writeback;
+}
+
+void cache_set_policy(int new_policy)
+{
     cache_entry_t *e;
-    list_for_each_entry(e, &lru_list, node) {
-        if (e->dirty && writeback_entry(e) == 0)
-            written++;
+
+    if (new_policy != CACHE_POLICY_LRU && new_policy != CACHE_POLICY_2Q)
+        return;
+
+    cache_enter();
+    if (new_policy == CACHE_POLICY_LRU) {
+        /* a1in_list blocks are the recent ones: ahead of lru_list */
+        list_for_each_entry(e, &a1in_list, node)
+            e->a1in = 0;
+        list_splice_init(&a1in_list, &lru_list);
+        num_a1in = 0;
+        clear_ghosts();
     }
-    return written;
+    policy = new_policy;
+    cache_leave();
+}
+
+int cache_policy(void)
+{
+    return policy;
 }
 
-void cache_invalidate(int prim_id, int scnd_id, uint32_t offset)
+int cache_invalidate(int prim_id, int scnd_id, uint32_t offset)
 {
+    int ret = 0;
+
+    cache_enter();
+
     cache_entry_t *entry = find_entry(prim_id, scnd_id, offset);
-    if (!entry)
-        return;
+    if (entry) {
+        if (writeback_entry(entry) < 0) {
+            printk(KERN_ERR "[CACHE] Keeping dirty block %u of device %d.%d: write-back failed\n",
+                   offset, prim_id, scnd_id);
+            ret = -1;
+        } else {
+            drop_entry(entry);
+        }
+    }
 
-    if (entry->dirty)
-        writeback_entry(entry);
+    cache_leave();
+    return ret;
+}
 
-    list_del(&entry->node);
-    kfree(entry->data);
-    kfree(entry);
-    num_entries--;
+/* Drop a device's blocks from a list; returns dirty blocks lost */
+static uint32_t invalidate_list(list_head_t *list, int prim_id)
+{
+    cache_entry_t *e, *tmp;
+    uint32_t       lost = 0;
+
+    list_for_each_entry_safe(e, tmp, list, node) {
+        if (e->buf.prim_id != prim_id)
+            continue;
+
+        if (writeback_entry(e) < 0)
+            lost++;
+
+        drop_entry(e);
+    }
+    return lost;
+}
+
+int cache_invalidate_device(int prim_id)
+{
+    cache_enter();
+    uint32_t lost = invalidate_list(&a1in_list, prim_id) +
+                    invalidate_list(&lru_list, prim_id);
+    cache_leave();
+
+    if (lost)
+        printk(KERN_ERR "[CACHE] Lost %u dirty blocks of device %d: write-back failed\n",
+               lost, prim_id);
+    return lost ? -1 : 0;
 }
 
 void cache_stats(uint32_t *hits, uint32_t *misses, uint32_t *entries)
@@ -199,4 +1149,30 @@ void cache_stats(uint32_t *hits, uint32_t *misses, uint32_t *entries)
     if (hits)    *hits    = stat_hits;
     if (misses)  *misses  = stat_misses;
     if (entries) *entries = num_entries;
-}
\ No newline at end of file
+}
+
+uint32_t cache_ghost_hits(void)
+{
+    return stat_ghost_hits;
+}
+
+void cache_usage(uint32_t *pages, uint32_t *min, uint32_t *max)
+{
+    if (pages) *pages = num_pages;
+    if (min)   *min   = min_pages;
+    if (max)   *max   = max_pages;
+}
+
+uint32_t cache_dirty_count(void)
+{
+    return num_dirty;
+}
+
+void cache_wb_stats(uint32_t *blocks, uint32_t *requests, uint32_t *merged)
+{
+    if (blocks)   *blocks   = stat_wb_blocks;
+    if (requests) *requests = stat_wb_requests;
+    if (merged)   *merged   = stat_wb_blocks - stat_wb_requests;
+}
+
+INITCALL(cache, cache_init, 0);
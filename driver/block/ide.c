@@ -1,6 +1,7 @@
 #include "driver/block/ide.h"
 #include "driver/block/block.h"
 #include "fs/devfs.h"
+#include "kernel/initcall.h"
 #include "kernel/asm.h"
 #include "lib/printk.h"
 #include <stddef.h>
@@ -61,41 +62,69 @@ static void ide_select_drive(uint16_t base_port, uint16_t ctrl_port, uint8_t dri
         inb(ctrl_port + IDE_REG_ALTSTATUS);
 }
 
-/**
- * Identify IDE disk and fill disk structure.
- * Returns true if disk exists, false otherwise.
- */
-static bool ide_identify(uint16_t base_port, uint16_t ctrl_port,
-                         uint8_t drive, ide_disk_t *disk)
-{
-    uint16_t identify_data[256];
+/* =========================================================================
+ * Probing
+ *
+ * IDENTIFY is issued to the same drive position on both channels at once
+ * and the two are polled together, so the controllers work in parallel
+ * and an absent drive's timeout overlaps the other channel's probe.
+ * ========================================================================= */
+
+#define IDE_PROBE_SPINS  1000000
+
+typedef struct {
+    uint16_t base_port;
+    uint16_t ctrl_port;
+    int      busy;       /* IDENTIFY outstanding */
+    int      spins;
+} ide_probe_t;
 
-    ide_select_drive(base_port, ctrl_port, drive);
+/* Send IDENTIFY to drive; returns 0 if something may be answering */
+static int ide_probe_start(ide_probe_t *p, uint8_t drive)
+{
+    ide_select_drive(p->base_port, p->ctrl_port, drive);
 
-    outb(base_port + IDE_REG_SECCOUNT, 0);
-    outb(base_port + IDE_REG_LBA_LOW,  0);
-    outb(base_port + IDE_REG_LBA_MID,  0);
-    outb(base_port + IDE_REG_LBA_HIGH, 0);
-    outb(base_port + IDE_REG_COMMAND,  IDE_CMD_IDENTIFY);
+    outb(p->base_port + IDE_REG_SECCOUNT, 0);
+    outb(p->base_port + IDE_REG_LBA_LOW,  0);
+    outb(p->base_port + IDE_REG_LBA_MID,  0);
+    outb(p->base_port + IDE_REG_LBA_HIGH, 0);
+    outb(p->base_port + IDE_REG_COMMAND,  IDE_CMD_IDENTIFY);
 
     /* Floating bus → no drive */
-    uint8_t status = inb(base_port + IDE_REG_STATUS);
+    uint8_t status = inb(p->base_port + IDE_REG_STATUS);
     if (status == 0 || status == 0xFF)
-        return false;
+        return -1;
+
+    p->busy  = 1;
+    p->spins = 0;
+    return 0;
+}
 
-    if (ide_wait_bsy(base_port) != 0) return false;
+/* 1: identify data ready, 0: still busy, -1: no usable drive */
+static int ide_probe_poll(ide_probe_t *p)
+{
+    uint8_t status = inb(p->base_port + IDE_REG_STATUS);
 
-    status = inb(base_port + IDE_REG_STATUS);
-    if (status & IDE_STATUS_ERR) return false;
+    if (++p->spins > IDE_PROBE_SPINS)
+        return -1;
+    if (status & IDE_STATUS_BSY)
+        return 0;
+    if (status & IDE_STATUS_ERR)
+        return -1;
+    return (status & IDE_STATUS_DRQ) ? 1 : 0;
+}
 
-    if (ide_wait_drq(base_port) != 0) return false;
+/* Read the identify block of a drive whose probe reported ready */
+static void ide_probe_finish(ide_probe_t *p, uint8_t drive, ide_disk_t *disk)
+{
+    uint16_t identify_data[256];
 
     for (int i = 0; i < 256; i++)
-        identify_data[i] = inw(base_port + IDE_REG_DATA);
+        identify_data[i] = inw(p->base_port + IDE_REG_DATA);
 
     disk->exists    = true;
-    disk->base_port = base_port;
-    disk->ctrl_port = ctrl_port;
+    disk->base_port = p->base_port;
+    disk->ctrl_port = p->ctrl_port;
     disk->drive     = drive;
     disk->sectors   = ((uint32_t)identify_data[61] << 16) | identify_data[60];
 
@@ -109,8 +138,38 @@ static bool ide_identify(uint16_t base_port, uint16_t ctrl_port,
         if (disk->model[i] == ' ') disk->model[i] = '\0';
         else break;
     }
+}
+
+/* Probe drive position `drive` on both channels; returns disks found */
+static int ide_probe_drive(uint8_t drive)
+{
+    ide_probe_t chan[2] = {
+        { IDE_PRIMARY_BASE,   IDE_PRIMARY_CTRL,   0, 0 },
+        { IDE_SECONDARY_BASE, IDE_SECONDARY_CTRL, 0, 0 },
+    };
+    int found = 0;
+
+    for (int c = 0; c < 2; c++)
+        ide_probe_start(&chan[c], drive);
+
+    while (chan[0].busy || chan[1].busy) {
+        for (int c = 0; c < 2; c++) {
+            if (!chan[c].busy)
+                continue;
+
+            int r = ide_probe_poll(&chan[c]);
+            if (r == 0)
+                continue;
+
+            chan[c].busy = 0;
+            if (r > 0) {
+                ide_probe_finish(&chan[c], drive, &ide_disks[c * 2 + drive]);
+                found++;
+            }
+        }
+    }
 
-    return true;
+    return found;
 }
 
 /* =========================================================================
@@ -211,7 +270,7 @@ static int ide_block_read(int prim_id, int scnd_id, void *buf,
 {
     (void)scnd_id;
     if (prim_id < 0 || prim_id >= IDE_MAX_DISKS) return -1;
-    if (count == 0 || count > 256) return -1;
+    if (count == 0 || count > 255) return -1;   /* 8-bit sector count */
 
     if (ide_read_sectors((uint8_t)prim_id, offset, (uint8_t)count, buf) == 0)
         return (int)(count * IDE_SECTOR_SIZE);
@@ -223,7 +282,7 @@ static int ide_block_write(int prim_id, int scnd_id, const void *buf,
 {
     (void)scnd_id;
     if (prim_id < 0 || prim_id >= IDE_MAX_DISKS) return -1;
-    if (count == 0 || count > 256) return -1;
+    if (count == 0 || count > 255) return -1;   /* 8-bit sector count */
 
     if (ide_write_sectors((uint8_t)prim_id, offset, (uint8_t)count, buf) == 0)
         return (int)(count * IDE_SECTOR_SIZE);
@@ -259,11 +318,8 @@ void ide_init(void)
 {
     printk("[IDE] Scanning for disks...\n");
 
-    int disk_count = 0;
-    if (ide_identify(IDE_PRIMARY_BASE,   IDE_PRIMARY_CTRL,   0, &ide_disks[0])) disk_count++;
-    if (ide_identify(IDE_PRIMARY_BASE,   IDE_PRIMARY_CTRL,   1, &ide_disks[1])) disk_count++;
-    if (ide_identify(IDE_SECONDARY_BASE, IDE_SECONDARY_CTRL, 0, &ide_disks[2])) disk_count++;
-    if (ide_identify(IDE_SECONDARY_BASE, IDE_SECONDARY_CTRL, 1, &ide_disks[3])) disk_count++;
+    /* Masters on both channels together, then slaves */
+    int disk_count = ide_probe_drive(0) + ide_probe_drive(1);
 
     printk("[IDE] Found %d disk(s)\n", disk_count);
 
@@ -271,7 +327,12 @@ void ide_init(void)
 
     /* Register every found disk as a block device + devfs node */
     static const char *names[] = {"hda", "hdb", "hdc", "hdd"};
-    block_ops_t ops = { .read = ide_block_read, .write = ide_block_write, .ioctl = NULL };
+    block_ops_t ops = {
+        .read       = ide_block_read,
+        .write      = ide_block_write,
+        .ioctl      = NULL,
+        .max_blocks = 255,          /* 8-bit sector count, 0 not used */
+    };
 
     for (int i = 0; i < IDE_MAX_DISKS; i++) {
         if (!ide_disks[i].exists) continue;
@@ -283,4 +344,7 @@ void ide_init(void)
         }
         devfs_register_device(names[i], DT_BLKDEV, i, 0);
     }
-}
\ No newline at end of file
+}
+
+/* Probing can take seconds with absent drives: keep it off the boot path */
+INITCALL(ide, ide_init, INITCALL_ASYNC);
@@ -2,6 +2,7 @@
 #include "driver/block/ide.h"
 #include "driver/driver.h"
 #include "lib/printk.h"
+#include "kernel/initcall.h"
 #include "lib/string.h"
 #include <stddef.h>
 #include <stdint.h>
@@ -173,7 +174,8 @@ void mbr_init(void)
     block_ops_t part_ops = {
         .read = part_block_read,
         .write = part_block_write,
-        .ioctl = NULL
+        .ioctl = NULL,
+        .flags = BLOCK_NOCACHE      /* the disk below caches these blocks */
     };
     
     const char *disk_names[] = {"hda", "hdb", "hdc", "hdd"};
@@ -366,4 +368,13 @@ int mbr_write_partition(uint8_t disk_id, uint8_t partition_num,
     
     /* Write to underlying disk using IDE driver */
     return ide_write_sectors(disk_id, absolute_lba, count, buffer);
-}
\ No newline at end of file
+}
+
+static void mbr_initcall(void)
+{
+    mbr_init();
+    mbr_print_partitions();
+}
+
+/* Partitions need the disks; runs after the async IDE probe */
+INITCALL(mbr, mbr_initcall, 0, "ide", "cache");
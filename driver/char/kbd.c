@@ -1,16 +1,18 @@
 #include "driver/char/kbd.h"
 #include "driver/char/char.h"
-#include "driver/pic.h"
+#include "driver/irq.h"
 #include "kernel/cpu.h"
 #include "fs/devfs.h"
 #include "kernel/asm.h"
+#include "kernel/initcall.h"
+#include "lib/ring.h"
 
 /* =========================================================================
  * PS/2 Keyboard Constants
  * ========================================================================= */
 
 #define KBD_DATA_PORT    0x60
-#define KBD_BUFFER_SIZE  128
+#define KBD_BUFFER_SIZE  128              /* power of two */
 
 #define SC_LSHIFT        0x2A
 #define SC_RSHIFT        0x36
@@ -23,14 +25,48 @@
  * ========================================================================= */
 
 static struct {
-    char    buffer[KBD_BUFFER_SIZE];
-    int     read_pos;
-    int     write_pos;
-    int     count;
     uint8_t shift_pressed;
     uint8_t caps_lock;
 } kbd_state = {0};
 
+/* kbd_irq() produces, kbd_read() consumes; full means keys are dropped */
+static DEFINE_RING(kbd_ring, KBD_BUFFER_SIZE);
+
+/* =========================================================================
+ * Hotkeys
+ * ========================================================================= */
+
+static struct {
+    uint8_t scancode;
+    void  (*fn)(void);
+    int     in_use;
+} kbd_hotkeys[KBD_MAX_HOTKEYS];
+
+int kbd_register_hotkey(uint8_t scancode, void (*fn)(void))
+{
+    for (int i = 0; i < KBD_MAX_HOTKEYS; i++) {
+        if (!kbd_hotkeys[i].in_use) {
+            kbd_hotkeys[i].scancode = scancode;
+            kbd_hotkeys[i].fn       = fn;
+            kbd_hotkeys[i].in_use   = 1;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Run the hotkey bound to scancode; returns 1 if there was one */
+static int kbd_run_hotkey(uint8_t scancode)
+{
+    for (int i = 0; i < KBD_MAX_HOTKEYS; i++) {
+        if (kbd_hotkeys[i].in_use && kbd_hotkeys[i].scancode == scancode) {
+            kbd_hotkeys[i].fn();
+            return 1;
+        }
+    }
+    return 0;
+}
+
 /* =========================================================================
  * Scancode to ASCII Translation Tables
  * ========================================================================= */
@@ -64,55 +100,33 @@ static const char scancode_to_ascii_shift[] = {
 };
 
 /* =========================================================================
- * Circular Buffer
+ * IRQ1 Handler – called from irq_dispatch()
  * ========================================================================= */
 
-static void kbd_buffer_push(char c)
+static int kbd_irq(int irq, void *data)
 {
-    if (kbd_state.count < KBD_BUFFER_SIZE) {
-        kbd_state.buffer[kbd_state.write_pos] = c;
-        kbd_state.write_pos = (kbd_state.write_pos + 1) % KBD_BUFFER_SIZE;
-        kbd_state.count++;
-    }
-}
-
-static char kbd_buffer_pop(void)
-{
-    if (kbd_state.count > 0) {
-        char c = kbd_state.buffer[kbd_state.read_pos];
-        kbd_state.read_pos = (kbd_state.read_pos + 1) % KBD_BUFFER_SIZE;
-        kbd_state.count--;
-        return c;
-    }
-    return 0;
-}
-
-/* =========================================================================
- * IRQ1 Handler
- * ========================================================================= */
+    (void)irq;
+    (void)data;
 
-void kbd_isr(void)
-{
     uint8_t scancode = inb(KBD_DATA_PORT);
 
     if (scancode == SC_LSHIFT || scancode == SC_RSHIFT) {
         kbd_state.shift_pressed = 1;
-        pic_send_eoi(IRQ1);
-        return;
+        return IRQ_HANDLED;
     }
     if (scancode == SC_LSHIFT_REL || scancode == SC_RSHIFT_REL) {
         kbd_state.shift_pressed = 0;
-        pic_send_eoi(IRQ1);
-        return;
+        return IRQ_HANDLED;
     }
     if (scancode == SC_CAPSLOCK) {
         kbd_state.caps_lock = !kbd_state.caps_lock;
-        pic_send_eoi(IRQ1);
-        return;
+        return IRQ_HANDLED;
     }
     if (scancode & 0x80) {   /* break code – ignore */
-        pic_send_eoi(IRQ1);
-        return;
+        return IRQ_HANDLED;
+    }
+    if (kbd_run_hotkey(scancode)) {
+        return IRQ_HANDLED;
     }
 
     char ascii = 0;
@@ -127,8 +141,8 @@ void kbd_isr(void)
             ascii = ascii - 'A' + 'a';
     }
 
-    if (ascii != 0) kbd_buffer_push(ascii);
-    pic_send_eoi(IRQ1);
+    if (ascii != 0) ring_put(&kbd_ring, ascii);
+    return IRQ_HANDLED;
 }
 
 /* =========================================================================
@@ -138,7 +152,10 @@ void kbd_isr(void)
 static char kbd_read(int scnd_id)
 {
     if (scnd_id != 0) return 0;
-    return kbd_buffer_pop();
+
+    char c = 0;
+    ring_get(&kbd_ring, &c);
+    return c;
 }
 
 static int kbd_write(int scnd_id, char c)
@@ -157,20 +174,16 @@ static int kbd_ioctl(int prim_id, int scnd_id, unsigned int command)
  * Initialisation – IRQ setup + driver registration + devfs node
  * ========================================================================= */
 
-extern void irq1(void);   /* defined in kernel/isr.s */
-
 void kbd_init(void)
 {
-    kbd_state.read_pos      = 0;
-    kbd_state.write_pos     = 0;
-    kbd_state.count         = 0;
     kbd_state.shift_pressed = 0;
     kbd_state.caps_lock     = 0;
 
-    idt_set_gate(33, (uint32_t)irq1, GDT_KERNEL_CODE, IDT_GATE_INT32);
-    pic_enable_irq(IRQ1);
+    request_irq(1, kbd_irq, NULL, "kbd");
 
     char_ops_t ops = { .read = kbd_read, .write = kbd_write, .ioctl = kbd_ioctl };
     register_char_device(3, &ops);
     devfs_register_device("kbd0", DT_CHRDEV, 3, 0);
-}
\ No newline at end of file
+}
+
+INITCALL(kbd, kbd_init, 0);
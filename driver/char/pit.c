@@ -1,10 +1,13 @@
 #include "driver/char/pit.h"
 #include "driver/char/char.h"
-#include "driver/pic.h"
+#include "driver/irq.h"
 #include "kernel/cpu.h"
 #include "fs/devfs.h"
 #include "lib/printk.h"
 #include "kernel/asm.h"
+#include "kernel/profile.h"
+#include "kernel/initcall.h"
+#include "kernel/workqueue.h"
 
 /* =========================================================================
  * Driver state
@@ -18,13 +21,17 @@ uint32_t pit_get_ticks(void)
 }
 
 /* =========================================================================
- * IRQ0 handler – called from the irq0 stub in isr.s
+ * IRQ0 handler – called from irq_dispatch()
  * ========================================================================= */
 
-void pit_isr(void)
+static int pit_irq(int irq, void *data)
 {
+    (void)irq;
+    (void)data;
     pit_ticks++;
-    pic_send_eoi(IRQ0);
+    profile_tick(get_irq_regs());
+    workqueue_tick();
+    return IRQ_HANDLED;
 }
 
 /* =========================================================================
@@ -48,8 +55,6 @@ static int pit_write(int scnd_id, char c)
  * Initialisation – hardware + IRQ setup + driver registration + devfs node
  * ========================================================================= */
 
-extern void irq0(void);   /* defined in kernel/isr.s */
-
 void pit_init(uint32_t hz)
 {
     /* Calculate divisor, clamp to valid range [1, 65535] */
@@ -62,14 +67,18 @@ void pit_init(uint32_t hz)
     outb(PIT_CHANNEL0, (uint8_t)(divisor & 0xFF));
     outb(PIT_CHANNEL0, (uint8_t)(divisor >> 8));
 
-    /* Register IRQ0 handler in IDT (vector 32 = PIC master offset 0x20) */
-    idt_set_gate(32, (uint32_t)irq0, GDT_KERNEL_CODE, IDT_GATE_INT32);
-
-    /* Unmask IRQ0 in the PIC */
-    pic_enable_irq(IRQ0);
+    /* Attach to IRQ0; request_irq() unmasks the line */
+    request_irq(0, pit_irq, NULL, "pit");
 
     /* Register as char device 1 and add devfs node */
     char_ops_t ops = { .read = pit_read, .write = pit_write, .ioctl = NULL };
     register_char_device(1, &ops);
     devfs_register_device("pit0", DT_CHRDEV, 1, 0);
-}
\ No newline at end of file
+}
+
+static void pit_initcall(void)
+{
+    pit_init(PIT_DEFAULT_HZ);
+}
+
+INITCALL(pit, pit_initcall, 0);
@@ -2,6 +2,7 @@
 #include "driver/char/vga.h"
 #include "driver/char/char.h"
 #include "fs/devfs.h"
+#include "kernel/initcall.h"
 #include <stdint.h>
 
 /* =========================================================================
@@ -302,4 +303,6 @@ void tty_init(void)
     char_ops_t ops = { .read = tty_read, .write = tty_write_cb, .ioctl = tty_ioctl };
     register_char_device(2, &ops);
     devfs_register_device("tty0", DT_CHRDEV, 2, 0);
-}
\ No newline at end of file
+}
+
+INITCALL(tty, tty_init, 0);
@@ -0,0 +1,346 @@
+#include "driver/char/uart.h"
+#include "driver/char/char.h"
+#include "driver/irq.h"
+#include "fs/devfs.h"
+#include "kernel/asm.h"
+#include "kernel/irqflags.h"
+#include "kernel/initcall.h"
+#include "kernel/log.h"
+#include "lib/printk.h"
+#include "lib/ring.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Port state
+ *
+ * Both directions are lib/ring.h rings.  TX has many producers (tasks,
+ * and printk consoles in any context) queueing with ring_enqueue_mp(),
+ * and one consumer, uart_tx_fill(), which always runs with interrupts
+ * off.  RX is filled by the interrupt handler and drained by uart_read().
+ * Interrupts are only disabled around the UART registers themselves.
+ * ========================================================================= */
+
+typedef struct {
+    const char *name;
+    uint16_t    base;
+    uint8_t     irq;
+    int         present;
+    int         irq_ok;        /* handler installed                   */
+    int         fifo_size;     /* bytes per THR-empty refill          */
+    uint8_t     ier;           /* shadow of UART_IER                  */
+
+    ring_t      tx;
+    ring_t      rx;
+    char        tx_buf[UART_TX_SIZE];
+    char        rx_buf[UART_RX_SIZE];
+    uint32_t    rx_dropped;
+    uint32_t    tx_dropped;    /* given up by nested polled writers   */
+
+    console_t   console;
+} uart_port_t;
+
+static uart_port_t uart_ports[UART_NR_PORTS] = {
+    { .name = "ttyS0", .base = 0x3F8, .irq = 4 },
+    { .name = "ttyS1", .base = 0x2F8, .irq = 3 },
+};
+
+static inline uint8_t uart_in(uart_port_t *p, int reg)
+{
+    return inb(p->base + reg);
+}
+
+static inline void uart_out(uart_port_t *p, int reg, uint8_t val)
+{
+    outb(p->base + reg, val);
+}
+
+static void uart_set_ier(uart_port_t *p, uint8_t ier)
+{
+    if (ier != p->ier) {
+        p->ier = ier;
+        uart_out(p, UART_IER, ier);
+    }
+}
+
+/* =========================================================================
+ * Transmit
+ * ========================================================================= */
+
+/*
+ * Load the FIFO from the TX ring; the caller knows the FIFO is empty and
+ * has interrupts off.  The THR-empty interrupt stays enabled only while
+ * there is more to send.
+ */
+static void uart_tx_fill(uart_port_t *p)
+{
+    char     chunk[UART_FIFO_SIZE];
+    uint32_t n = ring_dequeue(&p->tx, chunk, (uint32_t)p->fifo_size);
+
+    for (uint32_t i = 0; i < n; i++)
+        uart_out(p, UART_THR, chunk[i]);
+
+    if (!ring_empty(&p->tx))
+        uart_set_ier(p, p->ier | UART_IER_THRI);
+    else
+        uart_set_ier(p, p->ier & ~UART_IER_THRI);
+}
+
+/* Drain the whole ring by polling; for callers with interrupts off */
+static void uart_tx_poll(uart_port_t *p)
+{
+    while (!ring_empty(&p->tx)) {
+        while (!(uart_in(p, UART_LSR) & UART_LSR_THRE))
+            cpu_relax();
+        uart_tx_fill(p);
+    }
+}
+
+/* Start transmission after queueing; interrupts are off */
+static void uart_tx_kick(uart_port_t *p)
+{
+    if (p->ier & UART_IER_THRI)
+        return;                            /* interrupt already pending */
+    if (uart_in(p, UART_LSR) & UART_LSR_THRE)
+        uart_tx_fill(p);
+    else
+        uart_set_ier(p, p->ier | UART_IER_THRI);
+}
+
+int uart_write_buf(int port, const char *s, size_t len)
+{
+    if (port < 0 || port >= UART_NR_PORTS || !uart_ports[port].present)
+        return -1;
+
+    uart_port_t *p   = &uart_ports[port];
+    size_t       ret = len;
+
+    while (len) {
+        /* Queueing needs no lock; only the register access below does */
+        uint32_t n = ring_enqueue_mp(&p->tx, s, (uint32_t)len);
+        s   += n;
+        len -= n;
+
+        uint32_t flags  = irq_save();
+        int      polled = !(flags & EFLAGS_IF) || !p->irq_ok;
+
+        if (polled)
+            uart_tx_poll(p);
+        else if (n)
+            uart_tx_kick(p);
+        else if (uart_in(p, UART_LSR) & UART_LSR_THRE)
+            uart_tx_fill(p);      /* ring full; covers a lost THR-empty irq */
+
+        irq_restore(flags);
+
+        /* Nested in a writer that holds the rest of the ring: it cannot
+         * run until we return, so waiting for room would hang */
+        if (!n && polled && ring_mp_held(&p->tx)) {
+            p->tx_dropped += (uint32_t)len;
+            break;
+        }
+
+        if (!n && !polled)
+            cpu_relax();          /* wait for the interrupt handler */
+    }
+
+    return (int)ret;
+}
+
+/* =========================================================================
+ * Receive
+ * ========================================================================= */
+
+static void uart_rx_drain(uart_port_t *p)
+{
+    while (uart_in(p, UART_LSR) & UART_LSR_DR) {
+        if (!ring_put(&p->rx, (char)uart_in(p, UART_RBR)))
+            p->rx_dropped++;
+    }
+}
+
+static int uart_irq(int irq, void *data)
+{
+    (void)irq;
+    uart_port_t *p = (uart_port_t *)data;
+    int handled = IRQ_NONE;
+
+    for (;;) {
+        uint8_t iir = uart_in(p, UART_IIR);
+        if (iir & UART_IIR_NO_INT)
+            break;
+        handled = IRQ_HANDLED;
+
+        switch (iir & UART_IIR_ID) {
+        case UART_IIR_RDI:
+        case UART_IIR_TIMEOUT:
+            uart_rx_drain(p);
+            break;
+        case UART_IIR_THRI:
+            uart_tx_fill(p);
+            break;
+        case UART_IIR_RLSI:
+            if (uart_in(p, UART_LSR) & UART_LSR_OE)
+                p->rx_dropped++;
+            break;
+        default:
+            uart_in(p, UART_MSR);
+            break;
+        }
+    }
+
+    return handled;
+}
+
+/* =========================================================================
+ * Driver callbacks
+ * ========================================================================= */
+
+static char uart_read(int scnd_id)
+{
+    if (scnd_id < 0 || scnd_id >= UART_NR_PORTS || !uart_ports[scnd_id].present)
+        return 0;
+
+    char c = 0;
+    ring_get(&uart_ports[scnd_id].rx, &c);
+    return c;
+}
+
+static int uart_write(int scnd_id, char c)
+{
+    return uart_write_buf(scnd_id, &c, 1) < 0 ? -1 : 0;
+}
+
+static int uart_ioctl(int prim_id, int scnd_id, unsigned int command)
+{
+    (void)prim_id; (void)scnd_id; (void)command;
+    return -1;
+}
+
+/* =========================================================================
+ * Console
+ * ========================================================================= */
+
+/* Terminals want CR LF; send each line's text with one bulk write */
+static void uart_console_write(uart_port_t *p, const char *s, size_t len)
+{
+    int port = (int)(p - uart_ports);
+
+    while (len) {
+        size_t n = 0;
+        while (n < len && s[n] != '\n')
+            n++;
+        uart_write_buf(port, s, n);
+        if (n < len) {
+            uart_write_buf(port, "\r\n", 2);
+            n++;
+        }
+        s   += n;
+        len -= n;
+    }
+}
+
+static void uart_console_write0(const char *s, size_t len)
+{
+    uart_console_write(&uart_ports[0], s, len);
+}
+
+static void uart_console_write1(const char *s, size_t len)
+{
+    uart_console_write(&uart_ports[1], s, len);
+}
+
+/* =========================================================================
+ * Initialisation – probe + IRQ setup + driver registration + devfs nodes
+ * ========================================================================= */
+
+/* A scratch register that reads back is a good sign something is there */
+static int uart_probe(uart_port_t *p)
+{
+    uart_out(p, UART_SCR, 0x5A);
+    if (uart_in(p, UART_SCR) != 0x5A)
+        return 0;
+    uart_out(p, UART_SCR, 0xA5);
+    return uart_in(p, UART_SCR) == 0xA5;
+}
+
+static void uart_setup(uart_port_t *p, uint32_t baud)
+{
+    uint32_t divisor = UART_BAUD_BASE / (baud ? baud : UART_BAUD_BASE);
+    if (divisor == 0)
+        divisor = 1;
+
+    uart_out(p, UART_IER, 0);
+    p->ier = 0;
+
+    uart_out(p, UART_LCR, UART_LCR_DLAB);
+    uart_out(p, UART_DLL, (uint8_t)(divisor & 0xFF));
+    uart_out(p, UART_DLM, (uint8_t)(divisor >> 8));
+    uart_out(p, UART_LCR, UART_LCR_8N1);
+
+    uart_out(p, UART_FCR, UART_FCR_ENABLE | UART_FCR_CLR_RX | UART_FCR_CLR_TX |
+                          UART_FCR_TRIG14);
+    p->fifo_size = ((uart_in(p, UART_IIR) & UART_IIR_FIFO) == UART_IIR_FIFO) ? UART_FIFO_SIZE : 1;
+
+    uart_out(p, UART_MCR, UART_MCR_DTR | UART_MCR_RTS | UART_MCR_OUT2);
+
+    /* Discard anything left over from the firmware */
+    uart_in(p, UART_LSR);
+    uart_in(p, UART_RBR);
+    uart_in(p, UART_IIR);
+    uart_in(p, UART_MSR);
+}
+
+/* Parse the baud rate from console options ("115200"); 0 if absent */
+static uint32_t uart_parse_baud(const char *opts)
+{
+    uint32_t baud = 0;
+    while (*opts >= '0' && *opts <= '9')
+        baud = baud * 10 + (uint32_t)(*opts++ - '0');
+    return baud;
+}
+
+void uart_init(void)
+{
+    static void (*const console_write[UART_NR_PORTS])(const char *, size_t) = {
+        uart_console_write0, uart_console_write1,
+    };
+    int found = 0;
+
+    for (int i = 0; i < UART_NR_PORTS; i++) {
+        uart_port_t *p = &uart_ports[i];
+        if (!uart_probe(p))
+            continue;
+
+        char opts[16];
+        int  is_console = console_selected(p->name, opts, sizeof(opts));
+
+        ring_init(&p->tx, p->tx_buf, UART_TX_SIZE);
+        ring_init(&p->rx, p->rx_buf, UART_RX_SIZE);
+        uart_setup(p, uart_parse_baud(opts));
+        p->present = 1;
+        found++;
+
+        if (request_irq(p->irq, uart_irq, p, p->name) == 0) {
+            p->irq_ok = 1;
+            uart_set_ier(p, UART_IER_RDI | UART_IER_RLSI);
+        }
+
+        printk("[UART] %s at 0x%03x irq %d, %s\n", p->name, p->base, p->irq,
+               p->fifo_size > 1 ? "16550A FIFO" : "no FIFO");
+        devfs_register_device(p->name, DT_CHRDEV, UART_CHAR_DEV, (uint8_t)i);
+
+        if (is_console) {
+            p->console.name  = p->name;
+            p->console.write = console_write[i];
+            register_console(&p->console);
+        }
+    }
+
+    if (found) {
+        char_ops_t ops = { .read = uart_read, .write = uart_write, .ioctl = uart_ioctl };
+        register_char_device(UART_CHAR_DEV, &ops);
+    }
+}
+
+INITCALL(uart, uart_init, 0);
@@ -2,6 +2,7 @@
 #include "driver/char/char.h"
 #include "fs/devfs.h"
 #include "kernel/asm.h"
+#include "kernel/log.h"
 
 /* =========================================================================
  * VGA text-mode constants
@@ -89,7 +90,8 @@ static void vga_scroll(void)
  * Character output
  * ========================================================================= */
 
-void vga_putchar(char c)
+/* Draw one character; the hardware cursor is left for the caller */
+static void vga_emit(char c)
 {
     switch (c) {
     case '\n':
@@ -117,7 +119,18 @@ void vga_putchar(char c)
 
     if (vga_row >= VGA_HEIGHT)
         vga_scroll();
+}
+
+void vga_putchar(char c)
+{
+    vga_emit(c);
+    vga_set_cursor(vga_col, vga_row);
+}
 
+void vga_write_buf(const char *s, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        vga_emit(s[i]);
     vga_set_cursor(vga_col, vga_row);
 }
 
@@ -142,6 +155,11 @@ static int vga_write(int scnd_id, char c)
  * Initialisation – hardware + driver registration + devfs node
  * ========================================================================= */
 
+static console_t vga_console = {
+    .name  = "vga",
+    .write = vga_write_buf,
+};
+
 void vga_init(void)
 {
     vga_color = vga_entry_color(VGA_LIGHT_GREY, VGA_BLACK);
@@ -150,4 +168,7 @@ void vga_init(void)
     char_ops_t ops = { .read = vga_read, .write = vga_write, .ioctl = NULL };
     register_char_device(0, &ops);
     devfs_register_device("vga0", DT_CHRDEV, 0, 0);
+
+    if (console_selected(vga_console.name, NULL, 0))
+        register_console(&vga_console);
 }
\ No newline at end of file
@@ -0,0 +1,432 @@
+#include "driver/irq.h"
+#include "driver/apic.h"
+#include "driver/pic.h"
+#include "kernel/rcu.h"
+#include "kernel/irqflags.h"
+#include "kernel/trace.h"
+#include "fs/devfs.h"
+#include "lib/printk.h"
+#include "lib/div64.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Controller selection
+ *
+ * The 8259A is the boot-time default (pic_init() runs before anything
+ * else); irq_init() switches to the IOAPIC when apic_init() succeeds and
+ * then masks the whole 8259A cascade.
+ * ========================================================================= */
+
+static void pic_eoi(uint8_t irq)
+{
+    if (irq < 16)
+        pic_send_eoi(irq);
+}
+
+static void pic_enable(uint8_t irq)
+{
+    if (irq < 16)
+        pic_enable_irq(irq);
+}
+
+static void pic_disable(uint8_t irq)
+{
+    if (irq < 16)
+        pic_disable_irq(irq);
+}
+
+static const irq_chip_t pic_irq_chip = {
+    .name         = "8259A",
+    .eoi          = pic_eoi,
+    .enable       = pic_enable,
+    .disable      = pic_disable,
+    .set_affinity = NULL,
+};
+
+static const irq_chip_t *irq_chip = &pic_irq_chip;
+
+/* =========================================================================
+ * Dispatch table
+ *
+ * irq_lines[] heads are read by irq_dispatch() under rcu_read_lock() and
+ * updated by request_irq()/free_irq(); an action slot removed from a chain
+ * is reused only after a grace period.
+ * ========================================================================= */
+
+static irq_action_t *irq_lines[NR_IRQS];
+static irq_action_t  irq_actions[IRQ_MAX_ACTIONS];
+
+static irq_stat_t    irq_stats[NR_CPUS][NR_IRQS];
+
+irq_cpu_t irq_cpu[NR_CPUS];
+
+extern uint32_t irq_stub_table[NR_IRQS];   /* defined in kernel/isr.s */
+
+/* Written by irq_common before it calls irq_dispatch(); the boot CPU is
+ * the only one taking interrupts, so a single slot suffices. */
+volatile uint64_t irq_entry_tsc;
+
+DEFINE_STATIC_KEY_FALSE(irq_timing_key);
+
+DEFINE_TRACE_EVENT(irq, "irq=%u entry=%u run=%u handled=%u");
+
+static irq_action_t *alloc_action(void)
+{
+    for (int i = 0; i < IRQ_MAX_ACTIONS; i++) {
+        if (!irq_actions[i].in_use) {
+            irq_actions[i].in_use = 1;
+            return &irq_actions[i];
+        }
+    }
+    return NULL;
+}
+
+/* log2 histogram bucket for a cycle count */
+static inline int hist_bucket(uint64_t cycles)
+{
+    if (cycles >> 32)
+        return IRQ_HIST_BUCKETS - 1;
+    uint32_t c = (uint32_t)cycles;
+    return c ? 31 - __builtin_clz(c) : 0;
+}
+
+/* =========================================================================
+ * Dispatcher
+ * ========================================================================= */
+
+/* Histograms and irqs-off accounting; only reached with timing on */
+static void __attribute__((noinline))
+irq_account_timing(irq_stat_t *st, uint32_t irq, uint64_t start, uint64_t end,
+                   int handled, uint32_t eip)
+{
+    uint64_t entry = irq_entry_tsc;
+
+    /* Timing switched on while this interrupt was already in flight */
+    if (!start || entry > start)
+        return;
+
+    uint64_t entry_lat = start - entry;
+    uint64_t run       = end - start;
+
+    st->entry_hist[hist_bucket(entry_lat)]++;
+    st->run_hist[hist_bucket(run)]++;
+    if (entry_lat > st->entry_max) st->entry_max = entry_lat;
+    if (run > st->run_max)         st->run_max   = run;
+
+    TRACE(irq, irq, (uint32_t)entry_lat, (uint32_t)run, handled);
+
+    uint64_t total = rdtsc() - entry;
+    st->cycles += total;
+    st->timed++;
+
+    /* The whole interrupt ran with interrupts off */
+    irqsoff_record(total, eip);
+}
+
+void irq_dispatch(regs_t *regs)
+{
+    uint32_t irq   = regs->int_no - IRQ_VECTOR_BASE;
+    int      cpu   = smp_processor_id();
+
+    if (irq >= NR_IRQS)
+        return;
+
+    irq_cpu_t *ic       = &irq_cpu[cpu];
+    regs_t    *old_regs = ic->regs;
+    ic->regs = regs;
+    ic->nesting++;
+
+    int handled = IRQ_NONE;
+    rcu_read_lock();
+    irq_action_t *first = rcu_dereference(irq_lines[irq]);
+    uint64_t start = 0, end = 0;
+    if (static_branch_unlikely(&irq_timing_key))
+        start = rdtsc();
+    for (irq_action_t *a = first; a; a = rcu_dereference(a->next))
+        handled |= a->handler((int)irq, a->data);
+    if (static_branch_unlikely(&irq_timing_key))
+        end = rdtsc();
+    rcu_read_unlock();
+
+    irq_eoi((uint8_t)irq);
+
+    ic->nesting--;
+    ic->regs = old_regs;
+
+    /* Landing outside any read-side section makes this a quiescent state */
+    rcu_quiescent_state(1);
+
+    irq_stat_t *st = &irq_stats[cpu][irq];
+
+    if (handled == IRQ_NONE)
+        st->unhandled++;
+    st->count++;
+
+    if (static_branch_unlikely(&irq_timing_key))
+        irq_account_timing(st, irq, start, end, handled,
+                           first ? (uint32_t)first->handler : regs->eip);
+    else
+        TRACE(irq, irq, 0, 0, handled);
+}
+
+/* =========================================================================
+ * /dev/irqlat
+ * ========================================================================= */
+
+/* First handler name on a line, for labelling; caller holds rcu_read_lock() */
+static const char *irq_line_name(int irq)
+{
+    irq_action_t *a = rcu_dereference(irq_lines[irq]);
+    return a ? a->name : "-";
+}
+
+static int irq_latency_show(char *buf, size_t size)
+{
+    int len = 0;
+
+    if (!static_key_enabled(&irq_timing_key))
+        len += scnprintk(buf + len, size - len,
+                         "Timing is off (write \"on\" to /dev/irqlat)\n");
+
+    for (int cpu = 0; cpu < NR_CPUS; cpu++)
+        len += scnprintk(buf + len, size - len,
+                         "CPU%d irqs-off worst case: %llu cycles from eip 0x%08x\n",
+                         cpu, irqsoff_cpu[cpu].max_cycles, irqsoff_cpu[cpu].max_eip);
+
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        for (int irq = 0; irq < NR_IRQS; irq++) {
+            irq_stat_t *st = &irq_stats[cpu][irq];
+            if (st->count == 0)
+                continue;
+
+            rcu_read_lock();
+            len += scnprintk(buf + len, size - len,
+                             "\nCPU%d IRQ %d (%s): %llu irqs, entry max %llu, run max %llu cycles\n"
+                             "      cycles >=       entry         run\n",
+                             cpu, irq, irq_line_name(irq), st->count,
+                             st->entry_max, st->run_max);
+            rcu_read_unlock();
+
+            for (int b = 0; b < IRQ_HIST_BUCKETS; b++) {
+                if (!st->entry_hist[b] && !st->run_hist[b])
+                    continue;
+                len += scnprintk(buf + len, size - len, "  %14u  %10u  %10u\n",
+                                 b ? 1u << b : 0, st->entry_hist[b], st->run_hist[b]);
+            }
+        }
+    }
+
+    return len;
+}
+
+/* Timing (and irqs-off tracking) on or off at runtime */
+static void irq_timing_set(int on)
+{
+    if (on) {
+        static_key_enable(&irqsoff_key);
+        static_key_enable(&irq_timing_key);
+    } else {
+        static_key_disable(&irq_timing_key);
+        static_key_disable(&irqsoff_key);
+    }
+}
+
+/* "on" / "off" switch timing; any other write resets the histograms and
+ * the irqs-off record */
+static int irq_latency_store(const char *buf, size_t count)
+{
+    if (count >= 2 && strncmp(buf, "on", 2) == 0) {
+        irq_timing_set(1);
+        return (int)count;
+    }
+    if (count >= 3 && strncmp(buf, "off", 3) == 0) {
+        irq_timing_set(0);
+        return (int)count;
+    }
+
+    uint32_t flags = irq_save();
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        for (int irq = 0; irq < NR_IRQS; irq++) {
+            irq_stat_t *st = &irq_stats[cpu][irq];
+            st->entry_max = 0;
+            st->run_max   = 0;
+            for (int b = 0; b < IRQ_HIST_BUCKETS; b++) {
+                st->entry_hist[b] = 0;
+                st->run_hist[b]   = 0;
+            }
+        }
+    }
+    irq_restore(flags);
+
+    irqsoff_reset();
+    return (int)count;
+}
+
+void irq_latency_dump(void)
+{
+    /* Static: the hotkey runs in interrupt context where kalloc is unsafe */
+    static char dump_buf[DEVFS_SHOW_SIZE];
+
+    int len = irq_latency_show(dump_buf, sizeof(dump_buf));
+    if (len >= (int)sizeof(dump_buf))
+        len = sizeof(dump_buf) - 1;
+    dump_buf[len] = '\0';
+
+    printk("\n=== IRQ latency ===\n%s\n", dump_buf);
+}
+
+/* =========================================================================
+ * /dev/interrupts
+ * ========================================================================= */
+
+static int irq_show(char *buf, size_t size)
+{
+    int len = 0;
+
+    len += scnprintk(buf + len, size - len,
+                     "Controller: %s\n\n"
+                     "IRQ  VEC       COUNT          CYCLES    AVG  UNHANDLED  HANDLERS\n",
+                     irq_chip->name);
+
+    for (int irq = 0; irq < NR_IRQS; irq++) {
+        uint64_t count = 0, cycles = 0, timed = 0;
+        uint32_t unhandled = 0;
+        for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+            count     += irq_stats[cpu][irq].count;
+            cycles    += irq_stats[cpu][irq].cycles;
+            timed     += irq_stats[cpu][irq].timed;
+            unhandled += irq_stats[cpu][irq].unhandled;
+        }
+
+        rcu_read_lock();
+        irq_action_t *a = rcu_dereference(irq_lines[irq]);
+        if (count == 0 && !a) {
+            rcu_read_unlock();
+            continue;
+        }
+
+        /* Average over timed interrupts only; divisor clamped to 32 bits */
+        uint32_t div = timed > 0xFFFFFFFFULL ? 0xFFFFFFFFU : (uint32_t)timed;
+        uint32_t avg = div ? (uint32_t)div_u64(cycles, div) : 0;
+        len += scnprintk(buf + len, size - len, "%3d  0x%02x  %10llu  %14llu  %5u  %9u  ",
+                         irq, IRQ_VECTOR_BASE + irq, count, cycles, avg, unhandled);
+        for (; a; a = rcu_dereference(a->next))
+            len += scnprintk(buf + len, size - len, "%s%s", a->name,
+                             a->next ? "," : "");
+        rcu_read_unlock();
+
+        len += scnprintk(buf + len, size - len, "\n");
+    }
+
+    return len;
+}
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void irq_init(void)
+{
+    for (int irq = 0; irq < NR_IRQS; irq++)
+        idt_set_gate(IRQ_VECTOR_BASE + irq, irq_stub_table[irq],
+                     GDT_KERNEL_CODE, IDT_GATE_INT32);
+
+    if (apic_init() == 0) {
+        pic_disable_all();
+        irq_chip = &apic_irq_chip;
+    }
+    printk("[IRQ] Using %s interrupt controller\n", irq_chip->name);
+
+    devfs_register_file("interrupts", irq_show, NULL);
+    devfs_register_file("irqlat", irq_latency_show, irq_latency_store);
+}
+
+int request_irq(uint8_t irq, irq_handler_t handler, void *data, const char *name)
+{
+    if (irq >= NR_IRQS || !handler)
+        return -1;
+
+    uint32_t flags = irq_save();
+
+    irq_action_t *action = alloc_action();
+    if (!action) {
+        irq_restore(flags);
+        printk("[IRQ] No free action slot for IRQ %d (%s)\n", irq, name);
+        return -1;
+    }
+    action->handler = handler;
+    action->data    = data;
+    action->name    = name ? name : "?";
+    action->next    = NULL;
+
+    /* Append so shared handlers run in registration order */
+    irq_action_t **link = &irq_lines[irq];
+    while (*link)
+        link = &(*link)->next;
+    int first = (link == &irq_lines[irq]);
+    rcu_assign_pointer(*link, action);
+
+    irq_restore(flags);
+
+    if (first)
+        irq_enable(irq);
+    return 0;
+}
+
+int free_irq(uint8_t irq, void *data)
+{
+    if (irq >= NR_IRQS)
+        return -1;
+
+    uint32_t flags = irq_save();
+
+    irq_action_t **link = &irq_lines[irq];
+    while (*link && (*link)->data != data)
+        link = &(*link)->next;
+
+    irq_action_t *action = *link;
+    if (!action) {
+        irq_restore(flags);
+        return -1;
+    }
+    rcu_assign_pointer(*link, action->next);
+    int last = (irq_lines[irq] == NULL);
+
+    irq_restore(flags);
+
+    if (last)
+        irq_disable(irq);
+
+    /* A dispatcher may still be walking through the action */
+    synchronize_rcu();
+    action->in_use = 0;
+    return 0;
+}
+
+void irq_enable(uint8_t irq)
+{
+    irq_chip->enable(irq);
+}
+
+void irq_disable(uint8_t irq)
+{
+    irq_chip->disable(irq);
+}
+
+void irq_eoi(uint8_t irq)
+{
+    irq_chip->eoi(irq);
+}
+
+int irq_set_affinity(uint8_t irq, int cpu)
+{
+    if (!irq_chip->set_affinity)
+        return -1;
+    return irq_chip->set_affinity(irq, cpu);
+}
+
+const char *irq_chip_name(void)
+{
+    return irq_chip->name;
+}
@@ -4,6 +4,8 @@
 #include "mm/slab.h"
 #include "lib/string.h"
 #include "lib/printk.h"
+#include "kernel/rcu.h"
+#include "kernel/initcall.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -11,6 +13,9 @@
  * Static Node Table
  *
  * Populated by devfs_register_device() (which may be called before mount).
+ * Searched lock-free under RCU on every open/stat/readdir: a node is
+ * published only once its fields are written, and an unregistered slot is
+ * reused only after a grace period.
  * ========================================================================= */
 
 static devfs_node_t devfs_nodes[DEVFS_MAX_NODES];
@@ -22,18 +27,20 @@ static int          devfs_node_count = 0;
 
 typedef struct devfs_file {
     devfs_node_t *node;     /* pointer into devfs_nodes[]          */
-    uint32_t      offset;   /* byte offset (block devices)         */
+    uint32_t      offset;   /* byte offset (block devices, files)  */
     int           dir_pos;  /* readdir: next node index to return  */
+    char         *data;     /* DT_REG: snapshot taken at open      */
+    uint32_t      size;     /* DT_REG: bytes in data               */
 } devfs_file_t;
 
 /* =========================================================================
- * Node Lookup
+ * Node Lookup – caller must hold rcu_read_lock()
  * ========================================================================= */
 
 static devfs_node_t *devfs_find_node(const char *name)
 {
     for (int i = 0; i < DEVFS_MAX_NODES; i++) {
-        if (devfs_nodes[i].in_use &&
+        if (rcu_slot_live(&devfs_nodes[i].in_use) &&
             strcmp(devfs_nodes[i].name, name) == 0)
             return &devfs_nodes[i];
     }
@@ -52,14 +59,17 @@ static const char *strip_leading_slash(const char *path)
  * Public API – Device Registration
  * ========================================================================= */
 
-int devfs_register_device(const char *name, uint8_t type,
-                          int dev_id, int minor)
+/* Fill a free slot and publish it; shared by device and file registration */
+static int devfs_add_node(const char *name, uint8_t type, int dev_id,
+                          int minor, devfs_show_t show, devfs_store_t store)
 {
     if (!name || strlen(name) == 0 || strlen(name) >= 64) return -1;
-    if (type != DT_BLKDEV && type != DT_CHRDEV) return -1;
 
     /* Reject duplicates */
-    if (devfs_find_node(name)) return -1;
+    rcu_read_lock();
+    devfs_node_t *dup = devfs_find_node(name);
+    rcu_read_unlock();
+    if (dup) return -1;
 
     /* Find a free slot */
     for (int i = 0; i < DEVFS_MAX_NODES; i++) {
@@ -69,7 +79,9 @@ int devfs_register_device(const char *name, uint8_t type,
             devfs_nodes[i].type     = type;
             devfs_nodes[i].dev_id   = dev_id;
             devfs_nodes[i].minor    = minor;
-            devfs_nodes[i].in_use   = 1;
+            devfs_nodes[i].show     = show;
+            devfs_nodes[i].store    = store;
+            rcu_publish_slot(&devfs_nodes[i].in_use);
             devfs_node_count++;
             return 0;
         }
@@ -77,19 +89,35 @@ int devfs_register_device(const char *name, uint8_t type,
     return -1;   /* table full */
 }
 
+int devfs_register_device(const char *name, uint8_t type,
+                          int dev_id, int minor)
+{
+    if (type != DT_BLKDEV && type != DT_CHRDEV) return -1;
+    return devfs_add_node(name, type, dev_id, minor, NULL, NULL);
+}
+
+int devfs_register_file(const char *name, devfs_show_t show,
+                        devfs_store_t store)
+{
+    if (!show) return -1;
+    return devfs_add_node(name, DT_REG, -1, 0, show, store);
+}
+
 int devfs_unregister_device(const char *name)
 {
     if (!name) return -1;
 
-    for (int i = 0; i < DEVFS_MAX_NODES; i++) {
-        if (devfs_nodes[i].in_use &&
-            strcmp(devfs_nodes[i].name, name) == 0) {
-            devfs_nodes[i].in_use = 0;
-            devfs_node_count--;
-            return 0;
-        }
-    }
-    return -1;
+    rcu_read_lock();
+    devfs_node_t *node = devfs_find_node(name);
+    rcu_read_unlock();
+    if (!node) return -1;
+
+    rcu_retire_slot(&node->in_use);
+    devfs_node_count--;
+
+    /* Lookups that found the node may still be reading its name */
+    synchronize_rcu();
+    return 0;
 }
 
 /* =========================================================================
@@ -132,11 +160,15 @@ static int devfs_open(void *fs_private, const char *path, int flags,
         f->node    = NULL;    /* marks this as the directory fd */
         f->offset  = 0;
         f->dir_pos = 0;
+        f->data    = NULL;
+        f->size    = 0;
         *file_private = f;
         return 0;
     }
 
+    rcu_read_lock();
     devfs_node_t *node = devfs_find_node(name);
+    rcu_read_unlock();
     if (!node) {
         printk("[devfs] open: no device named '%s'\n", name);
         return -1;
@@ -154,6 +186,21 @@ static int devfs_open(void *fs_private, const char *path, int flags,
     f->node    = node;
     f->offset  = 0;
     f->dir_pos = 0;
+    f->data    = NULL;
+    f->size    = 0;
+
+    /* Show files: render the snapshot now so reads are consistent */
+    if (node->type == DT_REG) {
+        f->data = (char *)kalloc(DEVFS_SHOW_SIZE);
+        if (!f->data) {
+            kfree(f);
+            return -1;
+        }
+        int len = node->show(f->data, DEVFS_SHOW_SIZE);
+        f->size = (len < 0) ? 0 : (uint32_t)len;
+        if (f->size > DEVFS_SHOW_SIZE) f->size = DEVFS_SHOW_SIZE;
+    }
+
     *file_private = f;
     return 0;
 }
@@ -162,7 +209,11 @@ static int devfs_open(void *fs_private, const char *path, int flags,
 
 static int devfs_close(void *file_private)
 {
-    if (file_private) kfree(file_private);
+    devfs_file_t *f = (devfs_file_t *)file_private;
+    if (!f) return 0;
+
+    if (f->data) kfree(f->data);
+    kfree(f);
     return 0;
 }
 
@@ -175,6 +226,15 @@ static int devfs_read(void *file_private, void *buf, size_t count)
 
     devfs_node_t *node = f->node;
 
+    if (node->type == DT_REG) {
+        if (f->offset >= f->size) return 0;   /* EOF */
+        uint32_t avail = f->size - f->offset;
+        if (count > avail) count = avail;
+        memcpy(buf, f->data + f->offset, count);
+        f->offset += (uint32_t)count;
+        return (int)count;
+    }
+
     if (node->type == DT_CHRDEV) {
         /* Read count characters one at a time */
         char *cbuf = (char *)buf;
@@ -211,6 +271,11 @@ static int devfs_write(void *file_private, const void *buf, size_t count)
 
     devfs_node_t *node = f->node;
 
+    if (node->type == DT_REG) {
+        if (!node->store) return -1;
+        return node->store((const char *)buf, count);
+    }
+
     if (node->type == DT_CHRDEV) {
         const char *cbuf = (const char *)buf;
         for (size_t i = 0; i < count; i++) {
@@ -242,8 +307,8 @@ static int devfs_seek(void *file_private, int32_t offset, int whence,
     devfs_file_t *f = (devfs_file_t *)file_private;
     if (!f || !f->node) return -1;
 
-    /* seek is meaningful only for block devices */
-    if (f->node->type != DT_BLKDEV) return -1;
+    /* seek is meaningful only for block devices and show files */
+    if (f->node->type != DT_BLKDEV && f->node->type != DT_REG) return -1;
 
     int32_t pos;
     switch (whence) {
@@ -256,8 +321,11 @@ static int devfs_seek(void *file_private, int32_t offset, int whence,
         if (pos < 0) return -1;
         break;
     case SEEK_END:
-        /* We don't know device size; treat as error */
-        return -1;
+        /* Only show files know their size */
+        if (f->node->type != DT_REG) return -1;
+        pos = (int32_t)f->size + offset;
+        if (pos < 0) return -1;
+        break;
     default:
         return -1;
     }
@@ -285,16 +353,19 @@ static int devfs_readdir(void *file_private, dirent_t *dirent)
     if (!f) return -1;
 
     /* Scan for the next in-use node starting from dir_pos */
+    rcu_read_lock();
     while (f->dir_pos < DEVFS_MAX_NODES) {
         int i = f->dir_pos++;
-        if (!devfs_nodes[i].in_use) continue;
+        if (!rcu_slot_live(&devfs_nodes[i].in_use)) continue;
 
         strncpy(dirent->name, devfs_nodes[i].name, 255);
         dirent->name[255] = '\0';
         dirent->inode     = (uint32_t)i + 1;   /* 1-based synthetic inode */
         dirent->type      = devfs_nodes[i].type;
+        rcu_read_unlock();
         return 1;   /* entry returned */
     }
+    rcu_read_unlock();
 
     return 0;   /* end of directory */
 }
@@ -345,15 +416,21 @@ static int devfs_stat(void *fs_private, const char *path, stat_t *st)
         return 0;
     }
 
+    rcu_read_lock();
     devfs_node_t *node = devfs_find_node(name);
-    if (!node) return -1;
+    if (!node) {
+        rcu_read_unlock();
+        return -1;
+    }
 
     st->type  = node->type;
     st->size  = 0;
     st->inode = (uint32_t)(node - devfs_nodes) + 1;
     st->ctime = 0;
     st->mtime = 0;
-    st->mode  = (node->type == DT_CHRDEV) ? 0600 : 0660;
+    st->mode  = (node->type == DT_CHRDEV) ? 0600 :
+                (node->type == DT_REG)    ? (node->store ? 0644 : 0444) : 0660;
+    rcu_read_unlock();
     return 0;
 }
 
@@ -394,4 +471,7 @@ void devfs_init(void)
         printk("[devfs] FAILED to mount at /dev\n");
         return;
     }
-}
\ No newline at end of file
+}
+
+/* Mounts itself at /dev */
+INITCALL(devfs, devfs_init, 0, "vfs");
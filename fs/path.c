@@ -0,0 +1,112 @@
+#include "fs/fs.h"
+#include "lib/string.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * Path Resolution
+ *
+ * resolve_path: build an absolute, normalised path from cwd + input.
+ *   - If input starts with '/' use it directly.
+ *   - Otherwise prepend cwd (callers pass current->cwd).
+ *   - Collapse "." and ".." components.
+ *   - Result is written into out[0..size-1] (NUL-terminated).
+ *   - Returns 0 on success, -1 if the result exceeds size.
+ * ========================================================================= */
+
+int resolve_path(const char *cwd, const char *input, char *out, size_t size)
+{
+    char tmp[MAX_PATH_LEN];
+    int  tlen = 0;
+
+    /* Build raw absolute path in tmp */
+    if (input[0] == '/') {
+        /* Already absolute */
+        tlen = strlen(input);
+        if (tlen >= MAX_PATH_LEN) return -1;
+        strcpy(tmp, input);
+    } else {
+        /* Relative – prepend cwd */
+        int cwdlen = strlen(cwd);
+        int inlen  = strlen(input);
+        if (cwdlen + 1 + inlen + 1 >= MAX_PATH_LEN) return -1;
+
+        strcpy(tmp, cwd);
+        tlen = cwdlen;
+        /* Ensure separator */
+        if (tlen > 0 && tmp[tlen - 1] != '/') {
+            tmp[tlen++] = '/';
+            tmp[tlen]   = '\0';
+        }
+        strcpy(tmp + tlen, input);
+        tlen += inlen;
+    }
+
+    /* Normalise: process components into out using a simple stack approach.
+     * We re-use out as the output buffer, writing component by component. */
+    char *dst = out;
+    char *end = out + size - 1;  /* reserve space for NUL */
+    const char *p = tmp;
+
+    /* Always start with '/' */
+    if (dst >= end) return -1;
+    *dst++ = '/';
+
+    /* Track output stack (each component starts at a saved position) */
+    /* Simple in-place approach: scan components, handle . and .. */
+    while (*p) {
+        /* Skip slashes */
+        while (*p == '/') p++;
+        if (!*p) break;
+
+        /* Find end of component */
+        const char *comp_start = p;
+        while (*p && *p != '/') p++;
+        int comp_len = (int)(p - comp_start);
+
+        if (comp_len == 1 && comp_start[0] == '.') {
+            /* Current dir – skip */
+            continue;
+        }
+
+        if (comp_len == 2 && comp_start[0] == '.' && comp_start[1] == '.') {
+            /* Parent dir – remove last component from out */
+            /* Walk back past any trailing slash */
+            if (dst > out + 1) {
+                dst--;  /* step over the '/' we added */
+                /* Find start of previous component */
+                while (dst > out + 1 && *(dst - 1) != '/')
+                    dst--;
+            }
+            continue;
+        }
+
+        /* Regular component – append "/component" (the leading '/' is
+         * already in out from initialisation or a previous component) */
+        if (dst > out + 1) {
+            /* Add separator (not needed for first component after root '/') */
+            if (*(dst - 1) != '/') {
+                if (dst >= end) return -1;
+                *dst++ = '/';
+            }
+        }
+        if (dst + comp_len > end) return -1;
+        memcpy(dst, comp_start, comp_len);
+        dst += comp_len;
+    }
+
+    /* A trailing ".." leaves the separator of the component it removed */
+    if (dst > out + 1 && *(dst - 1) == '/')
+        dst--;
+
+    *dst = '\0';
+
+    /* Ensure at minimum "/" */
+    if (dst == out) {
+        if (size < 2) return -1;
+        out[0] = '/';
+        out[1] = '\0';
+    }
+
+    return 0;
+}
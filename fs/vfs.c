@@ -3,6 +3,9 @@
 #include "mm/slab.h"
 #include "lib/printk.h"
 #include "lib/string.h"
+#include "kernel/rcu.h"
+#include "kernel/trace.h"
+#include "kernel/initcall.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -27,114 +30,18 @@ typedef struct {
 
 /* =========================================================================
  * Global State
+ *
+ * mount_table is scanned on every path-based operation and is read
+ * lock-free under RCU.  fs_mount() publishes a slot only after filling it;
+ * fs_unmount() retires the slot and waits for a grace period before the
+ * filesystem's unmount callback may tear down fs_private.
  * ========================================================================= */
 
 static mount_point_t mount_table[MAX_MOUNT_POINTS];
 static fs_driver_t   fs_drivers[MAX_MOUNT_POINTS];
 
-/* =========================================================================
- * Path Resolution
- *
- * resolve_path: build an absolute, normalised path from cwd + input.
- *   - If input starts with '/' use it directly.
- *   - Otherwise prepend current->cwd.
- *   - Collapse "." and ".." components.
- *   - Result is written into out[0..size-1] (NUL-terminated).
- *   - Returns 0 on success, -1 if the result exceeds size.
- * ========================================================================= */
-
-static int resolve_path(const char *input, char *out, size_t size)
-{
-    char tmp[MAX_PATH_LEN];
-    int  tlen = 0;
-
-    /* Build raw absolute path in tmp */
-    if (input[0] == '/') {
-        /* Already absolute */
-        tlen = strlen(input);
-        if (tlen >= MAX_PATH_LEN) return -1;
-        strcpy(tmp, input);
-    } else {
-        /* Relative – prepend cwd */
-        int cwdlen = strlen(current->cwd);
-        int inlen  = strlen(input);
-        if (cwdlen + 1 + inlen + 1 >= MAX_PATH_LEN) return -1;
-
-        strcpy(tmp, current->cwd);
-        tlen = cwdlen;
-        /* Ensure separator */
-        if (tlen > 0 && tmp[tlen - 1] != '/') {
-            tmp[tlen++] = '/';
-            tmp[tlen]   = '\0';
-        }
-        strcpy(tmp + tlen, input);
-        tlen += inlen;
-    }
-
-    /* Normalise: process components into out using a simple stack approach.
-     * We re-use out as the output buffer, writing component by component. */
-    char *dst = out;
-    char *end = out + size - 1;  /* reserve space for NUL */
-    const char *p = tmp;
-
-    /* Always start with '/' */
-    if (dst >= end) return -1;
-    *dst++ = '/';
-
-    /* Track output stack (each component starts at a saved position) */
-    /* Simple in-place approach: scan components, handle . and .. */
-    while (*p) {
-        /* Skip slashes */
-        while (*p == '/') p++;
-        if (!*p) break;
-
-        /* Find end of component */
-        const char *comp_start = p;
-        while (*p && *p != '/') p++;
-        int comp_len = (int)(p - comp_start);
-
-        if (comp_len == 1 && comp_start[0] == '.') {
-            /* Current dir – skip */
-            continue;
-        }
-
-        if (comp_len == 2 && comp_start[0] == '.' && comp_start[1] == '.') {
-            /* Parent dir – remove last component from out */
-            /* Walk back past any trailing slash */
-            if (dst > out + 1) {
-                dst--;  /* step over the '/' we added */
-                /* Find start of previous component */
-                while (dst > out + 1 && *(dst - 1) != '/')
-                    dst--;
-            }
-            continue;
-        }
-
-        /* Regular component – append "/component" (the leading '/' is
-         * already in out from initialisation or a previous component) */
-        if (dst > out + 1) {
-            /* Add separator (not needed for first component after root '/') */
-            if (*(dst - 1) != '/') {
-                if (dst >= end) return -1;
-                *dst++ = '/';
-            }
-        }
-        if (dst + comp_len > end) return -1;
-        memcpy(dst, comp_start, comp_len);
-        dst += comp_len;
-    }
-
-    *dst = '\0';
-
-    /* Ensure at minimum "/" */
-    if (dst == out) {
-        if (size < 2) return -1;
-        out[0] = '/';
-        out[1] = '\0';
-    }
-
-    return 0;
-}
+DEFINE_TRACE_EVENT(fs_read,  "fd=%d count=%u ret=%d");
+DEFINE_TRACE_EVENT(fs_write, "fd=%d count=%u ret=%d");
 
 /* =========================================================================
  * File Handle Management
@@ -193,14 +100,15 @@ static int find_fs_driver(const char *fs_name)
 
 /* Find best (longest-prefix) mount point for abs_path.
  * Sets *match_len to the length of the matched prefix.
- * Returns NULL if no mount point matches. */
+ * Returns NULL if no mount point matches.
+ * Caller must hold rcu_read_lock() while using the result. */
 static mount_point_t *find_mount_point(const char *abs_path, int *match_len)
 {
     mount_point_t *best = NULL;
     int            best_len = 0;
 
     for (int i = 0; i < MAX_MOUNT_POINTS; i++) {
-        if (!mount_table[i].in_use) continue;
+        if (!rcu_slot_live(&mount_table[i].in_use)) continue;
 
         int mlen = strlen(mount_table[i].mount_path);
 
@@ -265,6 +173,10 @@ int fs_mount(int device_id, int partition_id,
 {
     if (!fs_type || !mount_path) return -1;
 
+    /* A disk mount is the first use of the deferred block probes */
+    if (device_id >= 0)
+        initcall_flush();
+
     int fs_id = find_fs_driver(fs_type);
     if (fs_id < 0) {
         printk("[VFS] Unknown filesystem type: %s\n", fs_type);
@@ -291,7 +203,7 @@ int fs_mount(int device_id, int partition_id,
     mount_table[slot].device_id    = device_id;
     mount_table[slot].partition_id = partition_id;
     mount_table[slot].fs_private   = fs_private;
-    mount_table[slot].in_use       = 1;
+    rcu_publish_slot(&mount_table[slot].in_use);
 
     printk("[VFS] Mounted %s (dev %d, part %d) at %s\n",
            fs_type, device_id, partition_id, mount_path);
@@ -306,11 +218,14 @@ int fs_unmount(const char *mount_path)
         if (mount_table[i].in_use &&
             strcmp(mount_table[i].mount_path, mount_path) == 0)
         {
+            /* Unpublish first; lookups in flight may still hold the slot */
+            rcu_retire_slot(&mount_table[i].in_use);
+            synchronize_rcu();
+
             int fs_id = mount_table[i].fs_id;
             if (fs_drivers[fs_id].ops.unmount)
                 fs_drivers[fs_id].ops.unmount(mount_table[i].fs_private);
 
-            mount_table[i].in_use     = 0;
             mount_table[i].fs_private = NULL;
             printk("[VFS] Unmounted %s\n", mount_path);
             return 0;
@@ -328,28 +243,41 @@ int fs_open(const char *path, int flags)
     if (!path) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
+
+    rcu_read_lock();
 
     const char *rel_path;
     mount_point_t *mp = resolve_mount(abs, &rel_path);
-    if (!mp) { printk("[VFS] No mount point for: %s\n", abs); return -1; }
+    if (!mp) {
+        rcu_read_unlock();
+        printk("[VFS] No mount point for: %s\n", abs);
+        return -1;
+    }
 
     file_handle_t *fh = alloc_file_handle();
-    if (!fh) { printk("[VFS] OOM: file handle\n"); return -1; }
+    if (!fh) {
+        rcu_read_unlock();
+        printk("[VFS] OOM: file handle\n");
+        return -1;
+    }
 
     int   fs_id       = mp->fs_id;
+    void *fs_private  = mp->fs_private;
     void *file_private = NULL;
 
     if (fs_drivers[fs_id].ops.open) {
-        if (fs_drivers[fs_id].ops.open(mp->fs_private, rel_path,
+        if (fs_drivers[fs_id].ops.open(fs_private, rel_path,
                                        flags, &file_private) != 0) {
+            rcu_read_unlock();
             free_file_handle(fh->fd);
             return -1;
         }
     }
+    rcu_read_unlock();
 
     fh->fs_id        = fs_id;
-    fh->fs_private   = mp->fs_private;
+    fh->fs_private   = fs_private;
     fh->file_private = file_private;
     fh->offset       = 0;
     fh->flags        = flags;
@@ -381,6 +309,7 @@ int fs_read(int fd, void *buf, size_t count)
         n = fs_drivers[fh->fs_id].ops.read(fh->file_private, buf, count);
         if (n > 0) fh->offset += n;
     }
+    TRACE(fs_read, fd, count, n);
     return n;
 }
 
@@ -397,6 +326,7 @@ int fs_write(int fd, const void *buf, size_t count)
         n = fs_drivers[fh->fs_id].ops.write(fh->file_private, buf, count);
         if (n > 0) fh->offset += n;
     }
+    TRACE(fs_write, fd, count, n);
     return n;
 }
 
@@ -469,15 +399,20 @@ int fs_mkdir(const char *path, uint32_t mode)
     if (!path) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
+
+    rcu_read_lock();
 
+    int ret = -1;
     const char *rel;
     mount_point_t *mp = resolve_mount(abs, &rel);
-    if (!mp) return -1;
+    if (mp && fs_drivers[mp->fs_id].ops.mkdir) {
+        int fs_id = mp->fs_id;
+        ret = fs_drivers[fs_id].ops.mkdir(mp->fs_private, rel, mode);
+    }
 
-    int fs_id = mp->fs_id;
-    if (!fs_drivers[fs_id].ops.mkdir) return -1;
-    return fs_drivers[fs_id].ops.mkdir(mp->fs_private, rel, mode);
+    rcu_read_unlock();
+    return ret;
 }
 
 int fs_rmdir(const char *path)
@@ -485,15 +420,20 @@ int fs_rmdir(const char *path)
     if (!path) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
+
+    rcu_read_lock();
 
+    int ret = -1;
     const char *rel;
     mount_point_t *mp = resolve_mount(abs, &rel);
-    if (!mp) return -1;
+    if (mp && fs_drivers[mp->fs_id].ops.rmdir) {
+        int fs_id = mp->fs_id;
+        ret = fs_drivers[fs_id].ops.rmdir(mp->fs_private, rel);
+    }
 
-    int fs_id = mp->fs_id;
-    if (!fs_drivers[fs_id].ops.rmdir) return -1;
-    return fs_drivers[fs_id].ops.rmdir(mp->fs_private, rel);
+    rcu_read_unlock();
+    return ret;
 }
 
 int fs_unlink(const char *path)
@@ -501,15 +441,20 @@ int fs_unlink(const char *path)
     if (!path) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
+
+    rcu_read_lock();
 
+    int ret = -1;
     const char *rel;
     mount_point_t *mp = resolve_mount(abs, &rel);
-    if (!mp) return -1;
+    if (mp && fs_drivers[mp->fs_id].ops.unlink) {
+        int fs_id = mp->fs_id;
+        ret = fs_drivers[fs_id].ops.unlink(mp->fs_private, rel);
+    }
 
-    int fs_id = mp->fs_id;
-    if (!fs_drivers[fs_id].ops.unlink) return -1;
-    return fs_drivers[fs_id].ops.unlink(mp->fs_private, rel);
+    rcu_read_unlock();
+    return ret;
 }
 
 int fs_rename(const char *old_path, const char *new_path)
@@ -517,8 +462,10 @@ int fs_rename(const char *old_path, const char *new_path)
     if (!old_path || !new_path) return -1;
 
     char abs_old[MAX_PATH_LEN], abs_new[MAX_PATH_LEN];
-    if (resolve_path(old_path, abs_old, sizeof(abs_old)) != 0) return -1;
-    if (resolve_path(new_path, abs_new, sizeof(abs_new)) != 0) return -1;
+    if (resolve_path(current->cwd, old_path, abs_old, sizeof(abs_old)) != 0) return -1;
+    if (resolve_path(current->cwd, new_path, abs_new, sizeof(abs_new)) != 0) return -1;
+
+    rcu_read_lock();
 
     /* Both paths must be on the same filesystem */
     const char *rel_old, *rel_new;
@@ -526,13 +473,19 @@ int fs_rename(const char *old_path, const char *new_path)
     mount_point_t *mp_new = resolve_mount(abs_new, &rel_new);
 
     if (!mp_old || !mp_new || mp_old != mp_new) {
+        rcu_read_unlock();
         printk("[VFS] fs_rename: cross-device rename not supported\n");
         return -1;
     }
 
+    int ret = -1;
     int fs_id = mp_old->fs_id;
-    if (!fs_drivers[fs_id].ops.rename) return -1;
-    return fs_drivers[fs_id].ops.rename(mp_old->fs_private, rel_old, rel_new);
+    if (fs_drivers[fs_id].ops.rename)
+        ret = fs_drivers[fs_id].ops.rename(mp_old->fs_private,
+                                           rel_old, rel_new);
+
+    rcu_read_unlock();
+    return ret;
 }
 
 int fs_stat(const char *path, stat_t *st)
@@ -540,15 +493,20 @@ int fs_stat(const char *path, stat_t *st)
     if (!path || !st) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
 
+    rcu_read_lock();
+
+    int ret = -1;
     const char *rel;
     mount_point_t *mp = resolve_mount(abs, &rel);
-    if (!mp) return -1;
+    if (mp && fs_drivers[mp->fs_id].ops.stat) {
+        int fs_id = mp->fs_id;
+        ret = fs_drivers[fs_id].ops.stat(mp->fs_private, rel, st);
+    }
 
-    int fs_id = mp->fs_id;
-    if (!fs_drivers[fs_id].ops.stat) return -1;
-    return fs_drivers[fs_id].ops.stat(mp->fs_private, rel, st);
+    rcu_read_unlock();
+    return ret;
 }
 
 /* =========================================================================
@@ -560,27 +518,37 @@ int fs_chdir(const char *path)
     if (!path) return -1;
 
     char abs[MAX_PATH_LEN];
-    if (resolve_path(path, abs, sizeof(abs)) != 0) return -1;
+    if (resolve_path(current->cwd, path, abs, sizeof(abs)) != 0) return -1;
 
     /* Verify the target exists and is a directory via stat */
+    rcu_read_lock();
+
     const char *rel;
     mount_point_t *mp = resolve_mount(abs, &rel);
-    if (!mp) { printk("[VFS] chdir: no mount point for %s\n", abs); return -1; }
+    if (!mp) {
+        rcu_read_unlock();
+        printk("[VFS] chdir: no mount point for %s\n", abs);
+        return -1;
+    }
 
     int fs_id = mp->fs_id;
     if (fs_drivers[fs_id].ops.stat) {
         stat_t st;
         if (fs_drivers[fs_id].ops.stat(mp->fs_private, rel, &st) != 0) {
+            rcu_read_unlock();
             printk("[VFS] chdir: %s not found\n", abs);
             return -1;
         }
         if (st.type != DT_DIR) {
+            rcu_read_unlock();
             printk("[VFS] chdir: %s is not a directory\n", abs);
             return -1;
         }
     }
     /* If FS doesn't implement stat, we trust the caller */
 
+    rcu_read_unlock();
+
     strncpy(current->cwd, abs, MAX_PATH_LEN - 1);
     current->cwd[MAX_PATH_LEN - 1] = '\0';
     return 0;
@@ -611,4 +579,6 @@ void vfs_init(void)
         fs_drivers[i].in_use = 0;
 
     printk("[VFS] Virtual filesystem initialized\n");
-}
\ No newline at end of file
+}
+
+INITCALL(vfs, vfs_init, 0);
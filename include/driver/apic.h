@@ -0,0 +1,67 @@
+#ifndef APIC_H
+#define APIC_H
+
+#include <stdint.h>
+#include "driver/irq.h"
+
+/* =========================================================================
+ * Local APIC and I/O APIC
+ *
+ * Discovery uses the Intel MultiProcessor Specification tables: the
+ * floating pointer structure is searched for in the EBDA, the last KB of
+ * base memory and the BIOS ROM; the configuration table lists processors,
+ * I/O APICs and ISA interrupt source overrides.
+ * ========================================================================= */
+
+/* IA32_APIC_BASE MSR */
+#define MSR_APIC_BASE          0x1B
+#define MSR_APIC_BASE_ENABLE   (1u << 11)
+
+/* Local APIC register offsets */
+#define LAPIC_ID               0x020
+#define LAPIC_VERSION          0x030
+#define LAPIC_TPR              0x080
+#define LAPIC_EOI              0x0B0
+#define LAPIC_SVR              0x0F0
+#define LAPIC_LVT_TIMER        0x320
+#define LAPIC_LVT_LINT0        0x350
+#define LAPIC_LVT_LINT1        0x360
+#define LAPIC_LVT_ERROR        0x370
+
+#define LAPIC_SVR_ENABLE       (1u << 8)
+#define LAPIC_LVT_MASKED       (1u << 16)
+#define LAPIC_LVT_NMI          (4u << 8)
+
+/* I/O APIC registers (indirect through IOREGSEL / IOWIN) */
+#define IOAPIC_REGSEL          0x00
+#define IOAPIC_WIN             0x10
+#define IOAPIC_REG_ID          0x00
+#define IOAPIC_REG_VER         0x01
+#define IOAPIC_REG_REDTBL      0x10   /* + 2 * pin (low), + 2 * pin + 1 (high) */
+
+/* Redirection entry bits */
+#define IOAPIC_RTE_ACTIVE_LOW  (1u << 13)
+#define IOAPIC_RTE_LEVEL       (1u << 15)
+#define IOAPIC_RTE_MASKED      (1u << 16)
+
+/* =========================================================================
+ * Functions
+ * ========================================================================= */
+
+/**
+ * Discover and enable the local APIC and I/O APICs, routing every IRQ
+ * (masked) to the boot CPU.  Returns 0 when APIC mode is active, -1 when
+ * the machine has no usable APIC and the 8259A must stay in charge.
+ */
+int apic_init(void);
+
+/** Signal end-of-interrupt to the local APIC */
+void lapic_eoi(void);
+
+/** APIC ID of the calling CPU */
+uint8_t lapic_id(void);
+
+/** Controller callbacks used by irq.c once apic_init() succeeded */
+extern const irq_chip_t apic_irq_chip;
+
+#endif /* APIC_H */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "driver/block/cache.h"
 
 /* =========================================================================
  * Shared ioctl callback type (guarded, same definition as in char.h)
@@ -24,8 +25,17 @@ typedef struct {
     block_read_fn  read;
     block_write_fn write;
     ioctl_fn       ioctl;
+    int            flags;      /* BLOCK_* below */
+    uint32_t       max_blocks; /* largest read/write count; 0: no limit */
 } block_ops_t;
 
+/*
+ * The device's I/O is not cached at this level.  For devices that remap
+ * onto another block device (partitions): the underlying disk caches the
+ * blocks already, and a second copy would go stale on writes to the disk.
+ */
+#define BLOCK_NOCACHE  (1 << 0)
+
 /* =========================================================================
  * Public API
  * ========================================================================= */
@@ -34,27 +44,93 @@ typedef struct {
 int register_block_device(int prim_id, block_ops_t *ops);
 
 /**
- * Read count blocks starting at offset from block device prim_id.
- * Goes through the LRU cache for single-block reads at offset 0.
+ * Unregister a block device.  Cached blocks are written back and dropped,
+ * and the call returns only once no bread/bwrite can still reach the
+ * driver's callbacks.  Must be called from process context.
+ * Returns 0 or -1 if prim_id is not registered.
+ */
+int unregister_block_device(int prim_id);
+
+/**
+ * Read count blocks starting at offset from block device prim_id into a
+ * caller buffer (a copying alternative to bread_ref() below).
+ * Blocks in the cache are copied from it; each run of consecutive
+ * misses is one driver read, and the blocks read are cached.
  * Returns bytes read or -1 on error.
  */
 int bread(int prim_id, int scnd_id, void *buf, uint32_t offset, size_t count);
 
 /**
  * Write count blocks starting at offset to block device prim_id.
- * Keeps cache consistent on single-block writes at offset 0.
+ * Write-through (default): the driver writes all of them with one call
+ * and the cache keeps the new contents.  Write-back (cache_writeback()):
+ * the blocks are only stored in the cache, dirty, and reach the disk
+ * later or on bsync(); blocks that find no cache slot are written now.
  * Returns bytes written or -1 on error.
  */
 int bwrite(int prim_id, int scnd_id, const void *buf,
            uint32_t offset, size_t count);
 
-/** Send an ioctl command to a block device. Returns device value or -1. */
-int block_ioctl(int prim_id, int scnd_id, unsigned int command);
+/**
+ * Write back the dirty cached blocks of block device prim_id (-1: all
+ * devices).  Returns the number of blocks written or -1 on error.
+ */
+int bsync(int prim_id);
+
+/* =========================================================================
+ * Buffer references
+ *
+ * Zero-copy access to single cached blocks, for code that reads
+ * metadata in place or edits it:
+ *
+ *   cache_buf_t *b = bread_ref(dev, 0, blk);
+ *   if (!b)
+ *       return -1;
+ *   ... read or change b->data ...
+ *   bmark_dirty(b);           (if changed)
+ *   brelse(b);
+ *
+ * A referenced block is pinned: it is not evicted and its data does not
+ * move, though bwrite() of the same block updates it in place.  Every
+ * reference must be released; pinned blocks keep the cache from reusing
+ * their slots.  BLOCK_NOCACHE devices have no buffers (NULL): use the
+ * device they remap onto.
+ * ========================================================================= */
+
+/**
+ * Reference the buffer for a block without reading it.  For blocks about
+ * to be overwritten whole: b->uptodate says whether data holds the disk
+ * contents.  Returns NULL if the device is unknown or uncached, or no
+ * buffer is free.
+ */
+cache_buf_t *bget(int prim_id, int scnd_id, uint32_t block);
+
+/**
+ * Reference the buffer for a block, reading it from the device if it is
+ * not cached.  Returns NULL as bget() does, or on a read error.
+ */
+cache_buf_t *bread_ref(int prim_id, int scnd_id, uint32_t block);
+
+/** The buffer's data was changed; it is written back later (cache_dirty). */
+void bmark_dirty(cache_buf_t *b);
+
+/** Release a buffer reference (NULL is ignored). */
+void brelse(cache_buf_t *b);
 
 /**
- * Initialise all block devices: IDE disks, MBR partition table.
- * Must be called after cache_init().
+ * bwrite() without the cache, for the cache's own write-back.  Anyone
+ * else would leave a stale cached copy behind.
  */
-void block_init(void);
+int bwrite_direct(int prim_id, int scnd_id, const void *buf,
+                  uint32_t offset, size_t count);
+
+/**
+ * Largest block count one read/write of the device may ask for
+ * (block_ops_t.max_blocks), or 0 if unlimited or not registered.
+ */
+uint32_t block_max_blocks(int prim_id);
+
+/** Send an ioctl command to a block device. Returns device value or -1. */
+int block_ioctl(int prim_id, int scnd_id, unsigned int command);
 
 #endif /* DRIVER_BLOCK_H */
\ No newline at end of file
@@ -5,15 +5,48 @@
 #include <stddef.h>
 
 /* =========================================================================
- * Block Device LRU Cache
+ * Block Device Cache
  *
- * Implements a Least Recently Used (LRU) cache for block devices.
- * Caches fixed-size blocks (512 bytes) to reduce physical I/O.
+ * Caches fixed-size blocks (512 bytes) for block devices to reduce
+ * physical I/O.  Blocks are found through a hash index, so lookups do
+ * not slow down as the cache grows.
+ *
+ * Blocks are stored in whole pages.  The cache grows while memory is
+ * plentiful and gives pages back when it runs low, between a floor and
+ * a ceiling set with "blkcache=MIN,MAX" (KB) on the command line.  The
+ * defaults are 32 KB and a quarter of memory.
+ *
+ * Dirty blocks are written back from the idle loop once they are a few
+ * seconds old, sooner when much of the cache is dirty.  bwrite() is
+ * write-through unless write-back mode is on ("blkcache=MIN,MAX,wb" or
+ * cache_set_writeback()); then it only dirties the cached blocks.
+ *
+ * Blocks are replaced least recently used first, or with the
+ * scan-resistant 2Q policy ("blkcache=MIN,MAX,2q" or cache_set_policy()),
+ * under which one pass over a large device does not push out blocks in
+ * repeated use.  Options combine: "blkcache=,,wb,2q".
  * ========================================================================= */
 
 /* Cache configuration */
 #define CACHE_BLOCK_SIZE 512    /* Standard disk sector size */
-#define CACHE_MAX_ENTRIES 64    /* Maximum cached blocks (32KB total) */
+
+/* Replacement policies (cache_set_policy) */
+#define CACHE_POLICY_LRU 0
+#define CACHE_POLICY_2Q  1
+
+/*
+ * A cached block handed out by cache_get() (and bget()/bread_ref() in
+ * block.h).  data stays put and the block stays cached until the
+ * reference is dropped; if the block is invalidated meanwhile, the
+ * buffer lives on outside the cache until then.
+ */
+typedef struct cache_buf {
+    uint8_t *data;              /* CACHE_BLOCK_SIZE bytes */
+    int      prim_id;
+    int      scnd_id;
+    uint32_t block;
+    int      uptodate;          /* 0: data not read in yet */
+} cache_buf_t;
 
 /* =========================================================================
  * Cache API
@@ -48,6 +81,36 @@ int cache_lookup(int prim_id, int scnd_id, uint32_t offset, void *buf);
  */
 int cache_insert(int prim_id, int scnd_id, uint32_t offset, const void *data);
 
+/**
+ * Take a reference to a cached block
+ * Counts a hit if the block is there and up to date, a miss otherwise.
+ *
+ * @param prim_id Primary device ID
+ * @param scnd_id Secondary device ID
+ * @param offset Block offset (block number relative to device)
+ * @param create If the block is not cached, take a slot for it (with
+ *               uptodate 0) instead of returning NULL
+ * @return The buffer, or NULL (not cached, or no slot free: every one
+ *         is referenced or memory is out)
+ */
+cache_buf_t *cache_get(int prim_id, int scnd_id, uint32_t offset, int create);
+
+/**
+ * Drop a reference taken with cache_get()
+ *
+ * @param buf Buffer to release; not to be used afterwards
+ */
+void cache_put(cache_buf_t *buf);
+
+/**
+ * Mark a referenced buffer's data as modified
+ * It is written back like any dirty block (eviction, invalidation or
+ * cache_flush()); if it was invalidated while referenced, at once.
+ *
+ * @param buf Buffer whose data was changed in place
+ */
+void cache_dirty(cache_buf_t *buf);
+
 /**
  * Mark a cached block as dirty (modified)
  * 
@@ -59,22 +122,82 @@ int cache_insert(int prim_id, int scnd_id, uint32_t offset, const void *data);
 int cache_mark_dirty(int prim_id, int scnd_id, uint32_t offset);
 
 /**
- * Flush all dirty blocks to their devices
- * Should be called periodically or before shutdown
+ * Store a block written by bwrite() in write-back mode: cached and
+ * dirty, to be written back later.  When a large share of the cache is
+ * dirty, the oldest blocks are written back before this returns.
+ *
+ * @param prim_id Primary device ID
+ * @param scnd_id Secondary device ID
+ * @param offset Block offset (block number relative to device)
+ * @param data Block data
+ * @return 0 on success, -1 if there is no slot (write it directly)
+ */
+int cache_write(int prim_id, int scnd_id, uint32_t offset, const void *data);
+
+/**
+ * Write back the dirty blocks of one device, oldest first
+ *
+ * @param prim_id Primary device ID, or -1 for all devices
+ * @return Number of blocks written, or -1 on error (the rest stay dirty)
+ */
+int cache_sync(int prim_id);
+
+/**
+ * Flush all dirty blocks to their devices: cache_sync(-1)
  * 
  * @return Number of blocks written, or -1 on error
  */
 int cache_flush(void);
 
+/**
+ * Choose write-back (nonzero) or write-through bwrite()
+ * Switching to write-through writes back every dirty block first.
+ */
+void cache_set_writeback(int on);
+
+/** Nonzero in write-back mode. */
+int cache_writeback(void);
+
+/**
+ * Choose the replacement policy, CACHE_POLICY_LRU or CACHE_POLICY_2Q
+ * Cached blocks stay; switching to LRU forgets 2Q's history.
+ */
+void cache_set_policy(int policy);
+
+/** The replacement policy in use (CACHE_POLICY_*). */
+int cache_policy(void);
+
 /**
  * Invalidate (remove) a specific block from cache
- * Writes back if dirty
+ * Writes back if dirty; if that fails the block stays cached and dirty
  * 
  * @param prim_id Primary device ID
  * @param scnd_id Secondary device ID
  * @param offset Block offset (block number relative to device)
+ * @return 0 on success, -1 if a dirty block could not be written back
+ */
+int cache_invalidate(int prim_id, int scnd_id, uint32_t offset);
+
+/**
+ * Invalidate every cached block of a device (all secondary IDs)
+ * Writes back dirty blocks first.  The blocks are dropped regardless,
+ * since the device may be going away; any whose write-back failed are
+ * reported at KERN_ERR.
+ *
+ * @param prim_id Primary device ID
+ * @return 0 on success, -1 if dirty data was lost
  */
-void cache_invalidate(int prim_id, int scnd_id, uint32_t offset);
+int cache_invalidate_device(int prim_id);
+
+/**
+ * Set the size bounds, rounded up to whole pages.  The cache can
+ * always grow to min_kb and never grows past max_kb; a ceiling below
+ * the current size shrinks the cache at once.
+ *
+ * @param min_kb Floor in KB; memory pressure never shrinks below it
+ * @param max_kb Ceiling in KB (raised to min_kb and at least one page)
+ */
+void cache_set_limits(uint32_t min_kb, uint32_t max_kb);
 
 /**
  * Get cache statistics
@@ -85,4 +208,30 @@ void cache_invalidate(int prim_id, int scnd_id, uint32_t offset);
  */
 void cache_stats(uint32_t *hits, uint32_t *misses, uint32_t *entries);
 
+/**
+ * Get the cache's memory use and bounds, in pages
+ *
+ * @param pages Pointer to store the data pages held (can be NULL)
+ * @param min Pointer to store the floor (can be NULL)
+ * @param max Pointer to store the ceiling (can be NULL)
+ */
+void cache_usage(uint32_t *pages, uint32_t *min, uint32_t *max);
+
+/** Misses that 2Q found on its ghost list and cached as hot blocks. */
+uint32_t cache_ghost_hits(void);
+
+/** Number of dirty blocks waiting to be written back. */
+uint32_t cache_dirty_count(void);
+
+/**
+ * Get write-back statistics
+ * Write-back sorts dirty blocks and merges neighbours into one request.
+ *
+ * @param blocks Pointer to store blocks written back (can be NULL)
+ * @param requests Pointer to store driver writes issued for them (can be NULL)
+ * @param merged Pointer to store requests saved by merging,
+ *               blocks - requests (can be NULL)
+ */
+void cache_wb_stats(uint32_t *blocks, uint32_t *requests, uint32_t *merged);
+
 #endif /* CACHE_H */
\ No newline at end of file
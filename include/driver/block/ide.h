@@ -87,7 +87,7 @@ void ide_init(void);
  * 
  * @param disk_id Disk ID (0-3)
  * @param lba Starting LBA sector number
- * @param count Number of sectors to read (1-256)
+ * @param count Number of sectors to read (1-255)
  * @param buffer Buffer to store read data (must be count * 512 bytes)
  * @return 0 on success, -1 on error
  */
@@ -98,7 +98,7 @@ int ide_read_sectors(uint8_t disk_id, uint32_t lba, uint8_t count, void *buffer)
  * 
  * @param disk_id Disk ID (0-3)
  * @param lba Starting LBA sector number
- * @param count Number of sectors to write (1-256)
+ * @param count Number of sectors to write (1-255)
  * @param buffer Buffer containing data to write (must be count * 512 bytes)
  * @return 0 on success, -1 on error
  */
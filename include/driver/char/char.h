@@ -30,6 +30,13 @@ typedef struct {
 /** Register a character device (prim_id 0-255). Returns 0 or -1. */
 int  register_char_device(int prim_id, char_ops_t *ops);
 
+/**
+ * Unregister a character device.  Returns once no cread/cwrite can still
+ * reach the driver's callbacks.  Must be called from process context.
+ * Returns 0 or -1 if prim_id is not registered.
+ */
+int  unregister_char_device(int prim_id);
+
 /** Read one character from char device prim_id. Returns 0 on error. */
 char cread(int prim_id, int scnd_id);
 
@@ -39,10 +46,4 @@ int  cwrite(int prim_id, int scnd_id, char c);
 /** Send an ioctl command to a char device. Returns device value or -1. */
 int  char_ioctl(int prim_id, int scnd_id, unsigned int command);
 
-/**
- * Initialise all character devices: VGA, TTY, PIT, keyboard.
- * Safe to call before buddy/slab (uses no dynamic allocation).
- */
-void char_init(void);
-
 #endif /* DRIVER_CHAR_H */
\ No newline at end of file
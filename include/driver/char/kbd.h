@@ -11,6 +11,19 @@
  * Supports basic ASCII input with modifier keys (Shift, Caps Lock).
  */
 
+/* Function-key scancodes (set 1 make codes) usable as hotkeys */
+#define SC_F11  0x57
+#define SC_F12  0x58
+
+#define KBD_MAX_HOTKEYS  8
+
+/**
+ * Bind fn to a key.  fn runs from the keyboard interrupt handler when the
+ * key is pressed; the key then produces no input character.
+ * Returns 0 on success, -1 if the hotkey table is full.
+ */
+int kbd_register_hotkey(uint8_t scancode, void (*fn)(void));
+
 /**
  * Initialize keyboard driver.
  * Sets up IRQ1 handler, buffer, driver registration and devfs node.
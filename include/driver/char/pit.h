@@ -17,6 +17,9 @@
 /* PIT input clock frequency (Hz) */
 #define PIT_BASE_HZ   1193182UL
 
+/* Tick rate programmed by the pit initcall */
+#define PIT_DEFAULT_HZ  100
+
 /*
  * Initialise PIT channel 0 at the given frequency (Hz).
  * Registers the IRQ0 handler in the IDT and unmasks IRQ0 in the PIC.
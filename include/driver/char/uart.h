@@ -0,0 +1,86 @@
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * 16550 UART (COM1 / COM2)
+ *
+ * Char device 4; scnd_id 0 is COM1 (ttyS0), 1 is COM2 (ttyS1).  Both
+ * directions go through ring buffers serviced by the UART interrupt with
+ * the 16-byte FIFOs enabled, so a transmitter-empty interrupt refills up
+ * to 16 bytes at once.  With interrupts off (early boot, panic) writes
+ * are drained by polling, still one status read per FIFO load.
+ *
+ * A port becomes a printk console with console=ttyS0[,baud] on the
+ * kernel command line (kernel/cmdline.h).
+ * ========================================================================= */
+
+#define UART_CHAR_DEV    4
+#define UART_NR_PORTS    2
+
+#define UART_BAUD_BASE   115200           /* divisor 1 */
+#define UART_TX_SIZE     4096             /* power of two */
+#define UART_RX_SIZE     256              /* power of two */
+#define UART_FIFO_SIZE   16               /* 16550A transmit FIFO */
+
+/* Register offsets from the port base */
+#define UART_RBR         0    /* receive buffer (read, DLAB=0)          */
+#define UART_THR         0    /* transmit holding (write, DLAB=0)       */
+#define UART_DLL         0    /* divisor latch low (DLAB=1)             */
+#define UART_IER         1    /* interrupt enable (DLAB=0)              */
+#define UART_DLM         1    /* divisor latch high (DLAB=1)            */
+#define UART_IIR         2    /* interrupt identification (read)        */
+#define UART_FCR         2    /* FIFO control (write)                   */
+#define UART_LCR         3    /* line control                           */
+#define UART_MCR         4    /* modem control                          */
+#define UART_LSR         5    /* line status                            */
+#define UART_MSR         6    /* modem status                           */
+#define UART_SCR         7    /* scratch                                */
+
+#define UART_IER_RDI     0x01 /* receive data available                 */
+#define UART_IER_THRI    0x02 /* transmit holding register empty        */
+#define UART_IER_RLSI    0x04 /* receiver line status                   */
+
+#define UART_IIR_NO_INT  0x01
+#define UART_IIR_ID      0x0E
+#define UART_IIR_MSI     0x00
+#define UART_IIR_THRI    0x02
+#define UART_IIR_RDI     0x04
+#define UART_IIR_RLSI    0x06
+#define UART_IIR_TIMEOUT 0x0C
+#define UART_IIR_FIFO    0xC0 /* both set: 16550A with working FIFOs    */
+
+#define UART_FCR_ENABLE  0x01
+#define UART_FCR_CLR_RX  0x02
+#define UART_FCR_CLR_TX  0x04
+#define UART_FCR_TRIG14  0xC0
+
+#define UART_LCR_8N1     0x03
+#define UART_LCR_DLAB    0x80
+
+#define UART_MCR_DTR     0x01
+#define UART_MCR_RTS     0x02
+#define UART_MCR_OUT2    0x08 /* gates the IRQ line on PC hardware      */
+
+#define UART_LSR_DR      0x01 /* data ready                             */
+#define UART_LSR_OE      0x02 /* overrun                                */
+#define UART_LSR_THRE    0x20 /* THR (FIFO, in FIFO mode) empty         */
+
+/* =========================================================================
+ * Functions
+ * ========================================================================= */
+
+/**
+ * Queue len bytes for transmission on port (0 = COM1); blocks while the
+ * TX ring is full.  With interrupts off inside another writer that holds
+ * the rest of the ring (a panic mid-printk), the bytes that do not fit
+ * are dropped instead.  Returns len, or -1 if the port is absent.
+ */
+int uart_write_buf(int port, const char *s, size_t len);
+
+/** Probe COM1/COM2, register char device 4 and any selected consoles. */
+void uart_init(void);
+
+#endif /* UART_H */
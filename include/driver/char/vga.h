@@ -2,6 +2,7 @@
 #define VGA_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 /* =========================================================================
  * VGA colour definitions
@@ -46,6 +47,7 @@ void vga_init(void);
 void vga_clear(void);
 void vga_set_color(uint8_t color);
 void vga_putchar(char c);
+void vga_write_buf(const char *s, size_t len);   /* one cursor update */
 void vga_set_cursor(uint8_t col, uint8_t row);
 void vga_get_cursor(uint8_t *col, uint8_t *row);
 
@@ -0,0 +1,152 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+#include "kernel/cpu.h"
+#include "kernel/panic.h"
+#include "kernel/jump_label.h"
+
+/* =========================================================================
+ * Interrupt controller abstraction
+ *
+ * Drivers never talk to the 8259A or the APICs directly; they use the
+ * irq_* calls below, which forward to whichever controller irq_init()
+ * selected.  IRQ n is always delivered on IDT vector IRQ_VECTOR_BASE + n.
+ *
+ *   IRQ 0-15   ISA interrupt lines (remapped through IOAPIC overrides)
+ *   IRQ 16-23  IOAPIC pins 16-23 (APIC mode only)
+ *
+ * Every vector has a generated stub in kernel/isr.s that calls
+ * irq_dispatch().  The dispatcher runs each handler registered on the line
+ * with request_irq() (lines may be shared), accounts the interrupt and
+ * sends the EOI – handlers must not.
+ *
+ * With timing on, each interrupt is timestamped (TSC) at stub entry and
+ * around its handlers; log2 histograms of both intervals are kept per line
+ * and reported in /dev/irqlat.  Timing is off by default and toggled by
+ * writing "on"/"off" to /dev/irqlat (any other write resets the
+ * statistics); while off, the timestamp sites are patched-out NOPs.
+ * ========================================================================= */
+
+#define IRQ_VECTOR_BASE    0x20
+#define NR_IRQS            24
+#define SPURIOUS_VECTOR    0xFF
+
+/* Controller callbacks; set_affinity may be NULL */
+typedef struct {
+    const char *name;
+    void (*eoi)(uint8_t irq);
+    void (*enable)(uint8_t irq);
+    void (*disable)(uint8_t irq);
+    int  (*set_affinity)(uint8_t irq, int cpu);
+} irq_chip_t;
+
+/* Handler return values; a shared line is unhandled if all return IRQ_NONE */
+#define IRQ_NONE       0
+#define IRQ_HANDLED    1
+
+typedef int (*irq_handler_t)(int irq, void *data);
+
+#define IRQ_MAX_ACTIONS  32   /* handlers across all lines */
+
+/* One registered handler; actions on a line form an RCU-protected chain */
+typedef struct irq_action {
+    irq_handler_t      handler;
+    void              *data;
+    const char        *name;
+    struct irq_action *next;
+    int                in_use;
+} irq_action_t;
+
+/* Latency histograms: bucket k counts samples in [2^k, 2^(k+1)) cycles */
+#define IRQ_HIST_BUCKETS  32
+
+/* Per-CPU, per-line accounting */
+typedef struct {
+    uint64_t count;       /* interrupts delivered              */
+    uint64_t cycles;      /* TSC cycles from stub entry to exit */
+    uint64_t timed;       /* interrupts counted in cycles      */
+    uint32_t unhandled;   /* no handler claimed it             */
+    uint64_t entry_max;   /* worst stub entry -> handler start  */
+    uint64_t run_max;     /* worst handler start -> end         */
+    uint32_t entry_hist[IRQ_HIST_BUCKETS];
+    uint32_t run_hist[IRQ_HIST_BUCKETS];
+} irq_stat_t;
+
+/* Per-CPU interrupt context */
+typedef struct {
+    uint32_t  nesting;    /* > 0 while inside irq_dispatch   */
+    regs_t   *regs;       /* frame of the innermost interrupt */
+} irq_cpu_t;
+
+extern irq_cpu_t irq_cpu[NR_CPUS];
+
+/* True while the calling CPU is servicing a hardware interrupt */
+static inline int in_interrupt(void)
+{
+    return irq_cpu[smp_processor_id()].nesting != 0;
+}
+
+/* Register frame of the interrupt being serviced (NULL outside interrupts) */
+static inline regs_t *get_irq_regs(void)
+{
+    return irq_cpu[smp_processor_id()].regs;
+}
+
+/* =========================================================================
+ * Functions
+ * ========================================================================= */
+
+/**
+ * Select the interrupt controller: IOAPIC + LAPIC when available,
+ * otherwise the 8259A.  Installs the IDT gates for every IRQ vector and
+ * registers /dev/interrupts.  pic_init() must have run first.
+ */
+void irq_init(void);
+
+/**
+ * Attach handler(irq, data) to an IRQ line and unmask it.
+ * Several handlers may share a line; they run in registration order.
+ * name is shown in /dev/interrupts and must stay valid.
+ * Returns 0 on success, -1 on a bad line or when the action pool is full.
+ */
+int request_irq(uint8_t irq, irq_handler_t handler, void *data, const char *name);
+
+/**
+ * Detach the handler registered with data from an IRQ line; the line is
+ * masked when its last handler goes.  Waits until no CPU can still be
+ * running the handler.  Process context only.  Returns 0 or -1.
+ */
+int free_irq(uint8_t irq, void *data);
+
+/* Patches the stub and dispatcher timestamps in (driver/irq.c) */
+DECLARE_STATIC_KEY_FALSE(irq_timing_key);
+
+/** Entry point from the irq_common stub in kernel/isr.s */
+void irq_dispatch(regs_t *regs);
+
+/**
+ * Print the latency histograms and the irqs-off worst case to the console.
+ * Safe from interrupt context (bound to a keyboard hotkey).
+ */
+void irq_latency_dump(void);
+
+/** Unmask an IRQ line */
+void irq_enable(uint8_t irq);
+
+/** Mask an IRQ line */
+void irq_disable(uint8_t irq);
+
+/** Acknowledge an IRQ; call once at the end of every handler */
+void irq_eoi(uint8_t irq);
+
+/**
+ * Steer an IRQ line to a CPU (index into the discovered processor list).
+ * Returns 0 on success, -1 if the controller cannot route interrupts.
+ */
+int irq_set_affinity(uint8_t irq, int cpu);
+
+/** Name of the active controller ("8259A" or "IOAPIC") */
+const char *irq_chip_name(void);
+
+#endif /* IRQ_H */
@@ -2,14 +2,17 @@
 #define DEVFS_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "fs/fs.h"   /* DT_BLKDEV, DT_CHRDEV */
 
 /* =========================================================================
  * devfs – in-memory device filesystem
  *
  * A flat, RAM-only filesystem that exposes registered hardware devices as
- * files under /dev.  Only block and character device files are supported;
- * no subdirectories, no regular files, no symlinks.
+ * files under /dev.  Besides block and character device files it supports
+ * read-only "show" files (DT_REG) whose text is generated by a kernel
+ * callback when the file is opened – used for statistics reports such as
+ * /dev/interrupts.  No subdirectories, no symlinks.
  *
  * Lifecycle
  * ---------
@@ -21,7 +24,20 @@
  * 3. From that point on, user code can open /dev/hda, /dev/tty0, etc.
  * ========================================================================= */
 
-#define DEVFS_MAX_NODES  64   /* maximum number of device nodes */
+#define DEVFS_MAX_NODES  64      /* maximum number of device nodes    */
+#define DEVFS_SHOW_SIZE  16384   /* text buffer for one opened show file */
+
+/*
+ * Show callback: render the file into buf (at most size bytes, no NUL
+ * needed) and return the number of bytes produced.
+ */
+typedef int (*devfs_show_t)(char *buf, size_t size);
+
+/*
+ * Store callback (optional): handle a write of count bytes.
+ * Returns count on success or -1.
+ */
+typedef int (*devfs_store_t)(const char *buf, size_t count);
 
 /* -------------------------------------------------------------------------
  * Device node descriptor
@@ -29,9 +45,11 @@
 
 typedef struct devfs_node {
     char     name[64];   /* e.g. "hda", "tty0" – no leading slash */
-    uint8_t  type;       /* DT_BLKDEV or DT_CHRDEV                */
+    uint8_t  type;       /* DT_BLKDEV, DT_CHRDEV or DT_REG         */
     int      dev_id;     /* primary device ID (prim_id in driver)  */
     int      minor;      /* secondary device ID (scnd_id)          */
+    devfs_show_t  show;  /* DT_REG: generates the file contents    */
+    devfs_store_t store; /* DT_REG: handles writes (may be NULL)   */
     int      in_use;     /* 1 = slot occupied                      */
 } devfs_node_t;
 
@@ -54,10 +72,25 @@ typedef struct devfs_node {
 int devfs_register_device(const char *name, uint8_t type,
                           int dev_id, int minor);
 
+/**
+ * Register a generated text file (DT_REG) in devfs.
+ *
+ * The contents are produced by show() each time the file is opened, so a
+ * reader sees a consistent snapshot.  Writes are passed to store(), or
+ * rejected when store is NULL.
+ *
+ * @param name   File name under /dev, e.g. "interrupts".  Must be < 64 chars.
+ * @param show   Content generator.
+ * @param store  Write handler, or NULL for a read-only file.
+ * @return 0 on success, -1 if the table is full or name already exists.
+ */
+int devfs_register_file(const char *name, devfs_show_t show,
+                        devfs_store_t store);
+
 /**
  * Remove a device node from the devfs node table.
  *
- * @param name  The name that was used in devfs_register_device().
+ * @param name  The name used in devfs_register_device() / devfs_register_file().
  * @return 0 on success, -1 if not found.
  */
 int devfs_unregister_device(const char *name);
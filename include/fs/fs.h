@@ -193,6 +193,13 @@ int fs_stat(const char *path, stat_t *st);
  * Working Directory (stored in task_struct.cwd)
  * ------------------------------------------------------------------------- */
 
+/**
+ * Build the absolute, normalised form of input ("." and ".." collapsed),
+ * relative to cwd unless input starts with '/'.  Pure string work, in
+ * fs/path.c.  Returns 0, or -1 if the result does not fit in size.
+ */
+int resolve_path(const char *cwd, const char *input, char *out, size_t size);
+
 /**
  * Change the current working directory.
  * The path must resolve to an existing directory.
@@ -0,0 +1,56 @@
+#ifndef ALTERNATIVE_H
+#define ALTERNATIVE_H
+
+#include <stdint.h>
+#include "kernel/cpufeature.h"
+
+/* =========================================================================
+ * Alternatives
+ *
+ * ALTERNATIVE(old, new, feature) emits the instruction string `old`,
+ * padded with NOPs to the length of `new`, and records both in the
+ * .altinstructions table.  apply_alternatives() copies `new` over `old`
+ * at boot on CPUs that have the feature:
+ *
+ *   __asm__ volatile (ALTERNATIVE("rep movsl ...", "rep movsb",
+ *                                 X86_FEATURE_ERMS) : ...);
+ *
+ * The replacement is copied verbatim, so it must not contain relative
+ * jumps or calls.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t orig;           /* address of the original sequence  */
+    uint32_t repl;           /* address of the replacement        */
+    uint16_t feature;        /* X86_FEATURE_*                     */
+    uint8_t  orig_len;       /* including padding                 */
+    uint8_t  repl_len;
+} __attribute__((packed)) alt_instr_t;
+
+#define __ALT_STR(x)   #x
+#define ALT_STR(x)     __ALT_STR(x)
+
+#define ALTERNATIVE(oldinstr, newinstr, feature)                              \
+    "661:\n\t" oldinstr "\n662:\n\t"                                          \
+    ".skip -(((6651f-6641f)-(662b-661b)) > 0) * "                             \
+        "((6651f-6641f)-(662b-661b)), 0x90\n"                                 \
+    "663:\n\t"                                                                \
+    ".pushsection .altinstructions, \"a\"\n\t"                                \
+    ".long 661b, 6641f\n\t"                                                   \
+    ".word " ALT_STR(feature) "\n\t"                                          \
+    ".byte 663b-661b, 6651f-6641f\n\t"                                        \
+    ".popsection\n\t"                                                         \
+    ".pushsection .altinstr_replacement, \"ax\"\n"                            \
+    "6641:\n\t" newinstr "\n6651:\n\t"                                        \
+    ".popsection\n"
+
+/** Patch every ALTERNATIVE() site; after cpu_detect_features(). */
+void apply_alternatives(void);
+
+/**
+ * Overwrite kernel text with interrupts off and resynchronise the
+ * instruction stream; used by alternatives and static keys.
+ */
+void text_poke(void *addr, const void *bytes, uint32_t len);
+
+#endif /* ALTERNATIVE_H */
@@ -35,12 +35,102 @@ static inline uint16_t inw(uint16_t port)
     return val;
 }
 
+/* Write a 32-bit dword to an I/O port */
+static inline void outl(uint16_t port, uint32_t val)
+{
+    __asm__ volatile ("outl %0, %1" : : "a"(val), "Nd"(port));
+}
+
+/* Read a 32-bit dword from an I/O port */
+static inline uint32_t inl(uint16_t port)
+{
+    uint32_t val;
+    __asm__ volatile ("inl %1, %0" : "=a"(val) : "Nd"(port));
+    return val;
+}
+
 /* Short I/O delay (write to unused port 0x80) */
 static inline void io_wait(void)
 {
     __asm__ volatile ("outb %%al, $0x80" : : "a"(0));
 }
 
+/* Execute CPUID for the given leaf / sub-leaf */
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                         uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+    __asm__ volatile ("cpuid"
+                      : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                      : "a"(leaf), "c"(subleaf));
+}
+
+/* Read / write a model-specific register */
+static inline uint64_t rdmsr(uint32_t msr)
+{
+    uint32_t lo, hi;
+    __asm__ volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t val)
+{
+    __asm__ volatile ("wrmsr"
+                      : : "c"(msr), "a"((uint32_t)val), "d"((uint32_t)(val >> 32)));
+}
+
+/* Read the time-stamp counter */
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Invalidate the TLB entry for one virtual address */
+static inline void invlpg(uint32_t virt)
+{
+    __asm__ volatile ("invlpg (%0)" : : "r"(virt) : "memory");
+}
+
+/* Control registers */
+static inline uint32_t read_cr0(void)
+{
+    uint32_t v;
+    __asm__ volatile ("mov %%cr0, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr0(uint32_t v)
+{
+    __asm__ volatile ("mov %0, %%cr0" : : "r"(v) : "memory");
+}
+
+static inline uint32_t read_cr2(void)
+{
+    uint32_t v;
+    __asm__ volatile ("mov %%cr2, %0" : "=r"(v));
+    return v;
+}
+
+static inline uint32_t read_cr3(void)
+{
+    uint32_t v;
+    __asm__ volatile ("mov %%cr3, %0" : "=r"(v));
+    return v;
+}
+
+static inline uint32_t read_cr4(void)
+{
+    uint32_t v;
+    __asm__ volatile ("mov %%cr4, %0" : "=r"(v));
+    return v;
+}
+
+static inline void write_cr4(uint32_t v)
+{
+    __asm__ volatile ("mov %0, %%cr4" : : "r"(v) : "memory");
+}
+
 /* Disable / enable hardware interrupts */
 static inline void cli(void)
 {
@@ -58,6 +148,79 @@ static inline void hlt(void)
     __asm__ volatile ("hlt");
 }
 
+/*
+ * Enable interrupts and halt as one step: STI takes effect after the next
+ * instruction, so an interrupt cannot slip in between and be slept through.
+ */
+static inline void safe_halt(void)
+{
+    __asm__ volatile ("sti; hlt" : : : "memory");
+}
+
+#define EFLAGS_IF  (1u << 9)   /* interrupt enable flag */
+
+/*
+ * Save EFLAGS and disable interrupts; returns the saved flags.
+ * Kernel code should use irq_save() from kernel/irqflags.h, which also
+ * feeds the irqs-off latency tracker.
+ */
+static inline uint32_t raw_irq_save(void)
+{
+    uint32_t flags;
+    __asm__ volatile ("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+/* Restore the interrupt flag saved by raw_irq_save() */
+static inline void raw_irq_restore(uint32_t flags)
+{
+    __asm__ volatile ("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+/* =========================================================================
+ * Ordering primitives
+ *
+ * x86 is TSO: loads are not reordered with other loads and stores are not
+ * reordered with other stores, so read/write barriers only need to stop
+ * the compiler.  A full barrier must also order stores before later loads.
+ * ========================================================================= */
+
+#define barrier()  __asm__ volatile ("" : : : "memory")
+#define smp_rmb()  barrier()
+#define smp_wmb()  barrier()
+#define smp_mb()   __asm__ volatile ("lock; addl $0, 0(%%esp)" : : : "memory", "cc")
+
+/*
+ * Add v to *p and return the old value as one instruction.  Atomic with
+ * respect to interrupts on the calling CPU (no LOCK prefix), which is all
+ * per-CPU data needs.
+ */
+static inline uint32_t local_fetch_add(volatile uint32_t *p, uint32_t v)
+{
+    __asm__ volatile ("xaddl %0, %1" : "+r"(v), "+m"(*p) : : "memory", "cc");
+    return v;
+}
+
+/*
+ * If *p equals old, store new; returns the value *p held.  Like
+ * local_fetch_add() this is one instruction without LOCK, so it is atomic
+ * against interrupts on this CPU but not against other CPUs.
+ */
+static inline uint32_t local_cmpxchg(volatile uint32_t *p, uint32_t old, uint32_t new)
+{
+    __asm__ volatile ("cmpxchgl %2, %1" : "+a"(old), "+m"(*p) : "r"(new) : "memory", "cc");
+    return old;
+}
+
+/* Force a single, untorn access the compiler cannot cache or re-read */
+#define READ_ONCE(x)       (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)   (*(volatile __typeof__(x) *)&(x) = (v))
+
+static inline void cpu_relax(void)
+{
+    __asm__ volatile ("pause" : : : "memory");
+}
+
 static inline void magic_break(void)
 {
     __asm__ volatile ("xchgw %bx, %bx");
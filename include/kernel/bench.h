@@ -0,0 +1,84 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * In-kernel benchmarks
+ *
+ * A benchmark performs one operation n times and returns 0, BENCH_SKIP
+ * when what it measures is not there (no scratch disk, no COM2), or -1
+ * on failure:
+ *
+ *   static int bench_kalloc64(uint32_t n)
+ *   {
+ *       while (n--)
+ *           kfree(kalloc(64));
+ *       return 0;
+ *   }
+ *   BENCHMARK(kalloc_64, bench_kalloc64, NULL, NULL);
+ *
+ * The optional setup/teardown hooks run outside the timed region.
+ * Descriptors live in the .benchmarks linker section.
+ *
+ * Booting with "bench" on the command line runs the suite once initcalls
+ * (async ones included) are done; "bench=blk" runs only the benchmarks
+ * whose names start with "blk".  Each one is first repeated with a
+ * doubling n until a pass takes BENCH_MIN_US, then timed BENCH_RUNS
+ * times with the TSC.  Results go to the console, one line each:
+ *
+ *   [BENCH] begin tsc_khz=2400000 count=12
+ *   [BENCH] name=kalloc_64 n=65536 cyc_min=41 cyc_med=43 ns_med=17
+ *   [BENCH] name=uart_write_64 skipped
+ *   [BENCH] end failed=0 skipped=1
+ *
+ * cyc_* are cycles per operation (minimum and median over the runs).
+ * Finally the status is written to the QEMU isa-debug-exit port, which
+ * ends a `make bench` run; elsewhere the write is ignored and boot goes
+ * on as usual.
+ *
+ * Block benchmarks only touch a disk whose sector 0 starts with
+ * BENCH_DISK_MAGIC (script/make_bench_disk.sh), and only sectors 1 to
+ * BENCH_DISK_SPAN of it.
+ * ========================================================================= */
+
+#define BENCH_SKIP        1
+
+#define BENCH_RUNS        5          /* timed passes per benchmark     */
+#define BENCH_MIN_US      20000      /* calibrated pass length         */
+#define BENCH_MAX_N       (1u << 20) /* calibration stops here         */
+
+#define BENCH_EXIT_PORT   0xF4       /* QEMU -device isa-debug-exit    */
+
+#define BENCH_DISK_MAGIC  "SCEPTER-BENCH-DISK"
+#define BENCH_DISK_SPAN   4096       /* scratch sectors after sector 0 */
+
+typedef struct benchmark {
+    const char *name;
+    int       (*fn)(uint32_t n);
+    int       (*setup)(void);      /* optional: 0, BENCH_SKIP or -1 */
+    void      (*teardown)(void);   /* optional */
+} benchmark_t;
+
+#define BENCHMARK(id, func, setup_fn, teardown_fn)                      \
+    benchmark_t __benchmark_##id                                        \
+    __attribute__((section(".benchmarks"), used, aligned(4))) = {       \
+        .name     = #id,                                                \
+        .fn       = func,                                               \
+        .setup    = setup_fn,                                           \
+        .teardown = teardown_fn,                                        \
+    }
+
+/**
+ * Run the suite if "bench" is on the command line, then signal QEMU to
+ * exit.  Call from kernel_main after do_initcalls(), interrupts still off.
+ */
+void bench_main(void);
+
+/**
+ * Block device holding the benchmark scratch disk, or -1.  The device
+ * is looked up once and remembered.
+ */
+int bench_disk(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,24 @@
+#ifndef BOOTTIME_H
+#define BOOTTIME_H
+
+/* =========================================================================
+ * Boot timeline
+ *
+ * boot.s stamps the TSC at _start and again once paging is on; kernel_main
+ * wraps every init step in BOOT_STAGE() so each one's duration is known.
+ * boottime_report() prints the timeline once and keeps it readable as
+ * /dev/boottime.
+ * ========================================================================= */
+
+#define BOOT_MAX_STAGES  32
+
+/** Record that the stage called name has just finished. */
+void boot_stage(const char *name);
+
+/* Run an init call and record it as a stage named after the call */
+#define BOOT_STAGE(call)  do { call; boot_stage(#call); } while (0)
+
+/** Print the timeline and register /dev/boottime; call last in boot. */
+void boottime_report(void);
+
+#endif /* BOOTTIME_H */
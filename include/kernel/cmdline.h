@@ -0,0 +1,33 @@
+#ifndef CMDLINE_H
+#define CMDLINE_H
+
+#include <stddef.h>
+
+/* =========================================================================
+ * Kernel command line
+ *
+ * boot.s keeps the multiboot magic and info pointer; cmdline_init() copies
+ * the command line out of bootloader memory before mm_init() can reuse it.
+ * Parameters are space separated, either "key=value" or a bare "key":
+ *
+ *   console=ttyS0,115200 console=vga0
+ *
+ * The line is readable as /dev/cmdline.
+ * ========================================================================= */
+
+#define CMDLINE_MAX  256
+
+/** Copy the multiboot command line; call first thing in kernel_main. */
+void cmdline_init(void);
+
+/** The whole command line ("" when the bootloader gave none). */
+const char *cmdline_get(void);
+
+/**
+ * Copy the value of the n-th (from 0) occurrence of key into buf, always
+ * NUL-terminated.  A bare "key" has the empty value.  Returns the value
+ * length, or -1 if there is no such occurrence.
+ */
+int cmdline_param(const char *key, int n, char *buf, size_t size);
+
+#endif /* CMDLINE_H */
@@ -3,6 +3,36 @@
 
 #include <stdint.h>
 #include "kernel/asm.h"
+#include "kernel/cpufeature.h"
+
+/* =========================================================================
+ * Processor identity
+ *
+ * The kernel currently brings up only the boot processor.  Per-CPU data is
+ * nevertheless declared as [NR_CPUS] arrays indexed by smp_processor_id()
+ * so that it keeps working unchanged once APs are started.
+ * ========================================================================= */
+
+#define NR_CPUS  1
+
+static inline int smp_processor_id(void)
+{
+    return 0;
+}
+
+/* =========================================================================
+ * CPU features (CPUID) – feature numbers are in kernel/cpufeature.h
+ * ========================================================================= */
+
+extern uint32_t cpu_features[X86_FEATURE_WORDS];
+
+/* Fill cpu_features[] from CPUID; call once, early in kernel_main */
+void cpu_detect_features(void);
+
+static inline int cpu_has(int feature)
+{
+    return (cpu_features[feature / 32] >> (feature % 32)) & 1;
+}
 
 /* =========================================================================
  * GDT
@@ -120,7 +150,21 @@ typedef uint32_t pte_t;   /* page table entry     */
 #define PAGE_PCD       (1u << 4)  /* cache disable */
 #define PAGE_SIZE_4MB  (1u << 7)  /* PSE – only valid in PDE */
 
+#ifndef KERNEL_VMA
+#define KERNEL_VMA  0xC0000000U
+#endif
+
+/* Physical address of the kernel page directory (set by boot.s) */
+extern volatile uint32_t kernel_page_table;
+
 /* Map a single 4 KB page: virt → phys in page_dir */
 void map_page(pde_t *page_dir, uint32_t virt, uint32_t phys, uint32_t flags);
 
+/*
+ * Map size bytes of device registers at phys into the uncached MMIO
+ * window and return the virtual address.  Mappings are permanent.
+ * Returns NULL when the window is exhausted.
+ */
+void *mmio_map(uint32_t phys, uint32_t size);
+
 #endif /* CPU_H */
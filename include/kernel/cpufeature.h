@@ -0,0 +1,27 @@
+#ifndef CPUFEATURE_H
+#define CPUFEATURE_H
+
+/* =========================================================================
+ * CPU feature numbers (CPUID)
+ *
+ * Feature numbers encode word * 32 + bit:
+ *   word 0 = leaf 1 EDX, word 1 = leaf 1 ECX, word 2 = leaf 7 EBX
+ *
+ * Plain constant expressions only, so ALTERNATIVE() can hand them to the
+ * assembler (kernel/alternative.h).
+ * ========================================================================= */
+
+#define X86_FEATURE_FPU         (0 * 32 + 0)
+#define X86_FEATURE_TSC         (0 * 32 + 4)
+#define X86_FEATURE_MSR         (0 * 32 + 5)
+#define X86_FEATURE_APIC        (0 * 32 + 9)
+#define X86_FEATURE_FXSR        (0 * 32 + 24)
+#define X86_FEATURE_SSE         (0 * 32 + 25)
+#define X86_FEATURE_SSE2        (0 * 32 + 26)
+#define X86_FEATURE_SSE3        (1 * 32 + 0)
+#define X86_FEATURE_HYPERVISOR  (1 * 32 + 31)
+#define X86_FEATURE_ERMS        (2 * 32 + 9)
+
+#define X86_FEATURE_WORDS  3
+
+#endif /* CPUFEATURE_H */
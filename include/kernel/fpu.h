@@ -0,0 +1,58 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * x87 / SSE state management
+ *
+ * fpu_init() turns the FPU (and SSE, when CPUID reports FXSR+SSE) on and
+ * leaves CR0.TS set.  Registers are then switched lazily: the first FPU
+ * instruction a task executes raises #NM, and the handler saves whoever
+ * still owns the registers and loads the task's own state.  Tasks that
+ * never touch the FPU cost nothing.
+ *
+ * Kernel code must bracket any FPU/SIMD use:
+ *
+ *   if (kernel_fpu_usable()) {
+ *       kernel_fpu_begin();
+ *       ... SSE ...
+ *       kernel_fpu_end();
+ *   } else {
+ *       ... scalar fallback ...
+ *   }
+ *
+ * kernel_fpu_begin() saves the owner's live registers into its task state,
+ * so the section may clobber every x87/XMM register.  Sections do not nest:
+ * an interrupt arriving inside one sees kernel_fpu_usable() == 0.
+ * Interrupts stay enabled throughout.
+ * ========================================================================= */
+
+/* FXSAVE image (512 bytes, 16-byte aligned); FNSAVE uses the first 108 */
+typedef struct {
+    uint8_t  area[512];
+    uint32_t used;          /* task has executed FPU code before */
+} __attribute__((aligned(16))) fpu_state_t;
+
+struct task_struct;
+
+/** Enable the FPU/SSE from CPUID; call after cpu_detect_features(). */
+void fpu_init(void);
+
+/** Nonzero when the FPU is on and not already in a kernel FPU section. */
+int  kernel_fpu_usable(void);
+
+void kernel_fpu_begin(void);
+void kernel_fpu_end(void);
+
+/**
+ * Hook for the context switch: next's registers are not live, so arm
+ * CR0.TS to load them on first use.  (One task today; kept for the
+ * scheduler.)
+ */
+void fpu_switch_to(struct task_struct *next);
+
+/** #NM handler, called from the isr7 stub. */
+void fpu_nm_trap(void);
+
+#endif /* FPU_H */
@@ -0,0 +1,63 @@
+#ifndef INITCALL_H
+#define INITCALL_H
+
+#include <stdint.h>
+#include "kernel/workqueue.h"
+
+/* =========================================================================
+ * Initcalls
+ *
+ * Drivers declare their init function next to its definition instead of
+ * being called from a hard-coded chain in kernel_main:
+ *
+ *   INITCALL(ide, ide_init, INITCALL_ASYNC);
+ *   INITCALL(mbr, mbr_initcall, 0, "ide", "cache");
+ *
+ * Descriptors live in the .initcalls linker section.  do_initcalls() runs
+ * each one once all the initcalls it names have finished, in link order
+ * otherwise.  INITCALL_ASYNC calls are handed to the idle loop instead, so
+ * boot does not wait on slow hardware; anything depending on them runs
+ * after them, from the idle loop as well.  initcall_flush() finishes all
+ * outstanding async calls immediately, for code that needs them first.
+ *
+ * Core setup (CPU tables, interrupt routing, memory) stays explicit in
+ * kernel_main; initcalls may assume it is done.
+ * ========================================================================= */
+
+#define INITCALL_ASYNC  (1 << 0)   /* run from the idle loop */
+
+enum {
+    INITCALL_PENDING = 0,
+    INITCALL_QUEUED,
+    INITCALL_RUNNING,
+    INITCALL_DONE,
+};
+
+typedef struct initcall {
+    const char         *name;
+    void              (*fn)(void);
+    const char *const  *deps;      /* names of initcalls that must finish first */
+    int                 ndeps;
+    int                 flags;
+    int                 state;
+    work_t              work;      /* async: queued on the idle loop */
+} initcall_t;
+
+#define INITCALL(id, func, flg, ...)                                    \
+    static const char *const __initcall_deps_##id[] = { __VA_ARGS__ }; \
+    initcall_t __initcall_##id                                         \
+    __attribute__((section(".initcalls"), used, aligned(4))) = {       \
+        .name  = #id,                                                  \
+        .fn    = func,                                                 \
+        .deps  = __initcall_deps_##id,                                 \
+        .ndeps = sizeof(__initcall_deps_##id) / sizeof(const char *),  \
+        .flags = flg,                                                  \
+    }
+
+/** Run synchronous initcalls in dependency order and queue async ones. */
+void do_initcalls(void);
+
+/** Complete every outstanding async initcall now. */
+void initcall_flush(void);
+
+#endif /* INITCALL_H */
@@ -0,0 +1,63 @@
+#ifndef IRQFLAGS_H
+#define IRQFLAGS_H
+
+#include <stdint.h>
+#include "kernel/asm.h"
+#include "kernel/cpu.h"
+#include "kernel/jump_label.h"
+
+/* =========================================================================
+ * Interrupt-disable sections with worst-case tracking
+ *
+ *   uint32_t flags = irq_save();
+ *   ... critical section ...
+ *   irq_restore(flags);
+ *
+ * When the outermost irq_save() turns interrupts off it stamps the TSC and
+ * its own EIP; the matching irq_restore() measures the section and keeps
+ * the longest one seen per CPU (reported in /dev/irqlat).  Tracking is
+ * behind irqsoff_key and costs a NOP per call while it is off.
+ * ========================================================================= */
+
+typedef struct {
+    uint64_t start;       /* TSC when interrupts went off, 0 = not timing */
+    uint32_t start_eip;   /* where they were turned off                   */
+    uint64_t max_cycles;  /* longest section so far                       */
+    uint32_t max_eip;     /* EIP that started it                          */
+} irqsoff_cpu_t;
+
+extern irqsoff_cpu_t irqsoff_cpu[NR_CPUS];
+DECLARE_STATIC_KEY_FALSE(irqsoff_key);
+
+/* Close the section opened at irqsoff_cpu[cpu].start (kernel/irqsoff.c) */
+void irqsoff_stop(void);
+
+/* Account an externally timed irqs-off section, e.g. an interrupt handler */
+void irqsoff_record(uint64_t cycles, uint32_t eip);
+
+/* Clear the worst-case record on every CPU */
+void irqsoff_reset(void);
+
+static inline uint32_t irq_save(void)
+{
+    uint32_t flags = raw_irq_save();
+
+    if (static_branch_unlikely(&irqsoff_key) && (flags & EFLAGS_IF)) {
+        uint32_t eip;
+        __asm__ volatile ("movl $1f, %0\n1:" : "=r"(eip));
+        irqsoff_cpu_t *st = &irqsoff_cpu[smp_processor_id()];
+        st->start_eip = eip;
+        st->start     = rdtsc();
+    }
+    return flags;
+}
+
+static inline void irq_restore(uint32_t flags)
+{
+    if (static_branch_unlikely(&irqsoff_key) && (flags & EFLAGS_IF) &&
+        irqsoff_cpu[smp_processor_id()].start)
+        irqsoff_stop();
+    raw_irq_restore(flags);
+}
+
+#endif /* IRQFLAGS_H */
@@ -0,0 +1,68 @@
+#ifndef JUMP_LABEL_H
+#define JUMP_LABEL_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * Static keys
+ *
+ * A static key replaces "load a flag, test, branch" with a 5-byte NOP in
+ * the instruction stream.  Enabling the key rewrites every such site into
+ * a JMP to the out-of-line code; disabling writes the NOP back.
+ *
+ *   DEFINE_STATIC_KEY_FALSE(my_key);
+ *   ...
+ *   if (static_branch_unlikely(&my_key))
+ *       slow_instrumentation();
+ *
+ * Sites are recorded in the __jump_table section as { site, target, key }.
+ * Flipping a key is slow (it patches text with interrupts off); testing
+ * it is free.  Keys start disabled.
+ *
+ * Assembly sites use JUMP_LABEL_NOP_BYTES and emit their own table entry
+ * (see irq_common in kernel/isr.s).
+ * ========================================================================= */
+
+typedef struct static_key {
+    volatile int enabled;
+} static_key_t;
+
+typedef struct {
+    uint32_t      code;      /* address of the 5-byte site    */
+    uint32_t      target;    /* where the JMP goes when on    */
+    static_key_t *key;
+} jump_entry_t;
+
+#define DEFINE_STATIC_KEY_FALSE(name)   static_key_t name = { 0 }
+#define DECLARE_STATIC_KEY_FALSE(name)  extern static_key_t name
+
+/* ds; lea 0(%esi,%eiz,1),%esi – a 5-byte NOP valid on every i386 */
+#define JUMP_LABEL_NOP_BYTES  0x3e, 0x8d, 0x74, 0x26, 0x00
+#define JUMP_LABEL_NOP_STR    ".byte 0x3e, 0x8d, 0x74, 0x26, 0x00"
+
+static inline __attribute__((always_inline))
+int static_branch_unlikely(static_key_t *key)
+{
+    __asm__ goto ("1: " JUMP_LABEL_NOP_STR "\n\t"
+                  ".pushsection __jump_table, \"aw\"\n\t"
+                  ".balign 4\n\t"
+                  ".long 1b, %l[l_yes], %c0\n\t"
+                  ".popsection"
+                  : : "i"(key) : : l_yes);
+    return 0;
+l_yes:
+    return 1;
+}
+
+static inline int static_key_enabled(const static_key_t *key)
+{
+    return key->enabled;
+}
+
+/** Patch all sites of key to jump; no-op if already enabled. */
+void static_key_enable(static_key_t *key);
+
+/** Patch all sites of key back to the NOP. */
+void static_key_disable(static_key_t *key);
+
+#endif /* JUMP_LABEL_H */
@@ -0,0 +1,35 @@
+#ifndef KSYMS_H
+#define KSYMS_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * Embedded kernel symbol table
+ *
+ * build/ksyms_table.c is generated from `nm -n` of a first link of the kernel
+ * (script/gen_ksyms.sh) and linked into the final image.  It only adds
+ * data, so text addresses are identical in both links.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t    addr;
+    const char *name;
+} ksym_t;
+
+/* Sorted by address; generated */
+extern const ksym_t   ksym_table[];
+extern const uint32_t ksym_count;
+
+/**
+ * Find the function containing addr.
+ * Returns its name and stores addr - start in *offset, or NULL when addr
+ * lies outside the kernel text or the table is empty.
+ */
+const char *ksym_lookup(uint32_t addr, uint32_t *offset);
+
+/**
+ * Index of the symbol containing addr in ksym_table, or -1.
+ */
+int ksym_index(uint32_t addr);
+
+#endif /* KSYMS_H */
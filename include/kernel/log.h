@@ -0,0 +1,89 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * Kernel log ring
+ *
+ * printk() formats into a line buffer and appends one record per line to
+ * a byte ring (level, TSC timestamp, text); it never touches a console
+ * device itself.  Registered consoles are fed from the ring in batches:
+ *
+ *   sync mode    the printk caller drains the ring before returning
+ *                (boot, until the idle loop runs, and after a panic)
+ *   async mode   a work item drains it from the idle loop
+ *
+ * Messages at LOGLEVEL_ERR and above are always written out at once.
+ * When the ring fills, the oldest records are overwritten; a console that
+ * falls behind reports how many it missed.
+ *
+ * /dev/dmesg shows the whole ring with timestamps.  Writing "clear"
+ * empties it; writing a digit sets the console log level.
+ * ========================================================================= */
+
+#define LOG_BUF_SIZE       (64 * 1024)   /* ring bytes, records included  */
+#define LOG_LINE_MAX       256           /* longest record text           */
+
+#define LOGLEVEL_EMERG     0
+#define LOGLEVEL_ALERT     1
+#define LOGLEVEL_CRIT      2
+#define LOGLEVEL_ERR       3
+#define LOGLEVEL_WARNING   4
+#define LOGLEVEL_NOTICE    5
+#define LOGLEVEL_INFO      6
+#define LOGLEVEL_DEBUG     7
+
+#define LOGLEVEL_DEFAULT   LOGLEVEL_INFO   /* printk without a KERN_ prefix */
+
+/* Records below this level reach the consoles */
+extern int console_loglevel;
+
+/* An output device fed from the ring */
+typedef struct console {
+    const char *name;                          /* as in console=        */
+    void      (*write)(const char *s, size_t len);
+    uint32_t    seq, idx;                      /* private: next record  */
+} console_t;
+
+#define MAX_CONSOLES     4
+#define CONSOLE_DEFAULT  "vga0"   /* used when there is no console= */
+
+/* =========================================================================
+ * Functions
+ * ========================================================================= */
+
+/** Append one record (text need not be NUL-terminated). */
+void log_store(int level, const char *text, size_t len);
+
+/**
+ * Attach a console.  It first receives everything still in the ring, so
+ * consoles set up late in boot see the whole log.  Returns 0, or -1 when
+ * the table is full.
+ */
+int register_console(console_t *con);
+
+/**
+ * Whether the console called name was asked for: listed in a console=
+ * parameter, or CONSOLE_DEFAULT when there is none.  Text after a comma
+ * ("console=ttyS0,115200") is copied to opts when opts is not NULL.
+ */
+int console_selected(const char *name, char *opts, size_t size);
+
+/** Write every pending record to the consoles now. */
+void console_flush(void);
+
+/** Choose sync (nonzero) or async console output; see above. */
+void log_set_sync(int sync);
+
+/** Called by panic(): force sync output even if a flush was interrupted. */
+void log_panic(void);
+
+/**
+ * Copy the ring, formatted with timestamps, into buf (NUL-terminated when
+ * size > 0).  Returns the number of characters stored.
+ */
+int log_read_all(char *buf, size_t size);
+
+#endif /* LOG_H */
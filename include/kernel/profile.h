@@ -0,0 +1,40 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include "kernel/panic.h"   /* regs_t */
+
+/* =========================================================================
+ * Sampling profiler
+ *
+ * Every timer interrupt records the interrupted EIP in a histogram that
+ * covers the kernel text at 1 << PROF_SHIFT byte granularity.  Optionally
+ * (kernel built with FRAME_POINTER=1) it also follows the saved EBP chain
+ * and charges each return address to a second histogram, which gives
+ * inclusive ("total") time per function.
+ *
+ * The report resolves buckets against the embedded symbol table
+ * (kernel/ksyms.h) and lists the hottest functions:
+ *   /dev/profile   read: report   write: "start", "stop", "reset",
+ *                                        "callchain", "nocallchain"
+ *   F11            print the report on the console
+ * ========================================================================= */
+
+#define PROF_SHIFT        2     /* 4-byte buckets                   */
+#define PROF_MAX_DEPTH    8     /* frames followed per sample       */
+#define PROF_REPORT_TOP   32    /* functions listed in the report   */
+
+/** Allocate the histograms and start sampling; needs mm_init(). */
+void profile_init(void);
+
+/** Record one sample; called from the timer interrupt handler. */
+void profile_tick(regs_t *regs);
+
+void profile_start(void);
+void profile_stop(void);
+void profile_reset(void);
+
+/** Print the hot-function report on the console (hotkey). */
+void profile_dump(void);
+
+#endif /* PROFILE_H */
@@ -0,0 +1,134 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <stdint.h>
+#include "kernel/asm.h"
+#include "kernel/cpu.h"
+
+/* =========================================================================
+ * Read-Copy-Update (epoch based)
+ *
+ * Lets read-mostly tables (mount table, devfs nodes, driver registries) be
+ * searched without any lock while writers publish and retire entries.
+ *
+ * Readers
+ * -------
+ *   rcu_read_lock();
+ *   p = rcu_dereference(table_ptr);       // or scan slots with rcu_slot_live()
+ *   ... use p ...
+ *   rcu_read_unlock();
+ *
+ *   Read-side sections nest, may be entered from interrupt handlers and
+ *   must not block.
+ *
+ * Writers
+ * -------
+ *   1. Fill in a new entry completely, then publish it with
+ *      rcu_assign_pointer() / rcu_publish_slot().
+ *   2. To remove an entry, unpublish it first, then either wait for all
+ *      pre-existing readers with synchronize_rcu() before reusing it, or
+ *      hand it to call_rcu() to have it reclaimed once they are gone.
+ *
+ * Grace periods are tracked with a global epoch counter.  Every CPU reports
+ * a quiescent state (no read-side section active) on each hardware
+ * interrupt (irq_dispatch) and in the idle loop; an epoch has elapsed once
+ * all CPUs have reported past it.
+ * ========================================================================= */
+
+typedef struct rcu_head {
+    struct rcu_head *next;
+    void           (*func)(struct rcu_head *head);
+    uint32_t         epoch;   /* grace period that must elapse first */
+} rcu_head_t;
+
+/* Per-CPU reader state */
+typedef struct {
+    volatile uint32_t nesting;   /* active read-side sections            */
+    volatile uint32_t qs_epoch;  /* last epoch this CPU was quiescent in */
+} rcu_cpu_t;
+
+extern rcu_cpu_t rcu_cpu[NR_CPUS];
+
+/* =========================================================================
+ * Read side
+ * ========================================================================= */
+
+static inline void rcu_read_lock(void)
+{
+    rcu_cpu[smp_processor_id()].nesting++;
+    barrier();
+}
+
+static inline void rcu_read_unlock(void)
+{
+    barrier();
+    rcu_cpu[smp_processor_id()].nesting--;
+}
+
+/* Fetch an RCU-protected pointer for use inside a read-side section */
+#define rcu_dereference(p)  ({                 \
+    __typeof__(p) ___p = READ_ONCE(p);         \
+    smp_rmb();                                 \
+    ___p;                                      \
+})
+
+/* Publish a fully initialised object through an RCU-protected pointer */
+#define rcu_assign_pointer(p, v)  do {         \
+    smp_wmb();                                 \
+    WRITE_ONCE(p, v);                          \
+} while (0)
+
+/* =========================================================================
+ * Slot tables
+ *
+ * The static registries mark entries with an in_use word.  A slot's fields
+ * must be completely written before it is published, and a retired slot may
+ * only be reused after a grace period.
+ * ========================================================================= */
+
+static inline void rcu_publish_slot(int *in_use)
+{
+    smp_wmb();
+    WRITE_ONCE(*in_use, 1);
+}
+
+static inline void rcu_retire_slot(int *in_use)
+{
+    WRITE_ONCE(*in_use, 0);
+}
+
+static inline int rcu_slot_live(const int *in_use)
+{
+    int live = READ_ONCE(*in_use);
+    smp_rmb();
+    return live;
+}
+
+/* =========================================================================
+ * Update side
+ * ========================================================================= */
+
+/**
+ * Wait until every read-side section that was active on entry has ended.
+ * Must be called from process context outside any read-side section.
+ */
+void synchronize_rcu(void);
+
+/**
+ * Queue func(head) to run after a grace period.  Safe from any context;
+ * callbacks are invoked from process context (idle loop or rcu_barrier()).
+ */
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head));
+
+/** Wait for a grace period and run every callback queued so far. */
+void rcu_barrier(void);
+
+/**
+ * Report a quiescent state for the calling CPU.
+ * from_irq: non-zero when called from an interrupt handler, in which case
+ * the state is only reported if the interrupted code held no read lock
+ * and callbacks are left for the next process-context call.
+ */
+void rcu_quiescent_state(int from_irq);
+
+#endif /* RCU_H */
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "lib/list.h"
 #include "fs/fs.h"   /* MAX_PATH_LEN */
+#include "kernel/fpu.h"
 
 /* =========================================================================
  * Process States
@@ -34,6 +35,9 @@ typedef struct task_struct {
 
     /* ---- Working directory ---- */
     char          cwd[MAX_PATH_LEN];  /* current working directory path   */
+
+    /* ---- FPU/SSE registers, saved lazily (kernel/fpu.c) ---- */
+    fpu_state_t   fpu;
 } task_struct_t;
 
 /* =========================================================================
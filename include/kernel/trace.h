@@ -0,0 +1,81 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "kernel/cpu.h"
+#include "kernel/jump_label.h"
+
+/* =========================================================================
+ * Static tracepoints and per-CPU binary trace rings
+ *
+ * A tracepoint records a fixed-size binary record (TSC, event, four 32-bit
+ * arguments) into the calling CPU's ring; the event's printk format is only
+ * applied when the ring is read, so tracing never formats text in the hot
+ * path.  A disabled tracepoint is a single NOP (a static key site, see
+ * kernel/jump_label.h); enabling the event patches it into a jump.
+ *
+ * Defining and firing an event
+ * ----------------------------
+ *   DEFINE_TRACE_EVENT(bread, "dev=%d minor=%d blk=%u count=%u");
+ *   ...
+ *   TRACE(bread, prim_id, scnd_id, offset, count);
+ *
+ * Events live in the .trace_events linker section so the control file can
+ * enumerate them without a registration call.
+ *
+ * Reading
+ * -------
+ *   /dev/trace         drains and formats the rings (read consumes records)
+ *   /dev/trace_events  lists events; write "+name", "-name", "+all", "-all"
+ *
+ * Rings overwrite their oldest records when full (flight-recorder mode);
+ * records lost that way are counted and reported by the reader.
+ * ========================================================================= */
+
+#define TRACE_RING_RECORDS  4096   /* per CPU, power of two */
+#define TRACE_RING_MASK     (TRACE_RING_RECORDS - 1)
+
+typedef struct trace_event {
+    const char   *name;
+    const char   *fmt;       /* printk format for args[0..3]      */
+    static_key_t  key;
+} trace_event_t;
+
+typedef struct {
+    uint32_t              seq;       /* ring index + 1 once complete */
+    const trace_event_t  *event;
+    uint64_t              tsc;
+    uint32_t              args[4];
+} trace_record_t;
+
+#define DEFINE_TRACE_EVENT(id, format)                                  \
+    trace_event_t trace_event_##id                                     \
+    __attribute__((section(".trace_events"), used, aligned(4))) =      \
+        { .name = #id, .fmt = format, .key = { 0 } }
+
+#define DECLARE_TRACE_EVENT(id)  extern trace_event_t trace_event_##id
+
+/* TRACE(id, a0[, a1[, a2[, a3]]]) – missing arguments are recorded as 0 */
+#define TRACE(id, ...)  TRACE_(id, __VA_ARGS__, 0, 0, 0, 0)
+#define TRACE_(id, a0, a1, a2, a3, ...)  do {                           \
+    if (static_branch_unlikely(&trace_event_##id.key))                 \
+        trace_emit(&trace_event_##id, (uint32_t)(uintptr_t)(a0),       \
+                   (uint32_t)(uintptr_t)(a1), (uint32_t)(uintptr_t)(a2), \
+                   (uint32_t)(uintptr_t)(a3));                         \
+} while (0)
+
+/* =========================================================================
+ * Functions
+ * ========================================================================= */
+
+/** Append a record to the calling CPU's ring; safe from any context. */
+void trace_emit(const trace_event_t *event, uint32_t a0, uint32_t a1,
+                uint32_t a2, uint32_t a3);
+
+/** Enable or disable an event by name ("all" matches every event). */
+int trace_set_event(const char *name, int enabled);
+
+/** Register /dev/trace and /dev/trace_events. */
+void trace_init(void);
+
+#endif /* TRACE_H */
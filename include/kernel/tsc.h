@@ -0,0 +1,23 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * Time Stamp Counter
+ *
+ * tsc_init() measures the TSC frequency against PIT channel 2 (the speaker
+ * timer, whose gate is software controlled) so it can run before the PIT
+ * interrupt is set up and does not disturb channel 0.
+ * ========================================================================= */
+
+/* TSC frequency in kHz; 0 until calibrated or when there is no TSC */
+extern uint32_t tsc_khz;
+
+/** Calibrate the TSC; needs cpu_detect_features(). */
+void tsc_init(void);
+
+/** Convert a cycle count to microseconds (0 when uncalibrated). */
+uint64_t tsc_to_us(uint64_t cycles);
+
+#endif /* TSC_H */
@@ -0,0 +1,57 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <stdint.h>
+#include "lib/list.h"
+
+/* =========================================================================
+ * Deferred work
+ *
+ * Work items are run by the idle loop, i.e. whenever the CPU would
+ * otherwise halt.  schedule_work() is safe from interrupt context.
+ * An item runs once per schedule_work(); scheduling an item that is
+ * already queued does nothing.
+ *
+ * schedule_delayed_work() queues an item after a number of timer ticks
+ * (PIT_DEFAULT_HZ per second).  A periodic job re-arms itself from its
+ * function.  schedule_work() on an item still waiting for its delay
+ * queues it at once.
+ * ========================================================================= */
+
+typedef struct work_struct work_t;
+typedef void (*work_fn_t)(work_t *work);
+
+struct work_struct {
+    list_head_t  node;
+    work_fn_t    fn;
+    int          pending;    /* queued and not yet started */
+    int          delayed;    /* pending on the timer, not the queue */
+    uint32_t     expires;    /* tick it is due at, when delayed */
+};
+
+#define INIT_WORK(w, f)  do {           \
+    INIT_LIST_HEAD(&(w)->node);         \
+    (w)->fn      = (f);                 \
+    (w)->pending = 0;                   \
+    (w)->delayed = 0;                   \
+} while (0)
+
+/** Queue work; returns 1 if queued, 0 if it was already pending. */
+int schedule_work(work_t *work);
+
+/**
+ * Queue work once `ticks` timer ticks have passed (0 queues it now).
+ * Returns 1 if armed, 0 if it was already pending (the old delay stands).
+ */
+int schedule_delayed_work(work_t *work, uint32_t ticks);
+
+/** Queue delayed work that is due; called by the timer interrupt. */
+void workqueue_tick(void);
+
+/** Run every queued item (including ones queued meanwhile); returns the count. */
+int run_work(void);
+
+/** Nonzero while any item is queued. */
+int work_pending(void);
+
+#endif /* WORKQUEUE_H */
@@ -0,0 +1,39 @@
+#ifndef DIV64_H
+#define DIV64_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * 64-bit division helpers
+ *
+ * The kernel links without libgcc, so plain '/' and '%' on 64-bit
+ * operands (which compile to __udivdi3 / __umoddi3 calls) are unavailable.
+ * These helpers divide a 64-bit value by a 32-bit divisor with two DIVL
+ * instructions.
+ * ========================================================================= */
+
+/* *n = *n / base; returns *n % base */
+static inline uint32_t div_u64_rem(uint64_t *n, uint32_t base)
+{
+    uint32_t low  = (uint32_t)*n;
+    uint32_t high = (uint32_t)(*n >> 32);
+    uint32_t q_high = 0, rem;
+
+    if (high >= base) {
+        q_high = high / base;
+        high  %= base;
+    }
+    __asm__ ("divl %2" : "=a"(low), "=d"(rem) : "rm"(base), "0"(low), "1"(high));
+
+    *n = ((uint64_t)q_high << 32) | low;
+    return rem;
+}
+
+/* Return n / base */
+static inline uint64_t div_u64(uint64_t n, uint32_t base)
+{
+    div_u64_rem(&n, base);
+    return n;
+}
+
+#endif /* DIV64_H */
@@ -0,0 +1,278 @@
+#ifndef LIB_HASH_H
+#define LIB_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "lib/list.h"
+
+/* =========================================================================
+ * Hash functions and intrusive hash tables
+ *
+ * Two flavours, both chaining through an hlist_node_t embedded in the
+ * object (a singly linked list with a back-pointer, so a bucket head is
+ * one pointer and deletion needs no walk):
+ *
+ * Fixed size (no allocation, usable from interrupt context):
+ *
+ *   static DEFINE_HASHTABLE(inode_table, 6);          // 64 buckets
+ *   hash_add(inode_table, &ino->hnode, ino->number);
+ *   hash_for_each_possible(inode_table, pos, hnode, number)
+ *       if (pos->number == number) return pos;
+ *   hash_del(&ino->hnode);
+ *
+ * Resizable (buckets from kalloc, grows past load 1, shrinks below 1/8):
+ *
+ *   htable_t t;
+ *   htable_init(&t, 4);
+ *   htable_add(&t, &obj->hnode, hash_str(obj->name));
+ *   htable_for_each_possible(&t, pos, hnode, h)
+ *       if (strcmp(pos->name, name) == 0) return pos;
+ *   htable_del(&t, &obj->hnode);
+ *
+ * htable_add/htable_del may resize, which allocates and rehashes every
+ * node at once: not from interrupt context and not while iterating.  If
+ * the allocation fails the table keeps its size and chains get longer.
+ * ========================================================================= */
+
+/* =========================================================================
+ * Hash functions
+ * ========================================================================= */
+
+#define GOLDEN_RATIO_32  0x61C88647u
+
+/* Multiplicative hash of val into the top `bits` bits (bits 1..32) */
+static inline uint32_t hash_32(uint32_t val, unsigned int bits)
+{
+    return (val * GOLDEN_RATIO_32) >> (32 - bits);
+}
+
+static inline uint32_t hash_64(uint64_t val, unsigned int bits)
+{
+    return hash_32((uint32_t)val ^ hash_32((uint32_t)(val >> 32), 32), bits);
+}
+
+static inline uint32_t hash_ptr(const void *ptr, unsigned int bits)
+{
+    return hash_32((uint32_t)(uintptr_t)ptr, bits);
+}
+
+/* FNV-1a over len bytes; a full 32-bit hash, reduce with hash_32() */
+static inline uint32_t hash_mem(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t h = 2166136261u;
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* FNV-1a over a NUL-terminated string */
+static inline uint32_t hash_str(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* =========================================================================
+ * hlist – singly linked list with O(1) delete
+ * ========================================================================= */
+
+typedef struct hlist_node {
+    struct hlist_node  *next;
+    struct hlist_node **pprev;   /* the pointer that points at us */
+} hlist_node_t;
+
+typedef struct hlist_head {
+    hlist_node_t *first;
+} hlist_head_t;
+
+#define HLIST_HEAD_INIT  { NULL }
+
+static inline void INIT_HLIST_HEAD(hlist_head_t *h)
+{
+    h->first = NULL;
+}
+
+static inline void INIT_HLIST_NODE(hlist_node_t *n)
+{
+    n->next  = NULL;
+    n->pprev = NULL;
+}
+
+/* Nonzero when n is on no list (after INIT_HLIST_NODE or hlist_del_init) */
+static inline int hlist_unhashed(const hlist_node_t *n)
+{
+    return n->pprev == NULL;
+}
+
+static inline int hlist_empty(const hlist_head_t *h)
+{
+    return h->first == NULL;
+}
+
+static inline void hlist_add_head(hlist_node_t *n, hlist_head_t *h)
+{
+    hlist_node_t *first = h->first;
+    n->next = first;
+    if (first)
+        first->pprev = &n->next;
+    h->first = n;
+    n->pprev = &h->first;
+}
+
+static inline void hlist_del(hlist_node_t *n)
+{
+    *n->pprev = n->next;
+    if (n->next)
+        n->next->pprev = n->pprev;
+    n->next  = NULL;
+    n->pprev = NULL;
+}
+
+/* Delete if hashed; safe to call on an unhashed node */
+static inline void hlist_del_init(hlist_node_t *n)
+{
+    if (!hlist_unhashed(n))
+        hlist_del(n);
+}
+
+#define hlist_entry(ptr, type, member)  container_of(ptr, type, member)
+
+#define hlist_entry_safe(ptr, type, member) ({                          \
+    hlist_node_t *____ptr = (ptr);                                      \
+    ____ptr ? hlist_entry(____ptr, type, member) : NULL;                \
+})
+
+/**
+ * hlist_for_each_entry - iterate over the objects on an hlist
+ * @pos:    loop cursor (pointer to enclosing type)
+ * @head:   hlist_head_t *
+ * @member: name of the hlist_node_t within the enclosing struct
+ */
+#define hlist_for_each_entry(pos, head, member)                             \
+    for ((pos) = hlist_entry_safe((head)->first, __typeof__(*(pos)), member); \
+         (pos);                                                             \
+         (pos) = hlist_entry_safe((pos)->member.next, __typeof__(*(pos)), member))
+
+/**
+ * hlist_for_each_entry_safe - iterate, safe against removal of pos
+ * @n: hlist_node_t * temporary
+ */
+#define hlist_for_each_entry_safe(pos, n, head, member)                     \
+    for ((pos) = hlist_entry_safe((head)->first, __typeof__(*(pos)), member); \
+         (pos) && ((n) = (pos)->member.next, 1);                            \
+         (pos) = hlist_entry_safe((n), __typeof__(*(pos)), member))
+
+/* =========================================================================
+ * Fixed-size tables
+ * ========================================================================= */
+
+#define DEFINE_HASHTABLE(name, bits)                                    \
+    hlist_head_t name[1 << (bits)] =                                    \
+        { [0 ... ((1 << (bits)) - 1)] = HLIST_HEAD_INIT }
+
+#define HASH_SIZE(name)  (sizeof(name) / sizeof((name)[0]))
+#define HASH_BITS(name)  ((unsigned int)__builtin_ctz(HASH_SIZE(name)))
+
+static inline void __hash_init(hlist_head_t *ht, unsigned int size)
+{
+    for (unsigned int i = 0; i < size; i++)
+        INIT_HLIST_HEAD(&ht[i]);
+}
+
+#define hash_init(table)  __hash_init(table, HASH_SIZE(table))
+
+#define hash_add(table, node, key) \
+    hlist_add_head(node, &(table)[hash_32((uint32_t)(key), HASH_BITS(table))])
+
+static inline void hash_del(hlist_node_t *node)
+{
+    hlist_del_init(node);
+}
+
+/**
+ * hash_for_each_possible - iterate over the objects that may match key
+ * Callers still compare keys: different keys can share a bucket.
+ */
+#define hash_for_each_possible(table, obj, member, key)                 \
+    hlist_for_each_entry(obj,                                           \
+        &(table)[hash_32((uint32_t)(key), HASH_BITS(table))], member)
+
+/**
+ * hash_for_each - iterate over every object in the table
+ * @bkt: unsigned int bucket cursor
+ */
+#define hash_for_each(table, bkt, obj, member)                          \
+    for ((bkt) = 0; (bkt) < HASH_SIZE(table); (bkt)++)                  \
+        hlist_for_each_entry(obj, &(table)[bkt], member)
+
+/* =========================================================================
+ * Resizable tables
+ * ========================================================================= */
+
+#define HTABLE_MAX_BITS  20
+
+/* Embed in objects stored in an htable_t; the full hash is kept so
+ * resizing needs no callback and lookups skip most key compares */
+typedef struct htable_node {
+    hlist_node_t link;
+    uint32_t     hash;
+} htable_node_t;
+
+typedef struct {
+    hlist_head_t *buckets;
+    unsigned int  bits;       /* 1 << bits buckets                 */
+    unsigned int  min_bits;   /* never shrink below the init size  */
+    uint32_t      count;      /* objects in the table              */
+} htable_t;
+
+/** Allocate 1 << bits buckets (bits >= 1); returns 0 or -1. */
+int htable_init(htable_t *t, unsigned int bits);
+
+/** Free the buckets; the objects themselves belong to the caller. */
+void htable_destroy(htable_t *t);
+
+/** Rehash into 1 << bits buckets; on allocation failure keep the old ones. */
+void htable_resize(htable_t *t, unsigned int bits);
+
+static inline void htable_add(htable_t *t, htable_node_t *n, uint32_t hash)
+{
+    n->hash = hash;
+    hlist_add_head(&n->link, &t->buckets[hash_32(hash, t->bits)]);
+    if (++t->count > (1u << t->bits) && t->bits < HTABLE_MAX_BITS)
+        htable_resize(t, t->bits + 1);
+}
+
+static inline void htable_del(htable_t *t, htable_node_t *n)
+{
+    hlist_del_init(&n->link);
+    t->count--;
+    if (t->bits > t->min_bits && t->count < (1u << t->bits) / 8)
+        htable_resize(t, t->bits - 1);
+}
+
+/**
+ * htable_for_each_possible - iterate over objects whose hash equals h
+ * @member: name of the htable_node_t within the enclosing struct
+ * Callers still compare keys: different keys can share a hash.
+ */
+#define htable_for_each_possible(t, pos, member, h)                     \
+    hlist_for_each_entry(pos, &(t)->buckets[hash_32((h), (t)->bits)],   \
+                         member.link)                                   \
+        if ((pos)->member.hash != (h)) {} else
+
+/**
+ * htable_for_each - iterate over every object
+ * @bkt: unsigned int bucket cursor
+ */
+#define htable_for_each(t, bkt, pos, member)                            \
+    for ((bkt) = 0; (bkt) < (1u << (t)->bits); (bkt)++)                 \
+        hlist_for_each_entry(pos, &(t)->buckets[bkt], member.link)
+
+#endif /* LIB_HASH_H */
@@ -124,6 +124,21 @@ static inline void list_move_tail(list_head_t *entry, list_head_t *head)
     __list_add(entry, head->prev, head);
 }
 
+/* Move every entry of LIST to the front of HEAD; LIST is left empty */
+static inline void list_splice_init(list_head_t *list, list_head_t *head)
+{
+    if (list_empty(list))
+        return;
+
+    list_head_t *first = list->next, *last = list->prev;
+
+    first->prev      = head;
+    last->next       = head->next;
+    head->next->prev = last;
+    head->next       = first;
+    INIT_LIST_HEAD(list);
+}
+
 /* =========================================================================
  * container_of / list_entry
  * ========================================================================= */
@@ -193,6 +208,17 @@ static inline void list_move_tail(list_head_t *entry, list_head_t *head)
          &(pos)->member != (head);                                      \
          (pos) = list_entry((pos)->member.next, __typeof__(*(pos)), member))
 
+/**
+ * list_for_each_entry_reverse - iterate from the tail towards the head
+ * @pos:    loop cursor (pointer to enclosing type)
+ * @head:   list sentinel head
+ * @member: name of the list_head_t member within the enclosing struct
+ */
+#define list_for_each_entry_reverse(pos, head, member)                  \
+    for ((pos) = list_entry((head)->prev, __typeof__(*(pos)), member);  \
+         &(pos)->member != (head);                                      \
+         (pos) = list_entry((pos)->member.prev, __typeof__(*(pos)), member))
+
 /**
  * list_for_each_entry_safe - iterate, safe against removal of current entry
  * @pos:    loop cursor (pointer to enclosing type)
@@ -207,4 +233,16 @@ static inline void list_move_tail(list_head_t *entry, list_head_t *head)
          (pos) = (n),                                                   \
          (n)   = list_entry((n)->member.next, __typeof__(*(pos)), member))
 
+/* =========================================================================
+ * Sorting (lib/list.c)
+ * ========================================================================= */
+
+/**
+ * list_sort - stable merge sort, O(n log n) with no allocation
+ * @head: list sentinel head
+ * @cmp:  <0 / 0 / >0 as a sorts before / with / after b
+ */
+void list_sort(list_head_t *head,
+               int (*cmp)(const list_head_t *a, const list_head_t *b));
+
 #endif /* LIB_LIST_H */
\ No newline at end of file
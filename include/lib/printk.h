@@ -2,13 +2,42 @@
 #define PRINTK_H
 
 #include <stdarg.h>
+#include <stddef.h>
 
-/* Early printk - uses direct VGA access (before driver layer is ready) */
+/*
+ * Log levels: prefix the format, e.g. printk(KERN_ERR "[IDE] ...").
+ * Messages without a prefix are logged at KERN_INFO (kernel/log.h).
+ */
+#define KERN_SOH_ASCII  '\001'
+#define KERN_SOH        "\001"
+#define KERN_EMERG      KERN_SOH "0"
+#define KERN_ALERT      KERN_SOH "1"
+#define KERN_CRIT       KERN_SOH "2"
+#define KERN_ERR        KERN_SOH "3"
+#define KERN_WARNING    KERN_SOH "4"
+#define KERN_NOTICE     KERN_SOH "5"
+#define KERN_INFO       KERN_SOH "6"
+#define KERN_DEBUG      KERN_SOH "7"
+
+/* Early printk - writes straight to VGA, bypassing the log */
 void printk_early(const char *fmt, ...);
 void vprintk_early(const char *fmt, va_list args);
 
-/* Regular printk - uses driver abstraction layer */
+/* Regular printk - appends to the kernel log; consoles are fed from it */
 void printk(const char *fmt, ...);
 void vprintk(const char *fmt, va_list args);
 
+/*
+ * Format into buf (always NUL-terminated when size > 0).
+ * Returns the length the full output would have had, like vsnprintf.
+ */
+int snprintk(char *buf, size_t size, const char *fmt, ...);
+int vsnprintk(char *buf, size_t size, const char *fmt, va_list args);
+
+/*
+ * Like snprintk but returns the number of characters actually stored,
+ * so calls can be chained: len += scnprintk(buf + len, size - len, ...)
+ */
+int scnprintk(char *buf, size_t size, const char *fmt, ...);
+
 #endif /* PRINTK_H */
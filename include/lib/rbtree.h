@@ -0,0 +1,135 @@
+#ifndef LIB_RBTREE_H
+#define LIB_RBTREE_H
+
+#include <stddef.h>
+#include "lib/list.h"
+
+/* =========================================================================
+ * Intrusive red-black tree
+ *
+ * Like list.h, the node is embedded in the object and the tree never
+ * allocates.  The caller does the search (it knows the key) and links the
+ * new node; rb_insert_color() then rebalances:
+ *
+ *   rb_node_t **link = &root.rb_node, *parent = NULL;
+ *   while (*link) {
+ *       my_obj_t *cur = rb_entry(*link, my_obj_t, node);
+ *       parent = *link;
+ *       link = (obj->key < cur->key) ? &parent->rb_left : &parent->rb_right;
+ *   }
+ *   rb_link_node(&obj->node, parent, link);
+ *   rb_insert_color(&obj->node, &root);
+ *
+ * rb_add() and rb_find() wrap those loops around a comparison callback.
+ * Lookup, insert and erase are O(log n); rb_first()/rb_next() walk the
+ * tree in key order.  The rebalancing code lives in lib/rbtree.c.
+ * ========================================================================= */
+
+#define RB_RED    0
+#define RB_BLACK  1
+
+typedef struct rb_node {
+    struct rb_node *rb_parent;
+    struct rb_node *rb_left;
+    struct rb_node *rb_right;
+    int             rb_color;
+} rb_node_t;
+
+typedef struct rb_root {
+    rb_node_t *rb_node;
+} rb_root_t;
+
+#define RB_ROOT  ((rb_root_t){ NULL })
+
+#define rb_entry(ptr, type, member)  container_of(ptr, type, member)
+
+#define rb_entry_safe(ptr, type, member) ({                             \
+    rb_node_t *____ptr = (ptr);                                         \
+    ____ptr ? rb_entry(____ptr, type, member) : NULL;                   \
+})
+
+#define RB_EMPTY_ROOT(root)  ((root)->rb_node == NULL)
+
+/* A node not in any tree points at itself (RB_CLEAR_NODE) */
+#define RB_EMPTY_NODE(node)  ((node)->rb_parent == (node))
+#define RB_CLEAR_NODE(node)  ((node)->rb_parent = (node))
+
+/* =========================================================================
+ * Linking and rebalancing
+ * ========================================================================= */
+
+/* Attach node as a red leaf at *link under parent (NULL for the root) */
+static inline void rb_link_node(rb_node_t *node, rb_node_t *parent,
+                                rb_node_t **link)
+{
+    node->rb_parent = parent;
+    node->rb_left   = NULL;
+    node->rb_right  = NULL;
+    node->rb_color  = RB_RED;
+    *link = node;
+}
+
+/** Rebalance after rb_link_node(). */
+void rb_insert_color(rb_node_t *node, rb_root_t *root);
+
+/** Remove node from the tree and rebalance. */
+void rb_erase(rb_node_t *node, rb_root_t *root);
+
+/** Put new in victim's place without rebalancing (same key order). */
+void rb_replace_node(rb_node_t *victim, rb_node_t *new, rb_root_t *root);
+
+/* =========================================================================
+ * Ordered traversal
+ * ========================================================================= */
+
+rb_node_t *rb_first(const rb_root_t *root);
+rb_node_t *rb_last(const rb_root_t *root);
+rb_node_t *rb_next(const rb_node_t *node);
+rb_node_t *rb_prev(const rb_node_t *node);
+
+/**
+ * rb_for_each_entry - iterate over objects in key order
+ * Do not erase pos inside the loop; fetch rb_next() first instead.
+ */
+#define rb_for_each_entry(pos, root, member)                                \
+    for ((pos) = rb_entry_safe(rb_first(root), __typeof__(*(pos)), member); \
+         (pos);                                                             \
+         (pos) = rb_entry_safe(rb_next(&(pos)->member), __typeof__(*(pos)), member))
+
+/* =========================================================================
+ * Callback helpers
+ * ========================================================================= */
+
+/* Insert node; less(a, b) orders the tree, equal keys go to the right */
+static inline void rb_add(rb_node_t *node, rb_root_t *root,
+                          int (*less)(const rb_node_t *a, const rb_node_t *b))
+{
+    rb_node_t **link = &root->rb_node, *parent = NULL;
+
+    while (*link) {
+        parent = *link;
+        link = less(node, parent) ? &parent->rb_left : &parent->rb_right;
+    }
+    rb_link_node(node, parent, link);
+    rb_insert_color(node, root);
+}
+
+/* Find a node matching key; cmp(key, node) returns <0, 0 or >0 */
+static inline rb_node_t *rb_find(const void *key, const rb_root_t *root,
+                                 int (*cmp)(const void *key, const rb_node_t *node))
+{
+    rb_node_t *node = root->rb_node;
+
+    while (node) {
+        int c = cmp(key, node);
+        if (c < 0)
+            node = node->rb_left;
+        else if (c > 0)
+            node = node->rb_right;
+        else
+            return node;
+    }
+    return NULL;
+}
+
+#endif /* LIB_RBTREE_H */
@@ -0,0 +1,246 @@
+#ifndef LIB_RING_H
+#define LIB_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "kernel/asm.h"
+#include "lib/string.h"
+
+/* =========================================================================
+ * Lock-free byte rings for interrupt-to-task handoff
+ *
+ * A power-of-two byte buffer with free-running indices: head is where the
+ * producer writes next, tail where the consumer reads next, and
+ * head - tail is the fill level (unsigned wrap makes this exact).  The
+ * producer only writes head and the consumer only writes tail, each on
+ * its own cache line, so neither side needs interrupts off:
+ *
+ *   static DEFINE_RING(rx_ring, 256);
+ *
+ *   // interrupt handler (producer)
+ *   ring_put(&rx_ring, inb(DATA_PORT));
+ *
+ *   // reader (consumer)
+ *   char c;
+ *   if (ring_get(&rx_ring, &c)) ...
+ *
+ * ring_enqueue()/ring_dequeue() move up to n bytes at once with at most
+ * two memcpy()s and one index update, and return how many moved; a full
+ * ring drops the excess rather than blocking.
+ *
+ * Single producer (ring_put, ring_enqueue): one context writes at a time,
+ * e.g. one interrupt handler, or tasks that hold interrupts off.
+ *
+ * Multiple producers (ring_enqueue_mp): any mix of task and interrupt
+ * contexts on this CPU.  Each call reserves its bytes with a
+ * local_cmpxchg() on `reserve`, copies, and the outermost producer still
+ * in flight publishes everything reserved so far to head.  Interrupts
+ * nest, so when the outermost one finishes every producer it interrupted
+ * has finished too; the consumer never sees a half-copied reservation.
+ * Bytes of different calls never interleave.  A ring uses one producer
+ * flavour or the other, never both.
+ *
+ * The flip side: space reserved by an interrupted producer only comes
+ * back once that producer runs again.  A nested caller that gets 0 and
+ * sees ring_mp_held() must not wait for room (it would wait forever with
+ * interrupts off); it drops or truncates instead.
+ *
+ * The consumer side is always single: one context calls ring_get and
+ * ring_dequeue at a time.  Ordering relies on x86 TSO plus compiler
+ * barriers, and the local_* primitives are per-CPU only.
+ * ========================================================================= */
+
+#define RING_CACHELINE  64
+
+typedef struct ring {
+    /* Read-only after init */
+    char             *buf;
+    uint32_t          size;        /* power of two */
+    uint32_t          mask;
+
+    /* Producer line */
+    volatile uint32_t head     __attribute__((aligned(RING_CACHELINE)));
+    volatile uint32_t reserve;     /* multi-producer: claimed up to here */
+    volatile uint32_t writers;     /* multi-producer: calls in flight    */
+
+    /* Consumer line */
+    volatile uint32_t tail     __attribute__((aligned(RING_CACHELINE)));
+} ring_t;
+
+#define RING_INIT(data, sz) { .buf = (data), .size = (sz), .mask = (sz) - 1 }
+
+/* A ring with static storage; size must be a power of two */
+#define DEFINE_RING(name, sz)                                           \
+    char name##_data[sz] __attribute__((aligned(RING_CACHELINE)));      \
+    ring_t name = RING_INIT(name##_data, sz)
+
+static inline void ring_init(ring_t *r, char *data, uint32_t size)
+{
+    r->buf     = data;
+    r->size    = size;
+    r->mask    = size - 1;
+    r->head    = 0;
+    r->reserve = 0;
+    r->writers = 0;
+    r->tail    = 0;
+}
+
+/* Bytes waiting; exact for the consumer, a lower bound for anyone else */
+static inline uint32_t ring_count(const ring_t *r)
+{
+    return READ_ONCE(r->head) - READ_ONCE(r->tail);
+}
+
+static inline int ring_empty(const ring_t *r)
+{
+    return ring_count(r) == 0;
+}
+
+/* Room left for a single producer */
+static inline uint32_t ring_space(const ring_t *r)
+{
+    return r->size - (r->head - READ_ONCE(r->tail));
+}
+
+/* Copy n bytes in at free-running index pos, splitting at the end */
+static inline void ring_copy_in(ring_t *r, uint32_t pos, const void *src, uint32_t n)
+{
+    uint32_t off   = pos & r->mask;
+    uint32_t first = r->size - off;
+
+    if (first >= n) {
+        memcpy(r->buf + off, src, n);
+    } else {
+        memcpy(r->buf + off, src, first);
+        memcpy(r->buf, (const char *)src + first, n - first);
+    }
+}
+
+static inline void ring_copy_out(const ring_t *r, uint32_t pos, void *dst, uint32_t n)
+{
+    uint32_t off   = pos & r->mask;
+    uint32_t first = r->size - off;
+
+    if (first >= n) {
+        memcpy(dst, r->buf + off, n);
+    } else {
+        memcpy(dst, r->buf + off, first);
+        memcpy((char *)dst + first, r->buf, n - first);
+    }
+}
+
+/* =========================================================================
+ * Single producer
+ * ========================================================================= */
+
+/* Append one byte; 0 if the ring is full */
+static inline int ring_put(ring_t *r, char c)
+{
+    uint32_t head = r->head;
+
+    if (head - READ_ONCE(r->tail) == r->size)
+        return 0;
+    r->buf[head & r->mask] = c;
+    smp_wmb();
+    WRITE_ONCE(r->head, head + 1);
+    return 1;
+}
+
+/* Append up to n bytes; returns how many fit */
+static inline uint32_t ring_enqueue(ring_t *r, const void *src, uint32_t n)
+{
+    uint32_t head  = r->head;
+    uint32_t space = r->size - (head - READ_ONCE(r->tail));
+
+    if (n > space)
+        n = space;
+    if (n) {
+        ring_copy_in(r, head, src, n);
+        smp_wmb();
+        WRITE_ONCE(r->head, head + n);
+    }
+    return n;
+}
+
+/* =========================================================================
+ * Multiple producers
+ * ========================================================================= */
+
+/* Append up to n bytes as one unit; returns how many fit */
+static inline uint32_t ring_enqueue_mp(ring_t *r, const void *src, uint32_t n)
+{
+    uint32_t pos, space;
+
+    local_fetch_add(&r->writers, 1);
+
+    do {
+        pos   = READ_ONCE(r->reserve);
+        space = r->size - (pos - READ_ONCE(r->tail));
+        if (n > space)
+            n = space;
+    } while (n && local_cmpxchg(&r->reserve, pos, pos + n) != pos);
+
+    if (n)
+        ring_copy_in(r, pos, src, n);
+    smp_wmb();
+
+    if (local_fetch_add(&r->writers, (uint32_t)-1) == 1) {
+        /* Outermost: publish, but never move head backwards if a producer
+         * that interrupted us published a later reservation already */
+        uint32_t head, want;
+        do {
+            head = READ_ONCE(r->head);
+            want = READ_ONCE(r->reserve);
+            if ((int32_t)(want - head) <= 0)
+                break;
+        } while (local_cmpxchg(&r->head, head, want) != head);
+    }
+    return n;
+}
+
+/*
+ * Nonzero if producers the caller interrupted are still in flight, so
+ * space they reserved cannot be published or freed until it returns.
+ * Meaningful between ring_enqueue_mp() calls, not inside one.
+ */
+static inline int ring_mp_held(const ring_t *r)
+{
+    return READ_ONCE(r->writers) != 0;
+}
+
+/* =========================================================================
+ * Consumer
+ * ========================================================================= */
+
+/* Take one byte into *c; 0 if the ring is empty */
+static inline int ring_get(ring_t *r, char *c)
+{
+    uint32_t tail = r->tail;
+
+    if (READ_ONCE(r->head) == tail)
+        return 0;
+    smp_rmb();
+    *c = r->buf[tail & r->mask];
+    barrier();                     /* data read before the slot is freed */
+    WRITE_ONCE(r->tail, tail + 1);
+    return 1;
+}
+
+/* Take up to n bytes; returns how many were available */
+static inline uint32_t ring_dequeue(ring_t *r, void *dst, uint32_t n)
+{
+    uint32_t tail  = r->tail;
+    uint32_t avail = READ_ONCE(r->head) - tail;
+
+    if (n > avail)
+        n = avail;
+    if (n) {
+        smp_rmb();
+        ring_copy_out(r, tail, dst, n);
+        barrier();                 /* data read before the slot is freed */
+        WRITE_ONCE(r->tail, tail + n);
+    }
+    return n;
+}
+
+#endif /* LIB_RING_H */
@@ -2,6 +2,11 @@
 #define LIB_STRING_H
 
 #include <stddef.h>
+#include <stdint.h>
+
+/* A 32-bit word that may alias any object, for routines that go through
+ * arbitrary buffers a word at a time (lib/string.c, lib/memops.c) */
+typedef uint32_t __attribute__((may_alias)) word_t;
 
 /* =========================================================================
  * String Functions
@@ -112,4 +117,29 @@ void *memmove(void *dst, const void *src, size_t n);
  */
 int memcmp(const void *s1, const void *s2, size_t n);
 
+/* =========================================================================
+ * Implementation selection (lib/memops.c)
+ *
+ * memcpy and memset dispatch through mem_impl, chosen from CPUID by
+ * mem_select_impl() once the FPU is set up.  /dev/membench compares the
+ * implementations and can switch between them.
+ * ========================================================================= */
+
+typedef struct {
+    const char *name;
+    void     *(*memcpy)(void *dst, const void *src, size_t n);
+    void     *(*memset)(void *s, int c, size_t n);
+    int       (*usable)(void);
+} mem_impl_t;
+
+extern const mem_impl_t  mem_impls[];
+extern const int         mem_nimpls;
+extern const mem_impl_t *mem_impl;
+
+/** Pick the fastest implementation this CPU supports; after fpu_init(). */
+void mem_select_impl(void);
+
+/** Switch to the named implementation; -1 if unknown or unsupported. */
+int  mem_set_impl(const char *name);
+
 #endif /* LIB_STRING_H */
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef SHRINKER_H
+#define SHRINKER_H
+
+#include <stdint.h>
+#include "lib/list.h"
+
+/* =========================================================================
+ * Shrinkers – caches that give pages back under memory pressure
+ *
+ * A cache that holds memory it could drop registers a shrinker:
+ *
+ *   static shrinker_t cache_shrinker = { .name = "blkcache", .scan = cache_scan };
+ *   register_shrinker(&cache_shrinker);
+ *
+ * When page_alloc() cannot satisfy a request it calls shrink_memory()
+ * and retries once.  scan(nr) should release up to nr pages to
+ * page_free() and return how many it released.
+ *
+ * scan runs in whatever context allocated: interrupt handlers, or the
+ * cache's own allocation path.  It must not sleep or do I/O (drop clean
+ * data only), and must return 0 when its structures are in use.
+ * ========================================================================= */
+
+typedef struct shrinker {
+    const char  *name;
+    uint32_t   (*scan)(uint32_t nr_pages);
+    list_head_t  node;
+} shrinker_t;
+
+/** Add a shrinker; it may be called from the next allocation on. */
+void register_shrinker(shrinker_t *s);
+
+void unregister_shrinker(shrinker_t *s);
+
+/**
+ * Ask the shrinkers for nr_pages, in registration order, until that
+ * many are released.  Returns the number released (0 when called again
+ * from inside a shrinker).
+ */
+uint32_t shrink_memory(uint32_t nr_pages);
+
+#endif /* SHRINKER_H */
@@ -0,0 +1,107 @@
+#include "kernel/alternative.h"
+#include "kernel/jump_label.h"
+#include "kernel/cpu.h"
+#include "kernel/asm.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Section bounds (linker.ld)
+ * ========================================================================= */
+
+extern alt_instr_t  __start_altinstructions[], __stop_altinstructions[];
+extern jump_entry_t __start___jump_table[],   __stop___jump_table[];
+
+/* =========================================================================
+ * Text patching
+ *
+ * Kernel text is mapped writable.  With one CPU, interrupts off is enough
+ * to keep anyone from executing a half-written site; CPUID afterwards
+ * serialises so no stale prefetched bytes run.
+ * ========================================================================= */
+
+static inline void sync_core(void)
+{
+    uint32_t a, b, c, d;
+    cpuid(0, 0, &a, &b, &c, &d);
+}
+
+void text_poke(void *addr, const void *bytes, uint32_t len)
+{
+    uint32_t flags = raw_irq_save();
+
+    /* Volatile byte stores: nothing may be merged, reordered or elided */
+    volatile uint8_t *dst = (volatile uint8_t *)addr;
+    const uint8_t    *src = (const uint8_t *)bytes;
+    for (uint32_t i = 0; i < len; i++)
+        dst[i] = src[i];
+
+    sync_core();
+    raw_irq_restore(flags);
+}
+
+/* =========================================================================
+ * Alternatives
+ * ========================================================================= */
+
+void apply_alternatives(void)
+{
+    int patched = 0;
+
+    for (alt_instr_t *a = __start_altinstructions; a < __stop_altinstructions; a++) {
+        if (!cpu_has(a->feature))
+            continue;
+
+        uint8_t insn[255];
+        memcpy(insn, (const void *)a->repl, a->repl_len);
+        for (int i = a->repl_len; i < a->orig_len; i++)
+            insn[i] = 0x90;
+
+        text_poke((void *)a->orig, insn, a->orig_len);
+        patched++;
+    }
+
+    printk("[ALT] Patched %d of %d alternative sites\n", patched,
+           (int)(__stop_altinstructions - __start_altinstructions));
+}
+
+/* =========================================================================
+ * Static keys
+ * ========================================================================= */
+
+static void jump_label_update(static_key_t *key, int enable)
+{
+    static const uint8_t nop[5] = { JUMP_LABEL_NOP_BYTES };
+
+    for (jump_entry_t *e = __start___jump_table; e < __stop___jump_table; e++) {
+        if (e->key != key)
+            continue;
+
+        if (enable) {
+            uint8_t jmp[5];
+            int32_t rel = (int32_t)(e->target - (e->code + 5));
+            jmp[0] = 0xE9;
+            memcpy(&jmp[1], &rel, 4);
+            text_poke((void *)e->code, jmp, 5);
+        } else {
+            text_poke((void *)e->code, nop, 5);
+        }
+    }
+}
+
+void static_key_enable(static_key_t *key)
+{
+    if (key->enabled)
+        return;
+    key->enabled = 1;
+    jump_label_update(key, 1);
+}
+
+void static_key_disable(static_key_t *key)
+{
+    if (!key->enabled)
+        return;
+    jump_label_update(key, 0);
+    key->enabled = 0;
+}
@@ -0,0 +1,140 @@
+#include "kernel/bench.h"
+#include "kernel/cmdline.h"
+#include "kernel/initcall.h"
+#include "kernel/tsc.h"
+#include "kernel/log.h"
+#include "kernel/asm.h"
+#include "lib/div64.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Benchmark table (linker section, see linker.ld)
+ * ========================================================================= */
+
+extern benchmark_t __start_benchmarks[], __stop_benchmarks[];
+
+#define for_each_benchmark(b) \
+    for (benchmark_t *b = __start_benchmarks; b < __stop_benchmarks; b++)
+
+/* =========================================================================
+ * Timing
+ * ========================================================================= */
+
+/* Cycles for one pass of n operations; *ret gets the benchmark's result */
+static uint64_t bench_pass(const benchmark_t *b, uint32_t n, int *ret)
+{
+    uint64_t t0 = rdtsc();
+    *ret = b->fn(n);
+    return rdtsc() - t0;
+}
+
+/* Double n until a pass takes min_cycles; returns n, or 0 on error/skip */
+static uint32_t bench_calibrate(const benchmark_t *b, uint64_t min_cycles, int *ret)
+{
+    uint32_t n = 1;
+
+    for (;;) {
+        uint64_t cycles = bench_pass(b, n, ret);
+        if (*ret != 0)
+            return 0;
+        if (cycles >= min_cycles || n >= BENCH_MAX_N)
+            return n;
+        n <<= 1;
+    }
+}
+
+static uint32_t per_op(uint64_t cycles, uint32_t n)
+{
+    return (uint32_t)div_u64(cycles, n);
+}
+
+/* Runs one benchmark and prints its line; returns 0, BENCH_SKIP or -1 */
+static int bench_one(const benchmark_t *b, uint64_t min_cycles)
+{
+    uint64_t runs[BENCH_RUNS];
+    uint32_t n   = 0;
+    int      ret = 0;
+
+    if (b->setup)
+        ret = b->setup();
+
+    if (ret == 0)
+        n = bench_calibrate(b, min_cycles, &ret);
+
+    for (int i = 0; ret == 0 && i < BENCH_RUNS; i++) {
+        uint64_t c = bench_pass(b, n, &ret);
+
+        /* Insertion sort: runs[0] is the fastest */
+        int j = i;
+        while (j > 0 && runs[j - 1] > c) {
+            runs[j] = runs[j - 1];
+            j--;
+        }
+        runs[j] = c;
+    }
+
+    if (b->teardown)
+        b->teardown();
+
+    if (ret == BENCH_SKIP) {
+        printk("[BENCH] name=%s skipped\n", b->name);
+        return BENCH_SKIP;
+    }
+    if (ret != 0) {
+        printk("[BENCH] name=%s failed\n", b->name);
+        return -1;
+    }
+
+    uint64_t med = runs[BENCH_RUNS / 2];
+    uint32_t ns  = tsc_khz ? per_op(div_u64(med * 1000000, tsc_khz), n) : 0;
+
+    printk("[BENCH] name=%s n=%u cyc_min=%u cyc_med=%u ns_med=%u\n",
+           b->name, n, per_op(runs[0], n), per_op(med, n), ns);
+    return 0;
+}
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void bench_main(void)
+{
+    char filter[32];
+
+    if (cmdline_param("bench", 0, filter, sizeof(filter)) < 0)
+        return;
+
+    /* Block benchmarks need the disks the async IDE probe finds */
+    initcall_flush();
+
+    /* Without a calibrated TSC, assume 1 GHz for the pass length */
+    uint64_t min_cycles = div_u64((uint64_t)(tsc_khz ? tsc_khz : 1000000) * BENCH_MIN_US, 1000);
+    size_t   flen       = strlen(filter);
+    int      count = 0, failed = 0, skipped = 0;
+
+    for_each_benchmark(b) {
+        if (strncmp(b->name, filter, flen) == 0)
+            count++;
+    }
+
+    printk("[BENCH] begin tsc_khz=%u count=%d\n", tsc_khz, count);
+
+    for_each_benchmark(b) {
+        if (strncmp(b->name, filter, flen) != 0)
+            continue;
+
+        int ret = bench_one(b, min_cycles);
+        if (ret == BENCH_SKIP)
+            skipped++;
+        else if (ret != 0)
+            failed++;
+    }
+
+    printk("[BENCH] end failed=%d skipped=%d\n", failed, skipped);
+    console_flush();
+
+    /* QEMU exits with (value << 1) | 1 */
+    outb(BENCH_EXIT_PORT, failed ? 1 : 0);
+}
@@ -0,0 +1,280 @@
+#include "kernel/bench.h"
+#include "driver/block/block.h"
+#include "driver/block/ide.h"
+#include "driver/char/vga.h"
+#include "driver/char/uart.h"
+#include "fs/fs.h"
+#include "mm/buddy.h"
+#include "mm/slab.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Standard benchmark suite
+ *
+ * Allocators, block I/O, VFS and console output; see kernel/bench.h for
+ * how these are run.  Subsystems may also declare BENCHMARK()s next to
+ * their own code.
+ * ========================================================================= */
+
+static uint8_t bench_buf[8 * 512] __attribute__((aligned(16)));
+
+/* =========================================================================
+ * Allocators
+ * ========================================================================= */
+
+static int bench_kalloc_64(uint32_t n)
+{
+    while (n--)
+        kfree(kalloc(64));
+    return 0;
+}
+BENCHMARK(kalloc_64, bench_kalloc_64, NULL, NULL);
+
+static int bench_kalloc_1024(uint32_t n)
+{
+    while (n--)
+        kfree(kalloc(1024));
+    return 0;
+}
+BENCHMARK(kalloc_1024, bench_kalloc_1024, NULL, NULL);
+
+/* Many objects live at once: slabs fill up and are released again */
+#define BATCH  256
+static void *batch[BATCH];
+
+static int bench_kalloc_batch(uint32_t n)
+{
+    while (n) {
+        uint32_t k = n < BATCH ? n : BATCH;
+        for (uint32_t i = 0; i < k; i++)
+            batch[i] = kalloc(128);
+        for (uint32_t i = 0; i < k; i++)
+            kfree(batch[i]);
+        n -= k;
+    }
+    return 0;
+}
+BENCHMARK(kalloc_batch_128, bench_kalloc_batch, NULL, NULL);
+
+static int bench_page_alloc_1(uint32_t n)
+{
+    while (n--) {
+        void *p = page_alloc(PAGE_SIZE);
+        if (!p)
+            return -1;
+        page_free(p);
+    }
+    return 0;
+}
+BENCHMARK(page_alloc_1, bench_page_alloc_1, NULL, NULL);
+
+static int bench_page_alloc_16(uint32_t n)
+{
+    while (n--) {
+        void *p = page_alloc(16 * PAGE_SIZE);
+        if (!p)
+            return -1;
+        page_free(p);
+    }
+    return 0;
+}
+BENCHMARK(page_alloc_16, bench_page_alloc_16, NULL, NULL);
+
+/* =========================================================================
+ * Block I/O (scratch disk only)
+ * ========================================================================= */
+
+static int bench_dev = -2;   /* -2: not looked for yet */
+
+int bench_disk(void)
+{
+    if (bench_dev != -2)
+        return bench_dev;
+
+    bench_dev = -1;
+    for (int i = 0; i < IDE_MAX_DISKS; i++) {
+        if (bread(i, 0, bench_buf, 0, 1) != 512)
+            continue;
+        if (memcmp(bench_buf, BENCH_DISK_MAGIC, sizeof(BENCH_DISK_MAGIC) - 1) == 0) {
+            bench_dev = i;
+            break;
+        }
+    }
+    return bench_dev;
+}
+
+static int bench_disk_setup(void)
+{
+    return bench_disk() < 0 ? BENCH_SKIP : 0;
+}
+
+/* Next scratch sector for sequential runs of `blocks` sectors */
+static uint32_t bench_seq = 0;
+
+static uint32_t bench_next(uint32_t blocks)
+{
+    if (bench_seq + blocks > BENCH_DISK_SPAN)
+        bench_seq = 0;
+    uint32_t sector = 1 + bench_seq;
+    bench_seq += blocks;
+    return sector;
+}
+
+/* The same block over and over: what a hot cache is worth */
+static int bench_blk_read_hot(uint32_t n)
+{
+    while (n--) {
+        if (bread(bench_dev, 0, bench_buf, 1, 1) != 512)
+            return -1;
+    }
+    return 0;
+}
+BENCHMARK(blk_read_hot, bench_blk_read_hot, bench_disk_setup, NULL);
+
+/* The same, by reference: no copy out of the cache */
+static int bench_blk_ref_hot(uint32_t n)
+{
+    while (n--) {
+        cache_buf_t *b = bread_ref(bench_dev, 0, 1);
+        if (!b)
+            return -1;
+        brelse(b);
+    }
+    return 0;
+}
+BENCHMARK(blk_ref_hot, bench_blk_ref_hot, bench_disk_setup, NULL);
+
+static int bench_blk_read_seq(uint32_t n)
+{
+    while (n--) {
+        if (bread(bench_dev, 0, bench_buf, bench_next(1), 1) != 512)
+            return -1;
+    }
+    return 0;
+}
+BENCHMARK(blk_read_seq, bench_blk_read_seq, bench_disk_setup, NULL);
+
+static int bench_blk_read_seq8(uint32_t n)
+{
+    while (n--) {
+        if (bread(bench_dev, 0, bench_buf, bench_next(8), 8) != 8 * 512)
+            return -1;
+    }
+    return 0;
+}
+BENCHMARK(blk_read_seq8, bench_blk_read_seq8, bench_disk_setup, NULL);
+
+static int bench_blk_write_seq(uint32_t n)
+{
+    memset(bench_buf, 0xA5, 512);
+    while (n--) {
+        if (bwrite(bench_dev, 0, bench_buf, bench_next(1), 1) != 512)
+            return -1;
+    }
+    return 0;
+}
+BENCHMARK(blk_write_seq, bench_blk_write_seq, bench_disk_setup, NULL);
+
+/* The same writes in write-back mode; what reaches the disk meanwhile is
+ * the dirty-limit throttling, the rest is synced in teardown */
+static int bench_wb_setup(void)
+{
+    if (bench_disk() < 0)
+        return BENCH_SKIP;
+    cache_set_writeback(1);
+    return 0;
+}
+
+static void bench_wb_teardown(void)
+{
+    cache_set_writeback(0);
+}
+BENCHMARK(blk_write_wb, bench_blk_write_seq, bench_wb_setup, bench_wb_teardown);
+
+/* =========================================================================
+ * VFS (through the scratch disk's /dev node)
+ * ========================================================================= */
+
+static char bench_path[16];
+static int  bench_fd = -1;
+
+static int bench_vfs_setup(void)
+{
+    if (bench_disk() < 0)
+        return BENCH_SKIP;
+
+    scnprintk(bench_path, sizeof(bench_path), "/dev/hd%c", 'a' + bench_dev);
+    bench_fd = fs_open(bench_path, O_RDONLY);
+    return bench_fd < 0 ? -1 : 0;
+}
+
+static void bench_vfs_teardown(void)
+{
+    if (bench_fd >= 0)
+        fs_close(bench_fd);
+    bench_fd = -1;
+}
+
+static int bench_vfs_open(uint32_t n)
+{
+    while (n--) {
+        int fd = fs_open(bench_path, O_RDONLY);
+        if (fd < 0)
+            return -1;
+        fs_close(fd);
+    }
+    return 0;
+}
+BENCHMARK(vfs_open_close, bench_vfs_open, bench_vfs_setup, bench_vfs_teardown);
+
+/* 4 KB reads, rewinding at the end of the scratch area */
+static int bench_vfs_read(uint32_t n)
+{
+    while (n--) {
+        uint32_t sector = bench_next(8);
+        if (fs_seek(bench_fd, (int32_t)(sector * 512), SEEK_SET) < 0)
+            return -1;
+        if (fs_read(bench_fd, bench_buf, 8 * 512) != 8 * 512)
+            return -1;
+    }
+    return 0;
+}
+BENCHMARK(vfs_read_4k, bench_vfs_read, bench_vfs_setup, bench_vfs_teardown);
+
+/* =========================================================================
+ * Console
+ * ========================================================================= */
+
+static const char bench_line[] =
+    "benchmark line 0123456789 abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRST\n";
+
+/* Formatting and the log ring; debug records stay off the consoles */
+static int bench_printk(uint32_t n)
+{
+    while (n--)
+        printk(KERN_DEBUG "[BENCH] printk %u %s", n, bench_line);
+    return 0;
+}
+BENCHMARK(printk_debug, bench_printk, NULL, NULL);
+
+/* One screen line with scrolling */
+static int bench_vga_write(uint32_t n)
+{
+    while (n--)
+        vga_write_buf(bench_line, sizeof(bench_line) - 1);
+    return 0;
+}
+BENCHMARK(vga_write_line, bench_vga_write, NULL, NULL);
+
+/* COM2, so the results on COM1 stay readable */
+static int bench_uart_write(uint32_t n)
+{
+    while (n--) {
+        if (uart_write_buf(1, bench_line, 64) < 0)
+            return BENCH_SKIP;
+    }
+    return 0;
+}
+BENCHMARK(uart_write_64, bench_uart_write, NULL, NULL);
@@ -20,6 +20,16 @@ multiboot_header:
 _start:
     /* Simple entry point - no bootloader dependencies */
 
+    /* Multiboot: EAX = magic, EBX = info structure (kernel/cmdline.c);
+     * saved first because RDTSC overwrites EAX */
+    movl  %eax, multiboot_magic - 0xC0000000
+    movl  %ebx, multiboot_info - 0xC0000000
+
+    /* Boot timeline: stamp the TSC before anything else (physical address) */
+    rdtsc
+    movl  %eax, boot_tsc_entry - 0xC0000000
+    movl  %edx, boot_tsc_entry - 0xC0000000 + 4
+
     /* ================================================================
      * Build page directory and page tables
      * ================================================================ */
@@ -124,6 +134,11 @@ _start_higher:
     movl  %cr3, %eax
     movl  %eax, %cr3
 
+    /* Boot timeline: page-table setup and the paging switch are done */
+    rdtsc
+    movl  %eax, boot_tsc_paging
+    movl  %edx, boot_tsc_paging + 4
+
     /* Set up kernel stack (virtual address) */
     movl  $stack_top, %esp
 
@@ -161,6 +176,29 @@ boot_page_tables:
  * 16 KB kernel stack
  * ----------------------------------------------------------------------- */
 .align 16
+.global stack_bottom
+.global stack_top
 stack_bottom:
     .skip 16384
-stack_top:
\ No newline at end of file
+stack_top:
+/* -----------------------------------------------------------------------
+ * Boot timeline stamps (kernel/boottime.c)
+ * ----------------------------------------------------------------------- */
+.align 8
+.global boot_tsc_entry
+.global boot_tsc_paging
+boot_tsc_entry:
+    .long 0, 0
+boot_tsc_paging:
+    .long 0, 0
+
+/* -----------------------------------------------------------------------
+ * Multiboot handoff (kernel/cmdline.c)
+ * ----------------------------------------------------------------------- */
+.align 4
+.global multiboot_magic
+.global multiboot_info
+multiboot_magic:
+    .long 0
+multiboot_info:
+    .long 0
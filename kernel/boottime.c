@@ -0,0 +1,83 @@
+#include "kernel/boottime.h"
+#include "kernel/tsc.h"
+#include "kernel/asm.h"
+#include "fs/devfs.h"
+#include "lib/printk.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * Stage table
+ * ========================================================================= */
+
+/* Stamped by boot.s */
+extern uint64_t boot_tsc_entry;     /* first instruction of _start      */
+extern uint64_t boot_tsc_paging;    /* paging on, before kernel_main    */
+
+static struct {
+    const char *name;
+    uint64_t    end;                /* TSC when the stage finished      */
+} boot_stages[BOOT_MAX_STAGES];
+
+static int boot_nstages = 0;
+
+void boot_stage(const char *name)
+{
+    if (boot_nstages == BOOT_MAX_STAGES)
+        return;
+    boot_stages[boot_nstages].name = name;
+    boot_stages[boot_nstages].end  = rdtsc();
+    boot_nstages++;
+}
+
+/* =========================================================================
+ * Report
+ * ========================================================================= */
+
+static int fmt_ms(char *buf, size_t size, uint64_t cycles)
+{
+    uint32_t us = (uint32_t)tsc_to_us(cycles);
+    return scnprintk(buf, size, "%6u.%03u", us / 1000, us % 1000);
+}
+
+static int boottime_show(char *buf, size_t size)
+{
+    int len = 0;
+
+    if (tsc_khz == 0)
+        return scnprintk(buf, size, "TSC not calibrated, no timeline\n");
+
+    len += scnprintk(buf + len, size - len, "entered kernel at ");
+    len += fmt_ms(buf + len, size - len, boot_tsc_entry);
+    len += scnprintk(buf + len, size - len, " ms after CPU reset\n\n");
+
+    len += scnprintk(buf + len, size - len, "%-28s %10s %10s\n", "stage", "ms", "total ms");
+
+    uint64_t prev = boot_tsc_paging;
+    len += scnprintk(buf + len, size - len, "%-28s ", "boot.s page tables");
+    len += fmt_ms(buf + len, size - len, boot_tsc_paging - boot_tsc_entry);
+    len += scnprintk(buf + len, size - len, " ");
+    len += fmt_ms(buf + len, size - len, boot_tsc_paging - boot_tsc_entry);
+    len += scnprintk(buf + len, size - len, "\n");
+
+    for (int i = 0; i < boot_nstages; i++) {
+        len += scnprintk(buf + len, size - len, "%-28s ", boot_stages[i].name);
+        len += fmt_ms(buf + len, size - len, boot_stages[i].end - prev);
+        len += scnprintk(buf + len, size - len, " ");
+        len += fmt_ms(buf + len, size - len, boot_stages[i].end - boot_tsc_entry);
+        len += scnprintk(buf + len, size - len, "\n");
+        prev = boot_stages[i].end;
+    }
+
+    return len;
+}
+
+void boottime_report(void)
+{
+    static char report[BOOT_MAX_STAGES * 64 + 256];
+
+    boottime_show(report, sizeof(report));
+    printk("[BOOT] Timeline:\n%s\n", report);
+
+    devfs_register_file("boottime", boottime_show, NULL);
+}
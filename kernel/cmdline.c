@@ -0,0 +1,102 @@
+#include "kernel/cmdline.h"
+#include "kernel/initcall.h"
+#include "fs/devfs.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stdint.h>
+
+/* =========================================================================
+ * Multiboot information (saved by boot.s)
+ * ========================================================================= */
+
+#define MULTIBOOT_BOOTLOADER_MAGIC  0x2BADB002
+#define MULTIBOOT_INFO_CMDLINE      (1u << 2)
+#define KERNEL_VMA                  0xC0000000u
+
+extern uint32_t multiboot_magic;
+extern uint32_t multiboot_info;     /* physical address */
+
+/* Leading fields of the multiboot information structure */
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;
+    uint32_t mem_upper;
+    uint32_t boot_device;
+    uint32_t cmdline;               /* physical address of a C string */
+} __attribute__((packed)) multiboot_info_t;
+
+static char cmdline[CMDLINE_MAX];
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void cmdline_init(void)
+{
+    if (multiboot_magic != MULTIBOOT_BOOTLOADER_MAGIC)
+        return;
+
+    /* The first GB of physical memory is mapped at KERNEL_VMA */
+    const multiboot_info_t *mbi =
+        (const multiboot_info_t *)(multiboot_info + KERNEL_VMA);
+    if (!(mbi->flags & MULTIBOOT_INFO_CMDLINE) || !mbi->cmdline)
+        return;
+
+    strncpy(cmdline, (const char *)(mbi->cmdline + KERNEL_VMA), CMDLINE_MAX - 1);
+    cmdline[CMDLINE_MAX - 1] = '\0';
+}
+
+const char *cmdline_get(void)
+{
+    return cmdline;
+}
+
+int cmdline_param(const char *key, int n, char *buf, size_t size)
+{
+    size_t      klen = strlen(key);
+    const char *p    = cmdline;
+
+    while (*p) {
+        while (*p == ' ')
+            p++;
+        const char *word = p;
+        while (*p && *p != ' ')
+            p++;
+
+        if ((size_t)(p - word) < klen || strncmp(word, key, klen) != 0)
+            continue;
+
+        const char *val = word + klen;
+        if (val != p && *val != '=')
+            continue;               /* longer key with the same prefix */
+        if (n-- > 0)
+            continue;
+
+        if (val != p)
+            val++;
+        int len = (int)(p - val);
+        if (size > 0) {
+            size_t copy = (size_t)len < size - 1 ? (size_t)len : size - 1;
+            memcpy(buf, val, copy);
+            buf[copy] = '\0';
+        }
+        return len;
+    }
+    return -1;
+}
+
+/* =========================================================================
+ * /dev/cmdline
+ * ========================================================================= */
+
+static int cmdline_show(char *buf, size_t size)
+{
+    return scnprintk(buf, size, "%s\n", cmdline);
+}
+
+static void cmdline_devfs_init(void)
+{
+    devfs_register_file("cmdline", cmdline_show, NULL);
+}
+
+INITCALL(cmdline, cmdline_devfs_init, 0);
@@ -126,8 +126,71 @@ void isr_init(void)
     idt_set_gate(31, (uint32_t)isr31, GDT_KERNEL_CODE, IDT_GATE_INT32);
 }
 
+/* =========================================================================
+ * CPU features
+ * ========================================================================= */
+
+uint32_t cpu_features[X86_FEATURE_WORDS];
+
+void cpu_detect_features(void)
+{
+    uint32_t max_leaf, eax, ebx, ecx, edx;
+
+    cpuid(0, 0, &max_leaf, &ebx, &ecx, &edx);
+
+    cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    cpu_features[0] = edx;
+    cpu_features[1] = ecx;
+
+    if (max_leaf >= 7) {
+        cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        cpu_features[2] = ebx;
+    }
+}
+
 /* =========================================================================
  * Paging
  * ========================================================================= */
 // global var for page physical addr
-volatile uint32_t kernel_page_table;
\ No newline at end of file
+volatile uint32_t kernel_page_table;
+
+/* =========================================================================
+ * MMIO window
+ *
+ * The boot page tables map all of 0xC0000000-0xFFFFFFFF onto the first
+ * 1 GB of RAM, so device registers living elsewhere (LAPIC, IOAPIC) are
+ * mapped through a 4 MB uncached window just below the kernel, backed by
+ * one statically allocated page table.  Usable before mm_init().
+ * ========================================================================= */
+
+#define MMIO_WINDOW_BASE   0xBFC00000U
+#define MMIO_WINDOW_PAGES  1024
+
+static pte_t    mmio_page_table[MMIO_WINDOW_PAGES] __attribute__((aligned(4096)));
+static uint32_t mmio_next_page = 0;
+
+void *mmio_map(uint32_t phys, uint32_t size)
+{
+    uint32_t offset = phys & 0xFFF;
+    uint32_t base   = phys & ~0xFFFU;
+    uint32_t pages  = (offset + size + 0xFFF) >> 12;
+
+    if (mmio_next_page + pages > MMIO_WINDOW_PAGES)
+        return NULL;
+
+    /* Hook the window's page table into the kernel page directory */
+    pde_t *page_dir = (pde_t *)(kernel_page_table + KERNEL_VMA);
+    pde_t *pde      = &page_dir[MMIO_WINDOW_BASE >> 22];
+    if (!(*pde & PAGE_PRESENT))
+        *pde = ((uint32_t)mmio_page_table - KERNEL_VMA) | PAGE_PRESENT | PAGE_WRITE;
+
+    uint32_t virt = MMIO_WINDOW_BASE + (mmio_next_page << 12);
+    for (uint32_t i = 0; i < pages; i++) {
+        mmio_page_table[mmio_next_page + i] =
+            (base + (i << 12)) | PAGE_PRESENT | PAGE_WRITE | PAGE_PCD | PAGE_PWT;
+        invlpg(virt + (i << 12));
+    }
+    mmio_next_page += pages;
+
+    return (void *)(virt + offset);
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "kernel/fpu.h"
+#include "kernel/cpu.h"
+#include "kernel/sched.h"
+#include "kernel/panic.h"
+#include "lib/printk.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Hardware bits
+ * ========================================================================= */
+
+#define CR0_MP          (1u << 1)    /* monitor coprocessor: WAIT honours TS */
+#define CR0_EM          (1u << 2)    /* emulate: every FPU op traps          */
+#define CR0_TS          (1u << 3)    /* task switched: next FPU op traps     */
+#define CR0_NE          (1u << 5)    /* native x87 error reporting (#MF)     */
+#define CR4_OSFXSR      (1u << 9)    /* FXSAVE/FXRSTOR + SSE enabled         */
+#define CR4_OSXMMEXCPT  (1u << 10)   /* unmasked SSE exceptions raise #XM    */
+
+#define MXCSR_DEFAULT   0x1F80       /* all exceptions masked, round-nearest */
+
+static inline void clts(void)
+{
+    __asm__ volatile ("clts" : : : "memory");
+}
+
+static inline void stts(void)
+{
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+/* =========================================================================
+ * State
+ *
+ * fpu_owner is the task whose state is in the registers (NULL: nobody's,
+ * e.g. right after a kernel FPU section).
+ * ========================================================================= */
+
+static int fpu_enabled = 0;
+static int fpu_fxsr    = 0;          /* FXSAVE available (else FNSAVE) */
+
+static struct task_struct *fpu_owner = NULL;
+static volatile int        kernel_fpu_active[NR_CPUS];
+
+static void fpu_save(fpu_state_t *st)
+{
+    if (fpu_fxsr)
+        __asm__ volatile ("fxsave %0" : "=m"(st->area));
+    else
+        __asm__ volatile ("fnsave %0; fwait" : "=m"(st->area));
+}
+
+static void fpu_restore(fpu_state_t *st)
+{
+    if (fpu_fxsr)
+        __asm__ volatile ("fxrstor %0" : : "m"(st->area));
+    else
+        __asm__ volatile ("frstor %0" : : "m"(st->area));
+}
+
+/* Fresh register state for a task's first FPU use */
+static void fpu_reset_regs(void)
+{
+    __asm__ volatile ("fninit");
+    if (fpu_fxsr && cpu_has(X86_FEATURE_SSE)) {
+        uint32_t mxcsr = MXCSR_DEFAULT;
+        __asm__ volatile ("ldmxcsr %0" : : "m"(mxcsr));
+    }
+}
+
+/* Write the owner's registers back to its task state */
+static void fpu_unlazy_owner(void)
+{
+    if (fpu_owner) {
+        fpu_save(&fpu_owner->fpu);
+        fpu_owner = NULL;
+    }
+}
+
+/* =========================================================================
+ * #NM – first FPU use since TS was set
+ * ========================================================================= */
+
+void fpu_nm_trap(void)
+{
+    if (!fpu_enabled)
+        panic("#NM Device Not Available (no FPU)");
+
+    clts();
+
+    /* Inside a kernel section TS is clear, so this is task-level use */
+    if (fpu_owner == current)
+        return;
+
+    fpu_unlazy_owner();
+
+    if (current->fpu.used) {
+        fpu_restore(&current->fpu);
+    } else {
+        fpu_reset_regs();
+        current->fpu.used = 1;
+    }
+    fpu_owner = current;
+}
+
+void fpu_switch_to(struct task_struct *next)
+{
+    if (fpu_enabled && fpu_owner != next)
+        stts();
+}
+
+/* =========================================================================
+ * Kernel FPU sections
+ * ========================================================================= */
+
+int kernel_fpu_usable(void)
+{
+    return fpu_enabled && !kernel_fpu_active[smp_processor_id()];
+}
+
+void kernel_fpu_begin(void)
+{
+    uint32_t flags = raw_irq_save();
+
+    kernel_fpu_active[smp_processor_id()] = 1;
+    clts();
+    fpu_unlazy_owner();
+
+    raw_irq_restore(flags);
+}
+
+void kernel_fpu_end(void)
+{
+    /* Registers now hold kernel scratch: make the next task use reload */
+    stts();
+    barrier();
+    kernel_fpu_active[smp_processor_id()] = 0;
+}
+
+/* =========================================================================
+ * Initialisation
+ * ========================================================================= */
+
+void fpu_init(void)
+{
+    if (!cpu_has(X86_FEATURE_FPU)) {
+        printk("[FPU] No x87 FPU, floating point and SIMD unavailable\n");
+        return;
+    }
+
+    uint32_t cr0 = read_cr0();
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    write_cr0(cr0);
+
+    fpu_fxsr = cpu_has(X86_FEATURE_FXSR);
+    if (fpu_fxsr && cpu_has(X86_FEATURE_SSE))
+        write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+
+    fpu_reset_regs();
+    fpu_enabled = 1;
+
+    /* Nobody owns the registers yet: trap the first use */
+    stts();
+
+    printk("[FPU] x87%s%s enabled, lazy %s switching\n",
+           (read_cr4() & CR4_OSFXSR) ? " SSE" : "",
+           cpu_has(X86_FEATURE_SSE2) ? " SSE2" : "",
+           fpu_fxsr ? "FXSAVE" : "FNSAVE");
+}
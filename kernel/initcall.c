@@ -0,0 +1,131 @@
+#include "kernel/initcall.h"
+#include "kernel/boottime.h"
+#include "kernel/tsc.h"
+#include "kernel/asm.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Section bounds (linker.ld)
+ * ========================================================================= */
+
+extern initcall_t __start_initcalls[];
+extern initcall_t __stop_initcalls[];
+
+#define for_each_initcall(c) \
+    for (initcall_t *c = __start_initcalls; c < __stop_initcalls; c++)
+
+static int boot_done = 0;   /* do_initcalls() has returned */
+
+/* =========================================================================
+ * Dependency resolution
+ * ========================================================================= */
+
+static initcall_t *initcall_find(const char *name)
+{
+    for_each_initcall(c) {
+        if (strcmp(c->name, name) == 0)
+            return c;
+    }
+    return NULL;
+}
+
+/* 1 when every dependency has finished */
+static int initcall_ready(const initcall_t *call)
+{
+    for (int i = 0; i < call->ndeps; i++) {
+        initcall_t *dep = initcall_find(call->deps[i]);
+        if (!dep || dep->state != INITCALL_DONE)
+            return 0;
+    }
+    return 1;
+}
+
+static void initcall_run(initcall_t *call)
+{
+    call->state = INITCALL_RUNNING;
+
+    uint64_t t0 = rdtsc();
+    call->fn();
+    uint64_t t1 = rdtsc();
+
+    call->state = INITCALL_DONE;
+
+    if (!boot_done) {
+        boot_stage(call->name);
+    } else {
+        uint32_t us = (uint32_t)tsc_to_us(t1 - t0);
+        printk("[INIT] %s finished in %u.%03u ms (deferred)\n",
+               call->name, us / 1000, us % 1000);
+    }
+}
+
+static void initcall_work(work_t *work);
+
+/*
+ * Start everything whose dependencies are met.  Synchronous calls run
+ * straight away, which may unblock more, so repeat until nothing changes.
+ */
+static void initcall_scan(void)
+{
+    int progress;
+
+    do {
+        progress = 0;
+        for_each_initcall(c) {
+            if (c->state != INITCALL_PENDING || !initcall_ready(c))
+                continue;
+
+            if ((c->flags & INITCALL_ASYNC) && !boot_done) {
+                c->state = INITCALL_QUEUED;
+                INIT_WORK(&c->work, initcall_work);
+                schedule_work(&c->work);
+            } else {
+                initcall_run(c);
+                progress = 1;
+            }
+        }
+    } while (progress);
+}
+
+static void initcall_work(work_t *work)
+{
+    initcall_t *call = container_of(work, initcall_t, work);
+
+    /* initcall_flush() may already have run it */
+    if (call->state != INITCALL_QUEUED)
+        return;
+
+    initcall_run(call);
+    initcall_scan();   /* release dependents */
+}
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void do_initcalls(void)
+{
+    /* Report names that can never be satisfied */
+    for_each_initcall(c) {
+        for (int i = 0; i < c->ndeps; i++) {
+            if (!initcall_find(c->deps[i]))
+                printk("[INIT] %s: unknown dependency '%s', not run\n",
+                       c->name, c->deps[i]);
+        }
+    }
+
+    initcall_scan();
+    boot_done = 1;
+}
+
+void initcall_flush(void)
+{
+    for_each_initcall(c) {
+        if (c->state == INITCALL_QUEUED) {
+            initcall_run(c);
+            initcall_scan();
+        }
+    }
+}
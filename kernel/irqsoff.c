@@ -0,0 +1,44 @@
+#include "kernel/irqflags.h"
+
+/* =========================================================================
+ * irqs-off worst-case tracker
+ *
+ * Per-CPU state is only touched with interrupts disabled on that CPU, so
+ * no further locking is needed.
+ * ========================================================================= */
+
+irqsoff_cpu_t irqsoff_cpu[NR_CPUS];
+DEFINE_STATIC_KEY_FALSE(irqsoff_key);
+
+void irqsoff_stop(void)
+{
+    irqsoff_cpu_t *st = &irqsoff_cpu[smp_processor_id()];
+    uint64_t cycles = rdtsc() - st->start;
+
+    if (cycles > st->max_cycles) {
+        st->max_cycles = cycles;
+        st->max_eip    = st->start_eip;
+    }
+    st->start = 0;
+}
+
+void irqsoff_record(uint64_t cycles, uint32_t eip)
+{
+    irqsoff_cpu_t *st = &irqsoff_cpu[smp_processor_id()];
+
+    if (static_key_enabled(&irqsoff_key) && cycles > st->max_cycles) {
+        st->max_cycles = cycles;
+        st->max_eip    = eip;
+    }
+}
+
+void irqsoff_reset(void)
+{
+    uint32_t flags = raw_irq_save();
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        irqsoff_cpu[cpu].start      = 0;
+        irqsoff_cpu[cpu].max_cycles = 0;
+        irqsoff_cpu[cpu].max_eip    = 0;
+    }
+    raw_irq_restore(flags);
+}
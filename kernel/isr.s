@@ -6,7 +6,11 @@
  *   2. Pushes the exception number
  *   3. Saves all GPRs (pusha) and segment registers
  *   4. Switches to kernel data segment and kernel CR3
- *   5. Calls panic_isr(regs_t *r)  — never returns
+ *   5. Clears DF, as the C calling convention requires
+ *   6. Calls panic_isr(regs_t *r)  — never returns
+ *
+ * The exception is #NM (vector 7), which handles lazy FPU switching and
+ * returns; see isr7 below.
  * ========================================================================= */
 
 /* Macro for exceptions WITHOUT a hardware error code */
@@ -39,7 +43,7 @@ ISR_NOERR  3   /* #BP  Breakpoint                    */
 ISR_NOERR  4   /* #OF  Overflow                      */
 ISR_NOERR  5   /* #BR  BOUND Range Exceeded           */
 ISR_NOERR  6   /* #UD  Invalid Opcode                */
-ISR_NOERR  7   /* #NM  Device Not Available           */
+/*         7      #NM  Device Not Available  – see isr7 below */
 ISR_ERR    8   /* #DF  Double Fault          (err=0) */
 ISR_NOERR  9   /*      Coprocessor Seg Overrun       */
 ISR_ERR   10   /* #TS  Invalid TSS                   */
@@ -66,35 +70,138 @@ ISR_ERR   30   /* #SX  Security Exception            */
 ISR_NOERR 31   /*      Reserved                      */
 
 /* -------------------------------------------------------------------------
- * IRQ stubs – save context, call C handler, restore, iret
+ * IRQ stubs – one per hardware vector (0x20 + irq), all funnelled into
+ * irq_common, which builds the same regs_t frame as the exception path
+ * and calls irq_dispatch(regs_t *r).  The dispatcher sends the EOI.
  * ------------------------------------------------------------------------- */
 
-.macro IRQ_STUB num, handler
+.macro IRQ_STUB num
 .global irq\num
 irq\num:
+    pushl $0            /* dummy error code */
+    pushl $(32 + \num)  /* vector number    */
+    jmp   irq_common
+.endm
+
+IRQ_STUB  0
+IRQ_STUB  1
+IRQ_STUB  2
+IRQ_STUB  3
+IRQ_STUB  4
+IRQ_STUB  5
+IRQ_STUB  6
+IRQ_STUB  7
+IRQ_STUB  8
+IRQ_STUB  9
+IRQ_STUB 10
+IRQ_STUB 11
+IRQ_STUB 12
+IRQ_STUB 13
+IRQ_STUB 14
+IRQ_STUB 15
+IRQ_STUB 16
+IRQ_STUB 17
+IRQ_STUB 18
+IRQ_STUB 19
+IRQ_STUB 20
+IRQ_STUB 21
+IRQ_STUB 22
+IRQ_STUB 23
+
+irq_common:
     pusha
+
+    /* Static key site (irq_timing_key): a 5-byte NOP, patched into
+     * "jmp irq_stamp_entry" while interrupt timing is on */
+1:  .byte 0x3e, 0x8d, 0x74, 0x26, 0x00
+    .pushsection __jump_table, "aw"
+    .balign 4
+    .long 1b, irq_stamp_entry, irq_timing_key
+    .popsection
+irq_stamped:
+
+    xorl  %eax, %eax
     movw  %ds, %ax
+    pushl %eax
     movw  %es, %ax
+    pushl %eax
     movw  %fs, %ax
+    pushl %eax
     movw  %gs, %ax
+    pushl %eax
+
     movw  $0x10, %ax
     movw  %ax, %ds
     movw  %ax, %es
     movw  %ax, %fs
     movw  %ax, %gs
+
+    /* Switch to the kernel page directory only if needed (avoids a TLB flush) */
     movl  kernel_page_table, %eax
+    movl  %cr3, %ebx
+    cmpl  %eax, %ebx
+    je    1f
     movl  %eax, %cr3
-    call  \handler
+1:
+    /* The interrupted code may be in a backward string copy (memmove);
+     * C code expects DF clear.  iret restores the caller's flags. */
+    cld
+    pushl %esp
+    call  irq_dispatch
+    addl  $4, %esp
+
+    popl  %eax
     movw  %ax, %gs
+    popl  %eax
     movw  %ax, %fs
+    popl  %eax
     movw  %ax, %es
+    popl  %eax
     movw  %ax, %ds
+
     popa
+    addl  $8, %esp      /* drop vector number and error code */
+    iret
+
+/* Out of line so the stub pays nothing while timing is off */
+irq_stamp_entry:
+    rdtsc                       /* stub-entry timestamp for irq_dispatch */
+    movl  %eax, irq_entry_tsc
+    movl  %edx, irq_entry_tsc+4
+    jmp   irq_stamped
+
+/* Stub addresses, indexed by IRQ number, for irq_init() */
+.section .data
+.global irq_stub_table
+irq_stub_table:
+    .long irq0,  irq1,  irq2,  irq3,  irq4,  irq5,  irq6,  irq7
+    .long irq8,  irq9,  irq10, irq11, irq12, irq13, irq14, irq15
+    .long irq16, irq17, irq18, irq19, irq20, irq21, irq22, irq23
+.section .text
+
+/* -------------------------------------------------------------------------
+ * #NM (vector 7) – lazy FPU state load.  Recoverable, so it returns to the
+ * faulting instruction instead of going through panic_isr.  Only the
+ * registers a C call may clobber need saving.
+ * ------------------------------------------------------------------------- */
+.global isr7
+isr7:
+    pushl %eax
+    pushl %ecx
+    pushl %edx
+    cld
+    call  fpu_nm_trap
+    popl  %edx
+    popl  %ecx
+    popl  %eax
     iret
-.endm
 
-IRQ_STUB 0, pit_isr   /* IRQ0 – PIT timer */
-IRQ_STUB 1, kbd_isr   /* IRQ1 – Keyboard */
+/* -------------------------------------------------------------------------
+ * LAPIC spurious interrupt (vector 0xFF) – must not be acknowledged
+ * ------------------------------------------------------------------------- */
+.global spurious_irq
+spurious_irq:
+    iret
 
 /* -------------------------------------------------------------------------
  * Common handler: save context, switch to kernel env, call panic_isr
@@ -125,6 +232,9 @@ isr_common:
     movl  kernel_page_table, %eax
     movl  %eax, %cr3
 
+    /* C code expects DF clear, whatever the faulting code had */
+    cld
+
     /* Pass pointer to saved frame as argument to panic_isr */
     pushl %esp
     call  panic_isr
@@ -1,19 +1,24 @@
 #include "kernel/cpu.h"
+#include "kernel/cmdline.h"
+#include "kernel/alternative.h"
 #include "kernel/sched.h"
+#include "kernel/rcu.h"
+#include "kernel/trace.h"
+#include "kernel/profile.h"
+#include "kernel/tsc.h"
+#include "kernel/fpu.h"
+#include "kernel/boottime.h"
+#include "kernel/initcall.h"
+#include "kernel/workqueue.h"
+#include "kernel/log.h"
+#include "kernel/bench.h"
 #include "driver/char/vga.h"
-#include "driver/char/tty.h"
-#include "driver/char/pit.h"
 #include "driver/char/kbd.h"
-#include "driver/char/char.h"
-#include "driver/block/block.h"
-#include "driver/block/ide.h"
-#include "driver/block/part_mbr.h"
 #include "driver/pic.h"
+#include "driver/irq.h"
 #include "lib/printk.h"
+#include "lib/string.h"
 #include "mm/mm.h"
-#include "driver/block/cache.h"
-#include "fs/fs.h"
-#include "fs/devfs.h"
 
 
 /* =========================================================================
@@ -25,47 +30,73 @@ void kernel_main(void)
     /* ------------------------------------------------------------------
      * CPU / interrupt infrastructure
      * ------------------------------------------------------------------ */
-    gdt_init();
-    idt_init();
-    isr_init();
-    pic_init(0x20, 0x28);
+    /* Save the command line before anything can overwrite it */
+    BOOT_STAGE(cmdline_init());
+    BOOT_STAGE(cpu_detect_features());
+    BOOT_STAGE(gdt_init());
+    BOOT_STAGE(idt_init());
+    BOOT_STAGE(isr_init());
+    BOOT_STAGE(pic_init(0x20, 0x28));
 
     /* VGA must come first so printk has somewhere to write */
-    vga_init();
+    BOOT_STAGE(vga_init());
+
+    /* Patch CPU-specific instruction sequences (needs cpu_detect_features) */
+    BOOT_STAGE(apply_alternatives());
+
+    /* Calibrate the TSC so the boot timeline can be shown in ms */
+    BOOT_STAGE(tsc_init());
+
+    /* x87/SSE on, with lazy register switching */
+    BOOT_STAGE(fpu_init());
+    BOOT_STAGE(mem_select_impl());
+
+    /* Switch to IOAPIC/LAPIC routing when the machine has it */
+    BOOT_STAGE(irq_init());
 
     /* ------------------------------------------------------------------
      * Memory management (detects RAM, initializes buddy & slab)
      * ------------------------------------------------------------------ */
-    mm_init();
+    BOOT_STAGE(mm_init());
 
     /* ------------------------------------------------------------------
      * Kernel services
      * ------------------------------------------------------------------ */
-    sched_init();
-    cache_init();
+    BOOT_STAGE(sched_init());
+    BOOT_STAGE(trace_init());
+    BOOT_STAGE(profile_init());
 
     /* ------------------------------------------------------------------
-     * Character drivers  (each registers itself + devfs node internally)
+     * Drivers and filesystems (INITCALL()s, in dependency order; slow
+     * probes are deferred to the idle loop)
      * ------------------------------------------------------------------ */
-    tty_init();
-    pit_init(100);
-    kbd_init();
+    do_initcalls();
+    kbd_register_hotkey(SC_F11, profile_dump);
+    kbd_register_hotkey(SC_F12, irq_latency_dump);
 
-    printk("[KERNEL] Early initialization complete\n\n");
-
-    /* ------------------------------------------------------------------
-     * Block drivers + partition scan
-     * ------------------------------------------------------------------ */
-    block_init();
+    printk("[KERNEL] Initialization complete\n\n");
+    boottime_report();
 
-    /* ------------------------------------------------------------------
-     * Virtual filesystem
-     * ------------------------------------------------------------------ */
-    vfs_init();
-    devfs_init();   /* mount devfs at /dev */
+    /* "bench" on the command line: run the benchmark suite (kernel/bench.h) */
+    bench_main();
 
-    printk("[KERNEL] Initialization complete\n\n");
+    /* From here on the idle loop feeds the console */
+    log_set_sync(0);
 
     sti();
-    while (1);
+
+    /*
+     * Idle loop: every pass is a quiescent state that retires RCU callbacks;
+     * deferred work runs here, and the CPU halts only when there is none.
+     */
+    for (;;) {
+        rcu_quiescent_state(0);
+        run_work();
+
+        cli();
+        if (work_pending())
+            sti();
+        else
+            safe_halt();
+    }
 }
@@ -0,0 +1,38 @@
+#include "kernel/ksyms.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Symbol lookup (binary search over the generated table)
+ * ========================================================================= */
+
+extern char _text_start[], _text_end[];
+
+int ksym_index(uint32_t addr)
+{
+    if (ksym_count == 0 ||
+        addr < (uint32_t)_text_start || addr >= (uint32_t)_text_end ||
+        addr < ksym_table[0].addr)
+        return -1;
+
+    /* Last symbol whose address is <= addr */
+    uint32_t lo = 0, hi = ksym_count - 1;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi + 1) / 2;
+        if (ksym_table[mid].addr <= addr)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    return (int)lo;
+}
+
+const char *ksym_lookup(uint32_t addr, uint32_t *offset)
+{
+    int i = ksym_index(addr);
+    if (i < 0)
+        return NULL;
+
+    if (offset)
+        *offset = addr - ksym_table[i].addr;
+    return ksym_table[i].name;
+}
@@ -0,0 +1,391 @@
+#include "kernel/log.h"
+#include "kernel/irqflags.h"
+#include "kernel/workqueue.h"
+#include "kernel/initcall.h"
+#include "kernel/tsc.h"
+#include "kernel/cmdline.h"
+#include "kernel/asm.h"
+#include "fs/devfs.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include "lib/div64.h"
+
+/* =========================================================================
+ * Ring layout
+ *
+ * Records are packed back to back, 8-byte aligned.  A record that would
+ * not fit before the end of the buffer is placed at offset 0 instead, and
+ * a header with len == 0 is left behind to mark the wrap.  There is always
+ * room for that marker after the last record.
+ *
+ * Sequence numbers count records; [log_first_seq, log_next_seq) is what
+ * the ring currently holds.  Everything is updated with interrupts off.
+ * ========================================================================= */
+
+#define LOG_CONT    (1 << 0)   /* continues a line the previous record began */
+
+typedef struct {
+    uint64_t tsc;          /* rdtsc() when stored                     */
+    uint16_t len;          /* whole record, aligned; 0 = wrap marker  */
+    uint16_t text_len;
+    uint8_t  level;
+    uint8_t  flags;        /* LOG_*                                   */
+    uint16_t pad;
+} log_rec_t;
+
+#define LOG_ALIGN(n)  (((n) + 7) & ~7u)
+
+static char     log_buf[LOG_BUF_SIZE] __attribute__((aligned(8)));
+
+static uint32_t log_first_idx, log_first_seq;   /* oldest record        */
+static uint32_t log_next_idx,  log_next_seq;    /* where the next goes  */
+static uint32_t clear_idx,     clear_seq;       /* /dev/dmesg start     */
+
+static int      log_cont;                       /* last record open-ended */
+
+extern uint64_t boot_tsc_entry;                 /* kernel/boot.s */
+
+/* Record at idx, following a wrap marker; idx is updated to match */
+static log_rec_t *log_rec(uint32_t *idx)
+{
+    log_rec_t *rec = (log_rec_t *)(log_buf + *idx);
+    if (rec->len == 0) {
+        *idx = 0;
+        rec  = (log_rec_t *)log_buf;
+    }
+    return rec;
+}
+
+static uint32_t log_next(uint32_t idx)
+{
+    log_rec_t *rec = log_rec(&idx);
+    return idx + rec->len;
+}
+
+static inline const char *log_text(const log_rec_t *rec)
+{
+    return (const char *)(rec + 1);
+}
+
+/* =========================================================================
+ * Consoles
+ * ========================================================================= */
+
+int console_loglevel = LOGLEVEL_DEBUG;   /* everything but debug */
+
+static console_t *consoles[MAX_CONSOLES];
+static int        nconsoles;
+static int        console_busy;          /* a flush is in progress */
+static int        log_sync = 1;          /* boot: write out in printk */
+
+static void console_work_fn(work_t *work);
+
+static work_t console_work = {
+    .node    = LIST_HEAD_INIT(console_work.node),
+    .fn      = console_work_fn,
+    .pending = 0,
+};
+
+#define CONSOLE_BATCH  1024
+
+/* Fill batch with con's next records; interrupts are off */
+static size_t console_fill(console_t *con, char *batch, size_t size)
+{
+    size_t len = 0;
+
+    if (con->seq < log_first_seq) {
+        len = scnprintk(batch, size, "** %u console messages dropped **\n",
+                        log_first_seq - con->seq);
+        con->seq = log_first_seq;
+        con->idx = log_first_idx;
+    }
+
+    while (con->seq < log_next_seq) {
+        uint32_t   idx = con->idx;
+        log_rec_t *rec = log_rec(&idx);
+
+        if (len + rec->text_len > size)
+            break;
+        if (rec->level < console_loglevel) {
+            memcpy(batch + len, log_text(rec), rec->text_len);
+            len += rec->text_len;
+        }
+        con->idx = idx + rec->len;
+        con->seq++;
+    }
+    return len;
+}
+
+void console_flush(void)
+{
+    /* Only one flusher runs at a time, so one batch buffer will do */
+    static char batch[CONSOLE_BATCH];
+
+    uint32_t flags = irq_save();
+    if (console_busy) {
+        /* The running flush picks up anything stored meanwhile */
+        irq_restore(flags);
+        return;
+    }
+    console_busy = 1;
+
+    for (int busy = 1; busy; ) {
+        busy = 0;
+        for (int i = 0; i < nconsoles; i++) {
+            console_t *con = consoles[i];
+            size_t     len = console_fill(con, batch, sizeof(batch));
+            if (len == 0)
+                continue;
+
+            /* Device output runs with interrupts as the caller had them */
+            irq_restore(flags);
+            con->write(batch, len);
+            flags = irq_save();
+            busy = 1;
+        }
+    }
+
+    console_busy = 0;
+    irq_restore(flags);
+}
+
+static void console_work_fn(work_t *work)
+{
+    (void)work;
+    console_flush();
+}
+
+int register_console(console_t *con)
+{
+    uint32_t flags = irq_save();
+
+    if (nconsoles == MAX_CONSOLES) {
+        irq_restore(flags);
+        return -1;
+    }
+
+    con->seq = log_first_seq;
+    con->idx = log_first_idx;
+    consoles[nconsoles++] = con;
+    irq_restore(flags);
+
+    console_flush();
+    return 0;
+}
+
+int console_selected(const char *name, char *opts, size_t size)
+{
+    char val[32];
+
+    if (opts && size)
+        opts[0] = '\0';
+
+    if (cmdline_param("console", 0, val, sizeof(val)) < 0)
+        return strcmp(name, CONSOLE_DEFAULT) == 0;
+
+    for (int n = 0; cmdline_param("console", n, val, sizeof(val)) >= 0; n++) {
+        char *comma = strchr(val, ',');
+        if (comma)
+            *comma = '\0';
+        if (strcmp(val, name) != 0)
+            continue;
+        if (comma && opts && size) {
+            strncpy(opts, comma + 1, size - 1);
+            opts[size - 1] = '\0';
+        }
+        return 1;
+    }
+    return 0;
+}
+
+void log_set_sync(int sync)
+{
+    log_sync = sync;
+    if (sync)
+        console_flush();
+}
+
+void log_panic(void)
+{
+    /* A flush interrupted by the fault would otherwise block us forever */
+    console_busy = 0;
+    log_sync     = 1;
+    console_flush();
+}
+
+/* =========================================================================
+ * Storing
+ * ========================================================================= */
+
+void log_store(int level, const char *text, size_t len)
+{
+    if (len > LOG_LINE_MAX)
+        len = LOG_LINE_MAX;
+
+    uint32_t size  = LOG_ALIGN(sizeof(log_rec_t) + len);
+    uint32_t flags = irq_save();
+
+    /* Drop old records until there is contiguous room plus a wrap marker */
+    while (log_first_seq < log_next_seq) {
+        uint32_t free;
+        if (log_next_idx > log_first_idx) {
+            free = LOG_BUF_SIZE - log_next_idx;
+            if (log_first_idx > free)
+                free = log_first_idx;
+        } else {
+            free = log_first_idx - log_next_idx;
+        }
+        if (free >= size + sizeof(log_rec_t))
+            break;
+
+        log_first_idx = log_next(log_first_idx);
+        log_first_seq++;
+    }
+    if (clear_seq < log_first_seq) {
+        clear_seq = log_first_seq;
+        clear_idx = log_first_idx;
+    }
+
+    if (log_next_idx + size + sizeof(log_rec_t) > LOG_BUF_SIZE) {
+        memset(log_buf + log_next_idx, 0, sizeof(log_rec_t));
+        log_next_idx = 0;
+    }
+
+    log_rec_t *rec = (log_rec_t *)(log_buf + log_next_idx);
+    rec->tsc      = rdtsc();
+    rec->len      = (uint16_t)size;
+    rec->text_len = (uint16_t)len;
+    rec->level    = (uint8_t)level;
+    rec->flags    = log_cont ? LOG_CONT : 0;
+    memcpy(rec + 1, text, len);
+
+    if (len)
+        log_cont = (text[len - 1] != '\n');
+
+    log_next_idx += size;
+    log_next_seq++;
+
+    irq_restore(flags);
+
+    if (log_sync || level <= LOGLEVEL_ERR)
+        console_flush();
+    else
+        schedule_work(&console_work);
+}
+
+/* =========================================================================
+ * Reading (/dev/dmesg)
+ * ========================================================================= */
+
+/* "[sssss.uuuuuu] text", the stamp only at the start of a line */
+static int log_format(const log_rec_t *rec, char *buf, size_t size)
+{
+    int len = 0;
+
+    if (size == 0)
+        return 0;
+
+    if (!(rec->flags & LOG_CONT)) {
+        uint64_t us   = tsc_to_us(rec->tsc - boot_tsc_entry);
+        uint32_t frac = div_u64_rem(&us, 1000000);
+        len += scnprintk(buf, size, "[%5u.%06u] ", (uint32_t)us, frac);
+    }
+
+    size_t n = rec->text_len;
+    if (n > size - 1 - len)
+        n = size - 1 - len;
+    memcpy(buf + len, log_text(rec), n);
+    len += n;
+    buf[len] = '\0';
+    return len;
+}
+
+/*
+ * Format the record at seq (index idx) and step past it; -1 at the end.  Runs a
+ * record at a time so interrupts are never off for a whole ring's worth;
+ * records overwritten in between are skipped.
+ */
+static int log_read_one(uint32_t *seq, uint32_t *idx, char *buf, size_t size)
+{
+    uint32_t flags = irq_save();
+
+    if (*seq < log_first_seq) {
+        *seq = log_first_seq;
+        *idx = log_first_idx;
+    }
+    if (*seq >= log_next_seq) {
+        irq_restore(flags);
+        return -1;
+    }
+
+    log_rec_t *rec = log_rec(idx);
+    int len = log_format(rec, buf, size);
+    *idx += rec->len;
+    (*seq)++;
+
+    irq_restore(flags);
+    return len;
+}
+
+int log_read_all(char *buf, size_t size)
+{
+    char     line[LOG_LINE_MAX + 32];
+    uint32_t seq, idx, total = 0;
+    int      n;
+
+    if (size == 0)
+        return 0;
+
+    uint32_t flags = irq_save();
+    uint32_t start_seq = clear_seq, start_idx = clear_idx;
+    irq_restore(flags);
+
+    /* Size everything, then skip the oldest until the rest fits */
+    seq = start_seq;
+    idx = start_idx;
+    while ((n = log_read_one(&seq, &idx, line, sizeof(line))) >= 0)
+        total += n;
+
+    seq = start_seq;
+    idx = start_idx;
+    while (total >= size && (n = log_read_one(&seq, &idx, line, sizeof(line))) >= 0)
+        total -= n;
+
+    int len = 0;
+    buf[0] = '\0';
+    while ((size_t)len < size - 1 &&
+           (n = log_read_one(&seq, &idx, buf + len, size - len)) >= 0)
+        len += n;
+    return len;
+}
+
+static int dmesg_show(char *buf, size_t size)
+{
+    return log_read_all(buf, size);
+}
+
+/* "clear" empties /dev/dmesg; a digit 1-8 sets console_loglevel */
+static int dmesg_store(const char *buf, size_t count)
+{
+    if (count >= 5 && strncmp(buf, "clear", 5) == 0) {
+        uint32_t flags = irq_save();
+        clear_seq = log_next_seq;
+        clear_idx = log_next_idx;
+        irq_restore(flags);
+        return (int)count;
+    }
+
+    if (count >= 1 && buf[0] >= '1' && buf[0] <= '8') {
+        console_loglevel = buf[0] - '0';
+        return (int)count;
+    }
+
+    return -1;
+}
+
+static void log_init(void)
+{
+    devfs_register_file("dmesg", dmesg_show, dmesg_store);
+}
+
+INITCALL(dmesg, log_init, 0);
@@ -1,6 +1,8 @@
 #include "kernel/panic.h"
 #include "lib/printk.h"
+#include "kernel/log.h"
 #include "kernel/asm.h"
+#include "kernel/ksyms.h"
 #include <stdint.h>
 
 /* =========================================================================
@@ -42,38 +44,6 @@ static const char *exception_names[32] = {
     "Reserved (31)",
 };
 
-/* =========================================================================
- * Read control registers via inline asm
- * ========================================================================= */
-
-static inline uint32_t read_cr0(void)
-{
-    uint32_t v;
-    __asm__ volatile ("mov %%cr0, %0" : "=r"(v));
-    return v;
-}
-
-static inline uint32_t read_cr2(void)
-{
-    uint32_t v;
-    __asm__ volatile ("mov %%cr2, %0" : "=r"(v));
-    return v;
-}
-
-static inline uint32_t read_cr3(void)
-{
-    uint32_t v;
-    __asm__ volatile ("mov %%cr3, %0" : "=r"(v));
-    return v;
-}
-
-static inline uint32_t read_cr4(void)
-{
-    uint32_t v;
-    __asm__ volatile ("mov %%cr4, %0" : "=r"(v));
-    return v;
-}
-
 /* =========================================================================
  * panic_isr – called from isr.s with the saved register frame
  * ========================================================================= */
@@ -84,6 +54,7 @@ void panic_isr(regs_t *r)
                        ? exception_names[r->int_no]
                        : "Unknown Exception";
 
+    log_panic();
     printk("\n\n*** CPU EXCEPTION ***\n");
     printk("Vector : %u  %s\n", r->int_no, name);
     printk("ErrCode: 0x%08x\n\n", r->err_code);
@@ -95,7 +66,12 @@ void panic_isr(regs_t *r)
            r->esi, r->edi, r->ebp);
 
     /* Instruction / stack pointers */
-    printk("EIP=%08x  EFLAGS=%08x\n", r->eip, r->eflags);
+    uint32_t off;
+    const char *sym = ksym_lookup(r->eip, &off);
+    if (sym)
+        printk("EIP=%08x <%s+0x%x>  EFLAGS=%08x\n", r->eip, sym, off, r->eflags);
+    else
+        printk("EIP=%08x  EFLAGS=%08x\n", r->eip, r->eflags);
 
     /* Segment registers
      * SS and user ESP are only pushed by the CPU on a ring-3 -> ring-0 transition.
@@ -130,7 +106,8 @@ void panic_isr(regs_t *r)
 
 void panic(const char *msg)
 {
-    printk("\nKERNEL PANIC: %s\n", msg);
+    log_panic();
+    printk(KERN_EMERG "\nKERNEL PANIC: %s\n", msg);
     cli();
     for (;;)
         hlt();
@@ -0,0 +1,259 @@
+#include "kernel/profile.h"
+#include "kernel/ksyms.h"
+#include "kernel/asm.h"
+#include "fs/devfs.h"
+#include "mm/slab.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Profiler state
+ * ========================================================================= */
+
+extern char _text_start[], _text_end[];
+extern char stack_bottom[], stack_top[];   /* boot stack, kernel/boot.s */
+
+static uint32_t *prof_self;       /* samples with EIP in the bucket        */
+static uint32_t *prof_child;      /* samples with a return address in it   */
+static uint32_t  prof_buckets;
+
+static volatile int prof_running   = 0;
+static int          prof_callchain = 0;
+static uint32_t     prof_samples   = 0;
+static uint32_t     prof_outside   = 0;   /* EIP outside kernel text */
+
+static inline int in_text(uint32_t addr)
+{
+    return addr >= (uint32_t)_text_start && addr < (uint32_t)_text_end;
+}
+
+static inline uint32_t bucket_of(uint32_t addr)
+{
+    return (addr - (uint32_t)_text_start) >> PROF_SHIFT;
+}
+
+static inline uint32_t bucket_addr(uint32_t b)
+{
+    return (uint32_t)_text_start + (b << PROF_SHIFT);
+}
+
+/* =========================================================================
+ * Sampling
+ * ========================================================================= */
+
+/* Follow saved EBP links while they stay on the boot stack and go up */
+static void profile_walk(uint32_t ebp)
+{
+    for (int depth = 0; depth < PROF_MAX_DEPTH; depth++) {
+        if ((ebp & 3) || ebp < (uint32_t)stack_bottom ||
+            ebp + 8 > (uint32_t)stack_top)
+            break;
+
+        uint32_t next = ((uint32_t *)ebp)[0];
+        uint32_t ret  = ((uint32_t *)ebp)[1];
+        if (!in_text(ret))
+            break;
+
+        prof_child[bucket_of(ret)]++;
+
+        if (next <= ebp)
+            break;
+        ebp = next;
+    }
+}
+
+void profile_tick(regs_t *regs)
+{
+    if (!prof_running || !regs)
+        return;
+
+    prof_samples++;
+    if (!in_text(regs->eip)) {
+        prof_outside++;
+        return;
+    }
+
+    prof_self[bucket_of(regs->eip)]++;
+    if (prof_callchain)
+        profile_walk(regs->ebp);
+}
+
+/* =========================================================================
+ * Control
+ * ========================================================================= */
+
+void profile_start(void)
+{
+    if (prof_self)
+        prof_running = 1;
+}
+
+void profile_stop(void)
+{
+    prof_running = 0;
+}
+
+void profile_reset(void)
+{
+    uint32_t flags = raw_irq_save();
+    if (prof_self) {
+        memset(prof_self,  0, prof_buckets * sizeof(uint32_t));
+        memset(prof_child, 0, prof_buckets * sizeof(uint32_t));
+    }
+    prof_samples = 0;
+    prof_outside = 0;
+    raw_irq_restore(flags);
+}
+
+/* =========================================================================
+ * Report
+ *
+ * Buckets are in address order, so each symbol's buckets are contiguous
+ * and one pass aggregates them; the PROF_REPORT_TOP hottest are kept in a
+ * small insertion-sorted array.  No allocation, so it can run from the
+ * hotkey in interrupt context.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t addr;     /* symbol (or bucket) start */
+    const char *name;  /* NULL: no symbol table    */
+    uint32_t self;
+    uint32_t total;
+} prof_entry_t;
+
+static void top_insert(prof_entry_t *top, int *n, const prof_entry_t *e)
+{
+    if (e->self == 0 && e->total == 0)
+        return;
+
+    int i = *n;
+    if (i == PROF_REPORT_TOP) {
+        if (top[i - 1].self >= e->self)
+            return;
+        i--;
+    } else {
+        (*n)++;
+    }
+    while (i > 0 && top[i - 1].self < e->self) {
+        top[i] = top[i - 1];
+        i--;
+    }
+    top[i] = *e;
+}
+
+static int pct_fmt(char *buf, size_t size, uint32_t part, uint32_t whole)
+{
+    /* part * 1000 stays in 32 bits for the first ~4M samples */
+    uint32_t permille = whole ? (part * 1000u) / whole : 0;
+    return scnprintk(buf, size, "%3u.%u%%", permille / 10, permille % 10);
+}
+
+static int profile_show(char *buf, size_t size)
+{
+    prof_entry_t top[PROF_REPORT_TOP];
+    int ntop = 0;
+    int len  = 0;
+
+    if (!prof_self)
+        return scnprintk(buf, size, "profiler not initialised\n");
+
+    len += scnprintk(buf + len, size - len,
+                     "%s, %u samples (%u outside kernel text), callchains %s\n\n",
+                     prof_running ? "running" : "stopped",
+                     prof_samples, prof_outside, prof_callchain ? "on" : "off");
+
+    if (ksym_count > 0) {
+        for (uint32_t s = 0; s < ksym_count; s++) {
+            uint32_t start = ksym_table[s].addr;
+            uint32_t end   = (s + 1 < ksym_count) ? ksym_table[s + 1].addr
+                                                   : (uint32_t)_text_end;
+            if (end <= start || !in_text(start))
+                continue;
+
+            prof_entry_t e = { start, ksym_table[s].name, 0, 0 };
+            for (uint32_t b = bucket_of(start); b < prof_buckets && bucket_addr(b) < end; b++) {
+                e.self  += prof_self[b];
+                e.total += prof_child[b];
+            }
+            e.total += e.self;
+            top_insert(top, &ntop, &e);
+        }
+    } else {
+        /* No symbols: report raw buckets */
+        for (uint32_t b = 0; b < prof_buckets; b++) {
+            prof_entry_t e = { bucket_addr(b), NULL, prof_self[b],
+                               prof_self[b] + prof_child[b] };
+            top_insert(top, &ntop, &e);
+        }
+    }
+
+    len += scnprintk(buf + len, size - len,
+                     "   self%%    self   total  function\n");
+    for (int i = 0; i < ntop; i++) {
+        len += pct_fmt(buf + len, size - len, top[i].self, prof_samples);
+        len += scnprintk(buf + len, size - len, "  %6u  %6u  ", top[i].self, top[i].total);
+        if (top[i].name)
+            len += scnprintk(buf + len, size - len, "%s\n", top[i].name);
+        else
+            len += scnprintk(buf + len, size - len, "0x%08x\n", top[i].addr);
+    }
+
+    return len;
+}
+
+static int profile_store(const char *buf, size_t count)
+{
+    /* Compare the command with any trailing newline stripped */
+    size_t n = count;
+    while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' '))
+        n--;
+
+    if (n == 5 && strncmp(buf, "start", 5) == 0)            profile_start();
+    else if (n == 4 && strncmp(buf, "stop", 4) == 0)        profile_stop();
+    else if (n == 5 && strncmp(buf, "reset", 5) == 0)       profile_reset();
+    else if (n == 9 && strncmp(buf, "callchain", 9) == 0)   prof_callchain = 1;
+    else if (n == 11 && strncmp(buf, "nocallchain", 11) == 0) prof_callchain = 0;
+    else return -1;
+
+    return (int)count;
+}
+
+void profile_dump(void)
+{
+    /* Static: the hotkey runs in interrupt context where kalloc is unsafe */
+    static char dump_buf[DEVFS_SHOW_SIZE];
+
+    int len = profile_show(dump_buf, sizeof(dump_buf));
+    if (len >= (int)sizeof(dump_buf))
+        len = sizeof(dump_buf) - 1;
+    dump_buf[len] = '\0';
+
+    printk("\n=== Profile ===\n%s\n", dump_buf);
+}
+
+/* =========================================================================
+ * Initialisation
+ * ========================================================================= */
+
+void profile_init(void)
+{
+    prof_buckets = (((uint32_t)_text_end - (uint32_t)_text_start) >> PROF_SHIFT) + 1;
+
+    prof_self  = (uint32_t *)kalloc(prof_buckets * sizeof(uint32_t));
+    prof_child = (uint32_t *)kalloc(prof_buckets * sizeof(uint32_t));
+    if (!prof_self || !prof_child) {
+        kfree(prof_self);
+        kfree(prof_child);
+        prof_self = prof_child = NULL;
+        printk("[PROF] Cannot allocate histograms\n");
+        return;
+    }
+    profile_reset();
+
+    devfs_register_file("profile", profile_show, profile_store);
+    profile_start();
+
+    printk("[PROF] Sampling %u KB of text, %u symbols\n",
+           ((uint32_t)_text_end - (uint32_t)_text_start) / 1024, ksym_count);
+}
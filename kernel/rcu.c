@@ -0,0 +1,114 @@
+#include "kernel/rcu.h"
+#include "kernel/irqflags.h"
+#include "kernel/panic.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Global State
+ *
+ * rcu_epoch only moves forward.  A CPU that reports a quiescent state
+ * copies the current epoch into its qs_epoch; epoch E has elapsed once
+ * every CPU's qs_epoch is >= E.
+ *
+ * Pending callbacks are kept in a FIFO.  Their epochs are non-decreasing,
+ * so processing can stop at the first callback whose epoch is still open.
+ * ========================================================================= */
+
+rcu_cpu_t rcu_cpu[NR_CPUS];
+
+static volatile uint32_t rcu_epoch = 1;
+
+static rcu_head_t  *cb_head = NULL;
+static rcu_head_t **cb_tail = &cb_head;
+
+/* =========================================================================
+ * Internal Helpers
+ * ========================================================================= */
+
+/* Open a new epoch and return it */
+static uint32_t rcu_start_epoch(void)
+{
+    uint32_t flags = irq_save();
+    uint32_t epoch = ++rcu_epoch;
+    irq_restore(flags);
+    return epoch;
+}
+
+static int rcu_epoch_elapsed(uint32_t epoch)
+{
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if ((int32_t)(rcu_cpu[cpu].qs_epoch - epoch) < 0)
+            return 0;
+    }
+    return 1;
+}
+
+/* Detach and invoke every callback whose grace period has elapsed */
+static void rcu_process_callbacks(void)
+{
+    for (;;) {
+        uint32_t flags = irq_save();
+        rcu_head_t *head = cb_head;
+        if (!head || !rcu_epoch_elapsed(head->epoch)) {
+            irq_restore(flags);
+            return;
+        }
+        cb_head = head->next;
+        if (!cb_head)
+            cb_tail = &cb_head;
+        irq_restore(flags);
+
+        head->func(head);
+    }
+}
+
+/* =========================================================================
+ * Public API
+ * ========================================================================= */
+
+void rcu_quiescent_state(int from_irq)
+{
+    rcu_cpu_t *rc = &rcu_cpu[smp_processor_id()];
+
+    /* Interrupted code (or the caller) is still inside a read section */
+    if (rc->nesting != 0)
+        return;
+
+    rc->qs_epoch = rcu_epoch;
+
+    if (!from_irq)
+        rcu_process_callbacks();
+}
+
+void synchronize_rcu(void)
+{
+    if (rcu_cpu[smp_processor_id()].nesting != 0)
+        panic("synchronize_rcu() inside read-side critical section");
+
+    uint32_t epoch = rcu_start_epoch();
+
+    /* The caller holds no read lock, so this CPU is quiescent right now */
+    smp_mb();
+    rcu_cpu[smp_processor_id()].qs_epoch = epoch;
+
+    while (!rcu_epoch_elapsed(epoch))
+        cpu_relax();
+}
+
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head))
+{
+    head->func = func;
+    head->next = NULL;
+
+    uint32_t flags = irq_save();
+    head->epoch = ++rcu_epoch;
+    *cb_tail = head;
+    cb_tail  = &head->next;
+    irq_restore(flags);
+}
+
+void rcu_barrier(void)
+{
+    synchronize_rcu();
+    rcu_process_callbacks();
+}
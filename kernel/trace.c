@@ -0,0 +1,174 @@
+#include "kernel/trace.h"
+#include "kernel/asm.h"
+#include "fs/devfs.h"
+#include "lib/printk.h"
+#include "lib/string.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Per-CPU rings
+ *
+ * head is advanced by writers with local_fetch_add(), so a writer that is
+ * interrupted by another tracepoint on the same CPU simply ends up with the
+ * earlier slot.  A record is valid once its seq equals its index + 1; the
+ * reader copies it out and re-checks seq to detect a concurrent overwrite.
+ * ========================================================================= */
+
+typedef struct {
+    volatile uint32_t head;      /* next index to write            */
+    uint32_t          tail;      /* next index to read             */
+    uint32_t          lost;      /* records overwritten unread     */
+    trace_record_t    records[TRACE_RING_RECORDS];
+} trace_ring_t;
+
+static trace_ring_t trace_rings[NR_CPUS];
+
+extern trace_event_t __start_trace_events[];
+extern trace_event_t __stop_trace_events[];
+
+void trace_emit(const trace_event_t *event, uint32_t a0, uint32_t a1,
+                uint32_t a2, uint32_t a3)
+{
+    trace_ring_t *ring = &trace_rings[smp_processor_id()];
+    uint32_t idx = local_fetch_add(&ring->head, 1);
+    trace_record_t *rec = &ring->records[idx & TRACE_RING_MASK];
+
+    WRITE_ONCE(rec->seq, 0);
+    barrier();
+    rec->event   = event;
+    rec->tsc     = rdtsc();
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    rec->args[3] = a3;
+    barrier();
+    WRITE_ONCE(rec->seq, idx + 1);
+}
+
+/* =========================================================================
+ * Event control
+ * ========================================================================= */
+
+int trace_set_event(const char *name, int enabled)
+{
+    int all = (strcmp(name, "all") == 0);
+    int found = 0;
+
+    for (trace_event_t *ev = __start_trace_events; ev < __stop_trace_events; ev++) {
+        if (all || strcmp(ev->name, name) == 0) {
+            if (enabled)
+                static_key_enable(&ev->key);
+            else
+                static_key_disable(&ev->key);
+            found = 1;
+        }
+    }
+    return found ? 0 : -1;
+}
+
+static int trace_events_show(char *buf, size_t size)
+{
+    int len = 0;
+    for (trace_event_t *ev = __start_trace_events; ev < __stop_trace_events; ev++)
+        len += scnprintk(buf + len, size - len, "%c %-16s %s\n",
+                         static_key_enabled(&ev->key) ? '+' : '-', ev->name, ev->fmt);
+    return len;
+}
+
+/* Accepts whitespace-separated "+name" / "-name" tokens */
+static int trace_events_store(const char *buf, size_t count)
+{
+    char   token[32];
+    size_t i = 0;
+
+    while (i < count) {
+        while (i < count && (buf[i] == ' ' || buf[i] == '\n' || buf[i] == '\t'))
+            i++;
+        if (i >= count)
+            break;
+
+        char op = buf[i++];
+        if (op != '+' && op != '-')
+            return -1;
+
+        size_t n = 0;
+        while (i < count && buf[i] != ' ' && buf[i] != '\n' && buf[i] != '\t') {
+            if (n < sizeof(token) - 1)
+                token[n++] = buf[i];
+            i++;
+        }
+        token[n] = '\0';
+
+        if (trace_set_event(token, op == '+') != 0)
+            return -1;
+    }
+    return (int)count;
+}
+
+/* =========================================================================
+ * Reader – formats records and advances the tail (consuming them)
+ * ========================================================================= */
+
+#define TRACE_LINE_MAX  160   /* stop when less than a line of room is left */
+
+static int trace_show(char *buf, size_t size)
+{
+    int len = 0;
+
+    for (int cpu = 0; cpu < NR_CPUS; cpu++) {
+        trace_ring_t *ring = &trace_rings[cpu];
+        uint32_t head = READ_ONCE(ring->head);
+        uint32_t tail = ring->tail;
+
+        if (head - tail > TRACE_RING_RECORDS) {
+            ring->lost += head - tail - TRACE_RING_RECORDS;
+            tail = head - TRACE_RING_RECORDS;
+        }
+
+        for (; tail != head; tail++) {
+            if (size - len < TRACE_LINE_MAX)
+                break;
+
+            trace_record_t *slot = &ring->records[tail & TRACE_RING_MASK];
+            if (READ_ONCE(slot->seq) != tail + 1) {
+                ring->lost++;          /* overwritten, or still being written */
+                continue;
+            }
+            smp_rmb();
+            trace_record_t rec = *slot;
+            smp_rmb();
+            if (READ_ONCE(slot->seq) != tail + 1) {
+                ring->lost++;
+                continue;
+            }
+
+            len += scnprintk(buf + len, size - len, "%20llu %d %-12s ",
+                             rec.tsc, cpu, rec.event->name);
+            len += scnprintk(buf + len, size - len, rec.event->fmt,
+                             rec.args[0], rec.args[1], rec.args[2], rec.args[3]);
+            len += scnprintk(buf + len, size - len, "\n");
+        }
+        ring->tail = tail;
+
+        if (ring->lost) {
+            len += scnprintk(buf + len, size - len, "# cpu %d: %u records lost\n",
+                             cpu, ring->lost);
+            ring->lost = 0;
+        }
+    }
+
+    return len;
+}
+
+/* =========================================================================
+ * Initialisation
+ * ========================================================================= */
+
+void trace_init(void)
+{
+    devfs_register_file("trace", trace_show, NULL);
+    devfs_register_file("trace_events", trace_events_show, trace_events_store);
+
+    printk("[TRACE] %d tracepoints, %d-record ring per CPU\n",
+           (int)(__stop_trace_events - __start_trace_events), TRACE_RING_RECORDS);
+}
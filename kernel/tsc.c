@@ -0,0 +1,82 @@
+#include "kernel/tsc.h"
+#include "kernel/cpu.h"
+#include "kernel/asm.h"
+#include "lib/div64.h"
+#include "lib/printk.h"
+
+/* =========================================================================
+ * PIT channel 2 one-shot
+ * ========================================================================= */
+
+#define PIT_CH2_DATA     0x42
+#define PIT_CMD          0x43
+#define PIT_SPEAKER      0x61     /* bit 0: ch2 gate, bit 1: speaker, bit 5: ch2 out */
+#define PIT_HZ           1193182
+
+#define CAL_MS           10
+#define CAL_LATCH        (PIT_HZ / (1000 / CAL_MS))
+#define CAL_PASSES       3
+
+uint32_t tsc_khz = 0;
+
+/* Cycles spent while channel 2 counts CAL_LATCH ticks down, or 0 on timeout */
+static uint64_t tsc_measure(void)
+{
+    /* Gate low, speaker off while programming */
+    uint8_t spk = inb(PIT_SPEAKER);
+    outb(PIT_SPEAKER, spk & ~0x03);
+
+    /* Channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    outb(PIT_CMD, 0xB0);
+    outb(PIT_CH2_DATA, CAL_LATCH & 0xFF);
+    outb(PIT_CH2_DATA, CAL_LATCH >> 8);
+
+    /* Raising the gate starts the count; OUT goes high at zero */
+    outb(PIT_SPEAKER, (spk & ~0x02) | 0x01);
+    uint64_t t0 = rdtsc();
+
+    uint32_t spins = 0;
+    while (!(inb(PIT_SPEAKER) & 0x20)) {
+        if (++spins > 10000000)
+            break;
+    }
+    uint64_t t1 = rdtsc();
+
+    outb(PIT_SPEAKER, spk);
+    return (spins > 10000000) ? 0 : t1 - t0;
+}
+
+/* =========================================================================
+ * Public interface
+ * ========================================================================= */
+
+void tsc_init(void)
+{
+    if (!cpu_has(X86_FEATURE_TSC)) {
+        printk("[TSC] Not present\n");
+        return;
+    }
+
+    /* Keep the shortest pass: it suffered the fewest delays */
+    uint64_t best = 0;
+    for (int i = 0; i < CAL_PASSES; i++) {
+        uint64_t d = tsc_measure();
+        if (d && (best == 0 || d < best))
+            best = d;
+    }
+
+    if (best == 0) {
+        printk("[TSC] PIT channel 2 did not expire, not calibrated\n");
+        return;
+    }
+
+    tsc_khz = (uint32_t)div_u64(best, CAL_MS);
+    printk("[TSC] %u.%03u MHz\n", tsc_khz / 1000, tsc_khz % 1000);
+}
+
+uint64_t tsc_to_us(uint64_t cycles)
+{
+    if (tsc_khz == 0)
+        return 0;
+    return div_u64(cycles * 1000, tsc_khz);
+}
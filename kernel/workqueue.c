@@ -0,0 +1,98 @@
+#include "kernel/workqueue.h"
+#include "kernel/irqflags.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Queue
+ *
+ * A FIFO protected by disabling interrupts; items are unlinked before
+ * their function runs, so a function may re-queue its own item.
+ *
+ * Delayed items wait on delayed_list (unordered: there are only ever a
+ * few) until workqueue_tick() finds them due and moves them to the FIFO.
+ * ========================================================================= */
+
+static LIST_HEAD(work_list);
+static LIST_HEAD(delayed_list);
+static uint32_t wq_ticks;
+
+int schedule_work(work_t *work)
+{
+    uint32_t flags = irq_save();
+    int queued = 0;
+
+    if (work->delayed) {
+        work->delayed = 0;
+        list_move_tail(&work->node, &work_list);
+        queued = 1;
+    } else if (!work->pending) {
+        work->pending = 1;
+        list_add_tail(&work->node, &work_list);
+        queued = 1;
+    }
+
+    irq_restore(flags);
+    return queued;
+}
+
+int schedule_delayed_work(work_t *work, uint32_t ticks)
+{
+    if (ticks == 0)
+        return schedule_work(work);
+
+    uint32_t flags = irq_save();
+    int armed = 0;
+
+    if (!work->pending) {
+        work->pending = 1;
+        work->delayed = 1;
+        work->expires = wq_ticks + ticks;
+        list_add_tail(&work->node, &delayed_list);
+        armed = 1;
+    }
+
+    irq_restore(flags);
+    return armed;
+}
+
+void workqueue_tick(void)
+{
+    work_t *work, *tmp;
+
+    uint32_t flags = irq_save();
+    wq_ticks++;
+    list_for_each_entry_safe(work, tmp, &delayed_list, node) {
+        if ((int32_t)(wq_ticks - work->expires) < 0)
+            continue;
+        work->delayed = 0;
+        list_move_tail(&work->node, &work_list);
+    }
+    irq_restore(flags);
+}
+
+int work_pending(void)
+{
+    return !list_empty(&work_list);
+}
+
+int run_work(void)
+{
+    int count = 0;
+
+    for (;;) {
+        uint32_t flags = irq_save();
+        if (list_empty(&work_list)) {
+            irq_restore(flags);
+            break;
+        }
+        work_t *work = list_first_entry(&work_list, work_t, node);
+        list_del(&work->node);
+        work->pending = 0;
+        irq_restore(flags);
+
+        work->fn(work);
+        count++;
+    }
+
+    return count;
+}
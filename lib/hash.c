@@ -0,0 +1,54 @@
+#include "lib/hash.h"
+#include "mm/slab.h"
+
+/* =========================================================================
+ * Resizable hash tables – the allocating half of lib/hash.h
+ * ========================================================================= */
+
+static hlist_head_t *htable_alloc_buckets(unsigned int bits)
+{
+    hlist_head_t *b = (hlist_head_t *)kalloc(sizeof(hlist_head_t) << bits);
+    if (b)
+        __hash_init(b, 1u << bits);
+    return b;
+}
+
+int htable_init(htable_t *t, unsigned int bits)
+{
+    if (bits < 1)
+        bits = 1;
+
+    t->buckets  = htable_alloc_buckets(bits);
+    t->bits     = bits;
+    t->min_bits = bits;
+    t->count    = 0;
+    return t->buckets ? 0 : -1;
+}
+
+void htable_destroy(htable_t *t)
+{
+    if (t->buckets)
+        kfree(t->buckets);
+    t->buckets = NULL;
+    t->count   = 0;
+}
+
+void htable_resize(htable_t *t, unsigned int bits)
+{
+    hlist_head_t *nb = htable_alloc_buckets(bits);
+    if (!nb)
+        return;
+
+    for (unsigned int i = 0; i < (1u << t->bits); i++) {
+        htable_node_t *pos;
+        hlist_node_t  *tmp;
+        hlist_for_each_entry_safe(pos, tmp, &t->buckets[i], link) {
+            hlist_del(&pos->link);
+            hlist_add_head(&pos->link, &nb[hash_32(pos->hash, bits)]);
+        }
+    }
+
+    kfree(t->buckets);
+    t->buckets = nb;
+    t->bits    = bits;
+}
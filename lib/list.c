@@ -1,9 +1,78 @@
 /*
  * lib/list.c – Generic intrusive doubly-linked list
  *
- * All list operations are defined as static inline functions in
- * include/lib/list.h.  This translation unit exists so that the build
- * system can produce list.o without complaints, and to serve as a home
- * for any future non-inline helpers.
+ * The list operations are static inline functions in include/lib/list.h;
+ * the non-inline helpers (list_sort) live here.
  */
-#include "lib/list.h"
\ No newline at end of file
+#include "lib/list.h"
+
+/* =========================================================================
+ * list_sort
+ *
+ * Bottom-up merge sort over the next pointers, as NULL-terminated runs:
+ * pending[k] holds a sorted run of 2^k entries, merged like the carries
+ * of a binary counter as entries arrive.  prev pointers are rebuilt at
+ * the end.  Runs from earlier in the list always go first into a merge
+ * and win ties, which keeps the sort stable.
+ * ========================================================================= */
+
+typedef int (*list_cmp_fn)(const list_head_t *a, const list_head_t *b);
+
+static list_head_t *merge(list_cmp_fn cmp, list_head_t *a, list_head_t *b)
+{
+    list_head_t  head;
+    list_head_t *tail = &head;
+
+    while (a && b) {
+        if (cmp(a, b) <= 0) {
+            tail->next = a;
+            a = a->next;
+        } else {
+            tail->next = b;
+            b = b->next;
+        }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+    return head.next;
+}
+
+void list_sort(list_head_t *head, list_cmp_fn cmp)
+{
+    list_head_t *pending[32] = { 0 };
+    list_head_t *list, *sorted = NULL;
+
+    if (list_empty(head))
+        return;
+
+    head->prev->next = NULL;
+    list = head->next;
+
+    while (list) {
+        list_head_t *run = list;
+        int k;
+
+        list      = list->next;
+        run->next = NULL;
+        for (k = 0; k < 31 && pending[k]; k++) {
+            run = merge(cmp, pending[k], run);
+            pending[k] = NULL;
+        }
+        pending[k] = pending[k] ? merge(cmp, pending[k], run) : run;
+    }
+
+    for (int k = 0; k < 32; k++) {
+        if (pending[k])
+            sorted = sorted ? merge(cmp, pending[k], sorted) : pending[k];
+    }
+
+    /* Relink prev pointers and close the ring through head */
+    list_head_t *prev = head;
+    for (list_head_t *p = sorted; p; p = p->next) {
+        p->prev = prev;
+        prev->next = p;
+        prev = p;
+    }
+    prev->next = head;
+    head->prev = prev;
+}
@@ -0,0 +1,440 @@
+#include "lib/string.h"
+#include "lib/printk.h"
+#include "kernel/cpu.h"
+#include "kernel/fpu.h"
+#include "kernel/tsc.h"
+#include "kernel/initcall.h"
+#include "kernel/alternative.h"
+#include "fs/devfs.h"
+#include "mm/slab.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * memcpy / memset / memmove
+ *
+ * Several implementations exist; mem_select_impl() picks one from CPUID
+ * at boot and the public functions call it through a pointer.  Until then
+ * the rep-string version is used, which works on every x86.
+ *
+ *   word   C loop, 32-bit words after aligning the destination
+ *   rep    rep movsl / rep stosl plus a byte tail
+ *   erms   rep movsb / rep stosb (fast on CPUs with Enhanced REP MOVSB)
+ *   sse2   16-byte aligned SSE2 stores inside kernel_fpu_begin/end for
+ *          n >= MEM_SSE2_MIN; smaller or non-FPU-safe calls use rep
+ *          strings (rep movsb on ERMS CPUs, patched in at boot)
+ *
+ * The C loops are compiled without loop-idiom recognition, which would
+ * otherwise turn them back into calls to memcpy/memset.
+ * ========================================================================= */
+
+#define MEM_SSE2_MIN  1024   /* below this the FPU section costs more than it saves */
+
+#define NO_LIBCALL  __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+/* ---- word ---- */
+
+static NO_LIBCALL void *memcpy_word(void *dst, const void *src, size_t n)
+{
+    uint8_t       *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+    while (n && ((uintptr_t)d & 3)) {
+        *d++ = *s++;
+        n--;
+    }
+    /* x86 allows unaligned loads; only the stores are aligned */
+    for (; n >= 4; n -= 4, d += 4, s += 4)
+        *(word_t *)d = *(const word_t *)s;
+    while (n--)
+        *d++ = *s++;
+
+    return dst;
+}
+
+static NO_LIBCALL void *memset_word(void *dst, int c, size_t n)
+{
+    uint8_t *d   = (uint8_t *)dst;
+    uint32_t pat = (uint8_t)c * 0x01010101u;
+
+    while (n && ((uintptr_t)d & 3)) {
+        *d++ = (uint8_t)c;
+        n--;
+    }
+    for (; n >= 4; n -= 4, d += 4)
+        *(word_t *)d = pat;
+    while (n--)
+        *d++ = (uint8_t)c;
+
+    return dst;
+}
+
+/* ---- rep movsl / rep stosl ---- */
+
+static void *memcpy_rep(void *dst, const void *src, size_t n)
+{
+    void       *d = dst;
+    const void *s = src;
+
+    if (n >= 16) {
+        size_t head = -(uintptr_t)d & 3;
+        __asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(head) : : "memory");
+        n -= -(uintptr_t)dst & 3;
+    }
+
+    size_t words = n >> 2;
+    size_t tail  = n & 3;
+    __asm__ volatile ("rep movsl\n\t"
+                      "movl %3, %%ecx\n\t"
+                      "rep movsb"
+                      : "+D"(d), "+S"(s), "+c"(words)
+                      : "r"(tail)
+                      : "memory");
+    return dst;
+}
+
+static void *memset_rep(void *dst, int c, size_t n)
+{
+    void    *d   = dst;
+    uint32_t pat = (uint8_t)c * 0x01010101u;
+
+    if (n >= 16) {
+        size_t head = -(uintptr_t)d & 3;
+        __asm__ volatile ("rep stosb" : "+D"(d), "+c"(head) : "a"(pat) : "memory");
+        n -= -(uintptr_t)dst & 3;
+    }
+
+    size_t words = n >> 2;
+    size_t tail  = n & 3;
+    __asm__ volatile ("rep stosl\n\t"
+                      "movl %2, %%ecx\n\t"
+                      "rep stosb"
+                      : "+D"(d), "+c"(words)
+                      : "r"(tail), "a"(pat)
+                      : "memory");
+    return dst;
+}
+
+/* ---- ERMS rep movsb / rep stosb ---- */
+
+static void *memcpy_erms(void *dst, const void *src, size_t n)
+{
+    void       *d = dst;
+    const void *s = src;
+    __asm__ volatile ("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    return dst;
+}
+
+static void *memset_erms(void *dst, int c, size_t n)
+{
+    void *d = dst;
+    __asm__ volatile ("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+    return dst;
+}
+
+/* ---- rep strings, patched to ERMS at boot ----
+ * Used for the pieces around and below the SSE2 loops.  The ERMS form is
+ * selected by apply_alternatives(), not by a run-time feature test. */
+
+static inline void rep_copy(void *d, const void *s, size_t n)
+{
+    __asm__ volatile (ALTERNATIVE("movl %%ecx, %%edx\n\t"
+                                  "shrl $2, %%ecx\n\t"
+                                  "andl $3, %%edx\n\t"
+                                  "rep movsl\n\t"
+                                  "movl %%edx, %%ecx\n\t"
+                                  "rep movsb",
+                                  "rep movsb", X86_FEATURE_ERMS)
+                      : "+D"(d), "+S"(s), "+c"(n)
+                      : : "edx", "memory", "cc");
+}
+
+static inline void rep_fill(void *d, int c, size_t n)
+{
+    uint32_t pat = (uint8_t)c * 0x01010101u;
+    __asm__ volatile (ALTERNATIVE("movl %%ecx, %%edx\n\t"
+                                  "shrl $2, %%ecx\n\t"
+                                  "andl $3, %%edx\n\t"
+                                  "rep stosl\n\t"
+                                  "movl %%edx, %%ecx\n\t"
+                                  "rep stosb",
+                                  "rep stosb", X86_FEATURE_ERMS)
+                      : "+D"(d), "+c"(n)
+                      : "a"(pat)
+                      : "edx", "memory", "cc");
+}
+
+/* ---- SSE2 ----
+ * The XMM registers cannot be listed as clobbers without -msse, but the
+ * compiler never allocates them in this kernel, and kernel_fpu_begin()
+ * has saved any task state that lived in them. */
+
+static void *memcpy_sse2(void *dst, const void *src, size_t n)
+{
+    if (n < MEM_SSE2_MIN || !kernel_fpu_usable()) {
+        rep_copy(dst, src, n);
+        return dst;
+    }
+
+    uint8_t       *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+    size_t head = -(uintptr_t)d & 15;
+    rep_copy(d, s, head);
+    d += head; s += head; n -= head;
+
+    size_t blocks = n >> 6;
+    kernel_fpu_begin();
+    __asm__ volatile ("1:\n\t"
+                      "movdqu   (%1), %%xmm0\n\t"
+                      "movdqu 16(%1), %%xmm1\n\t"
+                      "movdqu 32(%1), %%xmm2\n\t"
+                      "movdqu 48(%1), %%xmm3\n\t"
+                      "movdqa %%xmm0,   (%0)\n\t"
+                      "movdqa %%xmm1, 16(%0)\n\t"
+                      "movdqa %%xmm2, 32(%0)\n\t"
+                      "movdqa %%xmm3, 48(%0)\n\t"
+                      "addl   $64, %0\n\t"
+                      "addl   $64, %1\n\t"
+                      "decl   %2\n\t"
+                      "jnz    1b"
+                      : "+r"(d), "+r"(s), "+r"(blocks)
+                      : : "memory", "cc");
+    kernel_fpu_end();
+
+    rep_copy(d, s, n & 63);
+    return dst;
+}
+
+static void *memset_sse2(void *dst, int c, size_t n)
+{
+    if (n < MEM_SSE2_MIN || !kernel_fpu_usable()) {
+        rep_fill(dst, c, n);
+        return dst;
+    }
+
+    uint8_t *d   = (uint8_t *)dst;
+    uint32_t pat = (uint8_t)c * 0x01010101u;
+
+    size_t head = -(uintptr_t)d & 15;
+    rep_fill(d, c, head);
+    d += head; n -= head;
+
+    size_t blocks = n >> 6;
+    kernel_fpu_begin();
+    __asm__ volatile ("movd   %2, %%xmm0\n\t"
+                      "pshufd $0, %%xmm0, %%xmm0\n\t"
+                      "1:\n\t"
+                      "movdqa %%xmm0,   (%0)\n\t"
+                      "movdqa %%xmm0, 16(%0)\n\t"
+                      "movdqa %%xmm0, 32(%0)\n\t"
+                      "movdqa %%xmm0, 48(%0)\n\t"
+                      "addl   $64, %0\n\t"
+                      "decl   %1\n\t"
+                      "jnz    1b"
+                      : "+r"(d), "+r"(blocks)
+                      : "r"(pat)
+                      : "memory", "cc");
+    kernel_fpu_end();
+
+    rep_fill(d, c, n & 63);
+    return dst;
+}
+
+/* =========================================================================
+ * Implementation table and selection
+ * ========================================================================= */
+
+static int have_always(void) { return 1; }
+static int have_erms(void)   { return cpu_has(X86_FEATURE_ERMS); }
+static int have_sse2(void)   { return cpu_has(X86_FEATURE_SSE2) && kernel_fpu_usable(); }
+
+const mem_impl_t mem_impls[] = {
+    { "word", memcpy_word, memset_word, have_always },
+    { "rep",  memcpy_rep,  memset_rep,  have_always },
+    { "erms", memcpy_erms, memset_erms, have_erms   },
+    { "sse2", memcpy_sse2, memset_sse2, have_sse2   },
+};
+const int mem_nimpls = sizeof(mem_impls) / sizeof(mem_impls[0]);
+
+const mem_impl_t *mem_impl = &mem_impls[1];   /* rep until selected */
+
+int mem_set_impl(const char *name)
+{
+    for (int i = 0; i < mem_nimpls; i++) {
+        if (strcmp(mem_impls[i].name, name) == 0) {
+            if (!mem_impls[i].usable())
+                return -1;
+            mem_impl = &mem_impls[i];
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void mem_select_impl(void)
+{
+    /* Preference order: best first */
+    static const char *const order[] = { "sse2", "erms", "rep" };
+
+    for (unsigned i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        if (mem_set_impl(order[i]) == 0)
+            break;
+    }
+    printk("[MEM] Using %s memcpy/memset\n", mem_impl->name);
+}
+
+/* =========================================================================
+ * Public entry points
+ * ========================================================================= */
+
+void *memcpy(void *dst, const void *src, size_t n)
+{
+    return mem_impl->memcpy(dst, src, n);
+}
+
+void *memset(void *s, int c, size_t n)
+{
+    return mem_impl->memset(s, c, n);
+}
+
+void *memmove(void *dst, const void *src, size_t n)
+{
+    uintptr_t d = (uintptr_t)dst, s = (uintptr_t)src;
+
+    if (d - s >= n && s - d >= n)
+        return mem_impl->memcpy(dst, src, n);    /* no overlap */
+
+    if (d < s)
+        return memcpy_rep(dst, src, n);          /* forward is safe */
+    if (d == s)
+        return dst;
+
+    /* Destination above source: copy backwards, tail bytes first */
+    uint8_t       *dp = (uint8_t *)dst + n;
+    const uint8_t *sp = (const uint8_t *)src + n;
+    while (n & 3) {
+        *--dp = *--sp;
+        n--;
+    }
+
+    size_t words = n >> 2;
+    if (words) {
+        void       *dw = dp - 4;
+        const void *sw = sp - 4;
+        __asm__ volatile ("std\n\t"
+                          "rep movsl\n\t"
+                          "cld"
+                          : "+D"(dw), "+S"(sw), "+c"(words)
+                          : : "memory");
+    }
+    return dst;
+}
+
+/* =========================================================================
+ * Benchmark – /dev/membench
+ *
+ * Reading runs every usable implementation over sizes 8 B .. 64 KB and
+ * reports the best of MEMBENCH_REPS calls in cycles (rdtsc overhead
+ * subtracted).  Writing an implementation name switches to it.
+ * ========================================================================= */
+
+#define MEMBENCH_MIN   8
+#define MEMBENCH_MAX   65536
+#define MEMBENCH_REPS  16
+
+static uint32_t membench_overhead(void)
+{
+    uint64_t best = ~0ULL;
+    for (int i = 0; i < MEMBENCH_REPS; i++) {
+        uint64_t t0 = rdtsc();
+        uint64_t t1 = rdtsc();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return (uint32_t)best;
+}
+
+static uint32_t membench_run(const mem_impl_t *impl, int is_set,
+                             uint8_t *dst, const uint8_t *src, size_t n,
+                             uint32_t overhead)
+{
+    uint64_t best = ~0ULL;
+
+    for (int i = 0; i < MEMBENCH_REPS; i++) {
+        uint64_t t0 = rdtsc();
+        if (is_set)
+            impl->memset(dst, i, n);
+        else
+            impl->memcpy(dst, src, n);
+        uint64_t t1 = rdtsc();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return (best > overhead) ? (uint32_t)(best - overhead) : 0;
+}
+
+static int membench_show(char *buf, size_t size)
+{
+    /* +64 so both buffers can be offset by a cache line */
+    uint8_t *src = (uint8_t *)kalloc(MEMBENCH_MAX + 64);
+    uint8_t *dst = (uint8_t *)kalloc(MEMBENCH_MAX + 64);
+    int len = 0;
+
+    if (!src || !dst) {
+        kfree(src);
+        kfree(dst);
+        return scnprintk(buf, size, "membench: out of memory\n");
+    }
+    memset_rep(src, 0x5A, MEMBENCH_MAX + 64);
+
+    uint32_t overhead = membench_overhead();
+    len += scnprintk(buf + len, size - len,
+                     "selected: %s   (cycles per call, best of %d; TSC %u kHz)\n",
+                     mem_impl->name, MEMBENCH_REPS, tsc_khz);
+
+    for (int is_set = 0; is_set < 2; is_set++) {
+        len += scnprintk(buf + len, size - len, "\n%-8s", is_set ? "memset" : "memcpy");
+        for (int i = 0; i < mem_nimpls; i++) {
+            if (mem_impls[i].usable())
+                len += scnprintk(buf + len, size - len, "%10s", mem_impls[i].name);
+        }
+        len += scnprintk(buf + len, size - len, "\n");
+
+        for (size_t n = MEMBENCH_MIN; n <= MEMBENCH_MAX; n <<= 1) {
+            len += scnprintk(buf + len, size - len, "%8u", (uint32_t)n);
+            for (int i = 0; i < mem_nimpls; i++) {
+                if (!mem_impls[i].usable())
+                    continue;
+                uint32_t c = membench_run(&mem_impls[i], is_set, dst, src, n, overhead);
+                len += scnprintk(buf + len, size - len, "%10u", c);
+            }
+            len += scnprintk(buf + len, size - len, "\n");
+        }
+    }
+
+    kfree(src);
+    kfree(dst);
+    return len;
+}
+
+static int membench_store(const char *buf, size_t count)
+{
+    char name[16];
+    size_t n = 0;
+
+    while (n < count && n < sizeof(name) - 1 && buf[n] != '\n' && buf[n] != ' ') {
+        name[n] = buf[n];
+        n++;
+    }
+    name[n] = '\0';
+
+    return (mem_set_impl(name) == 0) ? (int)count : -1;
+}
+
+static void membench_init(void)
+{
+    devfs_register_file("membench", membench_show, membench_store);
+}
+
+INITCALL(membench, membench_init, 0);
@@ -1,7 +1,8 @@
 #include "lib/printk.h"
-#include "driver/driver.h"
-#include "driver/char/pit.h"
+#include "kernel/log.h"
+#include "lib/div64.h"
 #include <stdint.h>
+#include <stddef.h>
 
 /* =========================================================================
  * Internal flags for format specifier parsing
@@ -25,37 +26,68 @@
 
 static void put_char_early(char c)
 {
-    /* Direct VGA access for early boot */
+    /* Direct VGA access, bypassing the log */
     extern void vga_putchar(char);
     vga_putchar(c);
 }
 
-static void put_char(char c)
+/* =========================================================================
+ * Output sink
+ *
+ * The formatter writes through a sink so the same code serves the log
+ * (printk), the early console and memory buffers (snprintk).  Buffer sinks
+ * count every character produced, even those that did not fit.  The log
+ * sink collects a line in buf and stores it as one record at each newline
+ * or when buf fills.
+ * ========================================================================= */
+
+typedef enum {
+    OUT_BUF,           /* snprintk: into buf                        */
+    OUT_EARLY,         /* printk_early: straight to VGA             */
+    OUT_LOG,           /* printk: line buffer -> kernel/log.c       */
+} printk_sink_t;
+
+typedef struct {
+    printk_sink_t sink;
+    int    level;      /* OUT_LOG: LOGLEVEL_* of the record         */
+    char  *buf;        /* destination / line buffer                 */
+    size_t size;       /* buffer capacity including the NUL         */
+    size_t len;        /* characters produced so far                */
+} printk_out_t;
+
+static void out_char(printk_out_t *out, char c)
 {
-    /* Use driver abstraction layer - TTY device (ID 2) */
-    // extern int cwrite(int, int, char);
-    // cwrite(2, 0, c);
-    put_char_early(c);  /* Fallback to early output if TTY not ready */
+    switch (out->sink) {
+    case OUT_BUF:
+        if (out->len + 1 < out->size)
+            out->buf[out->len] = c;
+        out->len++;
+        break;
+
+    case OUT_EARLY:
+        put_char_early(c);
+        break;
+
+    case OUT_LOG:
+        out->buf[out->len++] = c;
+        if (c == '\n' || out->len == out->size) {
+            log_store(out->level, out->buf, out->len);
+            out->len = 0;
+        }
+        break;
+    }
 }
 
-static void put_str(const char *s, int len, int use_early)
+static void put_str(const char *s, int len, printk_out_t *out)
 {
-    for (int i = 0; i < len; i++) {
-        if (use_early)
-            put_char_early(s[i]);
-        else
-            put_char(s[i]);
-    }
+    for (int i = 0; i < len; i++)
+        out_char(out, s[i]);
 }
 
-static void put_pad(char pad_char, int n, int use_early)
+static void put_pad(char pad_char, int n, printk_out_t *out)
 {
-    for (int i = 0; i < n; i++) {
-        if (use_early)
-            put_char_early(pad_char);
-        else
-            put_char(pad_char);
-    }
+    for (int i = 0; i < n; i++)
+        out_char(out, pad_char);
 }
 
 /* =========================================================================
@@ -68,7 +100,7 @@ static void put_pad(char pad_char, int n, int use_early)
 static const char digits_lower[] = "0123456789abcdef";
 static const char digits_upper[] = "0123456789ABCDEF";
 
-static char *uint_to_str(unsigned long val, int base, int upper,
+static char *uint_to_str(unsigned long long val, int base, int upper,
                           char *buf_end, int *out_len)
 {
     const char *digits = upper ? digits_upper : digits_lower;
@@ -77,8 +109,9 @@ static char *uint_to_str(unsigned long val, int base, int upper,
         *--p = '0';
     } else {
         while (val) {
-            *--p = digits[val % (unsigned)base];
-            val /= (unsigned)base;
+            uint64_t v = val;
+            *--p = digits[div_u64_rem(&v, (uint32_t)base)];
+            val = v;
         }
     }
     *out_len = (int)(buf_end - p);
@@ -89,8 +122,8 @@ static char *uint_to_str(unsigned long val, int base, int upper,
  * Print an integer with full flag/width/precision support
  * ========================================================================= */
 
-static void print_int(unsigned long uval, int flags, int width,
-                       int prec, int base, int use_early)
+static void print_int(unsigned long long uval, int flags, int width,
+                       int prec, int base, printk_out_t *out)
 {
     char buf[INT_BUF_SIZE];
     char *buf_end = buf + INT_BUF_SIZE;
@@ -100,10 +133,10 @@ static void print_int(unsigned long uval, int flags, int width,
 
     /* Handle sign for signed values */
     if (flags & FL_SIGNED) {
-        long sval = (long)uval;
+        long long sval = (long long)uval;
         if (sval < 0) {
             sign = '-';
-            uval = (unsigned long)(-sval);
+            uval = (unsigned long long)(-sval);
         } else if (flags & FL_PLUS) {
             sign = '+';
         } else if (flags & FL_SPACE) {
@@ -139,30 +172,29 @@ static void print_int(unsigned long uval, int flags, int width,
 
     /* Emit: [spaces] sign prefix [zeros] digits [spaces] */
     if (!(flags & FL_LEFT) && pad_char == ' ')
-        put_pad(' ', pad, use_early);
+        put_pad(' ', pad, out);
 
     if (sign) {
-        if (use_early) put_char_early(sign);
-        else put_char(sign);
+        out_char(out, sign);
     }
-    if (prefix_len)  put_str(prefix, prefix_len, use_early);
+    if (prefix_len)  put_str(prefix, prefix_len, out);
 
     if (!(flags & FL_LEFT) && pad_char == '0')
-        put_pad('0', pad, use_early);
+        put_pad('0', pad, out);
 
     /* Leading zeros for precision */
-    put_pad('0', num_digits - num_len, use_early);
-    put_str(num_start, num_len, use_early);
+    put_pad('0', num_digits - num_len, out);
+    put_str(num_start, num_len, out);
 
     if (flags & FL_LEFT)
-        put_pad(' ', pad, use_early);
+        put_pad(' ', pad, out);
 }
 
 /* =========================================================================
  * Print a string with width/precision support
  * ========================================================================= */
 
-static void print_str(const char *s, int flags, int width, int prec, int use_early)
+static void print_str(const char *s, int flags, int width, int prec, printk_out_t *out)
 {
     if (!s) s = "(null)";
 
@@ -173,23 +205,20 @@ static void print_str(const char *s, int flags, int width, int prec, int use_ear
 
     int pad = (width > len) ? (width - len) : 0;
 
-    if (!(flags & FL_LEFT)) put_pad(' ', pad, use_early);
-    put_str(s, len, use_early);
-    if (flags & FL_LEFT)    put_pad(' ', pad, use_early);
+    if (!(flags & FL_LEFT)) put_pad(' ', pad, out);
+    put_str(s, len, out);
+    if (flags & FL_LEFT)    put_pad(' ', pad, out);
 }
 
 /* =========================================================================
  * Core variadic formatter
  * ========================================================================= */
 
-static void vprintk_internal(const char *fmt, va_list args, int use_early)
+static void vprintk_internal(const char *fmt, va_list args, printk_out_t *out)
 {
     for (; *fmt; fmt++) {
         if (*fmt != '%') {
-            if (use_early)
-                put_char_early(*fmt);
-            else
-                put_char(*fmt);
+            out_char(out, *fmt);
             continue;
         }
 
@@ -249,69 +278,68 @@ static void vprintk_internal(const char *fmt, va_list args, int use_early)
             {
                 char c = (char)va_arg(args, int);
                 int pad = (width > 1) ? (width - 1) : 0;
-                if (!(flags & FL_LEFT)) put_pad(' ', pad, use_early);
-                if (use_early) put_char_early(c);
-                else put_char(c);
-                if (flags & FL_LEFT)    put_pad(' ', pad, use_early);
+                if (!(flags & FL_LEFT)) put_pad(' ', pad, out);
+                out_char(out, c);
+                if (flags & FL_LEFT)    put_pad(' ', pad, out);
             }
             break;
 
         case 's':
             {
                 const char *s = va_arg(args, const char *);
-                print_str(s, flags, width, prec, use_early);
+                print_str(s, flags, width, prec, out);
             }
             break;
 
         case 'd':
         case 'i':
             {
-                long val;
-                if      (flags & FL_LLONG) val = (long)va_arg(args, long long);
+                long long val;
+                if      (flags & FL_LLONG) val = va_arg(args, long long);
                 else if (flags & FL_LONG)  val = va_arg(args, long);
                 else                       val = va_arg(args, int);
-                print_int((unsigned long)val,
-                          flags | FL_SIGNED, width, prec, 10, use_early);
+                print_int((unsigned long long)val,
+                          flags | FL_SIGNED, width, prec, 10, out);
             }
             break;
 
         case 'u':
             {
-                unsigned long val;
-                if      (flags & FL_LLONG) val = (unsigned long)va_arg(args, unsigned long long);
+                unsigned long long val;
+                if      (flags & FL_LLONG) val = va_arg(args, unsigned long long);
                 else if (flags & FL_LONG)  val = va_arg(args, unsigned long);
                 else                       val = va_arg(args, unsigned int);
-                print_int(val, flags, width, prec, 10, use_early);
+                print_int(val, flags, width, prec, 10, out);
             }
             break;
 
         case 'x':
             {
-                unsigned long val;
-                if      (flags & FL_LLONG) val = (unsigned long)va_arg(args, unsigned long long);
+                unsigned long long val;
+                if      (flags & FL_LLONG) val = va_arg(args, unsigned long long);
                 else if (flags & FL_LONG)  val = va_arg(args, unsigned long);
                 else                       val = va_arg(args, unsigned int);
-                print_int(val, flags, width, prec, 16, use_early);
+                print_int(val, flags, width, prec, 16, out);
             }
             break;
 
         case 'X':
             {
-                unsigned long val;
-                if      (flags & FL_LLONG) val = (unsigned long)va_arg(args, unsigned long long);
+                unsigned long long val;
+                if      (flags & FL_LLONG) val = va_arg(args, unsigned long long);
                 else if (flags & FL_LONG)  val = va_arg(args, unsigned long);
                 else                       val = va_arg(args, unsigned int);
-                print_int(val, flags | FL_UPPER, width, prec, 16, use_early);
+                print_int(val, flags | FL_UPPER, width, prec, 16, out);
             }
             break;
 
         case 'o':
             {
-                unsigned long val;
-                if      (flags & FL_LLONG) val = (unsigned long)va_arg(args, unsigned long long);
+                unsigned long long val;
+                if      (flags & FL_LLONG) val = va_arg(args, unsigned long long);
                 else if (flags & FL_LONG)  val = va_arg(args, unsigned long);
                 else                       val = va_arg(args, unsigned int);
-                print_int(val, flags, width, prec, 8, use_early);
+                print_int(val, flags, width, prec, 8, out);
             }
             break;
 
@@ -321,24 +349,18 @@ static void vprintk_internal(const char *fmt, va_list args, int use_early)
                 /* Always print as 0x + lowercase hex, field width 10 (32-bit) */
                 flags |= FL_HASH;
                 if (width == 0) width = 10;
-                print_int((unsigned long)val, flags, width, prec, 16, use_early);
+                print_int((unsigned long)val, flags, width, prec, 16, out);
             }
             break;
 
         case '%':
-            if (use_early) put_char_early('%');
-            else put_char('%');
+            out_char(out, '%');
             break;
 
         default:
             /* Unknown specifier: emit literally */
-            if (use_early) {
-                put_char_early('%');
-                put_char_early(*fmt);
-            } else {
-                put_char('%');
-                put_char(*fmt);
-            }
+            out_char(out, '%');
+            out_char(out, *fmt);
             break;
         }
     }
@@ -350,7 +372,8 @@ static void vprintk_internal(const char *fmt, va_list args, int use_early)
 
 void vprintk_early(const char *fmt, va_list args)
 {
-    vprintk_internal(fmt, args, 1);
+    printk_out_t out = { .sink = OUT_EARLY };
+    vprintk_internal(fmt, args, &out);
 }
 
 void printk_early(const char *fmt, ...)
@@ -363,7 +386,21 @@ void printk_early(const char *fmt, ...)
 
 void vprintk(const char *fmt, va_list args)
 {
-    vprintk_internal(fmt, args, 0);
+    char line[LOG_LINE_MAX];
+    printk_out_t out = { .sink = OUT_LOG, .level = LOGLEVEL_DEFAULT,
+                         .buf = line, .size = sizeof(line), .len = 0 };
+
+    /* KERN_<level> prefix */
+    if (fmt[0] == KERN_SOH_ASCII && fmt[1] >= '0' && fmt[1] <= '7') {
+        out.level = fmt[1] - '0';
+        fmt += 2;
+    }
+
+    vprintk_internal(fmt, args, &out);
+
+    /* Unterminated tail; the next printk continues the line */
+    if (out.len)
+        log_store(out.level, line, out.len);
 }
 
 void printk(const char *fmt, ...)
@@ -373,3 +410,34 @@ void printk(const char *fmt, ...)
     vprintk(fmt, args);
     va_end(args);
 }
+
+int vsnprintk(char *buf, size_t size, const char *fmt, va_list args)
+{
+    printk_out_t out = { .sink = OUT_BUF, .buf = buf, .size = size, .len = 0 };
+    vprintk_internal(fmt, args, &out);
+
+    if (size > 0)
+        buf[out.len < size ? out.len : size - 1] = '\0';
+    return (int)out.len;
+}
+
+int snprintk(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintk(buf, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+int scnprintk(char *buf, size_t size, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintk(buf, size, fmt, args);
+    va_end(args);
+
+    if (size == 0)
+        return 0;
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,289 @@
+#include "lib/rbtree.h"
+
+/* =========================================================================
+ * Red-black tree rebalancing
+ *
+ * The textbook algorithm (CLRS ch. 13) with NULL leaves, which count as
+ * black.  Invariants: the root is black, a red node has no red child and
+ * every root-to-leaf path passes the same number of black nodes.
+ * ========================================================================= */
+
+static inline int rb_is_black(const rb_node_t *n)
+{
+    return !n || n->rb_color == RB_BLACK;
+}
+
+/* Point whatever referenced old (parent link or root) at new */
+static inline void rb_change_child(rb_node_t *old, rb_node_t *new,
+                                   rb_node_t *parent, rb_root_t *root)
+{
+    if (!parent)
+        root->rb_node = new;
+    else if (parent->rb_left == old)
+        parent->rb_left = new;
+    else
+        parent->rb_right = new;
+}
+
+static void rb_rotate_left(rb_node_t *x, rb_root_t *root)
+{
+    rb_node_t *y = x->rb_right;
+
+    x->rb_right = y->rb_left;
+    if (y->rb_left)
+        y->rb_left->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    rb_change_child(x, y, x->rb_parent, root);
+    y->rb_left   = x;
+    x->rb_parent = y;
+}
+
+static void rb_rotate_right(rb_node_t *x, rb_root_t *root)
+{
+    rb_node_t *y = x->rb_left;
+
+    x->rb_left = y->rb_right;
+    if (y->rb_right)
+        y->rb_right->rb_parent = x;
+    y->rb_parent = x->rb_parent;
+    rb_change_child(x, y, x->rb_parent, root);
+    y->rb_right  = x;
+    x->rb_parent = y;
+}
+
+/* =========================================================================
+ * Insert
+ * ========================================================================= */
+
+void rb_insert_color(rb_node_t *node, rb_root_t *root)
+{
+    rb_node_t *parent;
+
+    while ((parent = node->rb_parent) && parent->rb_color == RB_RED) {
+        /* A red parent is never the root, so the grandparent exists */
+        rb_node_t *gparent = parent->rb_parent;
+
+        if (parent == gparent->rb_left) {
+            rb_node_t *uncle = gparent->rb_right;
+
+            if (!rb_is_black(uncle)) {
+                /* Recolour and continue from the grandparent */
+                parent->rb_color  = RB_BLACK;
+                uncle->rb_color   = RB_BLACK;
+                gparent->rb_color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->rb_right) {
+                rb_rotate_left(parent, root);
+                node   = parent;
+                parent = node->rb_parent;
+            }
+            parent->rb_color  = RB_BLACK;
+            gparent->rb_color = RB_RED;
+            rb_rotate_right(gparent, root);
+        } else {
+            rb_node_t *uncle = gparent->rb_left;
+
+            if (!rb_is_black(uncle)) {
+                parent->rb_color  = RB_BLACK;
+                uncle->rb_color   = RB_BLACK;
+                gparent->rb_color = RB_RED;
+                node = gparent;
+                continue;
+            }
+            if (node == parent->rb_left) {
+                rb_rotate_right(parent, root);
+                node   = parent;
+                parent = node->rb_parent;
+            }
+            parent->rb_color  = RB_BLACK;
+            gparent->rb_color = RB_RED;
+            rb_rotate_left(gparent, root);
+        }
+    }
+
+    root->rb_node->rb_color = RB_BLACK;
+}
+
+/* =========================================================================
+ * Erase
+ * ========================================================================= */
+
+/* Restore the black height after removing a black node; node (possibly
+ * NULL) has taken its place under parent and carries an extra black */
+static void rb_erase_color(rb_node_t *node, rb_node_t *parent, rb_root_t *root)
+{
+    while (node != root->rb_node && rb_is_black(node)) {
+        if (node == parent->rb_left) {
+            rb_node_t *sibling = parent->rb_right;
+
+            if (sibling->rb_color == RB_RED) {
+                sibling->rb_color = RB_BLACK;
+                parent->rb_color  = RB_RED;
+                rb_rotate_left(parent, root);
+                sibling = parent->rb_right;
+            }
+            if (rb_is_black(sibling->rb_left) && rb_is_black(sibling->rb_right)) {
+                sibling->rb_color = RB_RED;
+                node   = parent;
+                parent = node->rb_parent;
+                continue;
+            }
+            if (rb_is_black(sibling->rb_right)) {
+                sibling->rb_left->rb_color = RB_BLACK;
+                sibling->rb_color          = RB_RED;
+                rb_rotate_right(sibling, root);
+                sibling = parent->rb_right;
+            }
+            sibling->rb_color           = parent->rb_color;
+            parent->rb_color            = RB_BLACK;
+            sibling->rb_right->rb_color = RB_BLACK;
+            rb_rotate_left(parent, root);
+            node = root->rb_node;
+        } else {
+            rb_node_t *sibling = parent->rb_left;
+
+            if (sibling->rb_color == RB_RED) {
+                sibling->rb_color = RB_BLACK;
+                parent->rb_color  = RB_RED;
+                rb_rotate_right(parent, root);
+                sibling = parent->rb_left;
+            }
+            if (rb_is_black(sibling->rb_left) && rb_is_black(sibling->rb_right)) {
+                sibling->rb_color = RB_RED;
+                node   = parent;
+                parent = node->rb_parent;
+                continue;
+            }
+            if (rb_is_black(sibling->rb_left)) {
+                sibling->rb_right->rb_color = RB_BLACK;
+                sibling->rb_color           = RB_RED;
+                rb_rotate_left(sibling, root);
+                sibling = parent->rb_left;
+            }
+            sibling->rb_color          = parent->rb_color;
+            parent->rb_color           = RB_BLACK;
+            sibling->rb_left->rb_color = RB_BLACK;
+            rb_rotate_right(parent, root);
+            node = root->rb_node;
+        }
+    }
+
+    if (node)
+        node->rb_color = RB_BLACK;
+}
+
+void rb_erase(rb_node_t *node, rb_root_t *root)
+{
+    rb_node_t *child, *parent;
+    int        color;
+
+    if (!node->rb_left || !node->rb_right) {
+        /* At most one child: splice it into node's place */
+        child  = node->rb_left ? node->rb_left : node->rb_right;
+        parent = node->rb_parent;
+        color  = node->rb_color;
+
+        if (child)
+            child->rb_parent = parent;
+        rb_change_child(node, child, parent, root);
+    } else {
+        /* Two children: the in-order successor takes node's place */
+        rb_node_t *succ = node->rb_right;
+        while (succ->rb_left)
+            succ = succ->rb_left;
+
+        child  = succ->rb_right;
+        parent = succ->rb_parent;
+        color  = succ->rb_color;
+
+        if (parent == node) {
+            parent = succ;
+        } else {
+            if (child)
+                child->rb_parent = parent;
+            parent->rb_left = child;
+
+            succ->rb_right = node->rb_right;
+            node->rb_right->rb_parent = succ;
+        }
+
+        succ->rb_parent = node->rb_parent;
+        succ->rb_color  = node->rb_color;
+        succ->rb_left   = node->rb_left;
+        node->rb_left->rb_parent = succ;
+        rb_change_child(node, succ, node->rb_parent, root);
+    }
+
+    if (color == RB_BLACK)
+        rb_erase_color(child, parent, root);
+
+    RB_CLEAR_NODE(node);
+}
+
+void rb_replace_node(rb_node_t *victim, rb_node_t *new, rb_root_t *root)
+{
+    *new = *victim;
+    if (victim->rb_left)
+        victim->rb_left->rb_parent = new;
+    if (victim->rb_right)
+        victim->rb_right->rb_parent = new;
+    rb_change_child(victim, new, victim->rb_parent, root);
+    RB_CLEAR_NODE(victim);
+}
+
+/* =========================================================================
+ * Traversal
+ * ========================================================================= */
+
+rb_node_t *rb_first(const rb_root_t *root)
+{
+    rb_node_t *n = root->rb_node;
+    if (!n)
+        return NULL;
+    while (n->rb_left)
+        n = n->rb_left;
+    return n;
+}
+
+rb_node_t *rb_last(const rb_root_t *root)
+{
+    rb_node_t *n = root->rb_node;
+    if (!n)
+        return NULL;
+    while (n->rb_right)
+        n = n->rb_right;
+    return n;
+}
+
+rb_node_t *rb_next(const rb_node_t *node)
+{
+    if (node->rb_right) {
+        node = node->rb_right;
+        while (node->rb_left)
+            node = node->rb_left;
+        return (rb_node_t *)node;
+    }
+
+    /* Climb until we come up from a left child */
+    rb_node_t *parent;
+    while ((parent = node->rb_parent) && node == parent->rb_right)
+        node = parent;
+    return parent;
+}
+
+rb_node_t *rb_prev(const rb_node_t *node)
+{
+    if (node->rb_left) {
+        node = node->rb_left;
+        while (node->rb_right)
+            node = node->rb_right;
+        return (rb_node_t *)node;
+    }
+
+    rb_node_t *parent;
+    while ((parent = node->rb_parent) && node == parent->rb_left)
+        node = parent;
+    return parent;
+}
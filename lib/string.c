@@ -2,21 +2,79 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/* =========================================================================
+ * Word-at-a-time helpers
+ *
+ * The scanning routines read the string a 32-bit word at a time once the
+ * pointer is word aligned.  An aligned load never crosses a page boundary,
+ * so reading the bytes after the terminator inside the same word cannot
+ * fault even when the string ends at the last byte of a mapped page.
+ *
+ * has_zero(x) is nonzero iff some byte of x is 0; the lowest set 0x80 bit
+ * marks the first such byte (higher ones may be false positives, so the
+ * exact position is always found with a byte loop).  Words are accessed
+ * through word_t (lib/string.h), which may alias the caller's buffers.
+ * ========================================================================= */
+
+#define ONES   0x01010101u
+#define HIGHS  0x80808080u
+
+static inline uint32_t has_zero(uint32_t x)
+{
+    return (x - ONES) & ~x & HIGHS;
+}
+
+static inline int word_aligned(const void *p)
+{
+    return ((uintptr_t)p & 3) == 0;
+}
+
 /* =========================================================================
  * String Functions
  * ========================================================================= */
 
 size_t strlen(const char *s)
 {
-    size_t len = 0;
-    while (s[len]) {
-        len++;
+    const char *p = s;
+
+    while (!word_aligned(p)) {
+        if (!*p)
+            return p - s;
+        p++;
     }
-    return len;
+
+    const word_t *w = (const word_t *)p;
+    while (!has_zero(*w))
+        w++;
+
+    p = (const char *)w;
+    while (*p)
+        p++;
+    return p - s;
 }
 
 int strcmp(const char *s1, const char *s2)
 {
+    /* Words only when both strings can be aligned together */
+    if (((uintptr_t)s1 & 3) == ((uintptr_t)s2 & 3)) {
+        while (!word_aligned(s1)) {
+            if (!*s1 || *s1 != *s2)
+                goto bytes;
+            s1++;
+            s2++;
+        }
+
+        const word_t *w1 = (const word_t *)s1;
+        const word_t *w2 = (const word_t *)s2;
+        while (*w1 == *w2 && !has_zero(*w1)) {
+            w1++;
+            w2++;
+        }
+        s1 = (const char *)w1;
+        s2 = (const char *)w2;
+    }
+
+bytes:
     while (*s1 && (*s1 == *s2)) {
         s1++;
         s2++;
@@ -26,6 +84,27 @@ int strcmp(const char *s1, const char *s2)
 
 int strncmp(const char *s1, const char *s2, size_t n)
 {
+    if (((uintptr_t)s1 & 3) == ((uintptr_t)s2 & 3)) {
+        while (n && !word_aligned(s1)) {
+            if (!*s1 || *s1 != *s2)
+                goto bytes;
+            s1++;
+            s2++;
+            n--;
+        }
+
+        const word_t *w1 = (const word_t *)s1;
+        const word_t *w2 = (const word_t *)s2;
+        while (n >= 4 && *w1 == *w2 && !has_zero(*w1)) {
+            w1++;
+            w2++;
+            n -= 4;
+        }
+        s1 = (const char *)w1;
+        s2 = (const char *)w2;
+    }
+
+bytes:
     while (n && *s1 && (*s1 == *s2)) {
         s1++;
         s2++;
@@ -40,6 +119,20 @@ int strncmp(const char *s1, const char *s2, size_t n)
 char *strcpy(char *dst, const char *src)
 {
     char *ret = dst;
+
+    while (!word_aligned(src)) {
+        if (!(*dst++ = *src++))
+            return ret;
+    }
+
+    /* Aligned loads from src; x86 stores to dst need no alignment */
+    const word_t *w = (const word_t *)src;
+    while (!has_zero(*w)) {
+        *(word_t *)dst = *w++;
+        dst += 4;
+    }
+
+    src = (const char *)w;
     while ((*dst++ = *src++));
     return ret;
 }
@@ -60,26 +153,36 @@ char *strncpy(char *dst, const char *src, size_t n)
 
 char *strcat(char *dst, const char *src)
 {
-    char *ret = dst;
-    /* Find end of destination string */
-    while (*dst) {
-        dst++;
-    }
-    /* Append source string */
-    while ((*dst++ = *src++));
-    return ret;
+    strcpy(dst + strlen(dst), src);
+    return dst;
 }
 
 char *strchr(const char *s, int c)
 {
+    char ch = (char)c;
+
+    while (!word_aligned(s)) {
+        if (*s == ch)
+            return (char *)s;
+        if (!*s)
+            return NULL;
+        s++;
+    }
+
+    /* Stop at the first word holding either the terminator or ch */
+    uint32_t pat = (uint8_t)ch * ONES;
+    const word_t *w = (const word_t *)s;
+    while (!has_zero(*w) && !has_zero(*w ^ pat))
+        w++;
+
+    s = (const char *)w;
     while (*s) {
-        if (*s == (char)c) {
+        if (*s == ch)
             return (char *)s;
-        }
         s++;
     }
     /* Check if searching for null terminator */
-    if ((char)c == '\0') {
+    if (ch == '\0') {
         return (char *)s;
     }
     return NULL;
@@ -105,57 +208,7 @@ char *strrchr(const char *s, int c)
  * Memory Functions
  * ========================================================================= */
 
-void *memset(void *s, int c, size_t n)
-{
-    unsigned char *p = (unsigned char *)s;
-    unsigned char value = (unsigned char)c;
-    
-    while (n > 0) {
-        *p++ = value;
-        n--;
-    }
-    
-    return s;
-}
-
-void *memcpy(void *dst, const void *src, size_t n)
-{
-    unsigned char *d = (unsigned char *)dst;
-    const unsigned char *s = (const unsigned char *)src;
-    
-    while (n > 0) {
-        *d++ = *s++;
-        n--;
-    }
-    
-    return dst;
-}
-
-void *memmove(void *dst, const void *src, size_t n)
-{
-    unsigned char *d = (unsigned char *)dst;
-    const unsigned char *s = (const unsigned char *)src;
-    
-    /* Check for overlap */
-    if (d < s) {
-        /* Copy forwards */
-        while (n > 0) {
-            *d++ = *s++;
-            n--;
-        }
-    } else if (d > s) {
-        /* Copy backwards to handle overlap */
-        d += n;
-        s += n;
-        while (n > 0) {
-            *--d = *--s;
-            n--;
-        }
-    }
-    /* If d == s, no copy needed */
-    
-    return dst;
-}
+/* memset, memcpy and memmove live in memops.c */
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
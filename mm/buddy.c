@@ -1,4 +1,5 @@
 #include "mm/buddy.h"
+#include "mm/shrinker.h"
 #include "lib/printk.h"
 #include <stdint.h>
 #include <stddef.h>
@@ -21,6 +22,7 @@ typedef struct {
     uint32_t total_pages;     /* Total pages available */
     uint32_t free_pages;      /* Currently free pages */
     uint32_t bitmap[MAX_PAGES / 32];  /* Bitmap: 32 pages per uint32_t */
+    uint32_t cont[MAX_PAGES / 32];    /* Set: page continues the allocation before it */
 } page_allocator_t;
 
 static page_allocator_t allocator;
@@ -32,13 +34,13 @@ static page_allocator_t allocator;
 /* Convert physical address to virtual address */
 static inline void *phys_to_virt(uint32_t phys)
 {
-    return (void *)(phys + KERNEL_VMA);
+    return (void *)(uintptr_t)(phys + KERNEL_VMA);
 }
 
 /* Convert virtual address to physical address */
 static inline uint32_t virt_to_phys(void *virt)
 {
-    return (uint32_t)virt - KERNEL_VMA;
+    return (uint32_t)((uintptr_t)virt - KERNEL_VMA);
 }
 
 /* Set a bit in the bitmap (mark page as allocated) */
@@ -65,6 +67,22 @@ static inline int bitmap_test(uint32_t page_idx)
     return (allocator.bitmap[word_idx] & (1U << bit_idx)) != 0;
 }
 
+/* Continuation bits let page_free() release a whole multi-page run */
+static inline void cont_set(uint32_t page_idx)
+{
+    allocator.cont[page_idx / 32] |= (1U << (page_idx % 32));
+}
+
+static inline void cont_clear(uint32_t page_idx)
+{
+    allocator.cont[page_idx / 32] &= ~(1U << (page_idx % 32));
+}
+
+static inline int cont_test(uint32_t page_idx)
+{
+    return (allocator.cont[page_idx / 32] & (1U << (page_idx % 32))) != 0;
+}
+
 /* Find N consecutive free pages in bitmap, returns starting page index or -1 */
 static int find_free_pages(uint32_t count)
 {
@@ -113,6 +131,7 @@ void buddy_init(uint32_t base_phys, uint32_t total_kb)
     /* Initialize all pages as free (bitmap = 0) */
     for (uint32_t i = 0; i < (MAX_PAGES / 32); i++) {
         allocator.bitmap[i] = 0;
+        allocator.cont[i]   = 0;
     }
     
     allocator.free_pages = allocator.total_pages;
@@ -136,19 +155,23 @@ void *page_alloc(size_t size)
     /* Calculate number of pages needed (round up) */
     uint32_t pages_needed = (size + PAGE_SIZE - 1) >> PAGE_SHIFT;
     
-    if (pages_needed > allocator.free_pages) {
-        return NULL;  /* Not enough free pages */
-    }
-    
-    /* Find consecutive free pages */
-    int start_idx = find_free_pages(pages_needed);
+    /* Find consecutive free pages; if there are none, ask the caches
+     * to give some back (mm/shrinker.h) and look once more */
+    int start_idx = -1;
+    if (pages_needed <= allocator.free_pages)
+        start_idx = find_free_pages(pages_needed);
+    if (start_idx < 0 && shrink_memory(pages_needed) > 0 &&
+        pages_needed <= allocator.free_pages)
+        start_idx = find_free_pages(pages_needed);
     if (start_idx < 0) {
         return NULL;  /* No consecutive block large enough */
     }
     
-    /* Mark pages as allocated */
+    /* Mark pages as allocated; all but the first continue the run */
     for (uint32_t i = 0; i < pages_needed; i++) {
         bitmap_set(start_idx + i);
+        if (i > 0)
+            cont_set(start_idx + i);
     }
     
     allocator.free_pages -= pages_needed;
@@ -194,10 +217,18 @@ void page_free(void *addr)
         return;
     }
     
-    /* Free the page - we can only free one page at a time since we don't
-     * track allocation sizes. This is fine for our use case. */
-    bitmap_clear(page_idx);
-    allocator.free_pages++;
+    if (cont_test(page_idx)) {
+        printk("[ALLOCATOR] ERROR: Free 0x%08x is inside an allocation\n", phys);
+        return;
+    }
+
+    /* Free the first page and every page that continues the run */
+    do {
+        bitmap_clear(page_idx);
+        cont_clear(page_idx);
+        allocator.free_pages++;
+        page_idx++;
+    } while (page_idx < allocator.total_pages && cont_test(page_idx));
 }
 
 /* =========================================================================
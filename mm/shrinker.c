@@ -0,0 +1,49 @@
+#include "mm/shrinker.h"
+#include "kernel/asm.h"
+#include <stddef.h>
+
+/* =========================================================================
+ * Shrinker registry
+ * ========================================================================= */
+
+static LIST_HEAD(shrinkers);
+static int reclaiming = 0;
+
+void register_shrinker(shrinker_t *s)
+{
+    uint32_t flags = raw_irq_save();
+    list_add_tail(&s->node, &shrinkers);
+    raw_irq_restore(flags);
+}
+
+void unregister_shrinker(shrinker_t *s)
+{
+    uint32_t flags = raw_irq_save();
+    list_del(&s->node);
+    raw_irq_restore(flags);
+}
+
+uint32_t shrink_memory(uint32_t nr_pages)
+{
+    uint32_t released = 0;
+
+    /* One reclaim at a time: an interrupt that allocates while a scan
+     * runs gets nothing rather than re-entering the shrinkers */
+    uint32_t flags = raw_irq_save();
+    if (reclaiming) {
+        raw_irq_restore(flags);
+        return 0;
+    }
+    reclaiming = 1;
+    raw_irq_restore(flags);
+
+    shrinker_t *s;
+    list_for_each_entry(s, &shrinkers, node) {
+        if (released >= nr_pages)
+            break;
+        released += s->scan(nr_pages - released);
+    }
+
+    reclaiming = 0;
+    return released;
+}
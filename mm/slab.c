@@ -2,6 +2,7 @@
 #include "mm/buddy.h"
 #include "lib/list.h"
 #include "lib/printk.h"
+#include "kernel/trace.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -46,6 +47,9 @@ typedef struct {
 static slab_cache_t slab_caches[MAX_SLAB_CACHES];
 static int num_caches = 0;
 
+DEFINE_TRACE_EVENT(kalloc, "size=%u ptr=0x%08x");
+DEFINE_TRACE_EVENT(kfree,  "ptr=0x%08x");
+
 /* =========================================================================
  * Helper Functions
  * ========================================================================= */
@@ -63,7 +67,7 @@ static uint16_t round_up_pow2(size_t size)
 /* Return the slab_t for the page that contains addr */
 static inline slab_t *addr_to_slab(void *addr)
 {
-    return (slab_t *)((uint32_t)addr & ~(uint32_t)(PAGE_SIZE - 1));
+    return (slab_t *)((uintptr_t)addr & ~(uintptr_t)(PAGE_SIZE - 1));
 }
 
 static inline int is_slab_page(void *addr)
@@ -140,8 +144,11 @@ void *kalloc(size_t size)
         return NULL;
 
     /* Large allocations go directly to the page allocator */
-    if (size > 2048)
-        return page_alloc(size);
+    if (size > 2048) {
+        void *pages = page_alloc(size);
+        TRACE(kalloc, size, pages);
+        return pages;
+    }
 
     uint16_t obj_size = round_up_pow2(size);
     slab_cache_t *cache = get_cache(obj_size);
@@ -171,6 +178,7 @@ void *kalloc(size_t size)
         list_move(&slab->node, &cache->full);
     }
 
+    TRACE(kalloc, size, obj);
     return (void *)obj;
 }
 
@@ -183,6 +191,8 @@ void kfree(void *addr)
     if (!addr)
         return;
 
+    TRACE(kfree, addr);
+
     if (!is_slab_page(addr)) {
         /* Not a slab page – return directly to the page allocator */
         page_free(addr);
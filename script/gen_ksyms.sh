@@ -0,0 +1,29 @@
+#!/bin/sh
+# ============================================================================
+# Generate the embedded kernel symbol table
+#
+# Usage: nm -n build/kernel.elf | script/gen_ksyms.sh > build/ksyms_table.c
+#        script/gen_ksyms.sh < /dev/null > build/ksyms_table.c   (empty table)
+#
+# Keeps text symbols (t/T) only; the output is data-only C so linking it
+# does not move any code.
+# ============================================================================
+
+awk '
+BEGIN {
+    print "/* Generated by script/gen_ksyms.sh - do not edit */"
+    print "#include \"kernel/ksyms.h\""
+    print ""
+    print "const ksym_t ksym_table[] = {"
+}
+$2 == "t" || $2 == "T" {
+    printf "    { 0x%s, \"%s\" },\n", $1, $3
+    n++
+}
+END {
+    if (n == 0)
+        print "    { 0, \"\" },"
+    print "};"
+    print ""
+    printf "const uint32_t ksym_count = %d;\n", n
+}'
@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+# Create the scratch disk used by `make bench`
+# Usage: ./script/make_bench_disk.sh <image>
+#
+# A blank raw image whose sector 0 starts with the magic string the
+# in-kernel block benchmarks look for (BENCH_DISK_MAGIC, kernel/bench.h).
+# They only touch disks carrying it, so no root and no partitioning.
+#
+
+set -e
+
+DISK_IMG="${1:-build/bench.img}"
+DISK_SIZE_MB=16
+MAGIC="SCEPTER-BENCH-DISK"
+
+mkdir -p "$(dirname "$DISK_IMG")"
+dd if=/dev/zero of="$DISK_IMG" bs=1M count=$DISK_SIZE_MB status=none
+printf '%s' "$MAGIC" | dd of="$DISK_IMG" conv=notrunc status=none
+
+echo "Created benchmark disk $DISK_IMG (${DISK_SIZE_MB}MB)"
@@ -0,0 +1,126 @@
+#include "test.h"
+#include "driver/block/cache.h"
+#include <string.h>
+
+/* =========================================================================
+ * Block cache microbenchmarks
+ *
+ * The cache ceiling is raised to 64K blocks so it can be filled to each
+ * size below without evicting.  At every size:
+ * cache_lookup hits spread over all entries, lookups that miss, and the
+ * same hits through cache_get/cache_put references (no copy); then
+ * cache_insert with eviction once the cache is full.  bwrite_direct is a
+ * no-op: nothing is dirty here, so this is index and copy cost only.
+ *
+ * Last, the replacement policies on a mix of reads: a hot set of half
+ * the cache read at random, between which MIX_STREAM blocks are read
+ * once each in sequence (a large file or dd of a disk).  A miss inserts
+ * the block, as bread() does.  The hit rates are the point here.
+ * ========================================================================= */
+
+int bwrite_direct(int prim_id, int scnd_id, const void *buf, uint32_t offset, size_t count)
+{
+    (void)prim_id; (void)scnd_id; (void)buf; (void)offset;
+    return (int)(count * CACHE_BLOCK_SIZE);
+}
+
+uint32_t block_max_blocks(int prim_id)
+{
+    (void)prim_id;
+    return 0;
+}
+
+#define OPS          200000
+#define MAX_ENTRIES  65536
+
+#define MIX_CACHE    4096               /* blocks */
+#define MIX_HOT      (MIX_CACHE / 2)
+#define MIX_STREAM   2                  /* streamed blocks per hot read */
+
+static uint8_t mix_blk[CACHE_BLOCK_SIZE];
+
+/* One read through the cache; 1 on a hit */
+static int mix_read(uint32_t block)
+{
+    if (cache_lookup(0, 0, block, mix_blk))
+        return 1;
+    cache_insert(0, 0, block, mix_blk);
+    return 0;
+}
+
+static void bench_mix(int policy, const char *name)
+{
+    uint32_t hot_hits = 0, hits = 0, next = 1u << 20;
+    uint64_t t0, t1;
+
+    cache_invalidate_device(0);
+    cache_set_policy(policy);
+
+    t0 = test_now_ns();
+    for (int i = 0; i < OPS; i++) {
+        int h = mix_read(test_rand() % MIX_HOT);
+        hot_hits += (uint32_t)h;
+        hits     += (uint32_t)h;
+        for (int s = 0; s < MIX_STREAM; s++)
+            hits += (uint32_t)mix_read(next++);
+    }
+    t1 = test_now_ns();
+
+    printf("  %-4s hot hits %5.1f%%   all hits %5.1f%%   %7.1f ns/read\n", name,
+           100.0 * hot_hits / OPS, 100.0 * hits / (OPS * (1 + MIX_STREAM)),
+           (double)(t1 - t0) / (OPS * (1 + MIX_STREAM)));
+}
+
+int main(void)
+{
+    static uint8_t blk[CACHE_BLOCK_SIZE];
+    uint64_t t0, t1, t2, t3;
+    uint32_t sink = 0, filled = 0;
+
+    cache_init();
+    cache_set_limits(0, MAX_ENTRIES * CACHE_BLOCK_SIZE / 1024);
+
+    printf("[BENCH] block cache lookup by entry count, mean per call\n");
+
+    for (uint32_t n = 64; n <= MAX_ENTRIES; n *= 4) {
+        for (; filled < n; filled++)
+            cache_insert(0, 0, filled, blk);
+
+        t0 = test_now_ns();
+        for (int i = 0; i < OPS; i++)
+            sink += (uint32_t)cache_lookup(0, 0, test_rand() % n, blk);
+        t1 = test_now_ns();
+        for (int i = 0; i < OPS; i++)
+            sink += (uint32_t)cache_lookup(1, 0, (uint32_t)i, blk);
+        t2 = test_now_ns();
+        for (int i = 0; i < OPS; i++) {
+            cache_buf_t *b = cache_get(0, 0, test_rand() % n, 0);
+            sink += b->data[0];
+            cache_put(b);
+        }
+        t3 = test_now_ns();
+
+        printf("  entries %-6u  hit %7.1f ns   miss %7.1f ns   get/put %7.1f ns\n", n,
+               (double)(t1 - t0) / OPS, (double)(t2 - t1) / OPS,
+               (double)(t3 - t2) / OPS);
+    }
+
+    /* Full cache: every insert evicts the LRU entry */
+    for (; filled < MAX_ENTRIES; filled++)
+        cache_insert(0, 0, filled, blk);
+    t0 = test_now_ns();
+    for (int i = 0; i < OPS; i++)
+        cache_insert(0, 0, MAX_ENTRIES + (uint32_t)i, blk);
+    t1 = test_now_ns();
+    printf("  insert+evict at %u entries %7.1f ns\n", MAX_ENTRIES,
+           (double)(t1 - t0) / OPS);
+
+    cache_invalidate_device(0);
+    cache_set_limits(0, MIX_CACHE * CACHE_BLOCK_SIZE / 1024);
+    printf("[BENCH] %u-block hot set and %u streamed reads per hot read, %u-block cache\n",
+           MIX_HOT, MIX_STREAM, MIX_CACHE);
+    bench_mix(CACHE_POLICY_LRU, "lru");
+    bench_mix(CACHE_POLICY_2Q, "2q");
+
+    return sink == 0xFFFFFFFF;
+}
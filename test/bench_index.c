@@ -0,0 +1,96 @@
+#include "test.h"
+#include "lib/hash.h"
+#include "lib/rbtree.h"
+
+/* =========================================================================
+ * Index microbenchmarks
+ *
+ * Lookup cost of a list scan (what the block cache and VFS do today)
+ * against the resizable hash table and the red-black tree, for a few
+ * population sizes.  Every lookup hits; keys are probed in random order.
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t      key;
+    list_head_t   lnode;
+    htable_node_t hnode;
+    rb_node_t     rnode;
+} item_t;
+
+#define LOOKUPS  200000
+
+static volatile uintptr_t bench_sink;
+
+static int item_cmp(const void *key, const rb_node_t *n)
+{
+    uint32_t k = *(const uint32_t *)key, nk = rb_entry(n, item_t, rnode)->key;
+    return k < nk ? -1 : k > nk;
+}
+
+static int item_less(const rb_node_t *a, const rb_node_t *b)
+{
+    return rb_entry(a, item_t, rnode)->key < rb_entry(b, item_t, rnode)->key;
+}
+
+static void bench_size(uint32_t n)
+{
+    item_t    *items = malloc(sizeof(item_t) * n);
+    uint32_t  *probe = malloc(sizeof(uint32_t) * LOOKUPS);
+    LIST_HEAD(list);
+    htable_t   table;
+    rb_root_t  tree = RB_ROOT;
+
+    htable_init(&table, 4);
+    for (uint32_t i = 0; i < n; i++) {
+        items[i].key = i * 2654435761u;
+        list_add_tail(&items[i].lnode, &list);
+        htable_add(&table, &items[i].hnode, hash_32(items[i].key, 32));
+        rb_add(&items[i].rnode, &tree, item_less);
+    }
+    for (int i = 0; i < LOOKUPS; i++)
+        probe[i] = items[test_rand() % n].key;
+
+    /* A list scan is O(n); cap its lookups so large sizes stay quick */
+    int list_lookups = n > 1024 ? LOOKUPS / 64 : LOOKUPS;
+
+    uint64_t t0 = test_now_ns();
+    for (int i = 0; i < list_lookups; i++) {
+        item_t *pos;
+        list_for_each_entry(pos, &list, lnode)
+            if (pos->key == probe[i])
+                break;
+        bench_sink = (uintptr_t)pos;
+    }
+    uint64_t t1 = test_now_ns();
+    for (int i = 0; i < LOOKUPS; i++) {
+        item_t  *pos, *hit = NULL;
+        uint32_t h = hash_32(probe[i], 32);
+        htable_for_each_possible(&table, pos, hnode, h)
+            if (pos->key == probe[i]) {
+                hit = pos;
+                break;
+            }
+        bench_sink = (uintptr_t)hit;
+    }
+    uint64_t t2 = test_now_ns();
+    for (int i = 0; i < LOOKUPS; i++)
+        bench_sink = (uintptr_t)rb_find(&probe[i], &tree, item_cmp);
+    uint64_t t3 = test_now_ns();
+
+    printf("  n=%-7u list %8.1f ns   htable %6.1f ns   rbtree %6.1f ns\n", n,
+           (double)(t1 - t0) / list_lookups,
+           (double)(t2 - t1) / LOOKUPS,
+           (double)(t3 - t2) / LOOKUPS);
+
+    htable_destroy(&table);
+    free(probe);
+    free(items);
+}
+
+int main(void)
+{
+    printf("[BENCH] index lookup, %d random hits per structure\n", LOOKUPS);
+    for (uint32_t n = 16; n <= 65536; n *= 8)
+        bench_size(n);
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "test.h"
+#include "shim.h"
+#include "mm/buddy.h"
+#include "mm/slab.h"
+
+/* =========================================================================
+ * Allocator microbenchmarks
+ *
+ * mm/buddy.c and mm/slab.c as the kernel runs them, over a 64 MB arena.
+ * Each row is the mean cost of one operation:
+ *
+ *   lifo      alloc then immediately free (hot free list / first fit)
+ *   batch     allocate N objects, then free them all
+ *   random    free and reallocate random live objects, N resident
+ *   fragment  page allocs while every other page of the arena is taken
+ * ========================================================================= */
+
+#define ARENA_PHYS  0x00100000u
+#define ARENA_KB    (64 * 1024)
+#define N           4096
+
+static void *objs[N];
+
+static double ns_per(uint64_t t0, uint64_t t1, uint64_t ops)
+{
+    return (double)(t1 - t0) / (double)ops;
+}
+
+static void bench_kalloc(size_t size)
+{
+    enum { ITERS = 200 };
+    uint64_t t0, t1;
+
+    t0 = test_now_ns();
+    for (int i = 0; i < ITERS * N; i++)
+        kfree(kalloc(size));
+    t1 = test_now_ns();
+    double lifo = ns_per(t0, t1, (uint64_t)ITERS * N);
+
+    t0 = test_now_ns();
+    for (int r = 0; r < ITERS / 10; r++) {
+        for (int i = 0; i < N; i++)
+            objs[i] = kalloc(size);
+        for (int i = 0; i < N; i++)
+            kfree(objs[i]);
+    }
+    t1 = test_now_ns();
+    double batch = ns_per(t0, t1, (uint64_t)ITERS / 10 * N * 2);
+
+    for (int i = 0; i < N; i++)
+        objs[i] = kalloc(size);
+    t0 = test_now_ns();
+    for (int r = 0; r < ITERS * N; r++) {
+        int i = test_rand() % N;
+        kfree(objs[i]);
+        objs[i] = kalloc(size);
+    }
+    t1 = test_now_ns();
+    for (int i = 0; i < N; i++)
+        kfree(objs[i]);
+    double random = ns_per(t0, t1, (uint64_t)ITERS * N * 2);
+
+    printf("  kalloc %-5zu  lifo %7.1f ns   batch %7.1f ns   random %7.1f ns\n",
+           size, lifo, batch, random);
+}
+
+static void bench_page_alloc(void)
+{
+    enum { ITERS = 20 };
+    uint64_t t0, t1;
+
+    t0 = test_now_ns();
+    for (int r = 0; r < ITERS; r++) {
+        for (int i = 0; i < N; i++)
+            objs[i] = page_alloc(PAGE_SIZE);
+        for (int i = 0; i < N; i++)
+            page_free(objs[i]);
+    }
+    t1 = test_now_ns();
+    printf("  page_alloc 1 page      batch    %9.1f ns\n",
+           ns_per(t0, t1, (uint64_t)ITERS * N * 2));
+
+    t0 = test_now_ns();
+    for (int r = 0; r < ITERS * N; r++)
+        page_free(page_alloc(8 * PAGE_SIZE));
+    t1 = test_now_ns();
+    printf("  page_alloc 8 pages     lifo     %9.1f ns\n",
+           ns_per(t0, t1, (uint64_t)ITERS * N));
+
+    /* Take the whole arena, then free every other page: a request for
+     * two pages has to scan the full bitmap and fail */
+    uint32_t total = buddy_free_pages();
+    void   **all   = malloc(sizeof(void *) * total);
+    for (uint32_t i = 0; i < total; i++)
+        all[i] = page_alloc(PAGE_SIZE);
+    for (uint32_t i = 0; i < total; i += 2)
+        page_free(all[i]);
+
+    t0 = test_now_ns();
+    for (int r = 0; r < 200; r++)
+        (void)page_alloc(2 * PAGE_SIZE);
+    t1 = test_now_ns();
+    printf("  page_alloc fragmented  fail     %9.1f ns  (%u pages)\n",
+           ns_per(t0, t1, 200), total);
+
+    for (uint32_t i = 1; i < total; i += 2)
+        page_free(all[i]);
+    free(all);
+}
+
+int main(void)
+{
+    if (shim_arena_init(ARENA_PHYS, ARENA_KB) < 0) {
+        printf("[BENCH] mm: cannot map the arena, skipped\n");
+        return 0;
+    }
+    slab_init();
+
+    printf("[BENCH] allocators, mean per operation\n");
+    bench_kalloc(32);
+    bench_kalloc(512);
+    bench_kalloc(2048);
+    bench_page_alloc();
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "test.h"
+#include "lib/string.h"
+#include "fs/fs.h"
+
+/* =========================================================================
+ * String routine microbenchmarks
+ *
+ * lib/string.c (word at a time) against a plain byte loop, per call, for
+ * a few string lengths; then resolve_path on typical inputs.
+ * ========================================================================= */
+
+static size_t byte_strlen(const char *s)
+{
+    const volatile char *p = s;
+    while (*p)
+        p++;
+    return (size_t)(p - s);
+}
+
+static int byte_strcmp(const char *a, const char *b)
+{
+    const volatile char *p = a, *q = b;
+    while (*p && *p == *q) {
+        p++;
+        q++;
+    }
+    return (unsigned char)*p - (unsigned char)*q;
+}
+
+#define CALLS  200000
+
+static volatile size_t sink;
+
+static void bench_len(size_t len)
+{
+    static char a[4096 + 8], b[4096 + 8];
+    uint64_t t0, t1, t2, t3, t4;
+
+    memset(a, 'x', len);
+    memset(b, 'x', len);
+    a[len] = b[len] = '\0';
+
+    t0 = test_now_ns();
+    for (int i = 0; i < CALLS; i++)
+        sink = strlen(a);
+    t1 = test_now_ns();
+    for (int i = 0; i < CALLS; i++)
+        sink = byte_strlen(a);
+    t2 = test_now_ns();
+    for (int i = 0; i < CALLS; i++)
+        sink = (size_t)strcmp(a, b);
+    t3 = test_now_ns();
+    for (int i = 0; i < CALLS; i++)
+        sink = (size_t)byte_strcmp(a, b);
+    t4 = test_now_ns();
+
+    printf("  len %-5zu  strlen %7.1f ns (bytes %7.1f)   strcmp %7.1f ns (bytes %7.1f)\n",
+           len, (double)(t1 - t0) / CALLS, (double)(t2 - t1) / CALLS,
+           (double)(t3 - t2) / CALLS, (double)(t4 - t3) / CALLS);
+}
+
+static void bench_resolve(const char *cwd, const char *in)
+{
+    char     out[MAX_PATH_LEN];
+    uint64_t t0 = test_now_ns();
+
+    for (int i = 0; i < CALLS; i++)
+        sink = (size_t)resolve_path(cwd, in, out, sizeof(out));
+    uint64_t t1 = test_now_ns();
+
+    printf("  resolve_path %-28s %7.1f ns\n", in, (double)(t1 - t0) / CALLS);
+}
+
+int main(void)
+{
+    printf("[BENCH] string routines, mean per call\n");
+    for (size_t len = 8; len <= 4096; len *= 8)
+        bench_len(len);
+
+    bench_resolve("/", "/etc/passwd");
+    bench_resolve("/home/user", "docs/notes.txt");
+    bench_resolve("/home/user", "../other/./a/../b");
+    return 0;
+}
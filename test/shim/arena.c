@@ -0,0 +1,27 @@
+#include "shim.h"
+#include "mm/buddy.h"
+#include <sys/mman.h>
+
+/* =========================================================================
+ * "Physical" memory for mm/buddy.c
+ *
+ * The allocator hands out phys + KERNEL_VMA, so the host maps the arena
+ * at exactly that address.  Below 4 GB on a 64-bit host nothing else
+ * lives there, and the kernel's 32-bit address arithmetic still holds.
+ * ========================================================================= */
+
+#define KERNEL_VMA  0xC0000000U
+
+int shim_arena_init(uint32_t base_phys, uint32_t mem_kb)
+{
+    void  *want = (void *)(uintptr_t)(KERNEL_VMA + base_phys);
+    size_t len  = (size_t)mem_kb * 1024;
+
+    void *p = mmap(want, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p == MAP_FAILED || p != want)
+        return -1;
+
+    buddy_init(base_phys, mem_kb);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "shim.h"
+#include "mm/slab.h"
+#include <stdlib.h>
+
+/* =========================================================================
+ * kalloc/kfree over malloc
+ * ========================================================================= */
+
+int shim_kalloc_fail;
+
+void *kalloc(size_t size)
+{
+    if (shim_kalloc_fail > 0) {
+        shim_kalloc_fail--;
+        return NULL;
+    }
+    return malloc(size);
+}
+
+void kfree(void *addr)
+{
+    free(addr);
+}
@@ -0,0 +1,142 @@
+#include "shim.h"
+#include "kernel/asm.h"
+#include "kernel/jump_label.h"
+#include "kernel/irqflags.h"
+#include "kernel/trace.h"
+#include "kernel/rcu.h"
+#include "kernel/cmdline.h"
+#include "lib/printk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* =========================================================================
+ * printk
+ * ========================================================================= */
+
+char shim_printk_last[256];
+int  shim_printk_count;
+
+void vprintk(const char *fmt, va_list args)
+{
+    static int verbose = -1;
+    if (verbose < 0)
+        verbose = getenv("SHIM_VERBOSE") != NULL;
+
+    /* Skip a KERN_* level prefix */
+    if (fmt[0] == KERN_SOH_ASCII && fmt[1])
+        fmt += 2;
+
+    va_list copy;
+    va_copy(copy, args);
+    vsnprintf(shim_printk_last, sizeof(shim_printk_last), fmt, copy);
+    va_end(copy);
+    shim_printk_count++;
+
+    if (verbose)
+        vprintf(fmt, args);
+}
+
+void printk(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vprintk(fmt, args);
+    va_end(args);
+}
+
+void vprintk_early(const char *fmt, va_list args)
+{
+    vprintk(fmt, args);
+}
+
+void printk_early(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vprintk(fmt, args);
+    va_end(args);
+}
+
+/* =========================================================================
+ * Tracing, static keys, irqs-off tracking
+ * ========================================================================= */
+
+void trace_emit(const trace_event_t *event, uint32_t a0, uint32_t a1,
+                uint32_t a2, uint32_t a3)
+{
+    (void)event; (void)a0; (void)a1; (void)a2; (void)a3;
+}
+
+void static_key_enable(static_key_t *key)
+{
+    key->enabled = 1;
+}
+
+void static_key_disable(static_key_t *key)
+{
+    key->enabled = 0;
+}
+
+uint32_t      shim_eflags = EFLAGS_IF;
+irqsoff_cpu_t irqsoff_cpu[NR_CPUS];
+DEFINE_STATIC_KEY_FALSE(irqsoff_key);
+
+void irqsoff_stop(void)
+{
+    irqsoff_cpu[0].start = 0;
+}
+
+/* =========================================================================
+ * I/O ports
+ * ========================================================================= */
+
+static uint32_t         port_latch[65536];
+static shim_port_in_fn  port_in[65536];
+static shim_port_out_fn port_out[65536];
+
+void shim_port_handler(uint16_t first, uint16_t count,
+                       shim_port_in_fn in, shim_port_out_fn out)
+{
+    for (uint32_t p = first; p < (uint32_t)first + count && p < 65536; p++) {
+        port_in[p]  = in;
+        port_out[p] = out;
+    }
+}
+
+uint32_t shim_port_in(uint16_t port, int width)
+{
+    if (port_in[port])
+        return port_in[port](port, width);
+    return port_latch[port];
+}
+
+void shim_port_out(uint16_t port, uint32_t val, int width)
+{
+    if (port_out[port])
+        port_out[port](port, val, width);
+    else
+        port_latch[port] = val;
+}
+
+/* =========================================================================
+ * RCU: one thread, so readers never overlap an update
+ * ========================================================================= */
+
+rcu_cpu_t rcu_cpu[NR_CPUS];
+
+void synchronize_rcu(void)
+{
+}
+
+/* =========================================================================
+ * Command line: empty, so every parameter takes its default
+ * ========================================================================= */
+
+int cmdline_param(const char *key, int n, char *buf, size_t size)
+{
+    (void)key; (void)n;
+    if (size)
+        buf[0] = '\0';
+    return -1;
+}
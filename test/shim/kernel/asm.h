@@ -0,0 +1,95 @@
+#ifndef ASM_H
+#define ASM_H
+
+#include <stdint.h>
+#include <x86intrin.h>
+#include <cpuid.h>
+
+/* =========================================================================
+ * Host stand-in for include/kernel/asm.h
+ *
+ * test/shim is searched before include/, so kernel sources built for the
+ * host get this file instead of the real one.  Privileged instructions
+ * are replaced: port I/O goes to the emulated port space in
+ * shim/kernel.c, interrupt control only tracks a flag, and the rest maps
+ * onto the host CPU.  Keep the function set in step with the real header.
+ * ========================================================================= */
+
+uint32_t shim_port_in(uint16_t port, int width);
+void     shim_port_out(uint16_t port, uint32_t val, int width);
+
+static inline void     outb(uint16_t port, uint8_t val)  { shim_port_out(port, val, 1); }
+static inline uint8_t  inb(uint16_t port)                { return (uint8_t)shim_port_in(port, 1); }
+static inline void     outw(uint16_t port, uint16_t val) { shim_port_out(port, val, 2); }
+static inline uint16_t inw(uint16_t port)                { return (uint16_t)shim_port_in(port, 2); }
+static inline void     outl(uint16_t port, uint32_t val) { shim_port_out(port, val, 4); }
+static inline uint32_t inl(uint16_t port)                { return shim_port_in(port, 4); }
+static inline void     io_wait(void)                     { }
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+                         uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+    __cpuid_count(leaf, subleaf, *eax, *ebx, *ecx, *edx);
+}
+
+static inline uint64_t rdtsc(void)
+{
+    return __rdtsc();
+}
+
+/* Interrupt flag emulation: one flag for the whole process */
+#define EFLAGS_IF  (1u << 9)
+
+extern uint32_t shim_eflags;
+
+static inline void cli(void)        { shim_eflags &= ~EFLAGS_IF; }
+static inline void sti(void)        { shim_eflags |= EFLAGS_IF; }
+static inline void hlt(void)        { }
+static inline void safe_halt(void)  { sti(); }
+
+static inline uint32_t raw_irq_save(void)
+{
+    uint32_t flags = shim_eflags;
+    cli();
+    return flags;
+}
+
+static inline void raw_irq_restore(uint32_t flags)
+{
+    shim_eflags = flags;
+}
+
+/* =========================================================================
+ * Ordering primitives – same semantics as the kernel (x86 TSO)
+ * ========================================================================= */
+
+#define barrier()  __asm__ volatile ("" : : : "memory")
+#define smp_rmb()  barrier()
+#define smp_wmb()  barrier()
+#define smp_mb()   __sync_synchronize()
+
+static inline uint32_t local_fetch_add(volatile uint32_t *p, uint32_t v)
+{
+    __asm__ volatile ("xaddl %0, %1" : "+r"(v), "+m"(*p) : : "memory", "cc");
+    return v;
+}
+
+static inline uint32_t local_cmpxchg(volatile uint32_t *p, uint32_t old, uint32_t new)
+{
+    __asm__ volatile ("cmpxchgl %2, %1" : "+a"(old), "+m"(*p) : "r"(new) : "memory", "cc");
+    return old;
+}
+
+#define READ_ONCE(x)       (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, v)   (*(volatile __typeof__(x) *)&(x) = (v))
+
+static inline void cpu_relax(void)
+{
+    __asm__ volatile ("pause" : : : "memory");
+}
+
+static inline void magic_break(void)
+{
+}
+
+#endif /* ASM_H */
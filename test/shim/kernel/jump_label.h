@@ -0,0 +1,32 @@
+#ifndef JUMP_LABEL_H
+#define JUMP_LABEL_H
+
+#include <stdint.h>
+
+/* =========================================================================
+ * Host stand-in for include/kernel/jump_label.h
+ *
+ * No code patching: a static branch is an ordinary load of key->enabled.
+ * ========================================================================= */
+
+typedef struct static_key {
+    volatile int enabled;
+} static_key_t;
+
+#define DEFINE_STATIC_KEY_FALSE(name)   static_key_t name = { 0 }
+#define DECLARE_STATIC_KEY_FALSE(name)  extern static_key_t name
+
+static inline int static_branch_unlikely(static_key_t *key)
+{
+    return __builtin_expect(key->enabled, 0);
+}
+
+static inline int static_key_enabled(const static_key_t *key)
+{
+    return key->enabled;
+}
+
+void static_key_enable(static_key_t *key);
+void static_key_disable(static_key_t *key);
+
+#endif /* JUMP_LABEL_H */
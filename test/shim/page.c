@@ -0,0 +1,94 @@
+#include "shim.h"
+#include "mm/buddy.h"
+#include "mm/shrinker.h"
+#include <stdlib.h>
+
+/* =========================================================================
+ * page_alloc over host memory
+ *
+ * Runs are page aligned like the kernel's, which mm/slab.c relies on to
+ * find a slab header from an object address.  The run length is kept in
+ * a table so page_free() can account for it.
+ *
+ * shim_total_pages is the "machine size" for buddy_total_pages() and
+ * buddy_free_pages(); going past it fails like running out of memory,
+ * after asking the registered shrinker as mm/buddy.c does.
+ * ========================================================================= */
+
+int         shim_page_fail;
+uint32_t    shim_pages_out;
+uint32_t    shim_total_pages = 262144;
+shrinker_t *shim_shrinker;
+
+#define SHIM_MAX_RUNS  65536
+
+static struct {
+    void    *addr;
+    uint32_t pages;
+} runs[SHIM_MAX_RUNS];
+
+void *page_alloc(size_t size)
+{
+    if (size == 0)
+        return NULL;
+    if (shim_page_fail > 0) {
+        shim_page_fail--;
+        return NULL;
+    }
+
+    uint32_t pages = (uint32_t)((size + PAGE_SIZE - 1) >> PAGE_SHIFT);
+    if (shim_pages_out + pages > shim_total_pages &&
+        (!shim_shrinker || shim_shrinker->scan(pages) == 0 ||
+         shim_pages_out + pages > shim_total_pages))
+        return NULL;
+
+    for (int i = 0; i < SHIM_MAX_RUNS; i++) {
+        if (runs[i].addr)
+            continue;
+        void *p = aligned_alloc(PAGE_SIZE, (size_t)pages << PAGE_SHIFT);
+        if (!p)
+            return NULL;
+        runs[i].addr  = p;
+        runs[i].pages = pages;
+        shim_pages_out += pages;
+        return p;
+    }
+    return NULL;
+}
+
+void page_free(void *addr)
+{
+    if (!addr)
+        return;
+    for (int i = 0; i < SHIM_MAX_RUNS; i++) {
+        if (runs[i].addr == addr) {
+            shim_pages_out -= runs[i].pages;
+            runs[i].addr = NULL;
+            free(addr);
+            return;
+        }
+    }
+    abort();                       /* not from page_alloc: a real bug */
+}
+
+uint32_t buddy_total_pages(void)
+{
+    return shim_total_pages;
+}
+
+uint32_t buddy_free_pages(void)
+{
+    return shim_pages_out < shim_total_pages ? shim_total_pages - shim_pages_out : 0;
+}
+
+/* One shrinker is all the code under test registers */
+void register_shrinker(shrinker_t *s)
+{
+    shim_shrinker = s;
+}
+
+void unregister_shrinker(shrinker_t *s)
+{
+    if (shim_shrinker == s)
+        shim_shrinker = NULL;
+}
@@ -0,0 +1,55 @@
+#ifndef SHIM_H
+#define SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* =========================================================================
+ * Hooks into the host shims
+ *
+ * Each test binary links the kernel sources under test plus the shims it
+ * needs (see test/Makefile):
+ *
+ *   kernel.c  printk family, trace_emit, static keys, irqsoff state,
+ *             RCU for a single thread, an emulated I/O port space and
+ *             an empty command line
+ *   kalloc.c  kalloc/kfree over malloc, for code that only needs memory
+ *   page.c    page_alloc/page_free over aligned host pages, for mm/slab.c
+ *             and the block cache, with one shrinker
+ *   timer.c   pit_get_ticks() that only the test advances, driving
+ *             kernel/workqueue.c's delayed work
+ *   arena.c   a fixed mapping at KERNEL_VMA + phys so mm/buddy.c runs
+ *             unmodified over "physical" memory
+ * ========================================================================= */
+
+/* kernel.c: printk output is dropped unless SHIM_VERBOSE is set in the
+ * environment; the last line is always kept for tests to inspect */
+extern char shim_printk_last[256];
+extern int  shim_printk_count;
+
+/* kernel.c: port handlers; unhandled ports read back the last value written */
+typedef uint32_t (*shim_port_in_fn)(uint16_t port, int width);
+typedef void     (*shim_port_out_fn)(uint16_t port, uint32_t val, int width);
+void shim_port_handler(uint16_t first, uint16_t count,
+                       shim_port_in_fn in, shim_port_out_fn out);
+
+/* timer.c: pit_get_ticks() value; shim_tick() advances it n ticks */
+extern uint32_t shim_ticks;
+void shim_tick(uint32_t n);
+
+/* kalloc.c: the next n kalloc() calls fail */
+extern int shim_kalloc_fail;
+
+/* page.c: the next n page_alloc() calls fail; pages currently handed out;
+ * pages in the "machine" and the shrinker registered with it */
+struct shrinker;
+extern int              shim_page_fail;
+extern uint32_t         shim_pages_out;
+extern uint32_t         shim_total_pages;
+extern struct shrinker *shim_shrinker;
+
+/* arena.c: map mem_kb of "physical" memory from base_phys and hand it to
+ * buddy_init(); returns 0 or -1 if the fixed mapping is unavailable */
+int shim_arena_init(uint32_t base_phys, uint32_t mem_kb);
+
+#endif /* SHIM_H */
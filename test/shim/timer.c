@@ -0,0 +1,26 @@
+#include "shim.h"
+#include "kernel/workqueue.h"
+#include "driver/char/pit.h"
+
+/* =========================================================================
+ * PIT ticks, advanced only by the test
+ *
+ * Link kernel/workqueue.c along with this: each tick runs
+ * workqueue_tick() as the timer interrupt does, so delayed work comes
+ * due; run_work() then stands in for the idle loop.
+ * ========================================================================= */
+
+uint32_t shim_ticks;
+
+uint32_t pit_get_ticks(void)
+{
+    return shim_ticks;
+}
+
+void shim_tick(uint32_t n)
+{
+    while (n--) {
+        shim_ticks++;
+        workqueue_tick();
+    }
+}
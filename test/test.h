@@ -0,0 +1,62 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/* =========================================================================
+ * Minimal host test harness
+ *
+ *   static void test_foo(void) { CHECK(1 + 1 == 2); }
+ *   int main(void) { RUN(test_foo); return test_done("foo"); }
+ *
+ * A failed CHECK reports file:line and the expression, and the binary
+ * exits nonzero so `make test` stops.
+ * ========================================================================= */
+
+static int test_failures;
+static int test_checks;
+
+#define CHECK(expr) do {                                                \
+    test_checks++;                                                      \
+    if (!(expr)) {                                                      \
+        test_failures++;                                                \
+        fprintf(stderr, "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #expr); \
+    }                                                                   \
+} while (0)
+
+#define RUN(fn) do {                                                    \
+    int __before = test_failures;                                       \
+    fn();                                                               \
+    printf("  %-32s %s\n", #fn, test_failures == __before ? "ok" : "FAILED"); \
+} while (0)
+
+static inline int test_done(const char *suite)
+{
+    printf("[TEST] %s: %d checks, %d failures\n", suite, test_checks, test_failures);
+    return test_failures ? 1 : 0;
+}
+
+/* Deterministic xorshift PRNG so failures reproduce */
+static uint32_t test_rand_state = 2463534242u;
+
+static inline uint32_t test_rand(void)
+{
+    uint32_t x = test_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return test_rand_state = x;
+}
+
+/* Monotonic nanoseconds for the microbenchmarks */
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#endif /* TEST_H */
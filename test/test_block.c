@@ -0,0 +1,559 @@
+#include "test.h"
+#include "shim.h"
+#include "driver/block/block.h"
+#include "driver/block/cache.h"
+#include "driver/char/pit.h"
+#include "kernel/workqueue.h"
+#include <string.h>
+
+/* =========================================================================
+ * driver/block/block.c bread/bwrite through the cache
+ *
+ * Three RAM disks: device 0 is cached, device 1 registers BLOCK_NOCACHE
+ * and device 2 takes at most 4 blocks per request.
+ * The driver callbacks log every call so tests can check which blocks
+ * reached the "hardware" and in how many requests.
+ * ========================================================================= */
+
+#define BS           CACHE_BLOCK_SIZE
+#define DISK_BLOCKS  256
+
+static uint8_t disk[3][DISK_BLOCKS][BS];
+
+static struct {
+    int      reads, writes;     /* driver calls */
+    uint32_t last_off, last_count;
+    int      fail;              /* next driver call fails */
+    int      down;              /* every driver call fails */
+} drv;
+
+static int ram_read(int prim_id, int scnd_id, void *buf, uint32_t offset, size_t count)
+{
+    (void)scnd_id;
+    drv.reads++;
+    drv.last_off   = offset;
+    drv.last_count = (uint32_t)count;
+    if (drv.fail || drv.down) {
+        drv.fail = 0;
+        return -1;
+    }
+    if (offset + count > DISK_BLOCKS)
+        return -1;
+    memcpy(buf, disk[prim_id][offset], count * BS);
+    return (int)(count * BS);
+}
+
+static int ram_write(int prim_id, int scnd_id, const void *buf, uint32_t offset, size_t count)
+{
+    (void)scnd_id;
+    drv.writes++;
+    drv.last_off   = offset;
+    drv.last_count = (uint32_t)count;
+    if (drv.fail || drv.down) {
+        drv.fail = 0;
+        return -1;
+    }
+    if (offset + count > DISK_BLOCKS)
+        return -1;
+    memcpy(disk[prim_id][offset], buf, count * BS);
+    return (int)(count * BS);
+}
+
+static void fill(uint8_t *blk, uint32_t tag)
+{
+    for (int i = 0; i < BS; i += 4)
+        memcpy(blk + i, &tag, 4);
+}
+
+static int holds(const uint8_t *blk, uint32_t tag)
+{
+    uint8_t want[BS];
+    fill(want, tag);
+    return memcmp(blk, want, BS) == 0;
+}
+
+/* Every block of both disks tagged with its (device, number) */
+static void reset(void)
+{
+    cache_invalidate_device(0);
+    cache_invalidate_device(1);
+    cache_invalidate_device(2);
+    for (uint32_t d = 0; d < 3; d++)
+        for (uint32_t b = 0; b < DISK_BLOCKS; b++)
+            fill(disk[d][b], d << 16 | b);
+    memset(&drv, 0, sizeof(drv));
+}
+
+/* =========================================================================
+ * Tests
+ * ========================================================================= */
+
+static void test_block_read_caches_any_block(void)
+{
+    uint8_t buf[BS];
+
+    reset();
+    CHECK(bread(0, 0, buf, 37, 1) == BS && holds(buf, 37));
+    CHECK(drv.reads == 1);
+
+    memset(buf, 0, BS);
+    CHECK(bread(0, 0, buf, 37, 1) == BS && holds(buf, 37));
+    CHECK(drv.reads == 1);                          /* served from cache */
+}
+
+static void test_block_read_coalesces_misses(void)
+{
+    static uint8_t buf[16 * BS];
+
+    reset();
+    CHECK(bread(0, 0, buf, 100, 16) == 16 * BS);
+    CHECK(drv.reads == 1 && drv.last_off == 100 && drv.last_count == 16);
+    for (uint32_t i = 0; i < 16; i++)
+        CHECK(holds(buf + i * BS, 100 + i));
+
+    /* All cached now */
+    memset(buf, 0, sizeof(buf));
+    CHECK(bread(0, 0, buf, 104, 8) == 8 * BS && drv.reads == 1);
+    for (uint32_t i = 0; i < 8; i++)
+        CHECK(holds(buf + i * BS, 104 + i));
+
+    /* Holes at 102-103 and 110: one request per run of misses */
+    cache_invalidate(0, 0, 102);
+    cache_invalidate(0, 0, 103);
+    cache_invalidate(0, 0, 110);
+    memset(buf, 0, sizeof(buf));
+    drv.reads = 0;
+    CHECK(bread(0, 0, buf, 100, 16) == 16 * BS);
+    CHECK(drv.reads == 2);
+    CHECK(drv.last_off == 110 && drv.last_count == 1);
+    for (uint32_t i = 0; i < 16; i++)
+        CHECK(holds(buf + i * BS, 100 + i));
+
+    /* A trailing run is fetched too */
+    cache_invalidate(0, 0, 114);
+    cache_invalidate(0, 0, 115);
+    drv.reads = 0;
+    CHECK(bread(0, 0, buf, 110, 6) == 6 * BS);
+    CHECK(drv.reads == 1 && drv.last_off == 114 && drv.last_count == 2);
+    CHECK(holds(buf + 5 * BS, 115));
+
+    /* Runs are split at the device's max_blocks, writes as well */
+    drv.reads = 0;
+    CHECK(bread(2, 0, buf, 20, 10) == 10 * BS);
+    CHECK(drv.reads == 3 && drv.last_off == 28 && drv.last_count == 2);
+    for (uint32_t i = 0; i < 10; i++)
+        CHECK(holds(buf + i * BS, 2 << 16 | (20 + i)));
+    drv.writes = 0;
+    CHECK(bwrite(2, 0, buf, 40, 9) == 9 * BS);
+    CHECK(drv.writes == 3 && drv.last_off == 48 && drv.last_count == 1);
+    CHECK(holds(disk[2][48], 2 << 16 | 28));
+}
+
+static void test_block_write_through(void)
+{
+    uint8_t blk[4 * BS], out[4 * BS];
+
+    reset();
+    for (uint32_t i = 0; i < 4; i++)
+        fill(blk + i * BS, 0xAB00 + i);
+
+    CHECK(bwrite(0, 0, blk, 20, 4) == 4 * BS);
+    CHECK(drv.writes == 1 && drv.last_count == 4);
+    CHECK(holds(disk[0][21], 0xAB01));
+
+    /* Reading back needs no driver call */
+    CHECK(bread(0, 0, out, 20, 4) == 4 * BS && drv.reads == 0);
+    CHECK(memcmp(out, blk, sizeof(blk)) == 0);
+
+    /* Overwriting a cached block updates the cached copy */
+    fill(blk, 0xCD);
+    CHECK(bwrite(0, 0, blk, 22, 1) == BS);
+    CHECK(bread(0, 0, out, 22, 1) == BS && holds(out, 0xCD) && drv.reads == 0);
+}
+
+static void test_block_errors(void)
+{
+    uint8_t buf[4 * BS];
+    uint32_t n0, n1;
+
+    reset();
+    cache_stats(NULL, NULL, &n0);
+
+    /* A failed read caches nothing and reports the error */
+    drv.fail = 1;
+    CHECK(bread(0, 0, buf, 50, 4) == -1);
+    cache_stats(NULL, NULL, &n1);
+    CHECK(n1 == n0);
+    CHECK(bread(0, 0, buf, 50, 4) == 4 * BS && holds(buf, 50));
+
+    /* A failed write drops the blocks it may have half-written */
+    drv.fail = 1;
+    fill(buf, 0xEE);
+    CHECK(bwrite(0, 0, buf, 50, 1) == -1);
+    drv.reads = 0;
+    CHECK(bread(0, 0, buf, 50, 1) == BS && drv.reads == 1 && holds(buf, 50));
+
+    /* Past the end of the disk */
+    CHECK(bread(0, 0, buf, DISK_BLOCKS - 1, 2) == -1);
+
+    /* Unregistered device */
+    CHECK(bread(9, 0, buf, 0, 1) == -1);
+    CHECK(bwrite(9, 0, buf, 0, 1) == -1);
+}
+
+static void test_block_nocache(void)
+{
+    uint8_t buf[BS];
+    uint32_t n0, n1;
+
+    reset();
+    cache_stats(NULL, NULL, &n0);
+
+    CHECK(bread(1, 0, buf, 7, 1) == BS && holds(buf, 1 << 16 | 7));
+    CHECK(bread(1, 0, buf, 7, 1) == BS);
+    CHECK(drv.reads == 2);
+
+    fill(buf, 0x77);
+    CHECK(bwrite(1, 0, buf, 7, 1) == BS && holds(disk[1][7], 0x77));
+
+    cache_stats(NULL, NULL, &n1);
+    CHECK(n1 == n0);
+}
+
+static void test_block_buffer_refs(void)
+{
+    cache_buf_t *a, *b;
+    uint8_t buf[BS];
+
+    reset();
+
+    /* A miss is read into the cache slot; a hit is the same buffer */
+    a = bread_ref(0, 0, 60);
+    CHECK(a && a->uptodate && holds(a->data, 60) && drv.reads == 1);
+    b = bread_ref(0, 0, 60);
+    CHECK(b == a && drv.reads == 1);
+    brelse(b);
+
+    /* Changes in place reach bread() now and the disk on flush */
+    fill(a->data, 0x6060);
+    bmark_dirty(a);
+    brelse(a);
+    CHECK(bread(0, 0, buf, 60, 1) == BS && holds(buf, 0x6060) && drv.reads == 1);
+    CHECK(holds(disk[0][60], 60));
+    CHECK(cache_flush() == 1 && holds(disk[0][60], 0x6060));
+
+    /* bget() does not read */
+    a = bget(0, 0, 61);
+    CHECK(a && !a->uptodate && drv.reads == 1);
+    fill(a->data, 0x6161);
+    bmark_dirty(a);
+    CHECK(a->uptodate);
+    brelse(a);
+    CHECK(bread(0, 0, buf, 61, 1) == BS && holds(buf, 0x6161) && drv.reads == 1);
+    cache_flush();
+
+    /* bwrite() of a referenced block updates it in place */
+    a = bread_ref(0, 0, 62);
+    fill(buf, 0x6262);
+    CHECK(bwrite(0, 0, buf, 62, 1) == BS && holds(a->data, 0x6262));
+    brelse(a);
+}
+
+static void test_block_buffer_errors(void)
+{
+    cache_buf_t *a;
+    uint8_t buf[BS];
+
+    reset();
+
+    /* Read error: no buffer, and a later read tries again */
+    drv.fail = 1;
+    CHECK(bread_ref(0, 0, 70) == NULL);
+    CHECK((a = bread_ref(0, 0, 70)) != NULL && holds(a->data, 70));
+    CHECK(drv.reads == 2);
+
+    /* Invalidated while referenced: the buffer outlives the cached copy */
+    drv.fail = 1;
+    fill(buf, 0x7070);
+    CHECK(bwrite(0, 0, buf, 70, 1) == -1);
+    CHECK(holds(a->data, 70));
+    drv.reads = 0;
+    CHECK(bread(0, 0, buf, 70, 1) == BS && drv.reads == 1);
+    brelse(a);
+
+    /* No buffers for uncached or unknown devices */
+    CHECK(bread_ref(1, 0, 7) == NULL && bget(1, 0, 7) == NULL);
+    CHECK(bread_ref(9, 0, 7) == NULL && bget(9, 0, 7) == NULL);
+    CHECK(bread_ref(0, 0, DISK_BLOCKS) == NULL);
+    brelse(NULL);
+}
+
+static void test_block_write_back(void)
+{
+    uint8_t buf[4 * BS], out[4 * BS];
+
+    reset();
+    cache_set_limits(32, 32);                       /* 64 blocks */
+    cache_set_writeback(1);
+    for (uint32_t i = 0; i < 4; i++)
+        fill(buf + i * BS, 0xB000 + i);
+
+    /* Writes stop in the cache */
+    CHECK(bwrite(0, 0, buf, 30, 4) == 4 * BS && drv.writes == 0);
+    CHECK(cache_dirty_count() == 4 && holds(disk[0][30], 30));
+    CHECK(bread(0, 0, out, 30, 4) == 4 * BS && drv.reads == 0);
+    CHECK(memcmp(out, buf, sizeof(buf)) == 0);
+    CHECK(bwrite(0, 0, buf, 30, 1) == BS && drv.writes == 0);
+    CHECK(cache_dirty_count() == 4);
+
+    /* The flusher leaves them for 3 s, then writes them */
+    shim_tick(PIT_DEFAULT_HZ);
+    run_work();
+    CHECK(drv.writes == 0);
+    shim_tick(3 * PIT_DEFAULT_HZ);
+    run_work();
+    CHECK(drv.writes == 1 && drv.last_off == 30 && drv.last_count == 4);
+    CHECK(cache_dirty_count() == 0 && holds(disk[0][33], 0xB003));
+
+    /* Over 10% dirty: the flusher runs at once and writes the oldest */
+    for (uint32_t b = 0; b < 8; b++)
+        bwrite(0, 0, buf, 120 + b, 1);
+    CHECK(cache_dirty_count() == 8 && drv.writes == 1);
+    run_work();
+    CHECK(cache_dirty_count() == 6 && drv.writes == 2);
+    CHECK(holds(disk[0][121], 0xB000) && holds(disk[0][122], 122));
+
+    /* Over 40%: the writer waits for the disk */
+    for (uint32_t b = 0; b < 20; b++)
+        bwrite(0, 0, buf, 140 + b, 1);
+    CHECK(cache_dirty_count() == 25 && drv.writes == 3);
+
+    /* sync by device: 123-127, then 140-159 in runs of at most 16 */
+    CHECK(bsync(1) == 0 && drv.writes == 3);
+    CHECK(bsync(0) == 25 && drv.writes == 6 && cache_dirty_count() == 0);
+    CHECK(drv.last_off == 156 && drv.last_count == 4);
+    CHECK(holds(disk[0][159], 0xB000));
+
+    /* Leaving write-back mode syncs */
+    bwrite(0, 0, buf, 40, 1);
+    cache_set_writeback(0);
+    CHECK(drv.writes == 7 && cache_dirty_count() == 0);
+    run_work();
+}
+
+/* Dirty blocks reach the disk sorted, neighbours merged up to max_blocks */
+static void test_block_write_back_merge(void)
+{
+    static const uint32_t order[] = { 17, 5, 12, 6, 16, 4, 13, 7, 15, 8, 14, 30 };
+    uint32_t blocks0, requests0, merged0, blocks, requests, merged;
+    uint8_t  buf[BS];
+
+    reset();
+    cache_set_limits(32, 32);
+    cache_set_writeback(1);
+    cache_wb_stats(&blocks0, &requests0, &merged0);
+
+    /* 4-8, 12-17 and 30, written out of order */
+    for (uint32_t i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+        fill(buf, 0xD000 + order[i]);
+        CHECK(bwrite(0, 0, buf, order[i], 1) == BS);
+    }
+    CHECK(drv.writes == 0 && cache_dirty_count() == 12);
+    CHECK(bsync(0) == 12 && drv.writes == 3);
+    CHECK(drv.last_off == 30 && drv.last_count == 1);
+    for (uint32_t i = 0; i < sizeof(order) / sizeof(order[0]); i++)
+        CHECK(holds(disk[0][order[i]], 0xD000 + order[i]));
+
+    cache_wb_stats(&blocks, &requests, &merged);
+    CHECK(blocks - blocks0 == 12 && requests - requests0 == 3);
+    CHECK(merged - merged0 == 9 && merged == blocks - requests);
+
+    /* Device 2 takes 4 blocks at a time: 10 blocks, 3 requests */
+    drv.writes = 0;
+    for (uint32_t b = 100; b < 110; b++) {
+        fill(buf, 0x2D000 + b);
+        bwrite(2, 0, buf, b, 1);
+    }
+    CHECK(bsync(2) == 10 && drv.writes == 3);
+    CHECK(drv.last_off == 108 && drv.last_count == 2);
+    CHECK(holds(disk[2][103], 0x2D000 + 103) && holds(disk[2][104], 0x2D000 + 104));
+
+    /* A failed merged request is tried again block by block */
+    for (uint32_t b = 60; b < 63; b++)
+        bwrite(0, 0, buf, b, 1);
+    drv.writes = 0;
+    drv.fail   = 1;
+    CHECK(bsync(0) == 3 && cache_dirty_count() == 0 && drv.writes == 4);
+    CHECK(drv.last_off == 62 && drv.last_count == 1);
+
+    /* A failed single block stays dirty, to be retried */
+    bwrite(0, 0, buf, 60, 1);
+    drv.fail = 1;
+    CHECK(bsync(0) == -1 && cache_dirty_count() == 1);
+    CHECK(bsync(0) == 1 && cache_dirty_count() == 0);
+
+    cache_set_writeback(0);
+    cache_set_limits(32, 1024);
+}
+
+/* A block that can never be written does not hold up the others */
+static void test_block_write_back_error(void)
+{
+    uint8_t buf[BS];
+
+    reset();
+    cache_set_limits(32, 32);
+    cache_set_writeback(1);
+    fill(buf, 0xE000);
+
+    /* Past the end of the disk: accepted now, fails on write-back */
+    CHECK(bwrite(0, 0, buf, DISK_BLOCKS + 44, 1) == BS);
+    CHECK(bwrite(0, 0, buf, 70, 1) == BS);
+    CHECK(bwrite(2, 0, buf, 71, 1) == BS);
+    CHECK(cache_dirty_count() == 3);
+
+    /* The others are written; the bad one is retried, then dropped */
+    CHECK(bsync(-1) == -1 && cache_dirty_count() == 1);
+    CHECK(holds(disk[0][70], 0xE000) && holds(disk[2][71], 0xE000));
+    drv.writes = 0;
+    CHECK(bsync(-1) == -1 && cache_dirty_count() == 1);
+    CHECK(bsync(-1) == -1 && cache_dirty_count() == 0);
+    CHECK(drv.writes == 2);
+    CHECK(bsync(-1) == 0 && drv.writes == 2);
+
+    /* The flusher gives up on it as well, and stops coming back */
+    CHECK(bwrite(0, 0, buf, DISK_BLOCKS + 44, 1) == BS);
+    shim_tick(3 * PIT_DEFAULT_HZ);
+    run_work();
+    for (int i = 0; i < 4; i++) {
+        shim_tick(PIT_DEFAULT_HZ);
+        run_work();
+    }
+    CHECK(cache_dirty_count() == 0 && drv.writes == 5);
+
+    /* A merged run that fails is retried block by block */
+    for (uint32_t b = DISK_BLOCKS - 2; b <= DISK_BLOCKS; b++)
+        CHECK(bwrite(0, 0, buf, b, 1) == BS);
+    drv.writes = 0;
+    CHECK(bsync(0) == -1 && cache_dirty_count() == 1 && drv.writes == 4);
+    CHECK(holds(disk[0][DISK_BLOCKS - 1], 0xE000));
+
+    /* A failed block goes back by age, behind an older one of another
+     * device, which the flusher then still writes in time */
+    bsync(0);
+    bsync(0);
+    CHECK(cache_dirty_count() == 0);
+    shim_tick(3 * PIT_DEFAULT_HZ);
+    run_work();
+    fill(buf, 0xE001);
+    CHECK(bwrite(2, 0, buf, 80, 1) == BS);
+    shim_tick(PIT_DEFAULT_HZ);
+    run_work();
+    shim_tick(PIT_DEFAULT_HZ);
+    run_work();
+    CHECK(bwrite(0, 0, buf, DISK_BLOCKS + 44, 1) == BS);
+    CHECK(bsync(0) == -1 && cache_dirty_count() == 2);
+    shim_tick(PIT_DEFAULT_HZ);
+    run_work();
+    CHECK(holds(disk[2][80], 0xE001) && cache_dirty_count() == 1);
+
+    cache_set_writeback(0);
+}
+
+/* The device fails while the cache is full: nothing is given up dirty */
+static void test_block_write_back_down(void)
+{
+    cache_buf_t *pin[6];
+    uint8_t      buf[BS], out[BS];
+
+    reset();
+    cache_set_limits(4, 4);                         /* one page */
+    cache_set_writeback(1);
+    for (uint32_t i = 0; i < 6; i++)
+        pin[i] = bread_ref(0, 0, 90 + i);
+
+    drv.down = 1;
+    fill(buf, 0xF010);
+    CHECK(bwrite(0, 0, buf, 10, 1) == BS);
+    fill(buf, 0xF011);
+    CHECK(bwrite(0, 0, buf, 11, 1) == BS);
+    CHECK(cache_dirty_count() == 2);
+
+    /* Full, and the only unpinned blocks cannot be written: no room */
+    fill(buf, 0xF012);
+    CHECK(bwrite(0, 0, buf, 12, 1) == -1);
+    CHECK(bread(0, 0, out, 13, 1) == -1);
+    CHECK(cache_dirty_count() == 2);
+
+    /* Shrinking and invalidating keep them too */
+    cache_set_limits(0, 0);
+    CHECK(cache_invalidate(0, 0, 10) == -1 && cache_dirty_count() == 2);
+    CHECK(bread(0, 0, out, 10, 1) == BS && holds(out, 0xF010));
+
+    /* The device recovers: everything reaches it */
+    drv.down = 0;
+    for (uint32_t i = 0; i < 6; i++)
+        brelse(pin[i]);
+    CHECK(bsync(0) == 2 && cache_dirty_count() == 0);
+    CHECK(holds(disk[0][10], 0xF010) && holds(disk[0][11], 0xF011));
+    cache_invalidate_device(0);
+    CHECK(bread(0, 0, out, 11, 1) == BS && holds(out, 0xF011));
+
+    cache_set_writeback(0);
+    cache_set_limits(32, 1024);
+}
+
+static void test_block_write_back_full(void)
+{
+    cache_buf_t *pin[8];
+    uint8_t buf[3 * BS];
+
+    reset();
+    cache_set_limits(4, 4);                         /* one page */
+    cache_set_writeback(1);
+    for (uint32_t i = 0; i < 8; i++)
+        pin[i] = bget(0, 0, 200 + i);
+
+    /* No slot to hold them: written now, in one request */
+    for (uint32_t i = 0; i < 3; i++)
+        fill(buf + i * BS, 0xC000 + i);
+    CHECK(bwrite(0, 0, buf, 40, 3) == 3 * BS);
+    CHECK(drv.writes == 1 && drv.last_off == 40 && drv.last_count == 3);
+    CHECK(holds(disk[0][42], 0xC002) && cache_dirty_count() == 0);
+
+    drv.fail = 1;
+    CHECK(bwrite(0, 0, buf, 40, 3) == -1);
+
+    for (uint32_t i = 0; i < 8; i++)
+        brelse(pin[i]);
+    cache_set_writeback(0);
+    cache_set_limits(32, 1024);
+}
+
+int main(void)
+{
+    static block_ops_t cached   = { .read = ram_read, .write = ram_write };
+    static block_ops_t uncached = { .read = ram_read, .write = ram_write,
+                                    .flags = BLOCK_NOCACHE };
+    static block_ops_t limited  = { .read = ram_read, .write = ram_write,
+                                    .max_blocks = 4 };
+
+    cache_init();
+    CHECK(register_block_device(0, &cached) == 0);
+    CHECK(register_block_device(1, &uncached) == 0);
+    CHECK(register_block_device(2, &limited) == 0);
+
+    RUN(test_block_read_caches_any_block);
+    RUN(test_block_read_coalesces_misses);
+    RUN(test_block_write_through);
+    RUN(test_block_errors);
+    RUN(test_block_nocache);
+    RUN(test_block_buffer_refs);
+    RUN(test_block_buffer_errors);
+    RUN(test_block_write_back);
+    RUN(test_block_write_back_merge);
+    RUN(test_block_write_back_error);
+    RUN(test_block_write_back_down);
+    RUN(test_block_write_back_full);
+    return test_done("block");
+}
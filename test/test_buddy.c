@@ -0,0 +1,181 @@
+#include "test.h"
+#include "shim.h"
+#include "mm/buddy.h"
+#include "mm/shrinker.h"
+#include <string.h>
+
+/* =========================================================================
+ * mm/buddy.c over a 16 MB arena at "physical" 1 MB
+ * ========================================================================= */
+
+#define ARENA_PHYS  0x00100000u
+#define ARENA_KB    (16 * 1024)
+#define ARENA_PAGES (ARENA_KB / 4)
+
+static void test_page_init(void)
+{
+    CHECK(buddy_total_pages() == ARENA_PAGES);
+    CHECK(buddy_free_pages() == ARENA_PAGES);
+    CHECK(buddy_used_pages() == 0);
+}
+
+static void test_page_alloc_free(void)
+{
+    uint8_t *a = page_alloc(1);
+    uint8_t *b = page_alloc(PAGE_SIZE);
+    uint8_t *c = page_alloc(PAGE_SIZE + 1);         /* two pages */
+
+    CHECK(a && b && c);
+    CHECK(((uintptr_t)a & (PAGE_SIZE - 1)) == 0);
+    CHECK((uintptr_t)a == 0xC0000000u + ARENA_PHYS);
+    CHECK(b == a + PAGE_SIZE);
+    CHECK(c == b + PAGE_SIZE);
+    CHECK(buddy_used_pages() == 4);
+
+    memset(c, 0xAB, 2 * PAGE_SIZE);                 /* really mapped */
+
+    CHECK(page_alloc(0) == NULL);
+
+    /* Freeing the run start releases the whole run */
+    page_free(c);
+    CHECK(buddy_used_pages() == 2);
+
+    /* The hole left by b is reused first */
+    page_free(b);
+    uint8_t *d = page_alloc(PAGE_SIZE);
+    CHECK(d == b);
+
+    page_free(a);
+    page_free(d);
+    CHECK(buddy_used_pages() == 0);
+}
+
+static void test_page_bad_free(void)
+{
+    uint8_t *run = page_alloc(3 * PAGE_SIZE);
+    CHECK(run != NULL);
+
+    int before = shim_printk_count;
+    page_free(run + PAGE_SIZE);                     /* inside the run */
+    CHECK(shim_printk_count == before + 1);
+    CHECK(strstr(shim_printk_last, "inside an allocation") != NULL);
+    CHECK(buddy_used_pages() == 3);
+
+    page_free(run);
+    page_free(run);                                 /* double free */
+    CHECK(strstr(shim_printk_last, "Double free") != NULL);
+    CHECK(buddy_used_pages() == 0);
+}
+
+static void test_page_exhaust(void)
+{
+    static void *pages[ARENA_PAGES];
+    uint32_t n = 0;
+
+    while ((pages[n] = page_alloc(PAGE_SIZE)) != NULL)
+        n++;
+    CHECK(n == ARENA_PAGES);
+    CHECK(buddy_free_pages() == 0);
+
+    /* Free every other page: plenty free, nothing contiguous */
+    for (uint32_t i = 0; i < n; i += 2)
+        page_free(pages[i]);
+    CHECK(buddy_free_pages() == ARENA_PAGES / 2);
+    CHECK(page_alloc(2 * PAGE_SIZE) == NULL);
+    CHECK(page_alloc(PAGE_SIZE) != NULL);
+
+    for (uint32_t i = 1; i < n; i += 2)
+        page_free(pages[i]);
+    page_free(pages[0]);
+    CHECK(buddy_used_pages() == 0);
+    CHECK(page_alloc((size_t)ARENA_PAGES * PAGE_SIZE) == pages[0]);
+    page_free(pages[0]);
+}
+
+/* A shrinker holding one page; page_alloc() asks it when out of memory */
+static void    *held;
+static uint32_t scans;
+
+static uint32_t give_back(uint32_t nr_pages)
+{
+    (void)nr_pages;
+    scans++;
+    /* Reclaim never nests: the inner call gets nothing */
+    CHECK(shrink_memory(1) == 0);
+    if (!held)
+        return 0;
+    page_free(held);
+    held = NULL;
+    return 1;
+}
+
+static void test_page_shrinker(void)
+{
+    static void *pages[ARENA_PAGES];
+    static shrinker_t s = { .name = "test", .scan = give_back };
+    uint32_t n = 0;
+
+    register_shrinker(&s);
+    held = page_alloc(PAGE_SIZE);
+    while ((pages[n] = page_alloc(PAGE_SIZE)) != NULL)
+        n++;
+
+    /* The last success came from the shrinker's page, then it was dry */
+    CHECK(n == ARENA_PAGES);
+    CHECK(held == NULL && scans == 2);
+    CHECK(page_alloc(PAGE_SIZE) == NULL && scans == 3);
+
+    unregister_shrinker(&s);
+    CHECK(page_alloc(PAGE_SIZE) == NULL && scans == 3);
+    for (uint32_t i = 0; i < n; i++)
+        page_free(pages[i]);
+    CHECK(buddy_used_pages() == 0);
+}
+
+/* Random runs against a shadow map of which pages are in use */
+static void test_page_random(void)
+{
+    enum { SLOTS = 512 };
+    static uint8_t *ptr[SLOTS];
+    static uint32_t len[SLOTS];
+    uint32_t used = 0;
+
+    for (int op = 0; op < 50000; op++) {
+        int i = test_rand() % SLOTS;
+        if (ptr[i]) {
+            CHECK(ptr[i][0] == (uint8_t)i && ptr[i][len[i] * PAGE_SIZE - 1] == (uint8_t)i);
+            page_free(ptr[i]);
+            used -= len[i];
+            ptr[i] = NULL;
+        } else {
+            len[i] = 1 + test_rand() % 8;
+            ptr[i] = page_alloc(len[i] * PAGE_SIZE);
+            if (!ptr[i])
+                continue;
+            memset(ptr[i], i, len[i] * PAGE_SIZE);
+            used += len[i];
+        }
+    }
+    CHECK(buddy_used_pages() == used);
+
+    for (int i = 0; i < SLOTS; i++)
+        if (ptr[i])
+            page_free(ptr[i]);
+    CHECK(buddy_used_pages() == 0);
+}
+
+int main(void)
+{
+    if (shim_arena_init(ARENA_PHYS, ARENA_KB) < 0) {
+        printf("[TEST] buddy: cannot map the arena, skipped\n");
+        return 0;
+    }
+
+    RUN(test_page_init);
+    RUN(test_page_alloc_free);
+    RUN(test_page_bad_free);
+    RUN(test_page_exhaust);
+    RUN(test_page_shrinker);
+    RUN(test_page_random);
+    return test_done("buddy");
+}
@@ -0,0 +1,469 @@
+#include "test.h"
+#include "shim.h"
+#include "driver/block/cache.h"
+#include "driver/block/block.h"
+#include "mm/buddy.h"
+#include "mm/shrinker.h"
+#include <string.h>
+
+/* =========================================================================
+ * driver/block/cache.c against a RAM disk
+ *
+ * bwrite_direct() is the only block I/O the cache does (write-back of
+ * dirty entries); it lands in disk[] and is counted.  block_max_blocks()
+ * reports no transfer limit.  Data pages come
+ * from the page shim, whose shim_total_pages stands in for the size of
+ * memory.  Most tests pin the cache at CAP blocks.
+ * ========================================================================= */
+
+#define DISK_BLOCKS  8192
+#define CAP          64                 /* blocks in 32 KB */
+#define PER_PAGE     (PAGE_SIZE / CACHE_BLOCK_SIZE)
+
+static uint8_t disk[2][DISK_BLOCKS][CACHE_BLOCK_SIZE];
+static int     disk_writes;
+
+int bwrite_direct(int prim_id, int scnd_id, const void *buf, uint32_t offset, size_t count)
+{
+    if (prim_id < 0 || prim_id > 1 || offset + count > DISK_BLOCKS)
+        return -1;
+    (void)scnd_id;
+    memcpy(disk[prim_id][offset], buf, count * CACHE_BLOCK_SIZE);
+    disk_writes += (int)count;
+    return (int)(count * CACHE_BLOCK_SIZE);
+}
+
+uint32_t block_max_blocks(int prim_id)
+{
+    (void)prim_id;
+    return 0;
+}
+
+static void fill(uint8_t *blk, uint32_t tag)
+{
+    for (int i = 0; i < CACHE_BLOCK_SIZE; i += 4)
+        memcpy(blk + i, &tag, 4);
+}
+
+static int holds(const uint8_t *blk, uint32_t tag)
+{
+    uint8_t want[CACHE_BLOCK_SIZE];
+    fill(want, tag);
+    return memcmp(blk, want, CACHE_BLOCK_SIZE) == 0;
+}
+
+/* Empty the cache between tests and pin it at CAP blocks */
+static void reset(void)
+{
+    cache_invalidate_device(0);
+    cache_invalidate_device(1);
+    shim_total_pages = 262144;
+    cache_set_limits(32, 32);
+    disk_writes = 0;
+}
+
+static uint32_t cache_pages(void)
+{
+    uint32_t pages;
+    cache_usage(&pages, NULL, NULL);
+    return pages;
+}
+
+/* =========================================================================
+ * Tests
+ * ========================================================================= */
+
+static void test_cache_hit_miss(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+    uint32_t h0, m0, h1, m1, n;
+
+    reset();
+    cache_stats(&h0, &m0, NULL);
+
+    CHECK(cache_lookup(0, 0, 5, out) == 0);
+    fill(blk, 5);
+    CHECK(cache_insert(0, 0, 5, blk) == 0);
+    CHECK(cache_lookup(0, 0, 5, out) == 1 && holds(out, 5));
+
+    /* Keys differ by device, minor and block */
+    CHECK(cache_lookup(1, 0, 5, out) == 0);
+    CHECK(cache_lookup(0, 1, 5, out) == 0);
+    CHECK(cache_lookup(0, 0, 6, out) == 0);
+
+    /* Re-inserting replaces the data */
+    fill(blk, 55);
+    CHECK(cache_insert(0, 0, 5, blk) == 0);
+    CHECK(cache_lookup(0, 0, 5, out) == 1 && holds(out, 55));
+
+    cache_stats(&h1, &m1, &n);
+    CHECK(h1 - h0 == 2);
+    CHECK(m1 - m0 == 4);
+    CHECK(n == 1);
+}
+
+static void test_cache_lru_eviction(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+    uint32_t n;
+
+    reset();
+    for (uint32_t b = 0; b < CAP; b++) {
+        fill(blk, b);
+        cache_insert(0, 0, b, blk);
+    }
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == CAP);
+
+    /* Touch block 0 so block 1 is now the least recently used */
+    CHECK(cache_lookup(0, 0, 0, out) == 1);
+
+    fill(blk, 1000);
+    cache_insert(0, 0, 1000, blk);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == CAP);
+    CHECK(cache_lookup(0, 0, 1, out) == 0);         /* evicted */
+    CHECK(cache_lookup(0, 0, 0, out) == 1);         /* survived */
+    CHECK(cache_lookup(0, 0, 1000, out) == 1 && holds(out, 1000));
+}
+
+/* 2Q: CAP/4 blocks on the A1in FIFO, CAP/2 ghosts */
+static void test_cache_2q(void)
+{
+    uint8_t  blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+    uint32_t n, ghosts;
+
+    reset();
+    cache_set_policy(CACHE_POLICY_2Q);
+    CHECK(cache_policy() == CACHE_POLICY_2Q);
+    ghosts = cache_ghost_hits();
+
+    for (uint32_t b = 0; b < CAP; b++) {
+        fill(blk, b);
+        cache_insert(0, 0, b, blk);
+    }
+
+    /* A hit on A1in does not keep a block: 0-47 make way, 16-47 are
+     * remembered */
+    CHECK(cache_lookup(0, 0, 0, out) == 1);
+    for (uint32_t b = 100; b < 148; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_lookup(0, 0, 0, out) == 0);
+    CHECK(cache_lookup(0, 0, 47, out) == 0);
+
+    /* Asked for again after eviction: hot */
+    for (uint32_t b = 24; b < 32; b++) {
+        fill(blk, b);
+        cache_insert(0, 0, b, blk);
+    }
+    CHECK(cache_ghost_hits() - ghosts == 8);
+    cache_insert(0, 0, 0, blk);                     /* forgotten */
+    CHECK(cache_ghost_hits() - ghosts == 8);
+
+    /* A scan of 4 * CAP blocks only cycles through A1in */
+    for (uint32_t b = 1000; b < 1000 + 4 * CAP; b++)
+        cache_insert(0, 0, b, blk);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == CAP);
+    for (uint32_t b = 24; b < 32; b++)
+        CHECK(cache_lookup(0, 0, b, out) == 1 && holds(out, b));
+    CHECK(cache_lookup(0, 0, 1000 + 4 * CAP - 1, out) == 1);
+
+    /* Back to LRU: the blocks stay, the hot ones now go first */
+    cache_set_policy(CACHE_POLICY_LRU);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == CAP && cache_policy() == CACHE_POLICY_LRU);
+    for (uint32_t b = 2000; b < 2000 + CAP - 8; b++)
+        cache_insert(0, 0, b, blk);
+    for (uint32_t b = 24; b < 32; b++)
+        CHECK(cache_lookup(0, 0, b, out) == 0);
+    CHECK(cache_lookup(0, 0, 1000 + 4 * CAP - 1, out) == 1);
+}
+
+static void test_cache_dirty(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+
+    reset();
+    CHECK(cache_mark_dirty(0, 0, 7) == -1);         /* not cached */
+
+    fill(blk, 7);
+    cache_insert(0, 0, 7, blk);
+    CHECK(cache_mark_dirty(0, 0, 7) == 0);
+    CHECK(disk_writes == 0);
+
+    CHECK(cache_flush() == 1);
+    CHECK(disk_writes == 1 && holds(disk[0][7], 7));
+    CHECK(cache_flush() == 0);                      /* now clean */
+
+    /* Eviction gives up clean blocks first */
+    fill(blk, 8);
+    cache_insert(0, 0, 8, blk);
+    cache_mark_dirty(0, 0, 8);
+    for (uint32_t b = 100; b < 100 + CAP; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(disk_writes == 1 && cache_dirty_count() == 1);
+    CHECK(cache_flush() == 1 && disk_writes == 2 && holds(disk[0][8], 8));
+
+    /* With no other block to take, a dirty victim is written back */
+    cache_buf_t *pin[CAP - 1];
+    for (uint32_t i = 0; i < CAP - 1; i++)
+        pin[i] = cache_get(0, 0, 200 + i, 1);
+    fill(blk, 300);
+    CHECK(cache_write(0, 0, 300, blk) == 0);
+    CHECK(cache_insert(0, 0, 301, blk) == 0);
+    CHECK(disk_writes == 3 && holds(disk[0][300], 300));
+    CHECK(cache_dirty_count() == 0);
+    for (uint32_t i = 0; i < CAP - 1; i++)
+        cache_put(pin[i]);
+
+    /* Invalidation writes back too */
+    fill(blk, 9);
+    cache_insert(1, 0, 9, blk);
+    cache_mark_dirty(1, 0, 9);
+    CHECK(cache_invalidate(1, 0, 9) == 0);
+    CHECK(disk_writes == 4 && holds(disk[1][9], 9));
+}
+
+static void test_cache_invalidate_device(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+    uint32_t n;
+
+    reset();
+    fill(blk, 1);
+    for (uint32_t b = 0; b < 10; b++) {
+        cache_insert(0, 0, b, blk);
+        cache_insert(1, 2, b, blk);
+    }
+    cache_invalidate_device(1);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == 10);
+    CHECK(cache_lookup(1, 2, 3, out) == 0);
+    CHECK(cache_lookup(0, 0, 3, out) == 1);
+}
+
+static void test_cache_alloc_failure(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+
+    reset();
+    fill(blk, 3);
+    shim_kalloc_fail = 1;                           /* page descriptor */
+    CHECK(cache_insert(0, 0, 3, blk) == -1);
+    shim_kalloc_fail = 0;
+    shim_page_fail = 1;                             /* data page */
+    CHECK(cache_insert(0, 0, 3, blk) == -1);
+    shim_page_fail = 0;
+    CHECK(cache_lookup(0, 0, 3, out) == 0);
+    CHECK(cache_pages() == 0);
+
+    CHECK(cache_insert(0, 0, 3, blk) == 0);
+    CHECK(cache_lookup(0, 0, 3, out) == 1);
+}
+
+static void test_cache_page_storage(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+    uint32_t out0;
+
+    reset();
+    out0 = shim_pages_out;
+    fill(blk, 1);
+
+    /* Blocks fill a page before the next one is taken */
+    for (uint32_t b = 0; b < PER_PAGE + 1; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_pages() == 2 && shim_pages_out - out0 == 2);
+
+    /* A page goes back with its last block */
+    cache_invalidate(0, 0, PER_PAGE);
+    CHECK(cache_pages() == 1 && shim_pages_out - out0 == 1);
+    cache_invalidate_device(0);
+    CHECK(cache_pages() == 0 && shim_pages_out == out0);
+}
+
+static void test_cache_limits(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+    uint32_t pages, min, max, n;
+
+    reset();
+    fill(blk, 2);
+    cache_set_limits(5, 0);                         /* rounded up, max >= min */
+    cache_usage(NULL, &min, &max);
+    CHECK(min == 2 && max == 2);
+
+    cache_set_limits(32, 256);
+    for (uint32_t b = 0; b < 1000; b++)
+        cache_insert(0, 0, b, blk);
+    cache_usage(&pages, &min, &max);
+    CHECK(min == 8 && max == 64 && pages == 64);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == 64 * PER_PAGE);
+
+    /* Lowering the ceiling gives pages back at once, LRU first */
+    cache_set_limits(32, 64);
+    CHECK(cache_pages() == 16);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == 16 * PER_PAGE);
+    CHECK(cache_lookup(0, 0, 999, blk) == 1);
+    CHECK(cache_lookup(0, 0, 0, blk) == 0);
+}
+
+static void test_cache_grow_watermark(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+    uint32_t n;
+
+    reset();
+    fill(blk, 4);
+
+    /* 800 pages of memory: grow while more than 100 are free */
+    shim_total_pages = shim_pages_out + 800;
+    cache_set_limits(32, 8192);
+    for (uint32_t b = 0; b < 800 * PER_PAGE; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_pages() == 700);
+    cache_stats(NULL, NULL, &n);
+    CHECK(n == 700 * PER_PAGE);
+    CHECK(buddy_free_pages() == 100);
+
+    /* Below min_pages the cache grows regardless */
+    reset();
+    shim_total_pages = shim_pages_out + 16;
+    cache_set_limits(64, 8192);
+    for (uint32_t b = 0; b < 32 * PER_PAGE; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_pages() == 16);
+}
+
+static void test_cache_shrink_low_memory(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+    uint32_t base;
+
+    reset();
+    fill(blk, 5);
+    base = shim_pages_out;
+    shim_total_pages = base + 800;
+    cache_set_limits(32, 8192);
+    for (uint32_t b = 0; b < 700 * PER_PAGE; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_pages() == 700);
+
+    /* Others take memory until 40 of 740 pages are free (< 1/16): the
+     * next insert hands back pages until 1/8 (92) is free again */
+    shim_total_pages = base + 740;
+    cache_insert(0, 0, 700 * PER_PAGE, blk);
+    CHECK(cache_pages() == 648);
+    CHECK(buddy_free_pages() == 92);
+    CHECK(cache_lookup(0, 0, 0, blk) == 0);         /* oldest went first */
+    CHECK(cache_lookup(0, 0, 700 * PER_PAGE, blk) == 1);
+
+    /* Never below the floor: 600 pages, not the 578 that would leave
+     * 82 of 660 free */
+    cache_set_limits(600 * 4, 8192);
+    shim_total_pages = base + 660;
+    cache_insert(0, 0, 700 * PER_PAGE + 1, blk);
+    CHECK(cache_pages() == 600);
+}
+
+static void test_cache_shrinker(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE];
+    shrinker_t *s = shim_shrinker;
+
+    reset();
+    CHECK(s != NULL);
+    fill(blk, 6);
+    cache_set_limits(0, 64);
+    for (uint32_t b = 0; b < 4 * PER_PAGE; b++)
+        cache_insert(0, 0, b, blk);
+    CHECK(cache_pages() == 4);
+
+    /* The oldest page has a dirty block: skipped, nothing written */
+    cache_mark_dirty(0, 0, 1);
+    for (uint32_t b = PER_PAGE; b < 4 * PER_PAGE; b++)
+        cache_lookup(0, 0, b, blk);                 /* page 0 is LRU */
+    CHECK(s->scan(1) == 1);
+    CHECK(disk_writes == 0);
+    CHECK(cache_pages() == 3);
+    CHECK(cache_lookup(0, 0, 1, blk) == 1);
+
+    /* page_alloc() out of memory: the cache gives a clean page up */
+    shim_total_pages = shim_pages_out;
+    void *p = page_alloc(PAGE_SIZE);
+    CHECK(p != NULL && cache_pages() == 2);
+    page_free(p);
+
+    /* Only dirty pages left: nothing to give */
+    for (uint32_t b = 0; b < 4 * PER_PAGE; b += PER_PAGE)
+        cache_mark_dirty(0, 0, b + 2);
+    CHECK(s->scan(2) == 0);
+    cache_flush();
+    CHECK(s->scan(2) == 2 && cache_pages() == 0);
+}
+
+static void test_cache_pinned(void)
+{
+    uint8_t blk[CACHE_BLOCK_SIZE], out[CACHE_BLOCK_SIZE];
+    cache_buf_t *pin[CAP], *b;
+
+    reset();
+    fill(blk, 7);
+
+    /* Every slot referenced: nothing can be evicted */
+    for (uint32_t i = 0; i < CAP; i++) {
+        pin[i] = cache_get(0, 0, i, 1);
+        CHECK(pin[i] && !pin[i]->uptodate);
+        fill(pin[i]->data, i);
+        pin[i]->uptodate = 1;
+    }
+    CHECK(cache_get(0, 0, CAP, 1) == NULL);
+    CHECK(cache_insert(0, 0, CAP, blk) == -1);
+    CHECK(shim_shrinker->scan(CAP) == 0);
+
+    /* Released ones are, least recently used first */
+    cache_put(pin[5]);
+    CHECK(cache_insert(0, 0, CAP, blk) == 0);
+    CHECK(cache_lookup(0, 0, 5, out) == 0);
+    CHECK(cache_lookup(0, 0, 6, out) == 1 && holds(out, 6));
+
+    /* Invalidated while referenced: the data stays until the last put */
+    b = cache_get(0, 0, 6, 0);
+    CHECK(b == pin[6]);
+    cache_invalidate(0, 0, 6);
+    CHECK(cache_lookup(0, 0, 6, out) == 0 && holds(b->data, 6));
+    cache_dirty(b);                                 /* written at once */
+    CHECK(disk_writes == 1 && holds(disk[0][6], 6));
+    cache_put(b);
+    cache_put(pin[6]);
+
+    for (uint32_t i = 0; i < CAP; i++) {
+        if (i != 5 && i != 6)
+            cache_put(pin[i]);
+    }
+    reset();
+    CHECK(cache_pages() == 0);
+}
+
+int main(void)
+{
+    cache_init();
+    cache_set_limits(32, 32);
+
+    RUN(test_cache_hit_miss);
+    RUN(test_cache_lru_eviction);
+    RUN(test_cache_2q);
+    RUN(test_cache_dirty);
+    RUN(test_cache_invalidate_device);
+    RUN(test_cache_alloc_failure);
+    RUN(test_cache_page_storage);
+    RUN(test_cache_limits);
+    RUN(test_cache_grow_watermark);
+    RUN(test_cache_shrink_low_memory);
+    RUN(test_cache_shrinker);
+    RUN(test_cache_pinned);
+    return test_done("cache");
+}
@@ -0,0 +1,242 @@
+#include "test.h"
+#include "shim.h"
+#include "lib/hash.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t      key;
+    htable_node_t node;
+    hlist_node_t  fixed;
+} item_t;
+
+/* =========================================================================
+ * Hash functions
+ * ========================================================================= */
+
+static void test_hash_funcs(void)
+{
+    /* Known FNV-1a vectors */
+    CHECK(hash_str("") == 2166136261u);
+    CHECK(hash_str("a") == 0xE40C292Cu);
+    CHECK(hash_str("foobar") == 0xBF9CF968u);
+    CHECK(hash_mem("foobar", 6) == hash_str("foobar"));
+
+    for (unsigned int bits = 1; bits <= 32; bits++) {
+        uint32_t h = hash_32(0xDEADBEEF, bits);
+        CHECK(bits == 32 || h < (1u << bits));
+    }
+
+    /* Sequential keys should spread over all 64 buckets */
+    int used[64] = { 0 }, n = 0;
+    for (uint32_t k = 0; k < 256; k++)
+        used[hash_32(k, 6)]++;
+    for (int i = 0; i < 64; i++)
+        n += used[i] != 0;
+    CHECK(n == 64);
+}
+
+/* =========================================================================
+ * hlist and fixed tables
+ * ========================================================================= */
+
+static void test_hlist(void)
+{
+    hlist_head_t head = HLIST_HEAD_INIT;
+    item_t a = { .key = 1 }, b = { .key = 2 }, c = { .key = 3 }, *pos;
+    hlist_node_t *tmp;
+
+    INIT_HLIST_NODE(&a.fixed);
+    CHECK(hlist_unhashed(&a.fixed));
+    CHECK(hlist_empty(&head));
+
+    hlist_add_head(&a.fixed, &head);
+    hlist_add_head(&b.fixed, &head);
+    hlist_add_head(&c.fixed, &head);
+
+    uint32_t order = 0;
+    hlist_for_each_entry(pos, &head, fixed)
+        order = order * 10 + pos->key;
+    CHECK(order == 321);
+
+    hlist_del(&b.fixed);              /* middle */
+    CHECK(hlist_unhashed(&b.fixed));
+    hlist_del_init(&b.fixed);         /* harmless twice */
+    hlist_del(&c.fixed);              /* head   */
+
+    order = 0;
+    hlist_for_each_entry_safe(pos, tmp, &head, fixed) {
+        order = order * 10 + pos->key;
+        hlist_del(&pos->fixed);
+    }
+    CHECK(order == 1);
+    CHECK(hlist_empty(&head));
+}
+
+static void test_fixed_table(void)
+{
+    static DEFINE_HASHTABLE(table, 4);
+    static item_t items[200];
+    item_t *pos;
+    unsigned int bkt, n = 0;
+
+    CHECK(HASH_SIZE(table) == 16);
+    CHECK(HASH_BITS(table) == 4);
+
+    for (uint32_t i = 0; i < 200; i++) {
+        items[i].key = i * 7;
+        hash_add(table, &items[i].fixed, items[i].key);
+    }
+
+    hash_for_each(table, bkt, pos, fixed)
+        n++;
+    CHECK(n == 200);
+
+    int found = 0;
+    hash_for_each_possible(table, pos, fixed, 70u)
+        if (pos->key == 70)
+            found++;
+    CHECK(found == 1);
+
+    for (uint32_t i = 0; i < 200; i += 2)
+        hash_del(&items[i].fixed);
+    n = 0;
+    hash_for_each(table, bkt, pos, fixed) {
+        CHECK(pos->key % 14 == 7);
+        n++;
+    }
+    CHECK(n == 100);
+}
+
+/* =========================================================================
+ * Resizable tables
+ * ========================================================================= */
+
+static item_t *htable_lookup(htable_t *t, uint32_t key)
+{
+    item_t  *pos;
+    uint32_t h = hash_32(key, 32);
+
+    htable_for_each_possible(t, pos, node, h)
+        if (pos->key == key)
+            return pos;
+    return NULL;
+}
+
+static unsigned int htable_count(htable_t *t)
+{
+    item_t      *pos;
+    unsigned int bkt, n = 0;
+
+    htable_for_each(t, bkt, pos, node)
+        n++;
+    return n;
+}
+
+static void test_htable_resize(void)
+{
+    enum { N = 5000 };
+    static item_t items[N];
+    htable_t t;
+
+    CHECK(htable_init(&t, 2) == 0);
+    CHECK(t.bits == 2);
+
+    for (uint32_t i = 0; i < N; i++) {
+        items[i].key = i;
+        htable_add(&t, &items[i].node, hash_32(i, 32));
+    }
+    CHECK(t.count == N);
+    CHECK(t.count <= (1u << t.bits));          /* load factor at most 1 */
+    CHECK(htable_count(&t) == N);
+    for (uint32_t i = 0; i < N; i++)
+        CHECK(htable_lookup(&t, i) == &items[i]);
+    CHECK(htable_lookup(&t, N + 1) == NULL);
+
+    /* Shrink back down as entries leave */
+    for (uint32_t i = 0; i < N - 3; i++)
+        htable_del(&t, &items[i].node);
+    CHECK(t.count == 3);
+    CHECK(t.bits == 4);                       /* 13 bits shrank to load >= 1/8 */
+    CHECK(htable_count(&t) == 3);
+    for (uint32_t i = N - 3; i < N; i++)
+        CHECK(htable_lookup(&t, i) == &items[i]);
+    CHECK(htable_lookup(&t, 0) == NULL);
+
+    htable_destroy(&t);
+}
+
+static void test_htable_alloc_failure(void)
+{
+    static item_t items[64];
+    htable_t t;
+
+    CHECK(htable_init(&t, 3) == 0);
+
+    /* Growth fails: the table keeps working at its old size */
+    shim_kalloc_fail = 1000;
+    for (uint32_t i = 0; i < 64; i++) {
+        items[i].key = i;
+        htable_add(&t, &items[i].node, hash_32(i, 32));
+    }
+    shim_kalloc_fail = 0;
+
+    CHECK(t.bits == 3);
+    CHECK(htable_count(&t) == 64);
+    for (uint32_t i = 0; i < 64; i++)
+        CHECK(htable_lookup(&t, i) == &items[i]);
+
+    /* The next add can grow again */
+    htable_del(&t, &items[63].node);
+    htable_add(&t, &items[63].node, hash_32(63, 32));
+    CHECK(t.bits == 4);
+    CHECK(htable_count(&t) == 64);
+
+    htable_destroy(&t);
+}
+
+/* Random add/delete against a shadow membership array */
+static void test_htable_random(void)
+{
+    enum { N = 2048, OPS = 200000 };
+    static item_t items[N];
+    static int    member[N];
+    htable_t t;
+    uint32_t live = 0;
+
+    CHECK(htable_init(&t, 1) == 0);
+    for (uint32_t i = 0; i < N; i++)
+        items[i].key = i * 2654435761u;
+
+    for (int op = 0; op < OPS; op++) {
+        uint32_t i = test_rand() % N;
+        if (member[i]) {
+            htable_del(&t, &items[i].node);
+            live--;
+        } else {
+            htable_add(&t, &items[i].node, hash_32(items[i].key, 32));
+            live++;
+        }
+        member[i] = !member[i];
+
+        if (op % 5000 == 0) {
+            CHECK(t.count == live);
+            CHECK(htable_count(&t) == live);
+        }
+    }
+
+    for (uint32_t i = 0; i < N; i++)
+        CHECK((htable_lookup(&t, items[i].key) != NULL) == member[i]);
+
+    htable_destroy(&t);
+}
+
+int main(void)
+{
+    RUN(test_hash_funcs);
+    RUN(test_hlist);
+    RUN(test_fixed_table);
+    RUN(test_htable_resize);
+    RUN(test_htable_alloc_failure);
+    RUN(test_htable_random);
+    return test_done("hash");
+}
@@ -0,0 +1,108 @@
+#include "test.h"
+#include "lib/list.h"
+
+/* =========================================================================
+ * lib/list.c list_sort
+ * ========================================================================= */
+
+typedef struct {
+    uint32_t    key;
+    uint32_t    seq;            /* insertion order, to check stability */
+    list_head_t node;
+} item_t;
+
+static int item_cmp(const list_head_t *a, const list_head_t *b)
+{
+    uint32_t ka = list_entry(a, item_t, node)->key;
+    uint32_t kb = list_entry(b, item_t, node)->key;
+    return ka < kb ? -1 : ka > kb;
+}
+
+/* Sorted and stable, with prev links and the ring intact */
+static int sorted_ok(list_head_t *head, uint32_t n)
+{
+    item_t      *it, *last = NULL;
+    list_head_t *prev  = head;
+    uint32_t     count = 0;
+
+    list_for_each_entry(it, head, node) {
+        if (it->node.prev != prev)
+            return 0;
+        if (last && (last->key > it->key ||
+                     (last->key == it->key && last->seq > it->seq)))
+            return 0;
+        prev = &it->node;
+        last = it;
+        count++;
+    }
+    return head->prev == prev && count == n;
+}
+
+static void test_list_sort_small(void)
+{
+    static item_t items[3];
+    LIST_HEAD(head);
+
+    list_sort(&head, item_cmp);
+    CHECK(list_empty(&head));
+
+    items[0].key = 5;
+    list_add_tail(&items[0].node, &head);
+    list_sort(&head, item_cmp);
+    CHECK(sorted_ok(&head, 1));
+
+    items[1].key = 2;
+    items[2].key = 9;
+    list_add_tail(&items[1].node, &head);
+    list_add_tail(&items[2].node, &head);
+    list_sort(&head, item_cmp);
+    CHECK(sorted_ok(&head, 3));
+    CHECK(list_first_entry(&head, item_t, node) == &items[1]);
+}
+
+static void test_list_sort_random(void)
+{
+    enum { N = 5000 };
+    static item_t items[N];
+
+    for (uint32_t n = 2; n <= N; n = n * 3 + 1) {
+        LIST_HEAD(head);
+        for (uint32_t i = 0; i < n; i++) {
+            items[i].key = test_rand() % (n / 2 + 1);   /* with ties */
+            items[i].seq = i;
+            list_add_tail(&items[i].node, &head);
+        }
+        list_sort(&head, item_cmp);
+        CHECK(sorted_ok(&head, n));
+
+        /* Already sorted input stays put */
+        list_sort(&head, item_cmp);
+        CHECK(sorted_ok(&head, n));
+    }
+}
+
+static void test_list_splice(void)
+{
+    static item_t items[4];
+    LIST_HEAD(a);
+    LIST_HEAD(b);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        items[i].key = i;
+        list_add_tail(&items[i].node, i < 2 ? &a : &b);
+    }
+    list_splice_init(&a, &b);
+    CHECK(list_empty(&a));
+    CHECK(sorted_ok(&b, 4));
+
+    list_splice_init(&a, &b);                       /* empty: no-op */
+    CHECK(sorted_ok(&b, 4));
+}
+
+int main(void)
+{
+    RUN(test_list_sort_small);
+    RUN(test_list_sort_random);
+    RUN(test_list_splice);
+    return test_done("list");
+}
@@ -0,0 +1,70 @@
+#include "test.h"
+#include "fs/fs.h"
+#include <string.h>
+
+/* =========================================================================
+ * fs/path.c
+ * ========================================================================= */
+
+static int resolves(const char *cwd, const char *in, const char *want)
+{
+    char out[MAX_PATH_LEN];
+    if (resolve_path(cwd, in, out, sizeof(out)) != 0)
+        return 0;
+    if (strcmp(out, want) != 0) {
+        fprintf(stderr, "  resolve_path(\"%s\", \"%s\") = \"%s\", want \"%s\"\n",
+                cwd, in, out, want);
+        return 0;
+    }
+    return 1;
+}
+
+static void test_path_absolute(void)
+{
+    CHECK(resolves("/x", "/", "/"));
+    CHECK(resolves("/x", "/a/b", "/a/b"));
+    CHECK(resolves("/x", "//a///b/", "/a/b"));
+    CHECK(resolves("/x", "/a/./b/.", "/a/b"));
+}
+
+static void test_path_relative(void)
+{
+    CHECK(resolves("/", "a", "/a"));
+    CHECK(resolves("/home", "a/b", "/home/a/b"));
+    CHECK(resolves("/home/", "a", "/home/a"));
+    CHECK(resolves("/home", ".", "/home"));
+    CHECK(resolves("/home", "", "/home"));
+}
+
+static void test_path_dotdot(void)
+{
+    CHECK(resolves("/a/b", "..", "/a"));
+    CHECK(resolves("/a/b", "../c", "/a/c"));
+    CHECK(resolves("/a/b", "../../..", "/"));       /* stops at the root */
+    CHECK(resolves("/", "../x", "/x"));
+    CHECK(resolves("/x", "/a/b/../c/./d/..", "/a/c"));
+    CHECK(resolves("/x", "/a/..b/c", "/a/..b/c"));  /* not a dot-dot */
+}
+
+static void test_path_too_long(void)
+{
+    char in[MAX_PATH_LEN + 8], out[MAX_PATH_LEN];
+
+    memset(in, 'a', sizeof(in) - 1);
+    in[0] = '/';
+    in[sizeof(in) - 1] = '\0';
+    CHECK(resolve_path("/", in, out, sizeof(out)) == -1);
+
+    /* Fits in MAX_PATH_LEN but not in the caller's buffer */
+    CHECK(resolve_path("/", "/abcdef", out, 4) == -1);
+    CHECK(resolve_path("/", "/abc", out, 5) == 0 && strcmp(out, "/abc") == 0);
+}
+
+int main(void)
+{
+    RUN(test_path_absolute);
+    RUN(test_path_relative);
+    RUN(test_path_dotdot);
+    RUN(test_path_too_long);
+    return test_done("path");
+}
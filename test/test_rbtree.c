@@ -0,0 +1,180 @@
+#include "test.h"
+#include "lib/rbtree.h"
+
+typedef struct {
+    uint32_t  key;
+    rb_node_t node;
+} item_t;
+
+static int item_less(const rb_node_t *a, const rb_node_t *b)
+{
+    return rb_entry(a, item_t, node)->key < rb_entry(b, item_t, node)->key;
+}
+
+static int item_cmp(const void *key, const rb_node_t *n)
+{
+    uint32_t k = *(const uint32_t *)key, nk = rb_entry(n, item_t, node)->key;
+    return k < nk ? -1 : k > nk;
+}
+
+static item_t *item_find(rb_root_t *root, uint32_t key)
+{
+    return rb_entry_safe(rb_find(&key, root, item_cmp), item_t, node);
+}
+
+/* =========================================================================
+ * Invariant checker
+ *
+ * Returns the black height of the subtree, or -1 after reporting a
+ * violation.  Also checks parent links and key order.
+ * ========================================================================= */
+
+static int rb_check(const rb_node_t *n, const rb_node_t *parent,
+                    uint32_t lo, uint32_t hi)
+{
+    if (!n)
+        return 1;
+
+    uint32_t key = rb_entry(n, item_t, node)->key;
+    if (n->rb_parent != parent || key < lo || key > hi)
+        return -1;
+    if (n->rb_color == RB_RED &&
+        ((n->rb_left && n->rb_left->rb_color == RB_RED) ||
+         (n->rb_right && n->rb_right->rb_color == RB_RED)))
+        return -1;
+
+    int l = rb_check(n->rb_left, n, lo, key);
+    int r = rb_check(n->rb_right, n, key, hi);
+    if (l < 0 || r < 0 || l != r)
+        return -1;
+    return l + (n->rb_color == RB_BLACK);
+}
+
+static int rb_valid(const rb_root_t *root)
+{
+    if (root->rb_node && root->rb_node->rb_color != RB_BLACK)
+        return 0;
+    return rb_check(root->rb_node, NULL, 0, UINT32_MAX) > 0;
+}
+
+static unsigned int rb_count(const rb_root_t *root)
+{
+    unsigned int n = 0;
+    for (rb_node_t *p = rb_first(root); p; p = rb_next(p))
+        n++;
+    return n;
+}
+
+/* =========================================================================
+ * Tests
+ * ========================================================================= */
+
+static void test_rb_empty(void)
+{
+    rb_root_t root = RB_ROOT;
+    CHECK(RB_EMPTY_ROOT(&root));
+    CHECK(rb_first(&root) == NULL);
+    CHECK(rb_last(&root) == NULL);
+    CHECK(item_find(&root, 1) == NULL);
+}
+
+/* Ascending insertion is the worst case for an unbalanced tree */
+static void test_rb_sequential(void)
+{
+    enum { N = 4096 };
+    static item_t items[N];
+    rb_root_t root = RB_ROOT;
+
+    for (uint32_t i = 0; i < N; i++) {
+        items[i].key = i;
+        rb_add(&items[i].node, &root, item_less);
+    }
+    CHECK(rb_valid(&root));
+    CHECK(rb_count(&root) == N);
+
+    /* Height bound: 2 * log2(N + 1) */
+    int depth = 0;
+    for (rb_node_t *n = &items[N - 1].node; n; n = n->rb_parent)
+        depth++;
+    CHECK(depth <= 2 * 13);
+
+    uint32_t expect = 0;
+    item_t  *pos;
+    rb_for_each_entry(pos, &root, node)
+        CHECK(pos->key == expect++);
+    CHECK(expect == N);
+
+    expect = N;
+    for (rb_node_t *n = rb_last(&root); n; n = rb_prev(n))
+        CHECK(rb_entry(n, item_t, node)->key == --expect);
+    CHECK(expect == 0);
+
+    for (uint32_t i = 0; i < N; i++)
+        CHECK(item_find(&root, i) == &items[i]);
+    CHECK(item_find(&root, N) == NULL);
+}
+
+/* Random insert/erase against a shadow array, validating as we go */
+static void test_rb_random(void)
+{
+    enum { N = 1024, OPS = 100000 };
+    static item_t items[N];
+    static int    member[N];
+    rb_root_t root = RB_ROOT;
+    unsigned int live = 0;
+
+    for (uint32_t i = 0; i < N; i++)
+        items[i].key = test_rand() % (N * 4);   /* duplicates allowed */
+
+    for (int op = 0; op < OPS; op++) {
+        uint32_t i = test_rand() % N;
+        if (member[i]) {
+            rb_erase(&items[i].node, &root);
+            CHECK(RB_EMPTY_NODE(&items[i].node));
+            live--;
+        } else {
+            rb_add(&items[i].node, &root, item_less);
+            live++;
+        }
+        member[i] = !member[i];
+
+        if (op % 1000 == 0) {
+            CHECK(rb_valid(&root));
+            CHECK(rb_count(&root) == live);
+        }
+    }
+    CHECK(rb_valid(&root));
+
+    /* Drain through rb_first so every erase case runs near the root too */
+    while (!RB_EMPTY_ROOT(&root)) {
+        rb_erase(rb_first(&root), &root);
+        live--;
+    }
+    CHECK(live == 0);
+}
+
+static void test_rb_replace(void)
+{
+    static item_t items[16], spare;
+    rb_root_t root = RB_ROOT;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        items[i].key = i * 10;
+        rb_add(&items[i].node, &root, item_less);
+    }
+
+    spare.key = 50;
+    rb_replace_node(&items[5].node, &spare.node, &root);
+    CHECK(rb_valid(&root));
+    CHECK(item_find(&root, 50) == &spare);
+    CHECK(rb_count(&root) == 16);
+}
+
+int main(void)
+{
+    RUN(test_rb_empty);
+    RUN(test_rb_sequential);
+    RUN(test_rb_random);
+    RUN(test_rb_replace);
+    return test_done("rbtree");
+}
@@ -0,0 +1,126 @@
+#include "test.h"
+#include "shim.h"
+#include "mm/slab.h"
+#include "mm/buddy.h"
+#include <string.h>
+
+/* =========================================================================
+ * mm/slab.c over the page_alloc shim
+ * ========================================================================= */
+
+static void test_kalloc_sizes(void)
+{
+    static const size_t sizes[] = { 1, 7, 8, 9, 16, 31, 64, 100, 256, 513,
+                                    1024, 2000, 2048 };
+
+    CHECK(kalloc(0) == NULL);
+
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        size_t   n = sizes[i];
+        uint8_t *a = kalloc(n), *b = kalloc(n);
+
+        CHECK(a && b && a != b);
+        /* Objects of one cache never overlap */
+        CHECK(a + n <= b || b + n <= a);
+        memset(a, 0x11, n);
+        memset(b, 0x22, n);
+        CHECK(a[n - 1] == 0x11 && b[0] == 0x22);
+        kfree(a);
+        kfree(b);
+    }
+    kfree(NULL);
+}
+
+static void test_kalloc_large(void)
+{
+    uint32_t before = shim_pages_out;
+    uint8_t *p = kalloc(3 * PAGE_SIZE);
+
+    CHECK(p != NULL);
+    CHECK(shim_pages_out == before + 3);            /* straight to pages */
+    memset(p, 0x5A, 3 * PAGE_SIZE);
+    kfree(p);
+    CHECK(shim_pages_out == before);
+}
+
+/* Filling many slabs then freeing everything hands the pages back,
+ * except the one slab each cache keeps */
+static void test_kalloc_release(void)
+{
+    enum { N = 4000 };
+    static void *objs[N];
+    uint32_t before = shim_pages_out;
+
+    for (int i = 0; i < N; i++)
+        CHECK((objs[i] = kalloc(64)) != NULL);
+    CHECK(shim_pages_out > before + N * 64 / PAGE_SIZE);
+
+    for (int i = 0; i < N; i++)
+        kfree(objs[i]);
+    CHECK(shim_pages_out <= before + 1);
+
+    uint32_t alloc, free;
+    slab_stats(&alloc, &free);
+    CHECK(alloc == 0);
+}
+
+static void test_kalloc_no_pages(void)
+{
+    enum { N = 200 };
+    static void *objs[N];
+
+    /* Use up the partial slab so the next kalloc needs a page */
+    for (int i = 0; i < N; i++)
+        objs[i] = kalloc(512);
+
+    shim_page_fail = 1;
+    void *p = kalloc(512);
+    int   failed = (p == NULL) || shim_page_fail == 1;
+    shim_page_fail = 0;
+    CHECK(failed);
+    kfree(p);
+
+    for (int i = 0; i < N; i++)
+        kfree(objs[i]);
+}
+
+/* Random mix of sizes, checking contents survive neighbouring traffic */
+static void test_kalloc_random(void)
+{
+    enum { SLOTS = 1024 };
+    static uint8_t *ptr[SLOTS];
+    static size_t   len[SLOTS];
+
+    for (int op = 0; op < 200000; op++) {
+        int i = test_rand() % SLOTS;
+        if (ptr[i]) {
+            CHECK(ptr[i][0] == (uint8_t)i && ptr[i][len[i] - 1] == (uint8_t)i);
+            kfree(ptr[i]);
+            ptr[i] = NULL;
+        } else {
+            len[i] = 1 + test_rand() % 3000;
+            ptr[i] = kalloc(len[i]);
+            CHECK(ptr[i] != NULL);
+            memset(ptr[i], i, len[i]);
+        }
+    }
+
+    for (int i = 0; i < SLOTS; i++)
+        kfree(ptr[i]);
+
+    uint32_t alloc;
+    slab_stats(&alloc, NULL);
+    CHECK(alloc == 0);
+}
+
+int main(void)
+{
+    slab_init();
+
+    RUN(test_kalloc_sizes);
+    RUN(test_kalloc_large);
+    RUN(test_kalloc_release);
+    RUN(test_kalloc_no_pages);
+    RUN(test_kalloc_random);
+    return test_done("slab");
+}
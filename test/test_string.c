@@ -0,0 +1,183 @@
+#include "test.h"
+#include "lib/string.h"
+#include <sys/mman.h>
+#include <unistd.h>
+
+/* =========================================================================
+ * lib/string.c
+ *
+ * The kernel's definitions take the place of the C library's in this
+ * binary, so the expected results come from the byte-at-a-time reference
+ * versions below rather than from libc.  Every routine is run at every
+ * source alignment and a range of lengths, which covers the head, word
+ * and tail paths of the word-at-a-time scanners.
+ * ========================================================================= */
+
+static int sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+static int ref_strncmp(const char *a, const char *b, size_t n)
+{
+    for (; n; n--, a++, b++) {
+        if (*a != *b)
+            return (unsigned char)*a - (unsigned char)*b;
+        if (!*a)
+            return 0;
+    }
+    return 0;
+}
+
+static const char *ref_strchr(const char *s, int c)
+{
+    for (;; s++) {
+        if (*s == (char)c)
+            return s;
+        if (!*s)
+            return NULL;
+    }
+}
+
+static const char *ref_strrchr(const char *s, int c)
+{
+    const char *last = NULL;
+    for (;; s++) {
+        if (*s == (char)c)
+            last = s;
+        if (!*s)
+            return last;
+    }
+}
+
+/* =========================================================================
+ * Tests
+ * ========================================================================= */
+
+static char buf_a[256 + 8], buf_b[256 + 8];
+
+/* Put a len-byte string of fill at buf + align */
+static char *place(char *buf, size_t align, size_t len, char fill)
+{
+    char *s = buf + align;
+    for (size_t i = 0; i < len; i++)
+        s[i] = (char)(fill + (i % 23));
+    s[len] = '\0';
+    return s;
+}
+
+static void test_strlen(void)
+{
+    for (size_t align = 0; align < 8; align++)
+        for (size_t len = 0; len < 100; len++)
+            CHECK(strlen(place(buf_a, align, len, 'a')) == len);
+
+    /* High-bit bytes are not terminators */
+    char s[] = "\x80\xff\x81\x7f\x01";
+    CHECK(strlen(s) == 5);
+}
+
+static void test_strcmp(void)
+{
+    for (size_t ua = 0; ua < 4; ua++)
+        for (size_t ub = 0; ub < 4; ub++)
+            for (size_t len = 0; len < 40; len++) {
+                char *a = place(buf_a, ua, len, 'a');
+                char *b = place(buf_b, ub, len, 'a');
+                CHECK(strcmp(a, b) == 0);
+                CHECK(strncmp(a, b, len + 5) == 0);
+
+                for (size_t d = 0; d < len; d += 7) {
+                    b[d]++;
+                    CHECK(sign(strcmp(a, b)) == sign(ref_strncmp(a, b, 1000)));
+                    CHECK(sign(strncmp(a, b, d)) == 0);
+                    CHECK(sign(strncmp(a, b, d + 1)) == sign(ref_strncmp(a, b, d + 1)));
+                    b[d]--;
+                }
+            }
+
+    /* Prefixes and unsigned byte order */
+    CHECK(strcmp("abc", "abcd") < 0);
+    CHECK(strcmp("abcd", "abc") > 0);
+    CHECK(strcmp("\x80", "\x7f") > 0);
+    CHECK(strncmp("abcX", "abcY", 3) == 0);
+}
+
+static void test_strchr(void)
+{
+    for (size_t align = 0; align < 8; align++)
+        for (size_t len = 0; len < 60; len++) {
+            char *s = place(buf_a, align, len, 'a');
+            for (int c = 'a'; c < 'a' + 24; c += 5) {
+                CHECK(strchr(s, c) == ref_strchr(s, c));
+                CHECK(strrchr(s, c) == ref_strrchr(s, c));
+            }
+            CHECK(strchr(s, '\0') == s + len);
+            CHECK(strrchr(s, '\0') == s + len);
+        }
+}
+
+static void test_copy(void)
+{
+    char dst[64];
+
+    CHECK(strcpy(dst, "hello") == dst && ref_strncmp(dst, "hello", 6) == 0);
+    CHECK(strcat(dst, ", world") == dst && ref_strncmp(dst, "hello, world", 13) == 0);
+
+    /* strncpy pads with NULs and does not terminate when truncating */
+    for (int i = 0; i < 16; i++)
+        dst[i] = 'x';
+    strncpy(dst, "ab", 6);
+    CHECK(dst[0] == 'a' && dst[1] == 'b' && dst[2] == 0 && dst[5] == 0 && dst[6] == 'x');
+    strncpy(dst, "abcdefgh", 4);
+    CHECK(dst[3] == 'd' && dst[4] == 0);
+}
+
+static void test_memcmp(void)
+{
+    unsigned char a[64], b[64];
+    for (int i = 0; i < 64; i++)
+        a[i] = b[i] = (unsigned char)(i * 7);
+
+    CHECK(memcmp(a, b, 64) == 0);
+    CHECK(memcmp(a, b, 0) == 0);
+    b[40] = 0xFF;
+    CHECK(memcmp(a, b, 64) < 0);
+    CHECK(memcmp(b, a, 64) > 0);
+    CHECK(memcmp(a, b, 40) == 0);
+}
+
+/* A string that ends on the last byte of a page must not fault */
+static void test_page_end(void)
+{
+    long  pg  = sysconf(_SC_PAGESIZE);
+    char *map = mmap(NULL, 2 * pg, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(map != MAP_FAILED);
+    if (map == MAP_FAILED)
+        return;
+    mprotect(map + pg, pg, PROT_NONE);
+
+    for (size_t len = 0; len < 12; len++) {
+        char *s = map + pg - 1 - len;
+        for (size_t i = 0; i < len; i++)
+            s[i] = 'z';
+        s[len] = '\0';
+        CHECK(strlen(s) == len);
+        CHECK(strchr(s, 'q') == NULL);
+        CHECK(strrchr(s, 'z') == (len ? s + len - 1 : NULL));
+        CHECK(strcmp(s, s) == 0);
+    }
+    munmap(map, 2 * pg);
+}
+
+int main(void)
+{
+    RUN(test_strlen);
+    RUN(test_strcmp);
+    RUN(test_strchr);
+    RUN(test_copy);
+    RUN(test_memcmp);
+    RUN(test_page_end);
+    return test_done("string");
+}